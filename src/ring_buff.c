@@ -35,14 +35,112 @@
 
 #include "ring_buff.h"
 #include "ring_buff_osal.h"
+#include "ring_buff_priv.h"
 
 #if 0
 #define RING_BUFF_DBG_MSG
 #endif
 
 #define GET_RING_BUFF_OBJ(handle) ((ring_buff_obj_t*)handle)
-#define ENTER_RING_BUFF_CONTEXT(handle) (ring_buff_mutex_lock(handle->lock))
-#define LEAVE_RING_BUFF_CONTEXT(handle) (ring_buff_mutex_unlock(handle->lock))
+/* Default OSAL backend is called directly (so it can be inlined), other ones through their table */
+#define ENTER_RING_BUFF_CONTEXT(handle) ((handle)->osal == NULL ? ring_buff_mutex_lock((handle)->lock) : \
+		(handle)->osal->mutex_lock((handle)->lock))
+#define LEAVE_RING_BUFF_CONTEXT(handle) ((handle)->osal == NULL ? ring_buff_mutex_unlock((handle)->lock) : \
+		(handle)->osal->mutex_unlock((handle)->lock))
+#define RING_BUFF_SEM_TAKE(handle, sem) ((handle)->osal == NULL ? ring_buff_binary_sem_take(sem) : \
+		(handle)->osal->binary_sem_take(sem))
+#define RING_BUFF_SEM_GIVE(handle, sem) ((handle)->osal == NULL ? ring_buff_binary_sem_give(sem) : \
+		(handle)->osal->binary_sem_give(sem))
+/* Single-threaded buffer (all of them if the library is built for single-threaded use) */
+#ifdef RING_BUFF_SINGLE_THREADED
+#define RING_BUFF_ST(handle) 1
+#else
+#define RING_BUFF_ST(handle) ((handle)->single_thread)
+#endif
+/* Calls event callback (if set). Buffer context must be acquired. */
+#define RING_BUFF_EVENT(handle, events) if(handle->event_cb != NULL) { handle->event_cb(handle->event_arg, events); }
+/* Writer must not pass this position (in persistent mode, space is reused only after the read position is durable) */
+#define RING_BUFF_WRITE_LIMIT(handle) ((handle)->file != NULL ? (handle)->sync_read : \
+		(handle)->old != NULL ? (handle)->buff + (handle)->size : (handle)->read)
+
+/* Parts of the object storage (object, lock, semaphores) are 8 bytes aligned */
+#define RING_BUFF_STORAGE_ROUND(size) (((size) + 7) & ~7)
+
+/* Aligned chunks: padding is at least as big as its header (it is stored in the padding itself) */
+#define RING_BUFF_PAD_MIN sizeof(ring_buff_pad_t)
+/* Aligned chunks: no padding after this one */
+#define RING_BUFF_PAD_NONE 0xFFFFFFFF
+/* Aligned chunks: padding in front of the chunk reserved at the position */
+#define RING_BUFF_PAD(pos, align) ((((size_t)(pos) & ((align) - 1)) == 0) ? 0 : \
+		(uint32_t)((((size_t)(pos) + RING_BUFF_PAD_MIN + (align) - 1) & ~((size_t)(align) - 1)) - (size_t)(pos)))
+/* Distance from one buffer position to another, in the writing direction */
+#define RING_BUFF_DIST(handle, from, to) ((uint32_t)((to) >= (from) ? (to) - (from) : (handle)->size - ((from) - (to))))
+
+/* Idle page reclamation: free space smaller than this is not given back */
+#define RING_BUFF_RECLAIM_MIN (64 * 1024)
+
+/* Record mode: record alignment (record header size) */
+#define RING_BUFF_REC_ALIGN 8
+/* Record header flag: record is committed */
+#define RING_BUFF_REC_COMMITTED 0x1
+/* Record header flag: record is spilled (it is in the heap, not in the buffer) */
+#define RING_BUFF_REC_SPILLED 0x2
+/* Record size in the buffer (header and aligned data) */
+#define RING_BUFF_REC_SIZE(handle, size) ((handle)->rec_hdr + (((size) + RING_BUFF_REC_ALIGN - 1) & ~(RING_BUFF_REC_ALIGN - 1)))
+/* Default number of claimed records that are not reclaimed yet */
+#define RING_BUFF_REC_CLAIMS 64
+
+/* Persistent mode: file header magic ("RBUF") */
+#define RING_BUFF_PERSIST_MAGIC 0x52425546
+/* Persistent mode: file header size (data starts on the page boundary) */
+#define RING_BUFF_PERSIST_HDR_SIZE 4096
+
+/* CRC-32C (Castagnoli) lookup table */
+static const uint32_t ring_buff_crc_table[256] = {
+	0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4, 0xc79a971f, 0x35f1141c,
+	0x26a1e7e8, 0xd4ca64eb, 0x8ad958cf, 0x78b2dbcc, 0x6be22838, 0x9989ab3b,
+	0x4d43cfd0, 0xbf284cd3, 0xac78bf27, 0x5e133c24, 0x105ec76f, 0xe235446c,
+	0xf165b798, 0x030e349b, 0xd7c45070, 0x25afd373, 0x36ff2087, 0xc494a384,
+	0x9a879fa0, 0x68ec1ca3, 0x7bbcef57, 0x89d76c54, 0x5d1d08bf, 0xaf768bbc,
+	0xbc267848, 0x4e4dfb4b, 0x20bd8ede, 0xd2d60ddd, 0xc186fe29, 0x33ed7d2a,
+	0xe72719c1, 0x154c9ac2, 0x061c6936, 0xf477ea35, 0xaa64d611, 0x580f5512,
+	0x4b5fa6e6, 0xb93425e5, 0x6dfe410e, 0x9f95c20d, 0x8cc531f9, 0x7eaeb2fa,
+	0x30e349b1, 0xc288cab2, 0xd1d83946, 0x23b3ba45, 0xf779deae, 0x05125dad,
+	0x1642ae59, 0xe4292d5a, 0xba3a117e, 0x4851927d, 0x5b016189, 0xa96ae28a,
+	0x7da08661, 0x8fcb0562, 0x9c9bf696, 0x6ef07595, 0x417b1dbc, 0xb3109ebf,
+	0xa0406d4b, 0x522bee48, 0x86e18aa3, 0x748a09a0, 0x67dafa54, 0x95b17957,
+	0xcba24573, 0x39c9c670, 0x2a993584, 0xd8f2b687, 0x0c38d26c, 0xfe53516f,
+	0xed03a29b, 0x1f682198, 0x5125dad3, 0xa34e59d0, 0xb01eaa24, 0x42752927,
+	0x96bf4dcc, 0x64d4cecf, 0x77843d3b, 0x85efbe38, 0xdbfc821c, 0x2997011f,
+	0x3ac7f2eb, 0xc8ac71e8, 0x1c661503, 0xee0d9600, 0xfd5d65f4, 0x0f36e6f7,
+	0x61c69362, 0x93ad1061, 0x80fde395, 0x72966096, 0xa65c047d, 0x5437877e,
+	0x4767748a, 0xb50cf789, 0xeb1fcbad, 0x197448ae, 0x0a24bb5a, 0xf84f3859,
+	0x2c855cb2, 0xdeeedfb1, 0xcdbe2c45, 0x3fd5af46, 0x7198540d, 0x83f3d70e,
+	0x90a324fa, 0x62c8a7f9, 0xb602c312, 0x44694011, 0x5739b3e5, 0xa55230e6,
+	0xfb410cc2, 0x092a8fc1, 0x1a7a7c35, 0xe811ff36, 0x3cdb9bdd, 0xceb018de,
+	0xdde0eb2a, 0x2f8b6829, 0x82f63b78, 0x709db87b, 0x63cd4b8f, 0x91a6c88c,
+	0x456cac67, 0xb7072f64, 0xa457dc90, 0x563c5f93, 0x082f63b7, 0xfa44e0b4,
+	0xe9141340, 0x1b7f9043, 0xcfb5f4a8, 0x3dde77ab, 0x2e8e845f, 0xdce5075c,
+	0x92a8fc17, 0x60c37f14, 0x73938ce0, 0x81f80fe3, 0x55326b08, 0xa759e80b,
+	0xb4091bff, 0x466298fc, 0x1871a4d8, 0xea1a27db, 0xf94ad42f, 0x0b21572c,
+	0xdfeb33c7, 0x2d80b0c4, 0x3ed04330, 0xccbbc033, 0xa24bb5a6, 0x502036a5,
+	0x4370c551, 0xb11b4652, 0x65d122b9, 0x97baa1ba, 0x84ea524e, 0x7681d14d,
+	0x2892ed69, 0xdaf96e6a, 0xc9a99d9e, 0x3bc21e9d, 0xef087a76, 0x1d63f975,
+	0x0e330a81, 0xfc588982, 0xb21572c9, 0x407ef1ca, 0x532e023e, 0xa145813d,
+	0x758fe5d6, 0x87e466d5, 0x94b49521, 0x66df1622, 0x38cc2a06, 0xcaa7a905,
+	0xd9f75af1, 0x2b9cd9f2, 0xff56bd19, 0x0d3d3e1a, 0x1e6dcdee, 0xec064eed,
+	0xc38d26c4, 0x31e6a5c7, 0x22b65633, 0xd0ddd530, 0x0417b1db, 0xf67c32d8,
+	0xe52cc12c, 0x1747422f, 0x49547e0b, 0xbb3ffd08, 0xa86f0efc, 0x5a048dff,
+	0x8ecee914, 0x7ca56a17, 0x6ff599e3, 0x9d9e1ae0, 0xd3d3e1ab, 0x21b862a8,
+	0x32e8915c, 0xc083125f, 0x144976b4, 0xe622f5b7, 0xf5720643, 0x07198540,
+	0x590ab964, 0xab613a67, 0xb831c993, 0x4a5a4a90, 0x9e902e7b, 0x6cfbad78,
+	0x7fab5e8c, 0x8dc0dd8f, 0xe330a81a, 0x115b2b19, 0x020bd8ed, 0xf0605bee,
+	0x24aa3f05, 0xd6c1bc06, 0xc5914ff2, 0x37faccf1, 0x69e9f0d5, 0x9b8273d6,
+	0x88d28022, 0x7ab90321, 0xae7367ca, 0x5c18e4c9, 0x4f48173d, 0xbd23943e,
+	0xf36e6f75, 0x0105ec76, 0x12551f82, 0xe03e9c81, 0x34f4f86a, 0xc69f7b69,
+	0xd5cf889d, 0x27a40b9e, 0x79b737ba, 0x8bdcb4b9, 0x988c474d, 0x6ae7c44e,
+	0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351
+};
 
 /**
  * Buffer states. Buffer can be ONLY in ONE of possible states, but states are
@@ -55,24 +153,77 @@ typedef enum ring_buff_state
 	RING_BUFF_STATE_STOPPED = 4  /**< Buffer is stopped (e.g. end of stream). */
 } ring_buff_state_t;
 
+/**
+ * Record header (record mode).
+ */
+typedef struct ring_buff_rec_hdr
+{
+	/** Record data size */
+	uint32_t size;
+	/** Record flags */
+	uint32_t flags;
+} ring_buff_rec_hdr_t;
+
+/**
+ * Record header (persistent mode).
+ */
+typedef struct ring_buff_persist_rec_hdr
+{
+	/** Common record header */
+	ring_buff_rec_hdr_t hdr;
+	/** Record sequence number (lower 32 bits) */
+	uint32_t seq;
+	/** Data checksum (CRC-32C, seeded with the sequence number) */
+	uint32_t crc;
+} ring_buff_persist_rec_hdr_t;
+
+/**
+ * File header (persistent mode).
+ */
+typedef struct ring_buff_persist_hdr
+{
+	/** Magic number */
+	uint32_t magic;
+	/** Buffer size */
+	uint32_t size;
+	/** Sequence number of the record at read position */
+	uint64_t read_seq;
+	/** Sequence number of the first record that is not durable */
+	uint64_t commit_seq;
+	/** Read position (offset in the buffer) */
+	uint32_t read;
+	/** Reserved */
+	uint32_t reserved;
+} ring_buff_persist_hdr_t;
+
+/**
+ * Memory range (chunk freed out of order).
+ */
+typedef struct ring_buff_range
+{
+	uint8_t *buff;
+	uint32_t size;
+} ring_buff_range_t;
+
+/**
+ * Padding in front of the aligned chunk. It is stored at the padding start (not aligned),
+ * and paddings are linked in the writing order.
+ */
+typedef struct ring_buff_pad
+{
+	/** Padding size */
+	uint32_t size;
+	/** Next padding offset in the buffer (RING_BUFF_PAD_NONE if there is none) */
+	uint32_t next;
+} ring_buff_pad_t;
+
 typedef struct ring_buff_obj
 {
+	/* fields used on every reserve/commit/read/free come first, so that they share cache lines with the lock */
 	/** Buffer */
 	uint8_t *buff;
 	/** Buffer size */
 	uint32_t size;
-	/** Accumulate window size */
-	uint32_t accumulate;
-	/** Notify callback, called whenever window is filled with data and available for consuming */
-	ring_buff_notify_t notify_func;
-	/** Low watermark value in bytes. */
-	uint32_t wm_low;
-	/** High watermark value in bytes. */
-	uint32_t wm_high;
-	/** Watermark callback. */
-	ring_buff_wm_cb_t wm_cb;
-	/** The last watermark level notified */
-	ring_buff_wm_level_t last_level;
 	/** Read pointer (available data start) */
 	uint8_t *read;
 	/** Write pointer (free memory start) */
@@ -84,18 +235,172 @@ typedef struct ring_buff_obj
 	 * reading before write pointer wrapped to the buffer start.
 	 */
 	uint8_t *eod;
+	/**
+	 * End of Data pointer for the free side. It marks where writer wrapped, so that
+	 * the read position can follow it.
+	 */
+	uint8_t *free_eod;
+	/** First record that is not committed (record mode, records may be committed out of order) */
+	uint8_t *commit;
 	/** Continuous data available */
 	uint32_t acc_size;
 	/** State */
 	ring_buff_state_t state;
+	/** Record mode */
+	uint8_t records;
+	/** Record header size */
+	uint32_t rec_hdr;
+	/** Number of producers waiting for free space */
+	uint32_t write_waiters;
+	/** Chunk alignment (1 = not aligned) */
+	uint32_t align;
+	/** Chunks were aligned (data is not continuous anymore) */
+	uint8_t aligned;
+	/** First padding that accumulation window (reader) did not pass */
+	uint8_t *pad_acc;
+	/** First padding that read position did not pass (paddings are not reused while it is set) */
+	uint8_t *pad_free;
+	/** Last padding */
+	uint8_t *pad_tail;
 	/** Buffer lock */
 	ring_buff_mutex_t lock;
 	/** Read semaphore */
 	ring_buff_binary_sem_t read_sem;
 	/** Write semaphore */
 	ring_buff_binary_sem_t write_sem;
+	/** Single-threaded buffer (hot functions neither lock nor wait) */
+	uint8_t single_thread;
+	/** OSAL backend of the lock and semaphores (NULL = default one) */
+	const ring_buff_osal_ops_t *osal;
+	/** Event callback (see ring_buff_priv.h) */
+	ring_buff_event_cb_t event_cb;
+	/** Event callback argument */
+	void* event_arg;
+	/** Number of records claimed */
+	uint32_t claimed;
+	/** Number of chunks that read position advanced over (claimed - reclaimed = records in use) */
+	uint32_t reclaimed;
+	/** Chunks freed ahead of the read position (completion tracker, circular and sorted by position) */
+	ring_buff_range_t *freed;
+	/** Completion tracker size (0 if chunks are freed in order) */
+	uint32_t freed_max;
+	/** Number of chunks in the completion tracker */
+	uint32_t freed_count;
+	/** Completion tracker entry of the chunk closest to the read position */
+	uint32_t freed_first;
+	/** Accumulate window size */
+	uint32_t accumulate;
+	/** Notify callback, called whenever window is filled with data and available for consuming */
+	ring_buff_notify_t notify_func;
+	/** Low watermark value in bytes. */
+	uint32_t wm_low;
+	/** High watermark value in bytes. */
+	uint32_t wm_high;
+	/** Watermark callback. */
+	ring_buff_wm_cb_t wm_cb;
+	/** The last watermark level notified */
+	ring_buff_wm_level_t last_level;
+	/** Linger time in microseconds */
+	uint32_t linger_us;
+	/** Time when the oldest data that is not notified is committed (0 if there is no such data) */
+	uint64_t acc_start;
+	/** Linger timer */
+	ring_buff_timer_t linger_timer;
+	/** Serializes notifications (commit and linger timer may notify concurrently) */
+	ring_buff_mutex_t notify_lock;
+	/** Adaptive accumulation target (0 if accumulate size is fixed) */
+	uint32_t acc_target_us;
+	/** Adaptive accumulation bounds */
+	uint32_t acc_min;
+	uint32_t acc_max;
+	/** Time of the last notification */
+	uint64_t acc_notify_time;
+	/** Average commit rate (bytes per second) */
+	uint64_t acc_rate;
+	/** Average notify callback duration in microseconds */
+	uint64_t notify_us;
+	/** Sequence number of the next record reserved */
+	uint64_t seq;
+	/** Sequence number of the first record that is not committed */
+	uint64_t commit_seq;
+	/** Sequence number of the record at read position */
+	uint64_t read_seq;
+	/** Persistent mode: file mapping (NULL if buffer is not persistent) */
+	ring_buff_file_map_t file;
+	/** Persistent mode: file header */
+	ring_buff_persist_hdr_t *phdr;
+	/** Persistent mode: group commit size */
+	uint32_t sync_batch;
+	/** Persistent mode: sequence number of the first record that is not durable */
+	uint64_t sync_seq;
+	/** Persistent mode: read position saved in the file */
+	uint8_t *sync_read;
+	/** Persistent mode: commit position saved in the file */
+	uint8_t *sync_commit;
+	/** Persistent mode: serializes syncs */
+	ring_buff_mutex_t sync_lock;
+	/** Spill file (NULL if overflow spilling is not used) */
+	ring_buff_file_t spill;
+	/** Set while new records are spilled */
+	uint8_t spilling;
+	/** Spill file offset for the next record appended */
+	uint64_t spill_write;
+	/** Spill file offset of the next record read (guarded by spill_lock) */
+	uint64_t spill_read;
+	/** Number of spilled records that are not claimed */
+	uint32_t spill_count;
+	/** Number of records reserved for spilling, and not committed yet */
+	uint32_t spill_pending;
+	/** Number of spilled records that are claimed, and not read from the file yet */
+	uint32_t spill_reading;
+	/** Serializes spill file appends and reads */
+	ring_buff_mutex_t spill_lock;
+	/** Elastic mode: maximum buffer size (0 if buffer size is fixed) */
+	uint32_t size_max;
+	/** Elastic mode: idle time before the buffer shrinks */
+	uint32_t shrink_us;
+	/** Elastic mode: memory passed on creation (it is not freed) */
+	uint8_t *base;
+	/** Elastic mode: size of the memory passed on creation */
+	uint32_t base_size;
+	/** Elastic mode: memory that is not drained yet after the writer moved on (NULL if there is no such memory) */
+	uint8_t *old;
+	/** Elastic mode: old memory size */
+	uint32_t old_size;
+	/** Elastic mode: number of times producers waited for the room since the last wrap around */
+	uint32_t waits;
+	/** Elastic mode: time since committed data is under wm_low (0 if it is not) */
+	uint64_t low_since;
+	/** Idle page reclamation: time under wm_low before free space is given back to the system (0 if not used) */
+	uint32_t reclaim_us;
+	/** Idle page reclamation: time since committed data is under wm_low (0 if it is not) */
+	uint64_t reclaim_since;
+	/** Idle page reclamation: time of the last reclamation */
+	uint64_t reclaim_time;
+	/** Idle page reclamation: write position at the last reclamation (nothing to give back if it did not move) */
+	uint8_t *reclaim_write;
+	/** Object memory is allocated by "ring_buff_create" (otherwise it is the caller's storage) */
+	uint8_t allocated;
+	/** Real-time profile (buffer memory and object storage are locked) */
+	uint8_t realtime;
+	/** Object storage size (it is unlocked on destroy) */
+	uint32_t storage_size;
 } ring_buff_obj_t;
 
+/**
+ * Internal function which constructs buffer object in its storage (see "ring_buff_get_storage_size"),
+ * with everything that does not have to be allocated.
+ * @param obj Object storage.
+ * @param attr Ring buffer attribute object.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+static ring_buff_err_t ring_buff_setup(ring_buff_obj_t* obj, ring_buff_attr_t* attr);
+/**
+ * Internal function which returns OSAL backend of the buffer lock and semaphores.
+ * @param attr Ring buffer attribute object.
+ * @return OSAL backend.
+ */
+static const ring_buff_osal_ops_t* ring_buff_get_osal(ring_buff_attr_t* attr);
 /**
  * Internal function which checks weather the buffer is in expected state.
  * It is internal function, and expects that buffer context is already acquired by the caller.
@@ -108,10 +413,146 @@ static ring_buff_err_t ring_buff_check_state(ring_buff_obj_t* obj, ring_buff_sta
  * Internal function which handles accumulation. It is used only if accumulation mechanism is
  * used. Internally, it may call notify callback (if enough data is accumulated).
  * @param obj Valid buffer object.
+ * @param chunk Chunk that is committed.
  * @param added_size How much of data (in bytes) is added to the buffer.
  * @return RING_BUFF_ERR_OK or error code returned by the callback.
  */
-static ring_buff_err_t ring_buff_handle_acc(ring_buff_obj_t* obj, uint32_t added_size);
+static ring_buff_err_t ring_buff_handle_acc(ring_buff_obj_t* obj, uint8_t* chunk, uint32_t added_size);
+/**
+ * Internal function which notifies all accumulated data.
+ * @param obj Valid buffer object.
+ * @param force If not set, data is notified only if it lingered long enough.
+ * @return RING_BUFF_ERR_OK or error code returned by the callback.
+ */
+static ring_buff_err_t ring_buff_flush_acc(ring_buff_obj_t* obj, uint8_t force);
+/**
+ * Linger timer callback.
+ * @param arg Valid buffer object.
+ */
+static void ring_buff_linger_expired(void* arg);
+/**
+ * Internal function which adjusts accumulate size based on the observed commit rate and
+ * notify callback duration. It expects that buffer context is already acquired by the caller.
+ * @param obj Valid buffer object.
+ * @param size Size of the data being notified.
+ * @param now Current time in microseconds.
+ */
+static void ring_buff_adapt_acc(ring_buff_obj_t* obj, uint32_t size, uint64_t now);
+/**
+ * Internal function which frees chunk using completion tracker. It expects that buffer context
+ * is already acquired by the caller.
+ * @param obj Valid buffer object.
+ * @param buff Chunk start.
+ * @param size Chunk size.
+ * @return RING_BUFF_ERR_OK, or RING_BUFF_ERR_OVERRUN if completion tracker is full.
+ */
+static ring_buff_err_t ring_buff_free_tracked(ring_buff_obj_t* obj, uint8_t* buff, uint32_t size);
+/**
+ * Internal function which claims next record.
+ * @param obj Valid buffer object.
+ * @param buff Output argument that will contain pointer to the record data.
+ * @param size Output argument that will contain record size.
+ * @param wait If set, function waits for the record to become available.
+ * @return RING_BUFF_ERR_OK, RING_BUFF_ERR_WOULD_BLOCK if there is no record (and wait is not set),
+ * or error code.
+ */
+static ring_buff_err_t ring_buff_claim_rec(ring_buff_obj_t* obj, void** buff, uint32_t* size, uint8_t wait);
+/**
+ * Internal function which advances commit position over the committed records. It expects that buffer context
+ * is already acquired by the caller.
+ * @param obj Valid buffer object.
+ * @return Size of the records that became readable.
+ */
+static uint32_t ring_buff_commit_rec(ring_buff_obj_t* obj);
+/**
+ * Internal function which waits for the writer space. It expects that buffer context is already acquired
+ * by the caller, and it returns with the context acquired.
+ * @param obj Valid buffer object.
+ * @return RING_BUFF_ERR_OK, or error code (RING_BUFF_ERR_PERM if buffer is not active anymore).
+ */
+static ring_buff_err_t ring_buff_wait_write(ring_buff_obj_t* obj);
+/**
+ * Internal function which maps the file (persistent mode), and recovers records that are not released.
+ * @param obj Valid buffer object.
+ * @param path File path.
+ * @return RING_BUFF_ERR_OK, or error code.
+ */
+static ring_buff_err_t ring_buff_persist_open(ring_buff_obj_t* obj, const char* path);
+/**
+ * Internal function which checks weather there is valid record at the given offset (persistent mode).
+ * @param obj Valid buffer object.
+ * @param off Record offset.
+ * @param limit Record must end before this offset.
+ * @param seq Expected sequence number.
+ * @return Record size in the buffer, or 0 if record is not valid.
+ */
+static uint32_t ring_buff_persist_check(ring_buff_obj_t* obj, uint32_t off, uint32_t limit, uint64_t seq);
+/**
+ * Internal function which makes committed records and read position durable (persistent mode).
+ * @param obj Valid buffer object.
+ * @return RING_BUFF_ERR_OK, or error code.
+ */
+static ring_buff_err_t ring_buff_persist_sync(ring_buff_obj_t* obj);
+/**
+ * Internal function which decides weather new record is spilled (it starts and ends spilling).
+ * It expects that buffer context is already acquired by the caller.
+ * @param obj Valid buffer object.
+ * @return Non-zero if new records are spilled.
+ */
+static uint8_t ring_buff_spill_active(ring_buff_obj_t* obj);
+/**
+ * Internal function which appends spilled record to the spill file.
+ * @param obj Valid buffer object.
+ * @param hdr Staged record.
+ * @return RING_BUFF_ERR_OK, or error code.
+ */
+static ring_buff_err_t ring_buff_spill_commit(ring_buff_obj_t* obj, ring_buff_rec_hdr_t* hdr);
+/**
+ * Internal function which reads the next spilled record from the file. It expects that the record is already
+ * claimed (counted in spill_reading) and that buffer context is NOT acquired, so producers do not wait for the disk.
+ * @param obj Valid buffer object.
+ * @param buff Output argument that will contain pointer to the record data.
+ * @param size Output argument that will contain record size.
+ * @return RING_BUFF_ERR_OK, or error code.
+ */
+static ring_buff_err_t ring_buff_spill_claim(ring_buff_obj_t* obj, void** buff, uint32_t* size);
+/**
+ * Internal function which resizes the buffer (elastic mode) when the writer wraps around, or when buffer is empty.
+ * It expects that buffer context is already acquired by the caller.
+ * @param obj Valid buffer object.
+ * @param size Size requested by the writer.
+ * @return Non-zero if writer moved to the new memory (write points to its start).
+ */
+static uint8_t ring_buff_elastic_resize(ring_buff_obj_t* obj, uint32_t size);
+/**
+ * Internal function which moves positions of the empty buffer back to the buffer start, so that
+ * the writer does not have to wrap around. It expects that buffer context is already acquired by the caller.
+ * @param obj Valid buffer object.
+ * @return Non-zero if buffer is empty (positions are moved).
+ */
+static uint8_t ring_buff_rewind(ring_buff_obj_t* obj);
+/**
+ * Internal function which frees the old memory once it is drained (elastic mode).
+ * It expects that buffer context is already acquired by the caller.
+ * @param obj Valid buffer object.
+ */
+static void ring_buff_elastic_drained(ring_buff_obj_t* obj);
+/**
+ * Internal function which gives free space of the idle buffer back to the system (idle page reclamation).
+ * It expects that buffer context is acquired by the caller.
+ * @param obj Valid buffer object.
+ * @param force If set, space is given back even if buffer is not idle (long enough).
+ * @return Number of bytes given back.
+ */
+static uint32_t ring_buff_reclaim_idle(ring_buff_obj_t* obj, uint8_t force);
+/**
+ * Internal function which calculates CRC-32C checksum.
+ * @param crc Initial value.
+ * @param buff Data.
+ * @param size Data size.
+ * @return Checksum.
+ */
+static uint32_t ring_buff_crc32(uint32_t crc, const uint8_t* buff, uint32_t size);
 /**
  * Internal function which handles watermark. It is used only if watermark notification
  * callback is set.
@@ -119,6 +560,96 @@ static ring_buff_err_t ring_buff_handle_acc(ring_buff_obj_t* obj, uint32_t added
  * @return RING_BUFF_ERR_OK or error code returned by the watermark callback.
  */
 static ring_buff_err_t ring_buff_handle_wm(ring_buff_obj_t* obj);
+/**
+ * Internal function which checks if buffer fullness crossed one of the watermarks.
+ * It expects that buffer context is acquired by the caller.
+ * @param obj Valid buffer object.
+ * @return 1 if watermark callback should be called (with the new level), 0 otherwise.
+ */
+static uint8_t ring_buff_check_wm(ring_buff_obj_t* obj);
+/**
+ * Internal function which takes the accumulated window that should be notified after the commit.
+ * It expects that buffer context is acquired by the caller.
+ * @param obj Valid buffer object.
+ * @param chunk Chunk just committed.
+ * @param added_size Size of the data just committed.
+ * @param size Output argument that will contain window size.
+ * @return Window that should be notified (NULL if there is nothing to notify).
+ */
+static void* ring_buff_acc_window(ring_buff_obj_t* obj, uint8_t* chunk, uint32_t added_size, uint32_t* size);
+/**
+ * Internal function which puts padding in front of the aligned chunk, and links it after the last one.
+ * It expects that buffer context is acquired by the caller.
+ * @param obj Valid buffer object.
+ * @param pad Padding start.
+ * @param size Padding size.
+ */
+static void ring_buff_add_pad(ring_buff_obj_t* obj, uint8_t* pad, uint32_t size);
+/**
+ * Internal function which drops paddings that are in front of the chunk from the padding list.
+ * It expects that buffer context is acquired by the caller.
+ * @param obj Valid buffer object.
+ * @param pad First padding of the list (it is updated).
+ * @param from Position that is already passed (paddings are behind the chunk, but not behind this position).
+ * @param chunk Chunk start.
+ */
+static void ring_buff_pass_pads(ring_buff_obj_t* obj, uint8_t** pad, uint8_t* from, uint8_t* chunk);
+/**
+ * Internal function which moves reader over the paddings (and writer's wrap in front of them).
+ * It expects that buffer context is acquired by the caller.
+ * @param obj Valid buffer object.
+ */
+static void ring_buff_skip_pads(ring_buff_obj_t* obj);
+/**
+ * Internal function which checks whether the chunk is the next one that read position can advance over.
+ * @param obj Valid buffer object.
+ * @param buff Chunk start.
+ * @return 1 if chunk is the next one, 0 otherwise.
+ */
+static uint8_t ring_buff_free_in_line(ring_buff_obj_t* obj, uint8_t* buff);
+/**
+ * Internal function which advances read position over the chunk that is next in line.
+ * @param obj Valid buffer object.
+ * @param buff Chunk start.
+ * @param size Chunk size.
+ */
+static void ring_buff_free_advance(ring_buff_obj_t* obj, uint8_t* buff, uint32_t size);
+/**
+ * Internal function which returns the distance of the chunk from the read position, in the order
+ * chunks are read (following the writer's wrap, and the move to the new memory in elastic mode).
+ * @param obj Valid buffer object.
+ * @param buff Chunk start (ahead of the read position).
+ * @return Distance in bytes.
+ */
+static uint64_t ring_buff_free_dist(ring_buff_obj_t* obj, uint8_t* buff);
+/**
+ * Internal function which reserves the chunk (arguments are already checked).
+ * @param obj Valid buffer object.
+ * @param buff Reserved chunk (output param).
+ * @param size Chunk size.
+ * @param align Chunk alignment.
+ * @param locked 0 for single-threaded buffer: nothing is locked nor signaled, and RING_BUFF_ERR_WOULD_BLOCK
+ * is returned instead of waiting for the space.
+ * @return RING_BUFF_ERR_OK, or error code.
+ */
+static ring_buff_err_t ring_buff_reserve_chunk(ring_buff_obj_t* obj, void** buff, uint32_t size, uint32_t align, uint8_t locked);
+/**
+ * Internal function which reads the data (arguments are already checked).
+ * @param obj Valid buffer object.
+ * @param buff Data (output param).
+ * @param size Requested size.
+ * @param read Size of the data read (output param).
+ * @param locked 0 for single-threaded buffer: nothing is locked, and RING_BUFF_ERR_WOULD_BLOCK
+ * is returned instead of waiting for the data.
+ * @return RING_BUFF_ERR_OK, or error code.
+ */
+static ring_buff_err_t ring_buff_read_data(ring_buff_obj_t* obj, void** buff, uint32_t size, uint32_t *read, uint8_t locked);
+/*
+ * Single-threaded variants of the hot functions. Nothing is locked nor signaled,
+ * and calls that would have to wait for the other thread return RING_BUFF_ERR_WOULD_BLOCK.
+ */
+static ring_buff_err_t ring_buff_commit_st(ring_buff_obj_t* obj, void* buff, uint32_t size);
+static ring_buff_err_t ring_buff_free_st(ring_buff_obj_t* obj, void* buff, uint32_t size);
 
 ring_buff_err_t ring_buff_create(ring_buff_attr_t* attr, ring_buff_handle_t* handle)
 {
@@ -129,57 +660,108 @@ ring_buff_err_t ring_buff_create(ring_buff_attr_t* attr, ring_buff_handle_t* han
 	{
 		goto done;
 	}
-	if(attr->size == 0 || attr->buff == NULL)
+	if(attr->size == 0 || (attr->buff == NULL && attr->path == NULL))
 	{
 		goto done;
 	}
-	obj = malloc(sizeof(ring_buff_obj_t));
-	if(obj == NULL)
+	/* persistent buffer memory is the file */
+	if(attr->path != NULL && (attr->buff != NULL || !attr->records))
 	{
-		err_code = RING_BUFF_ERR_NO_MEM;
 		goto done;
 	}
-	memset(obj, 0, sizeof(ring_buff_obj_t));
-	if(ring_buff_mutex_create(&(obj->lock)) != RING_BUFF_ERR_OK)
+	/* spilling is driven by the watermarks */
+	if(attr->spill_path != NULL && (!attr->records || attr->path != NULL ||
+			attr->wm_high > attr->size || attr->wm_low > attr->wm_high))
 	{
-		free(obj);
-		obj = NULL;
 		goto done;
 	}
-	if(attr->accumulate > (attr->size / 2))
+	if(attr->realtime)
 	{
-		fprintf(stderr, "WARNING (%s): Accumulation set too high. It will be turned OFF!\n", __func__);
-		obj->accumulate = 0;
+		/* object storage gets pages of its own, so unlocking them does not unlock anybody else's memory */
+		err_code = ring_buff_mem_alloc_locked(ring_buff_get_storage_size(attr), (void**)&obj);
+		if(err_code != RING_BUFF_ERR_OK)
+		{
+			goto done;
+		}
 	}
 	else
 	{
-		obj->accumulate = attr->accumulate;
+		obj = malloc(ring_buff_get_storage_size(attr));
+		if(obj == NULL)
+		{
+			err_code = RING_BUFF_ERR_NO_MEM;
+			goto done;
+		}
 	}
-	if(attr->wm_cb != NULL)
+	err_code = ring_buff_setup(obj, attr);
+	if(err_code != RING_BUFF_ERR_OK)
 	{
-		if(attr->wm_high > attr->size || attr->wm_low > attr->wm_high)
+		if(attr->realtime)
 		{
-			fprintf(stderr, "WARNING (%s): Watermark is not set properly. It will be turned OFF!\n", __func__);
+			ring_buff_mem_free_locked(obj, ring_buff_get_storage_size(attr));
 		}
 		else
 		{
-			obj->wm_cb = attr->wm_cb;
-			obj->wm_low = attr->wm_low;
-			obj->wm_high = attr->wm_high;
-			obj->last_level = ring_buff_wm_low;
+			free(obj);
 		}
+		obj = NULL;
+		goto done;
+	}
+	obj->allocated = 1;
+	if(attr->size_max)
+	{
+		if(attr->size_max <= attr->size || (obj->accumulate && obj->notify_func) || attr->path != NULL)
+		{
+			fprintf(stderr, "WARNING (%s): Elastic mode is not set properly. It will be turned OFF!\n", __func__);
+		}
+		else
+		{
+			obj->size_max = attr->size_max;
+			obj->shrink_us = attr->shrink_us;
+			obj->base = attr->buff;
+			obj->base_size = attr->size;
+		}
+	}
+	if(attr->spill_path != NULL)
+	{
+		if(ring_buff_mutex_create(&(obj->spill_lock)) != RING_BUFF_ERR_OK ||
+				ring_buff_file_open(&(obj->spill), attr->spill_path) != RING_BUFF_ERR_OK)
+		{
+			ring_buff_destroy(obj);
+			obj = NULL;
+			err_code = RING_BUFF_ERR_INTERNAL;
+			goto done;
+		}
+	}
+	if(attr->path != NULL)
+	{
+		obj->sync_batch = attr->sync_batch;
+		err_code = ring_buff_persist_open(obj, attr->path);
+		if(err_code != RING_BUFF_ERR_OK)
+		{
+			ring_buff_destroy(obj);
+			obj = NULL;
+			goto done;
+		}
+	}
+	if(attr->linger_us && obj->accumulate && obj->notify_func)
+	{
+		if(ring_buff_mutex_create(&(obj->notify_lock)) != RING_BUFF_ERR_OK)
+		{
+			ring_buff_destroy(obj);
+			obj = NULL;
+			err_code = RING_BUFF_ERR_NO_MEM;
+			goto done;
+		}
+		if(ring_buff_timer_create(&(obj->linger_timer), ring_buff_linger_expired, obj) != RING_BUFF_ERR_OK)
+		{
+			ring_buff_destroy(obj);
+			obj = NULL;
+			err_code = RING_BUFF_ERR_INTERNAL;
+			goto done;
+		}
+		obj->linger_us = attr->linger_us;
 	}
-	obj->buff = attr->buff;
-	obj->size = attr->size;
-	obj->notify_func = attr->notify_func;
-	obj->read = attr->buff;
-	obj->write = attr->buff;
-	obj->acc = attr->buff;
-	obj->eod = NULL;
-	obj->acc_size = 0;
-	obj->state = RING_BUFF_STATE_ACTIVE;
-	ring_buff_binary_sem_create(&(obj->read_sem));
-	ring_buff_binary_sem_create(&(obj->write_sem));
 	err_code = RING_BUFF_ERR_OK;
 
 done:
@@ -190,108 +772,422 @@ done:
 	return err_code;
 }
 
-ring_buff_err_t ring_buff_destroy(ring_buff_handle_t handle)
+uint32_t ring_buff_get_storage_size(ring_buff_attr_t* attr)
 {
-	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+	uint32_t freed_max = 0;
+	const ring_buff_osal_ops_t *osal = NULL;
 
-	if(obj == NULL)
+	if(attr == NULL)
 	{
-		return RING_BUFF_ERR_GENERAL;
+		return 0;
 	}
-	ring_buff_mutex_destroy(obj->lock);
-	ring_buff_binary_sem_destroy(obj->read_sem);
-	ring_buff_binary_sem_destroy(obj->write_sem);
-	free(obj);
+	freed_max = attr->free_slots;
+	if(attr->records && freed_max == 0)
+	{
+		freed_max = RING_BUFF_REC_CLAIMS;
+	}
+	osal = ring_buff_get_osal(attr);
 
-	return RING_BUFF_ERR_OK;
+	return RING_BUFF_STORAGE_ROUND(sizeof(ring_buff_obj_t)) + RING_BUFF_STORAGE_ROUND(osal->mutex_size()) +
+			2 * RING_BUFF_STORAGE_ROUND(osal->binary_sem_size()) + freed_max * sizeof(ring_buff_range_t);
 }
 
-ring_buff_err_t ring_buff_reserve(ring_buff_handle_t handle, void** buff, uint32_t size)
+ring_buff_err_t ring_buff_init(ring_buff_attr_t* attr, void* storage, uint32_t storage_size, ring_buff_handle_t* handle)
 {
-	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+	ring_buff_obj_t* obj = NULL;
+	ring_buff_err_t err_code = RING_BUFF_ERR_BAD_ARG;
 
-	if(handle == NULL || buff == NULL)
+	if(attr == NULL || storage == NULL || handle == NULL)
 	{
-		return RING_BUFF_ERR_BAD_ARG;
+		goto done;
 	}
-	if(size > obj->size)
+	if(attr->size == 0 || attr->buff == NULL || ((size_t)storage & (RING_BUFF_STORAGE_ALIGN - 1)) != 0)
 	{
-		return RING_BUFF_ERR_SIZE;
+		goto done;
 	}
-	ENTER_RING_BUFF_CONTEXT(obj);
-	if(ring_buff_check_state(obj, RING_BUFF_STATE_ACTIVE))
+	/* these would need more memory or system resources */
+	if(attr->path != NULL || attr->spill_path != NULL || attr->size_max || attr->linger_us)
 	{
-		LEAVE_RING_BUFF_CONTEXT(obj);
-		return RING_BUFF_ERR_PERM;
+		err_code = RING_BUFF_ERR_PERM;
+		goto done;
 	}
-	/* simple situation, there is enough space left till the end of buffer */
-	if(obj->write + size <= obj->buff + obj->size)
+	if(storage_size < ring_buff_get_storage_size(attr))
 	{
-		/* don't want to overwrite read buffer partition, wait for free chunk if read is too close up-front */
-		while(obj->write < obj->read && obj->write + size >= obj->read)
-		{
-			/* unlock context */
-			LEAVE_RING_BUFF_CONTEXT(obj);
-			/* wait for some free chunk */
-			ring_buff_binary_sem_take(obj->write_sem);
-			ENTER_RING_BUFF_CONTEXT(obj);
-			if(ring_buff_check_state(obj, RING_BUFF_STATE_ACTIVE))
-			{
-				LEAVE_RING_BUFF_CONTEXT(obj);
-				return RING_BUFF_ERR_PERM;
-			}
-		}
-		*buff = obj->write;
-		obj->write += size;
+		err_code = RING_BUFF_ERR_SIZE;
+		goto done;
 	}
-	/* wrap around */
-	else
+	err_code = ring_buff_setup(storage, attr);
+	if(err_code == RING_BUFF_ERR_OK)
 	{
-#ifdef RING_BUFF_DBG_MSG
-		printf("RESERVE: Wrap around %d (%p) RD %p ACC %p WR %p\n", size, obj->buff, obj->read, obj->acc, obj->write);
-#endif
-		/* try to get buffer from the beginning, and be sure that read is not overwritten */
-		while((obj->read - size) < obj->buff || obj->read > obj->write)
+		obj = storage;
+		if(obj->realtime)
 		{
-#ifdef RING_BUFF_DBG_MSG
-			printf("RESERVE: Waiting start free buffer (%d) (%p) RD %p ACC %p WR %p \n", size, obj->buff, obj->read, obj->acc, obj->write);
-#endif
-			LEAVE_RING_BUFF_CONTEXT(obj);
-			ring_buff_binary_sem_take(obj->write_sem);
-			ENTER_RING_BUFF_CONTEXT(obj);
-			if(ring_buff_check_state(obj, RING_BUFF_STATE_ACTIVE))
+			err_code = ring_buff_mem_lock(obj, obj->storage_size);
+			if(err_code != RING_BUFF_ERR_OK)
 			{
-				LEAVE_RING_BUFF_CONTEXT(obj);
-				return RING_BUFF_ERR_PERM;
+				obj->realtime = 0;
+				ring_buff_mem_unlock(obj->buff, obj->size);
+				ring_buff_destroy(obj);
+				obj = NULL;
 			}
 		}
-		/* reader must not exceed data available (current write) */
-		obj->eod = obj->write;
-		*buff = obj->buff;
-		obj->write = obj->buff + size;
 	}
-	LEAVE_RING_BUFF_CONTEXT(obj);
 
-	return RING_BUFF_ERR_OK;
+done:
+	if(handle != NULL)
+	{
+		*handle = obj;
+	}
+	return err_code;
 }
 
-ring_buff_err_t ring_buff_commit(ring_buff_handle_t handle, void* buff, uint32_t size)
+ring_buff_err_t ring_buff_destroy(ring_buff_handle_t handle)
 {
 	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
 
-	if(handle == NULL || buff == NULL)
+	if(obj == NULL)
 	{
-		return RING_BUFF_ERR_BAD_ARG;
+		return RING_BUFF_ERR_GENERAL;
+	}
+	/* timer has to be stopped first, it uses the rest of the object */
+	if(obj->linger_timer != NULL)
+	{
+		ring_buff_timer_destroy(obj->linger_timer);
+	}
+	if(obj->notify_lock != NULL)
+	{
+		ring_buff_mutex_destroy(obj->notify_lock);
+	}
+	if(obj->file != NULL)
+	{
+		ring_buff_persist_sync(obj);
+		ring_buff_file_unmap(obj->file);
+	}
+	if(obj->sync_lock != NULL)
+	{
+		ring_buff_mutex_destroy(obj->sync_lock);
+	}
+	if(obj->spill != NULL)
+	{
+		ring_buff_file_truncate(obj->spill, 0);
+		ring_buff_file_close(obj->spill);
+	}
+	if(obj->spill_lock != NULL)
+	{
+		ring_buff_mutex_destroy(obj->spill_lock);
+	}
+	/* lock, semaphores and completion tracker are in the object storage */
+	if(obj->osal == NULL)
+	{
+		ring_buff_mutex_deinit(obj->lock);
+		ring_buff_binary_sem_deinit(obj->read_sem);
+		ring_buff_binary_sem_deinit(obj->write_sem);
+	}
+	else
+	{
+		obj->osal->mutex_deinit(obj->lock);
+		obj->osal->binary_sem_deinit(obj->read_sem);
+		obj->osal->binary_sem_deinit(obj->write_sem);
+	}
+	/* memory of the grown buffer */
+	if(obj->size_max)
+	{
+		if(obj->old != NULL && obj->old != obj->base)
+		{
+			free(obj->old);
+		}
+		if(obj->buff != obj->base)
+		{
+			free(obj->buff);
+		}
+	}
+	if(obj->realtime)
+	{
+		ring_buff_mem_unlock(obj->buff, obj->size);
+	}
+	if(obj->allocated && obj->realtime)
+	{
+		ring_buff_mem_free_locked(obj, obj->storage_size);
+	}
+	else if(obj->allocated)
+	{
+		free(obj);
+	}
+	else if(obj->realtime)
+	{
+		ring_buff_mem_unlock(obj, obj->storage_size);
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_reserve(ring_buff_handle_t handle, void** buff, uint32_t size)
+{
+	return ring_buff_reserve_aligned(handle, buff, size, 0);
+}
+
+ring_buff_err_t ring_buff_reserve_aligned(ring_buff_handle_t handle, void** buff, uint32_t size, uint32_t align)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+
+	if(handle == NULL || buff == NULL || (align & (align - 1)) != 0)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	if(align == 0)
+	{
+		align = obj->align;
+	}
+	/* records, spilled records and moved data can not carry the padding */
+	else if(align > 1 && (obj->records || obj->size_max))
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+	if(align > 1 && size + RING_BUFF_PAD(obj->buff, align) > obj->size)
+	{
+		return RING_BUFF_ERR_SIZE;
+	}
+	if(RING_BUFF_ST(obj))
+	{
+		return ring_buff_reserve_chunk(obj, buff, size, align, 0);
+	}
+
+	return ring_buff_reserve_chunk(obj, buff, size, align, 1);
+}
+
+static ring_buff_err_t ring_buff_reserve_chunk(ring_buff_obj_t* obj, void** buff, uint32_t size, uint32_t align, uint8_t locked)
+{
+	uint32_t data_size = size;
+	uint32_t pad = 0;
+	uint8_t* write = NULL;
+	ring_buff_rec_hdr_t* rec = NULL;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	/* record is preceded by its header */
+	if(obj->records)
+	{
+		if(size > obj->size)
+		{
+			return RING_BUFF_ERR_SIZE;
+		}
+		size = RING_BUFF_REC_SIZE(obj, size);
+	}
+	if(size > obj->size)
+	{
+		return RING_BUFF_ERR_SIZE;
+	}
+	if(locked)
+	{
+		ENTER_RING_BUFF_CONTEXT(obj);
+	}
+	if(ring_buff_check_state(obj, RING_BUFF_STATE_ACTIVE))
+	{
+		if(locked)
+		{
+			LEAVE_RING_BUFF_CONTEXT(obj);
+		}
+		return RING_BUFF_ERR_PERM;
+	}
+	/* consumers are behind, records go to the spill file until they catch up */
+	if(obj->spill != NULL && ring_buff_spill_active(obj))
+	{
+		goto spill;
+	}
+	/* grown buffer that is empty may shrink right away (idle writer may not get to wrap around for a long time) */
+	if(obj->size_max && obj->size > obj->base_size && obj->read == obj->write)
+	{
+		ring_buff_elastic_resize(obj, size);
+	}
+retry:
+	/* write position seen before waiting (other producer may reserve meanwhile) */
+	write = obj->write;
+	pad = RING_BUFF_PAD(obj->write, align);
+	/* simple situation, there is enough space left till the end of buffer */
+	if(obj->write + pad + size <= obj->buff + obj->size)
+	{
+		/* don't want to overwrite read buffer partition, wait for free chunk if read is too close up-front */
+		while(obj->write < RING_BUFF_WRITE_LIMIT(obj) && obj->write + pad + size >= RING_BUFF_WRITE_LIMIT(obj))
+		{
+			/* single-threaded buffer: nobody else can free the space meanwhile */
+			if(!locked)
+			{
+				return RING_BUFF_ERR_WOULD_BLOCK;
+			}
+			/* wait for some free chunk */
+			err = ring_buff_wait_write(obj);
+			if(err == RING_BUFF_ERR_WOULD_BLOCK)
+			{
+				goto spill;
+			}
+			if(err != RING_BUFF_ERR_OK)
+			{
+				LEAVE_RING_BUFF_CONTEXT(obj);
+				return err;
+			}
+			if(obj->write != write)
+			{
+				goto retry;
+			}
+		}
+		*buff = obj->write + pad;
+		obj->write += pad + size;
+	}
+	/* wrap around */
+	else
+	{
+#ifdef RING_BUFF_DBG_MSG
+		printf("RESERVE: Wrap around %d (%p) RD %p ACC %p WR %p\n", size, obj->buff, obj->read, obj->acc, obj->write);
+#endif
+		/* buffer is resized when the writer wraps around, so nothing has to be moved */
+		if(obj->size_max && ring_buff_elastic_resize(obj, size))
+		{
+			*buff = obj->write;
+			obj->write += size;
+			goto reserved;
+		}
+		/* empty buffer starts over, read position must not stay behind */
+		if(ring_buff_rewind(obj))
+		{
+			goto retry;
+		}
+		pad = RING_BUFF_PAD(obj->buff, align);
+		/* try to get buffer from the beginning, and be sure that read is not overwritten.
+		 * Write must stay behind read, otherwise full buffer would look like an empty one. */
+		while((RING_BUFF_WRITE_LIMIT(obj) - pad - size) <= obj->buff || RING_BUFF_WRITE_LIMIT(obj) > obj->write)
+		{
+#ifdef RING_BUFF_DBG_MSG
+			printf("RESERVE: Waiting start free buffer (%d) (%p) RD %p ACC %p WR %p \n", size, obj->buff, obj->read, obj->acc, obj->write);
+#endif
+			if(!locked)
+			{
+				return RING_BUFF_ERR_WOULD_BLOCK;
+			}
+			err = ring_buff_wait_write(obj);
+			if(err == RING_BUFF_ERR_WOULD_BLOCK)
+			{
+				goto spill;
+			}
+			if(err != RING_BUFF_ERR_OK)
+			{
+				LEAVE_RING_BUFF_CONTEXT(obj);
+				return err;
+			}
+			if(obj->write != write)
+			{
+				goto retry;
+			}
+		}
+		/* reader must not exceed data available (current write) */
+		obj->eod = obj->write;
+		obj->free_eod = obj->write;
+		*buff = obj->buff + pad;
+		obj->write = obj->buff + pad + size;
+	}
+	if(align > 1)
+	{
+		obj->aligned = 1;
+		if(pad)
+		{
+			ring_buff_add_pad(obj, (uint8_t*)*buff - pad, pad);
+		}
+	}
+reserved:
+	/* header has to be valid before the context is left, commit of other producer may already look at it */
+	if(obj->records)
+	{
+		((ring_buff_rec_hdr_t*)*buff)->size = data_size;
+		((ring_buff_rec_hdr_t*)*buff)->flags = 0;
+		if(obj->file != NULL)
+		{
+			((ring_buff_persist_rec_hdr_t*)*buff)->seq = (uint32_t)obj->seq;
+		}
+		obj->seq++;
+		*buff = (uint8_t*)*buff + obj->rec_hdr;
+	}
+	if(locked)
+	{
+		/* semaphore is binary, pass the wake up to the other producer (there may be more space) */
+		if(obj->write_waiters)
+		{
+			RING_BUFF_SEM_GIVE(obj, obj->write_sem);
+		}
+		LEAVE_RING_BUFF_CONTEXT(obj);
+	}
+
+	return RING_BUFF_ERR_OK;
+
+spill:
+	obj->spill_pending++;
+	/* other producers that wait for the room should spill as well */
+	if(obj->write_waiters)
+	{
+		RING_BUFF_SEM_GIVE(obj, obj->write_sem);
+	}
+	LEAVE_RING_BUFF_CONTEXT(obj);
+	rec = malloc(RING_BUFF_REC_ALIGN + data_size);
+	if(rec == NULL)
+	{
+		ENTER_RING_BUFF_CONTEXT(obj);
+		obj->spill_pending--;
+		LEAVE_RING_BUFF_CONTEXT(obj);
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	rec->size = data_size;
+	rec->flags = RING_BUFF_REC_SPILLED;
+	*buff = (uint8_t*)rec + RING_BUFF_REC_ALIGN;
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_commit(ring_buff_handle_t handle, void* buff, uint32_t size)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+	ring_buff_persist_rec_hdr_t* rec = NULL;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	uint8_t sync_needed = 0;
+
+	if(handle == NULL || buff == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	if(RING_BUFF_ST(obj))
+	{
+		return ring_buff_commit_st(obj, buff, size);
+	}
+	if(obj->spill != NULL && (((ring_buff_rec_hdr_t*)((uint8_t*)buff - RING_BUFF_REC_ALIGN))->flags & RING_BUFF_REC_SPILLED))
+	{
+		return ring_buff_spill_commit(obj, (ring_buff_rec_hdr_t*)((uint8_t*)buff - RING_BUFF_REC_ALIGN));
+	}
+	/* record is owned by the producer until it is marked as committed, so checksum is calculated out of context */
+	if(obj->file != NULL)
+	{
+		rec = (ring_buff_persist_rec_hdr_t*)((uint8_t*)buff - obj->rec_hdr);
+		rec->crc = ring_buff_crc32(rec->seq, buff, rec->hdr.size);
 	}
 
+	/* linger timer must not notify data between the commit and its accumulation handling */
+	if(obj->linger_us)
+	{
+		ring_buff_mutex_lock(obj->notify_lock);
+	}
 	ENTER_RING_BUFF_CONTEXT(obj);
+	/* records may be committed out of order (several producers), only committed prefix is readable */
+	if(obj->records)
+	{
+		((ring_buff_rec_hdr_t*)((uint8_t*)buff - obj->rec_hdr))->flags |= RING_BUFF_REC_COMMITTED;
+		size = ring_buff_commit_rec(obj);
+		/* group commit, the first producer that gets to sync takes the records of the others as well */
+		sync_needed = obj->sync_batch && obj->commit_seq - obj->sync_seq >= obj->sync_batch;
+	}
 	obj->acc_size += size;
 	/* Sanity check. This may be removed. */
 	if(obj->acc_size > obj->size)
 	{
 		LEAVE_RING_BUFF_CONTEXT(obj);
-		return RING_BUFF_ERR_SIZE;
+		err = RING_BUFF_ERR_SIZE;
+		goto done;
 	}
+	RING_BUFF_EVENT(obj, RING_BUFF_EVENT_READ);
 	LEAVE_RING_BUFF_CONTEXT(obj);
 	if(obj->wm_cb != NULL)
 	{
@@ -300,15 +1196,24 @@ ring_buff_err_t ring_buff_commit(ring_buff_handle_t handle, void* buff, uint32_t
 	/* in case of accumulation, leave buffer context and notify listener */
 	if(obj->accumulate && obj->notify_func)
 	{
-		return ring_buff_handle_acc(obj, size);
+		err = ring_buff_handle_acc(obj, buff, size);
 	}
 	/* Read functionality may be used only if we don't accumulate data */
 	else
 	{
-		ring_buff_binary_sem_give(obj->read_sem);
+		RING_BUFF_SEM_GIVE(obj, obj->read_sem);
+	}
+	if(sync_needed)
+	{
+		err = ring_buff_persist_sync(obj);
 	}
 
-	return RING_BUFF_ERR_OK;
+done:
+	if(obj->linger_us)
+	{
+		ring_buff_mutex_unlock(obj->notify_lock);
+	}
+	return err;
 }
 
 ring_buff_err_t ring_buff_free(ring_buff_handle_t handle, void* buff, uint32_t size)
@@ -319,10 +1224,47 @@ ring_buff_err_t ring_buff_free(ring_buff_handle_t handle, void* buff, uint32_t s
 	{
 		return RING_BUFF_ERR_BAD_ARG;
 	}
+	if(RING_BUFF_ST(obj))
+	{
+		return ring_buff_free_st(obj, buff, size);
+	}
+	if(obj->records)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
 	ENTER_RING_BUFF_CONTEXT(obj);
-	/* Free will just update read pointer. It is up to the user to call it in proper order. */
-	obj->read = (uint8_t*)buff + size;
-	ring_buff_binary_sem_give(obj->write_sem);
+	if(obj->freed_max)
+	{
+		if(ring_buff_free_tracked(obj, buff, size) != RING_BUFF_ERR_OK)
+		{
+			LEAVE_RING_BUFF_CONTEXT(obj);
+			return RING_BUFF_ERR_OVERRUN;
+		}
+	}
+	else
+	{
+		/* Free will just update read pointer. It is up to the user to call it in proper order. */
+		if(obj->pad_free != NULL)
+		{
+			ring_buff_pass_pads(obj, &(obj->pad_free), obj->read, buff);
+		}
+		if((uint8_t*)buff == obj->buff || (obj->free_eod != NULL && (uint8_t*)buff < obj->read))
+		{
+			/* read position follows the writer's wrap */
+			obj->free_eod = NULL;
+		}
+		obj->read = (uint8_t*)buff + size;
+	}
+	if(obj->old != NULL)
+	{
+		ring_buff_elastic_drained(obj);
+	}
+	if(obj->reclaim_us)
+	{
+		ring_buff_reclaim_idle(obj, 0);
+	}
+	RING_BUFF_SEM_GIVE(obj, obj->write_sem);
+	RING_BUFF_EVENT(obj, RING_BUFF_EVENT_WRITE);
 	LEAVE_RING_BUFF_CONTEXT(obj);
 	if(obj->wm_cb != NULL)
 	{
@@ -335,21 +1277,48 @@ ring_buff_err_t ring_buff_free(ring_buff_handle_t handle, void* buff, uint32_t s
 ring_buff_err_t ring_buff_read(ring_buff_handle_t handle, void** buff, uint32_t size, uint32_t *read)
 {
 	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
-	ring_buff_err_t err = RING_BUFF_ERR_OK;
 
 	if(handle == NULL || buff == NULL || size > obj->size || read == NULL)
 	{
 		return RING_BUFF_ERR_BAD_ARG;
 	}
-	ENTER_RING_BUFF_CONTEXT(obj);
+	if(obj->records)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+	if(RING_BUFF_ST(obj))
+	{
+		return ring_buff_read_data(obj, buff, size, read, 0);
+	}
+
+	return ring_buff_read_data(obj, buff, size, read, 1);
+}
+
+static ring_buff_err_t ring_buff_read_data(ring_buff_obj_t* obj, void** buff, uint32_t size, uint32_t *read, uint8_t locked)
+{
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	if(locked)
+	{
+		ENTER_RING_BUFF_CONTEXT(obj);
+	}
+	else if(obj->state == RING_BUFF_STATE_CANCELED)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
 	/* make sure that we have enough data available */
 	while(size > obj->acc_size && obj->state != RING_BUFF_STATE_STOPPED)
 	{
+		/* single-threaded buffer: nobody else can commit the data meanwhile */
+		if(!locked)
+		{
+			return RING_BUFF_ERR_WOULD_BLOCK;
+		}
 #ifdef RING_BUFF_DBG_MSG
 		printf("READ: Waiting read buffer for %u ACC: %d\n", size, obj->acc_size);
 #endif
 		LEAVE_RING_BUFF_CONTEXT(obj);
-		ring_buff_binary_sem_take(obj->read_sem);
+		RING_BUFF_SEM_TAKE(obj, obj->read_sem);
 		ENTER_RING_BUFF_CONTEXT(obj);
 		/* We can read, even if buffer has been stopped */
 		if(ring_buff_check_state(obj, RING_BUFF_STATE_ACTIVE | RING_BUFF_STATE_STOPPED))
@@ -358,6 +1327,15 @@ ring_buff_err_t ring_buff_read(ring_buff_handle_t handle, void** buff, uint32_t
 			return RING_BUFF_ERR_PERM;
 		}
 	}
+	/* padding is not data, give as much as there is in front of it */
+	if(obj->pad_acc != NULL)
+	{
+		ring_buff_skip_pads(obj);
+		if(obj->pad_acc != NULL && obj->pad_acc >= obj->acc && obj->acc + size > obj->pad_acc)
+		{
+			size = obj->pad_acc - obj->acc;
+		}
+	}
 	*buff = obj->acc;
 	/* If writer wrapped, and we don't have enough data at the end, give as much as we can */
 	if(obj->eod != NULL && (obj->acc + size > obj->eod))
@@ -366,6 +1344,12 @@ ring_buff_err_t ring_buff_read(ring_buff_handle_t handle, void** buff, uint32_t
 		/* just a wrap (no data) available -> wrap right away and give requested size */
 		if(*read == 0)
 		{
+			/* stopped buffer gives only what is left */
+			if(obj->state == RING_BUFF_STATE_STOPPED && size > obj->acc_size)
+			{
+				size = obj->acc_size;
+				err = RING_BUFF_ERR_PERM;
+			}
 			*read = size;
 			*buff = obj->buff;
 			obj->acc = obj->buff + *read;
@@ -395,61 +1379,161 @@ ring_buff_err_t ring_buff_read(ring_buff_handle_t handle, void** buff, uint32_t
 		obj->acc += size;
 		*read = size;
 	}
-	LEAVE_RING_BUFF_CONTEXT(obj);
+	if(locked)
+	{
+		LEAVE_RING_BUFF_CONTEXT(obj);
+	}
 
 	return err;
 }
 
-ring_buff_err_t ring_buff_flush(ring_buff_handle_t handle)
+ring_buff_err_t ring_buff_claim(ring_buff_handle_t handle, void** buff, uint32_t *size)
 {
 	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
 
-	if(handle == NULL)
+	if(handle == NULL || buff == NULL || size == NULL)
 	{
 		return RING_BUFF_ERR_BAD_ARG;
 	}
-	/* cannot be used if accumulation is not set */
-	if(!obj->accumulate && !obj->notify_func)
-	{
-		return RING_BUFF_ERR_GENERAL;
-	}
-	/* on commit, wrap around is handled, so just send what is left */
-	if(obj->acc_size != 0 && obj->accumulate && obj->notify_func)
+	if(!obj->records)
 	{
-		return obj->notify_func(obj, obj->acc, obj->acc_size);
+		return RING_BUFF_ERR_PERM;
 	}
 
-	return RING_BUFF_ERR_OK;
+	return ring_buff_claim_rec(obj, buff, size, 1);
 }
 
-ring_buff_err_t ring_buff_cancel(ring_buff_handle_t handle)
+ring_buff_err_t ring_buff_try_claim(ring_buff_handle_t handle, void** buff, uint32_t *size)
 {
 	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
 
-	if(obj == NULL)
+	if(handle == NULL || buff == NULL || size == NULL)
 	{
 		return RING_BUFF_ERR_BAD_ARG;
 	}
-	ENTER_RING_BUFF_CONTEXT(obj);
-	obj->state = RING_BUFF_STATE_CANCELED;
-	ring_buff_binary_sem_give(obj->read_sem);
-	ring_buff_binary_sem_give(obj->write_sem);
-	LEAVE_RING_BUFF_CONTEXT(obj);
-	return RING_BUFF_ERR_OK;
+	if(!obj->records)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+
+	return ring_buff_claim_rec(obj, buff, size, 0);
 }
 
-ring_buff_err_t ring_buff_stop(ring_buff_handle_t handle)
+ring_buff_err_t ring_buff_release(ring_buff_handle_t handle, void* buff)
 {
 	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+	uint8_t* rec = NULL;
 
-	if(obj == NULL)
+	if(handle == NULL || buff == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	if(!obj->records)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+	rec = (uint8_t*)buff - obj->rec_hdr;
+	/* spilled record is in the heap */
+	if(((ring_buff_rec_hdr_t*)rec)->flags & RING_BUFF_REC_SPILLED)
+	{
+		free(rec);
+		return RING_BUFF_ERR_OK;
+	}
+	ENTER_RING_BUFF_CONTEXT(obj);
+	/* cannot fail, number of claimed records is limited by the completion tracker size */
+	if(ring_buff_free_tracked(obj, rec, RING_BUFF_REC_SIZE(obj, ((ring_buff_rec_hdr_t*)rec)->size)) != RING_BUFF_ERR_OK)
+	{
+		LEAVE_RING_BUFF_CONTEXT(obj);
+		return RING_BUFF_ERR_OVERRUN;
+	}
+	if(obj->old != NULL)
+	{
+		ring_buff_elastic_drained(obj);
+	}
+	if(obj->reclaim_us)
+	{
+		ring_buff_reclaim_idle(obj, 0);
+	}
+	RING_BUFF_SEM_GIVE(obj, obj->write_sem);
+	/* consumer may wait for the claimed records to be reclaimed */
+	RING_BUFF_SEM_GIVE(obj, obj->read_sem);
+	RING_BUFF_EVENT(obj, RING_BUFF_EVENT_WRITE);
+	LEAVE_RING_BUFF_CONTEXT(obj);
+	if(obj->wm_cb != NULL)
+	{
+		return ring_buff_handle_wm(obj);
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_sync(ring_buff_handle_t handle)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	if(obj->file == NULL)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+
+	return ring_buff_persist_sync(obj);
+}
+
+ring_buff_err_t ring_buff_flush(ring_buff_handle_t handle)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+
+	if(handle == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	/* cannot be used if accumulation is not set */
+	if(!obj->accumulate && !obj->notify_func)
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	if(!obj->accumulate || !obj->notify_func)
+	{
+		return RING_BUFF_ERR_OK;
+	}
+
+	return ring_buff_flush_acc(obj, 1);
+}
+
+ring_buff_err_t ring_buff_cancel(ring_buff_handle_t handle)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ENTER_RING_BUFF_CONTEXT(obj);
+	obj->state = RING_BUFF_STATE_CANCELED;
+	RING_BUFF_SEM_GIVE(obj, obj->read_sem);
+	RING_BUFF_SEM_GIVE(obj, obj->write_sem);
+	RING_BUFF_EVENT(obj, RING_BUFF_EVENT_READ | RING_BUFF_EVENT_WRITE);
+	LEAVE_RING_BUFF_CONTEXT(obj);
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_stop(ring_buff_handle_t handle)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+
+	if(obj == NULL)
 	{
 		return RING_BUFF_ERR_BAD_ARG;
 	}
 	ENTER_RING_BUFF_CONTEXT(obj);
 	obj->state = RING_BUFF_STATE_STOPPED;
-	ring_buff_binary_sem_give(obj->read_sem);
-	ring_buff_binary_sem_give(obj->write_sem);
+	RING_BUFF_SEM_GIVE(obj, obj->read_sem);
+	RING_BUFF_SEM_GIVE(obj, obj->write_sem);
+	RING_BUFF_EVENT(obj, RING_BUFF_EVENT_READ | RING_BUFF_EVENT_WRITE);
 	LEAVE_RING_BUFF_CONTEXT(obj);
 	return RING_BUFF_ERR_OK;
 }
@@ -463,18 +1547,188 @@ ring_buff_err_t ring_buff_resume(ring_buff_handle_t handle)
 		return RING_BUFF_ERR_BAD_ARG;
 	}
 	ENTER_RING_BUFF_CONTEXT(obj);
+	/* data is dropped, and so is the memory that was not drained */
+	if(obj->old != NULL)
+	{
+		if(obj->old != obj->base)
+		{
+			free(obj->old);
+		}
+		obj->old = NULL;
+	}
 	obj->read = obj->buff;
 	obj->write = obj->buff;
 	obj->acc = obj->buff;
 	obj->eod = NULL;
 	obj->acc_size = 0;
+	obj->acc_start = 0;
+	obj->acc_notify_time = 0;
+	obj->freed_count = 0;
+	obj->freed_first = 0;
+	obj->free_eod = NULL;
+	obj->pad_acc = NULL;
+	obj->pad_free = NULL;
+	obj->claimed = 0;
+	obj->reclaimed = 0;
+	obj->commit = obj->buff;
+	obj->commit_seq = obj->seq;
+	obj->read_seq = obj->seq;
 	obj->last_level = ring_buff_wm_low;
 	obj->state = RING_BUFF_STATE_ACTIVE;
+	if(obj->spill != NULL)
+	{
+		obj->spilling = 0;
+		obj->spill_count = 0;
+		obj->spill_read = 0;
+		obj->spill_write = 0;
+		ring_buff_file_truncate(obj->spill, 0);
+	}
+	/* records are dropped in the file as well (sequence numbers go on, so old records are not valid anymore) */
+	if(obj->file != NULL)
+	{
+		obj->phdr->read = 0;
+		obj->phdr->read_seq = obj->seq;
+		obj->phdr->commit_seq = obj->seq;
+		ring_buff_file_sync(obj->file, obj->phdr, sizeof(ring_buff_persist_hdr_t));
+		obj->sync_seq = obj->seq;
+		obj->sync_read = obj->buff;
+		obj->sync_commit = obj->buff;
+	}
+	RING_BUFF_EVENT(obj, RING_BUFF_EVENT_WRITE);
+	LEAVE_RING_BUFF_CONTEXT(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_get_accumulate(ring_buff_handle_t handle, uint32_t *accumulate)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+
+	if(obj == NULL || accumulate == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ENTER_RING_BUFF_CONTEXT(obj);
+	*accumulate = obj->accumulate;
+	LEAVE_RING_BUFF_CONTEXT(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_set_event_cb(ring_buff_handle_t handle, ring_buff_event_cb_t cb, void* arg)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	/* events are signaled only by the locked functions */
+	if(RING_BUFF_ST(obj) && cb != NULL)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+	/* callback is called only with buffer context acquired, so it is not running once we get it */
+	ENTER_RING_BUFF_CONTEXT(obj);
+	if(cb != NULL && obj->event_cb != NULL)
+	{
+		LEAVE_RING_BUFF_CONTEXT(obj);
+		return RING_BUFF_ERR_PERM;
+	}
+	obj->event_cb = cb;
+	obj->event_arg = arg;
+	LEAVE_RING_BUFF_CONTEXT(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_get_size(ring_buff_handle_t handle, uint32_t *size)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+
+	if(obj == NULL || size == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ENTER_RING_BUFF_CONTEXT(obj);
+	*size = obj->size;
+	LEAVE_RING_BUFF_CONTEXT(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_reclaim(ring_buff_handle_t handle, uint32_t *released)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+	uint32_t size = 0;
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	if(!obj->reclaim_us)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+	ENTER_RING_BUFF_CONTEXT(obj);
+	size = ring_buff_reclaim_idle(obj, 1);
 	LEAVE_RING_BUFF_CONTEXT(obj);
+	if(released != NULL)
+	{
+		*released = size;
+	}
 
 	return RING_BUFF_ERR_OK;
 }
 
+uint32_t ring_buff_get_events(ring_buff_handle_t handle)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+	uint32_t events = 0;
+
+	if(obj == NULL)
+	{
+		return 0;
+	}
+	ENTER_RING_BUFF_CONTEXT(obj);
+	if(obj->state != RING_BUFF_STATE_ACTIVE)
+	{
+		events = RING_BUFF_EVENT_READ | RING_BUFF_EVENT_WRITE;
+	}
+	else
+	{
+		if(obj->acc_size != 0 || (obj->spill_count != 0 && obj->commit == obj->write))
+		{
+			events |= RING_BUFF_EVENT_READ;
+		}
+		/* at least one byte can be reserved (same conditions as in reserve) */
+		if(obj->write < obj->read ? (obj->read - obj->write > 1) :
+				(obj->write < obj->buff + obj->size || obj->read - obj->buff > 1 || obj->read == obj->write))
+		{
+			events |= RING_BUFF_EVENT_WRITE;
+		}
+	}
+	LEAVE_RING_BUFF_CONTEXT(obj);
+
+	return events;
+}
+
+uint32_t ring_buff_get_queued(ring_buff_handle_t handle)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(handle);
+	uint32_t queued = 0;
+
+	if(obj == NULL)
+	{
+		return 0;
+	}
+	ENTER_RING_BUFF_CONTEXT(obj);
+	queued = obj->acc_size;
+	LEAVE_RING_BUFF_CONTEXT(obj);
+
+	return queued;
+}
+
 void ring_buff_print_err(ring_buff_err_t err)
 {
 	switch(err)
@@ -497,6 +1751,9 @@ void ring_buff_print_err(ring_buff_err_t err)
 	case RING_BUFF_ERR_PERM:
 		fprintf(stderr, "Operation not permited.\n");
 		break;
+	case RING_BUFF_ERR_WOULD_BLOCK:
+		fprintf(stderr, "Operation would block.\n");
+		break;
 	default:
 		fprintf(stderr, "Unknown error code: %d.\n", err);
 		break;
@@ -504,67 +1761,1190 @@ void ring_buff_print_err(ring_buff_err_t err)
 }
 
 
-static ring_buff_err_t ring_buff_check_state(ring_buff_obj_t* obj, ring_buff_state_t states)
+static const ring_buff_osal_ops_t* ring_buff_get_osal(ring_buff_attr_t* attr)
 {
-	if((obj->state & states) == 0)
+	if(attr->osal != NULL)
 	{
-		return RING_BUFF_ERR_PERM;
+		return attr->osal;
 	}
-
-	return RING_BUFF_ERR_OK;
+	return attr->realtime ? &ring_buff_osal_pi : &ring_buff_osal_posix;
 }
 
-
-static ring_buff_err_t ring_buff_handle_acc(ring_buff_obj_t* obj, uint32_t added_size)
+static ring_buff_err_t ring_buff_setup(ring_buff_obj_t* obj, ring_buff_attr_t* attr)
 {
-	void* buff = NULL;
-	uint32_t size;
+	uint8_t* mem = (uint8_t*)obj + RING_BUFF_STORAGE_ROUND(sizeof(ring_buff_obj_t));
+#ifdef RING_BUFF_SINGLE_THREADED
+	uint8_t single_thread = 1;
+#else
+	uint8_t single_thread = attr->single_thread;
+#endif
+	const ring_buff_osal_ops_t *osal = NULL;
 
-	ENTER_RING_BUFF_CONTEXT(obj);
-	/* send notification if there is enough data accumulated,
-	 * or we got to the end of the buffer */
-	if(obj->acc + obj->acc_size > obj->buff + obj->size)
+	/* these need other threads (consumers, timer) or locks of their own */
+	if(single_thread && (attr->records || attr->path != NULL || attr->spill_path != NULL || attr->size_max || attr->linger_us))
 	{
-		size = obj->acc_size - added_size;
-		buff = obj->acc;
-		obj->acc_size = added_size;
-
-		obj->acc = obj->buff;
+		return RING_BUFF_ERR_BAD_ARG;
 	}
-	else if(obj->acc_size >= obj->accumulate)
+	/* these do I/O, allocate, or wake up a timer on the data path */
+	if(attr->realtime && (attr->path != NULL || attr->spill_path != NULL || attr->size_max || attr->linger_us))
 	{
-		size = obj->acc_size - added_size;
-		buff = obj->acc;
-		obj->acc_size = added_size;
-		obj->acc += size;
+		return RING_BUFF_ERR_BAD_ARG;
 	}
-	/* callback is executed out of ring buffer context */
-	LEAVE_RING_BUFF_CONTEXT(obj);
-	if(buff)
+	/* records, spilled records and moved data can not carry the padding */
+	if((attr->align & (attr->align - 1)) != 0 ||
+			(attr->align > 1 && (attr->records || attr->path != NULL || attr->spill_path != NULL || attr->size_max)))
 	{
-		return obj->notify_func(obj, buff, size);
+		return RING_BUFF_ERR_BAD_ARG;
 	}
-
-	return RING_BUFF_ERR_OK;
-}
-
-static ring_buff_err_t ring_buff_handle_wm(ring_buff_obj_t* obj)
-{
-	uint8_t notify = 0;
-
-	ENTER_RING_BUFF_CONTEXT(obj);
-	if((obj->acc_size > obj->wm_high) && obj->last_level == ring_buff_wm_low)
+	memset(obj, 0, ring_buff_get_storage_size(attr));
+	obj->single_thread = single_thread;
+	/* lock and semaphores follow the object, completion tracker is at the end */
+	osal = ring_buff_get_osal(attr);
+	if(osal->mutex_init(mem, &(obj->lock)) != RING_BUFF_ERR_OK)
 	{
-		obj->last_level = ring_buff_wm_high;
-		notify = 1;
+		return RING_BUFF_ERR_INTERNAL;
 	}
-	else if((obj->acc_size < obj->wm_low) && obj->last_level == ring_buff_wm_high)
+	mem += RING_BUFF_STORAGE_ROUND(osal->mutex_size());
+	if(osal->binary_sem_init(mem, &(obj->read_sem)) != RING_BUFF_ERR_OK)
 	{
-		obj->last_level = ring_buff_wm_low;
-		notify = 1;
+		osal->mutex_deinit(obj->lock);
+		return RING_BUFF_ERR_INTERNAL;
 	}
-	LEAVE_RING_BUFF_CONTEXT(obj);
-	if(notify != 0)
+	mem += RING_BUFF_STORAGE_ROUND(osal->binary_sem_size());
+	if(osal->binary_sem_init(mem, &(obj->write_sem)) != RING_BUFF_ERR_OK)
+	{
+		osal->binary_sem_deinit(obj->read_sem);
+		osal->mutex_deinit(obj->lock);
+		return RING_BUFF_ERR_INTERNAL;
+	}
+	mem += RING_BUFF_STORAGE_ROUND(osal->binary_sem_size());
+	obj->osal = (osal != &ring_buff_osal_posix) ? osal : NULL;
+	if(attr->accumulate > (attr->size / 2))
+	{
+		fprintf(stderr, "WARNING (%s): Accumulation set too high. It will be turned OFF!\n", __func__);
+		obj->accumulate = 0;
+	}
+	else
+	{
+		obj->accumulate = attr->accumulate;
+	}
+	if(attr->acc_target_us && attr->notify_func)
+	{
+		obj->acc_min = attr->acc_min ? attr->acc_min : 1;
+		obj->acc_max = attr->acc_max;
+		if(obj->acc_max > (attr->size / 2) || obj->acc_max < obj->acc_min)
+		{
+			fprintf(stderr, "WARNING (%s): Accumulation bounds set wrong. Maximum will be half of the buffer!\n", __func__);
+			obj->acc_max = attr->size / 2;
+		}
+		if(obj->accumulate < obj->acc_min)
+		{
+			obj->accumulate = obj->acc_min;
+		}
+		else if(obj->accumulate > obj->acc_max)
+		{
+			obj->accumulate = obj->acc_max;
+		}
+		if(obj->acc_min <= obj->acc_max)
+		{
+			obj->acc_target_us = attr->acc_target_us;
+		}
+	}
+	if(attr->wm_cb != NULL || attr->spill_path != NULL || attr->size_max || attr->reclaim_us)
+	{
+		if(attr->wm_high > attr->size || attr->wm_low > attr->wm_high)
+		{
+			fprintf(stderr, "WARNING (%s): Watermark is not set properly. It will be turned OFF!\n", __func__);
+		}
+		else
+		{
+			obj->wm_cb = attr->wm_cb;
+			obj->wm_low = attr->wm_low;
+			obj->wm_high = attr->wm_high;
+			obj->last_level = ring_buff_wm_low;
+		}
+	}
+	obj->buff = attr->buff;
+	obj->size = attr->size;
+	obj->align = attr->align > 1 ? attr->align : 1;
+	obj->notify_func = attr->notify_func;
+	obj->read = attr->buff;
+	obj->write = attr->buff;
+	obj->acc = attr->buff;
+	obj->commit = attr->buff;
+	obj->state = RING_BUFF_STATE_ACTIVE;
+	/* file mapping pages are not dropped (they hold the data that is recovered) */
+	if(attr->reclaim_us && attr->path == NULL && !attr->realtime && attr->wm_low <= attr->wm_high && attr->wm_high <= attr->size)
+	{
+		obj->reclaim_us = attr->reclaim_us;
+		obj->reclaim_write = attr->buff;
+	}
+	if(attr->records)
+	{
+		if(obj->accumulate)
+		{
+			fprintf(stderr, "WARNING (%s): Accumulation can not be used in record mode. It will be turned OFF!\n", __func__);
+			obj->accumulate = 0;
+			obj->acc_target_us = 0;
+		}
+		obj->records = 1;
+		obj->rec_hdr = (attr->path != NULL) ? sizeof(ring_buff_persist_rec_hdr_t) : RING_BUFF_REC_ALIGN;
+		obj->freed_max = attr->free_slots ? attr->free_slots : RING_BUFF_REC_CLAIMS;
+	}
+	else
+	{
+		obj->freed_max = attr->free_slots;
+	}
+	if(obj->freed_max)
+	{
+		obj->freed = (ring_buff_range_t*)mem;
+	}
+	if(attr->realtime)
+	{
+		if(ring_buff_mem_lock(attr->buff, attr->size) != RING_BUFF_ERR_OK)
+		{
+			osal->binary_sem_deinit(obj->write_sem);
+			osal->binary_sem_deinit(obj->read_sem);
+			osal->mutex_deinit(obj->lock);
+			return RING_BUFF_ERR_NO_MEM;
+		}
+		obj->realtime = 1;
+		obj->storage_size = ring_buff_get_storage_size(attr);
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_check_state(ring_buff_obj_t* obj, ring_buff_state_t states)
+{
+	if((obj->state & states) == 0)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_wait_write(ring_buff_obj_t* obj)
+{
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	/* producer is not blocked, record is spilled instead */
+	if(obj->spill != NULL)
+	{
+		obj->spilling = 1;
+		return RING_BUFF_ERR_WOULD_BLOCK;
+	}
+	/* space is released, but recovery would still start from the old read position, so save it instead of waiting */
+	if(obj->file != NULL && obj->sync_read != obj->read)
+	{
+		LEAVE_RING_BUFF_CONTEXT(obj);
+		err = ring_buff_persist_sync(obj);
+		ENTER_RING_BUFF_CONTEXT(obj);
+		if(err != RING_BUFF_ERR_OK)
+		{
+			return err;
+		}
+	}
+	else
+	{
+		obj->write_waiters++;
+		obj->waits++;
+		LEAVE_RING_BUFF_CONTEXT(obj);
+		RING_BUFF_SEM_TAKE(obj, obj->write_sem);
+		ENTER_RING_BUFF_CONTEXT(obj);
+		obj->write_waiters--;
+	}
+
+	return ring_buff_check_state(obj, RING_BUFF_STATE_ACTIVE);
+}
+
+
+static ring_buff_err_t ring_buff_handle_acc(ring_buff_obj_t* obj, uint8_t* chunk, uint32_t added_size)
+{
+	void* buff = NULL;
+	uint32_t size = 0;
+	uint64_t now = 0;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	ENTER_RING_BUFF_CONTEXT(obj);
+	buff = ring_buff_acc_window(obj, chunk, added_size, &size);
+	if((obj->linger_us || obj->acc_target_us) && (buff != NULL || obj->acc_start == 0))
+	{
+		now = ring_buff_time_us();
+	}
+	/* start linger time for the oldest data that is not notified */
+	if(obj->linger_us && (buff != NULL || obj->acc_start == 0))
+	{
+		obj->acc_start = now;
+		ring_buff_timer_arm(obj->linger_timer, obj->acc_start + obj->linger_us);
+	}
+	if(obj->acc_target_us && buff && size)
+	{
+		ring_buff_adapt_acc(obj, size, now);
+	}
+	/* callback is executed out of ring buffer context */
+	LEAVE_RING_BUFF_CONTEXT(obj);
+	/* nothing to notify, if previous data was already flushed */
+	if(buff && size)
+	{
+		err = obj->notify_func(obj, buff, size);
+		/* linger timer may notify (and adapt the window) at the same time */
+		if(obj->acc_target_us)
+		{
+			now = ring_buff_time_us() - now;
+			ENTER_RING_BUFF_CONTEXT(obj);
+			obj->notify_us = (obj->notify_us * 7 + now) / 8;
+			LEAVE_RING_BUFF_CONTEXT(obj);
+		}
+	}
+
+	return err;
+}
+
+static void* ring_buff_acc_window(ring_buff_obj_t* obj, uint8_t* chunk, uint32_t added_size, uint32_t* size)
+{
+	void* buff = NULL;
+
+	*size = 0;
+	/* aligned chunk may not follow the data (there is padding or writer's wrap in front of it),
+	 * so the data before it is notified, and the window moves to the chunk */
+	if(obj->aligned && chunk != obj->acc + (obj->acc_size - added_size))
+	{
+		*size = obj->acc_size - added_size;
+		buff = obj->acc;
+		if(obj->pad_acc != NULL)
+		{
+			ring_buff_pass_pads(obj, &(obj->pad_acc), obj->acc + *size, chunk);
+		}
+		obj->acc_size = added_size;
+		obj->acc = chunk;
+	}
+	/* send notification if there is enough data accumulated,
+	 * or we got to the end of the buffer */
+	else if(obj->acc + obj->acc_size > obj->buff + obj->size)
+	{
+		*size = obj->acc_size - added_size;
+		buff = obj->acc;
+		obj->acc_size = added_size;
+
+		obj->acc = obj->buff;
+	}
+	else if(obj->acc_size >= obj->accumulate)
+	{
+		*size = obj->acc_size - added_size;
+		buff = obj->acc;
+		obj->acc_size = added_size;
+		obj->acc += *size;
+	}
+
+	return buff;
+}
+
+static void ring_buff_adapt_acc(ring_buff_obj_t* obj, uint32_t size, uint64_t now)
+{
+	uint64_t interval = now - obj->acc_notify_time;
+	uint64_t rate, target;
+
+	if(obj->acc_notify_time == 0 || interval == 0)
+	{
+		obj->acc_notify_time = now;
+		return;
+	}
+	obj->acc_notify_time = now;
+	rate = (uint64_t)size * 1000000 / interval;
+	obj->acc_rate = (obj->acc_rate == 0) ? rate : (obj->acc_rate * 7 + rate) / 8;
+	/* window which is filled in the target time */
+	target = obj->acc_rate * obj->acc_target_us / 1000000;
+	/* consumer spends most of the time in notifications, so bigger batches are needed */
+	if(obj->notify_us * 2 > interval && target < (uint64_t)obj->accumulate * 2)
+	{
+		target = (uint64_t)obj->accumulate * 2;
+	}
+	target = (obj->accumulate * (uint64_t)3 + target) / 4;
+	if(target < obj->acc_min)
+	{
+		target = obj->acc_min;
+	}
+	else if(target > obj->acc_max)
+	{
+		target = obj->acc_max;
+	}
+	obj->accumulate = (uint32_t)target;
+}
+
+static ring_buff_err_t ring_buff_flush_acc(ring_buff_obj_t* obj, uint8_t force)
+{
+	void* buff = NULL;
+	uint32_t size = 0;
+	uint64_t now;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	if(obj->linger_us)
+	{
+		ring_buff_mutex_lock(obj->notify_lock);
+	}
+	ENTER_RING_BUFF_CONTEXT(obj);
+	if(obj->acc_size != 0)
+	{
+		now = (obj->linger_us && !force) ? ring_buff_time_us() : 0;
+		if(force || now - obj->acc_start >= obj->linger_us)
+		{
+			/* on commit, wrap around is handled, so just send what is left */
+			buff = obj->acc;
+			size = obj->acc_size;
+			obj->acc += size;
+			obj->acc_size = 0;
+			obj->acc_start = 0;
+		}
+		else
+		{
+			/* timer fired early (it was re-armed meanwhile) */
+			ring_buff_timer_arm(obj->linger_timer, obj->acc_start + obj->linger_us);
+		}
+	}
+	LEAVE_RING_BUFF_CONTEXT(obj);
+	if(buff)
+	{
+		err = obj->notify_func(obj, buff, size);
+	}
+	if(obj->linger_us)
+	{
+		ring_buff_mutex_unlock(obj->notify_lock);
+	}
+
+	return err;
+}
+
+static void ring_buff_linger_expired(void* arg)
+{
+	ring_buff_obj_t* obj = GET_RING_BUFF_OBJ(arg);
+
+	if(ring_buff_flush_acc(obj, 0) != RING_BUFF_ERR_OK)
+	{
+		fprintf(stderr, "WARNING (%s): Lingering data notification failed!\n", __func__);
+	}
+}
+
+static ring_buff_err_t ring_buff_free_tracked(ring_buff_obj_t* obj, uint8_t* buff, uint32_t size)
+{
+	ring_buff_range_t* range = NULL;
+	uint64_t dist = 0;
+	uint32_t i = 0;
+	uint32_t prev = 0;
+
+	/* chunk is not next in line, keep it (in order) until the ones before are freed */
+	if(!ring_buff_free_in_line(obj, buff))
+	{
+		if(obj->freed_count == obj->freed_max)
+		{
+			return RING_BUFF_ERR_OVERRUN;
+		}
+		/* chunks are mostly freed close to the reading order, so the place is searched from the tail */
+		dist = ring_buff_free_dist(obj, buff);
+		for(i = obj->freed_count; i > 0; i--)
+		{
+			prev = (obj->freed_first + i - 1) % obj->freed_max;
+			if(ring_buff_free_dist(obj, obj->freed[prev].buff) < dist)
+			{
+				break;
+			}
+			obj->freed[(prev + 1) % obj->freed_max] = obj->freed[prev];
+		}
+		range = &(obj->freed[(obj->freed_first + i) % obj->freed_max]);
+		range->buff = buff;
+		range->size = size;
+		obj->freed_count++;
+		return RING_BUFF_ERR_OK;
+	}
+	ring_buff_free_advance(obj, buff, size);
+	/* advance over chunks that were already freed, the closest one is always first */
+	while(obj->freed_count != 0)
+	{
+		range = &(obj->freed[obj->freed_first]);
+		if(!ring_buff_free_in_line(obj, range->buff))
+		{
+			break;
+		}
+		ring_buff_free_advance(obj, range->buff, range->size);
+		obj->freed_first = (obj->freed_first + 1) % obj->freed_max;
+		obj->freed_count--;
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+static uint64_t ring_buff_free_dist(ring_buff_obj_t* obj, uint8_t* buff)
+{
+	/* read position is at the end of data, all the chunks are after the wrap (or in the new memory) */
+	if(obj->read == obj->free_eod)
+	{
+		return buff - obj->buff;
+	}
+	/* read position is in the old memory (elastic mode), chunks in the new memory are after its end of data */
+	if(obj->old != NULL && obj->read >= obj->old && obj->read < obj->old + obj->old_size)
+	{
+		if(buff >= obj->old && buff < obj->old + obj->old_size)
+		{
+			return buff - obj->read;
+		}
+		return (uint64_t)(obj->free_eod - obj->read) + (buff - obj->buff);
+	}
+	/* chunks after the writer's wrap are after the end of data */
+	if(obj->free_eod != NULL && (buff < obj->read || buff >= obj->free_eod))
+	{
+		return (uint64_t)(obj->free_eod - obj->read) + (buff - obj->buff);
+	}
+
+	return buff - obj->read;
+}
+
+static uint8_t ring_buff_free_in_line(ring_buff_obj_t* obj, uint8_t* buff)
+{
+	uint8_t* next = obj->read;
+	ring_buff_pad_t pad;
+
+	if(buff == next)
+	{
+		return 1;
+	}
+	/* read position follows the writer's wrap, and the padding in front of the chunk */
+	if(next == obj->free_eod)
+	{
+		next = obj->buff;
+	}
+	if(next == obj->pad_free)
+	{
+		memcpy(&pad, next, sizeof(pad));
+		next += pad.size;
+	}
+
+	return buff == next;
+}
+
+static void ring_buff_free_advance(ring_buff_obj_t* obj, uint8_t* buff, uint32_t size)
+{
+	if(obj->pad_free != NULL)
+	{
+		ring_buff_pass_pads(obj, &(obj->pad_free), obj->read, buff);
+	}
+	if(buff != obj->read && obj->read == obj->free_eod)
+	{
+		/* read position follows the writer's wrap */
+		obj->free_eod = NULL;
+	}
+	obj->read = buff + size;
+	obj->reclaimed++;
+	obj->read_seq++;
+}
+
+static void ring_buff_add_pad(ring_buff_obj_t* obj, uint8_t* pad, uint32_t size)
+{
+	ring_buff_pad_t hdr;
+
+	hdr.size = size;
+	hdr.next = RING_BUFF_PAD_NONE;
+	memcpy(pad, &hdr, sizeof(hdr));
+	/* last padding is not reused until the read position passes it */
+	if(obj->pad_free == NULL)
+	{
+		obj->pad_free = pad;
+	}
+	else
+	{
+		memcpy(&hdr, obj->pad_tail, sizeof(hdr));
+		hdr.next = (uint32_t)(pad - obj->buff);
+		memcpy(obj->pad_tail, &hdr, sizeof(hdr));
+	}
+	if(obj->pad_acc == NULL)
+	{
+		obj->pad_acc = pad;
+	}
+	obj->pad_tail = pad;
+}
+
+static void ring_buff_pass_pads(ring_buff_obj_t* obj, uint8_t** pad, uint8_t* from, uint8_t* chunk)
+{
+	ring_buff_pad_t hdr;
+
+	while(*pad != NULL && RING_BUFF_DIST(obj, from, *pad) < RING_BUFF_DIST(obj, from, chunk))
+	{
+		memcpy(&hdr, *pad, sizeof(hdr));
+		*pad = (hdr.next == RING_BUFF_PAD_NONE) ? NULL : obj->buff + hdr.next;
+	}
+}
+
+static void ring_buff_skip_pads(ring_buff_obj_t* obj)
+{
+	ring_buff_pad_t hdr;
+
+	while(obj->pad_acc != NULL)
+	{
+		if(obj->acc == obj->pad_acc)
+		{
+			memcpy(&hdr, obj->pad_acc, sizeof(hdr));
+			obj->acc += hdr.size;
+			obj->pad_acc = (hdr.next == RING_BUFF_PAD_NONE) ? NULL : obj->buff + hdr.next;
+		}
+		else if(obj->eod != NULL && obj->acc == obj->eod)
+		{
+			obj->acc = obj->buff;
+			obj->eod = NULL;
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+static ring_buff_err_t ring_buff_claim_rec(ring_buff_obj_t* obj, void** buff, uint32_t* size, uint8_t wait)
+{
+	uint8_t* rec = NULL;
+
+	ENTER_RING_BUFF_CONTEXT(obj);
+	/* wait for the record, and for the room in completion tracker (so that release can not fail).
+	 * Spilled records are newer, they are claimed once the buffer is drained and nothing reserved
+	 * in the buffer is still to be committed. */
+	while((obj->acc_size == 0 && (obj->spill_count == 0 || obj->commit != obj->write)) ||
+			(obj->acc_size != 0 && obj->claimed - obj->reclaimed == obj->freed_max))
+	{
+		if(obj->state == RING_BUFF_STATE_STOPPED && obj->acc_size == 0 && obj->spill_count == 0)
+		{
+			/* let the other consumers know as well */
+			RING_BUFF_SEM_GIVE(obj, obj->read_sem);
+			LEAVE_RING_BUFF_CONTEXT(obj);
+			return RING_BUFF_ERR_PERM;
+		}
+		if(!wait)
+		{
+			LEAVE_RING_BUFF_CONTEXT(obj);
+			return RING_BUFF_ERR_WOULD_BLOCK;
+		}
+		LEAVE_RING_BUFF_CONTEXT(obj);
+		RING_BUFF_SEM_TAKE(obj, obj->read_sem);
+		ENTER_RING_BUFF_CONTEXT(obj);
+		/* We can claim, even if buffer has been stopped */
+		if(ring_buff_check_state(obj, RING_BUFF_STATE_ACTIVE | RING_BUFF_STATE_STOPPED))
+		{
+			RING_BUFF_SEM_GIVE(obj, obj->read_sem);
+			LEAVE_RING_BUFF_CONTEXT(obj);
+			return RING_BUFF_ERR_PERM;
+		}
+	}
+	if(obj->acc_size == 0)
+	{
+		obj->spill_count--;
+		obj->spill_reading++;
+		if(obj->spill_count != 0 || obj->state != RING_BUFF_STATE_ACTIVE)
+		{
+			RING_BUFF_SEM_GIVE(obj, obj->read_sem);
+		}
+		LEAVE_RING_BUFF_CONTEXT(obj);
+		return ring_buff_spill_claim(obj, buff, size);
+	}
+	/* writer wrapped, records continue from the beginning */
+	if(obj->eod != NULL && obj->acc == obj->eod)
+	{
+		obj->acc = obj->buff;
+		obj->eod = NULL;
+	}
+	rec = obj->acc;
+	*size = ((ring_buff_rec_hdr_t*)rec)->size;
+	*buff = rec + obj->rec_hdr;
+	obj->acc += RING_BUFF_REC_SIZE(obj, *size);
+	obj->acc_size -= RING_BUFF_REC_SIZE(obj, *size);
+	obj->claimed++;
+	/* semaphore is binary, pass the wake up to the other consumers if there is more to claim */
+	if(obj->acc_size != 0 || obj->state != RING_BUFF_STATE_ACTIVE)
+	{
+		RING_BUFF_SEM_GIVE(obj, obj->read_sem);
+	}
+	LEAVE_RING_BUFF_CONTEXT(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+static uint32_t ring_buff_commit_rec(ring_buff_obj_t* obj)
+{
+	ring_buff_rec_hdr_t* hdr = NULL;
+	uint32_t size = 0;
+
+	for(;;)
+	{
+		/* writer wrapped, records continue from the beginning (reader can't reset eod before we get here) */
+		if(obj->eod != NULL && obj->commit == obj->eod)
+		{
+			obj->commit = obj->buff;
+		}
+		if(obj->commit == obj->write)
+		{
+			break;
+		}
+		hdr = (ring_buff_rec_hdr_t*)obj->commit;
+		if(!(hdr->flags & RING_BUFF_REC_COMMITTED))
+		{
+			break;
+		}
+		obj->commit += RING_BUFF_REC_SIZE(obj, hdr->size);
+		size += RING_BUFF_REC_SIZE(obj, hdr->size);
+		obj->commit_seq++;
+	}
+
+	return size;
+}
+
+static ring_buff_err_t ring_buff_persist_open(ring_buff_obj_t* obj, const char* path)
+{
+	void* addr = NULL;
+	uint8_t created = 0;
+	uint32_t start, off, limit, rec;
+	uint64_t seq;
+	uint8_t wrapped = 0;
+	ring_buff_err_t err;
+
+	if(obj->size > UINT32_MAX - RING_BUFF_PERSIST_HDR_SIZE)
+	{
+		return RING_BUFF_ERR_SIZE;
+	}
+	err = ring_buff_mutex_create(&(obj->sync_lock));
+	if(err != RING_BUFF_ERR_OK)
+	{
+		return err;
+	}
+	err = ring_buff_file_map(&(obj->file), path, RING_BUFF_PERSIST_HDR_SIZE + obj->size, &addr, &created);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		return err;
+	}
+	obj->phdr = (ring_buff_persist_hdr_t*)addr;
+	obj->buff = (uint8_t*)addr + RING_BUFF_PERSIST_HDR_SIZE;
+	/* file that is not initialized yet is zero (e.g. crash right after it is created) */
+	if(created || obj->phdr->magic == 0)
+	{
+		memset(obj->phdr, 0, sizeof(ring_buff_persist_hdr_t));
+		obj->phdr->magic = RING_BUFF_PERSIST_MAGIC;
+		obj->phdr->size = obj->size;
+	}
+	else if(obj->phdr->magic != RING_BUFF_PERSIST_MAGIC || obj->phdr->size != obj->size)
+	{
+		fprintf(stderr, "WARNING (%s): File is not a ring buffer of the same size!\n", __func__);
+		/* file must be left as it is */
+		ring_buff_file_unmap(obj->file);
+		obj->file = NULL;
+		return RING_BUFF_ERR_GENERAL;
+	}
+	start = obj->phdr->read;
+	if(start >= obj->size || start % RING_BUFF_REC_ALIGN)
+	{
+		fprintf(stderr, "WARNING (%s): Read position is not valid. Records will not be recovered!\n", __func__);
+		start = 0;
+	}
+	/* follow the records from the read position, until the first one that is not valid */
+	seq = obj->phdr->read_seq;
+	off = start;
+	limit = obj->size;
+	for(;;)
+	{
+		rec = ring_buff_persist_check(obj, off, limit, seq);
+		if(rec == 0)
+		{
+			/* writer might have wrapped (it must stay behind the read position) */
+			if(wrapped || (rec = ring_buff_persist_check(obj, 0, start ? start - 1 : 0, seq)) == 0)
+			{
+				break;
+			}
+			obj->eod = obj->buff + off;
+			obj->free_eod = obj->eod;
+			wrapped = 1;
+			limit = start - 1;
+			off = 0;
+		}
+		off += rec;
+		obj->acc_size += rec;
+		seq++;
+	}
+	obj->read = obj->buff + start;
+	obj->acc = obj->read;
+	obj->write = obj->buff + off;
+	obj->commit = obj->write;
+	obj->seq = seq;
+	obj->commit_seq = seq;
+	obj->read_seq = obj->phdr->read_seq;
+	obj->sync_seq = seq;
+	obj->sync_read = obj->read;
+	obj->sync_commit = obj->commit;
+	/* records that are not recovered (e.g. torn writes) may be followed by the valid ones,
+	 * clear free space so that they are not mistaken for the new records later */
+	if(wrapped)
+	{
+		memset(obj->write, 0, start - off);
+	}
+	else
+	{
+		memset(obj->write, 0, obj->size - off);
+		memset(obj->buff, 0, start);
+	}
+	err = ring_buff_file_sync(obj->file, obj->buff, obj->size);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		return err;
+	}
+	obj->phdr->commit_seq = seq;
+	obj->phdr->read = start;
+
+	return ring_buff_file_sync(obj->file, obj->phdr, sizeof(ring_buff_persist_hdr_t));
+}
+
+static uint32_t ring_buff_persist_check(ring_buff_obj_t* obj, uint32_t off, uint32_t limit, uint64_t seq)
+{
+	ring_buff_persist_rec_hdr_t* rec = (ring_buff_persist_rec_hdr_t*)(obj->buff + off);
+	uint32_t size;
+
+	if(off >= limit || limit - off < obj->rec_hdr)
+	{
+		return 0;
+	}
+	if(!(rec->hdr.flags & RING_BUFF_REC_COMMITTED) || rec->seq != (uint32_t)seq || rec->hdr.size > limit - off - obj->rec_hdr)
+	{
+		return 0;
+	}
+	size = RING_BUFF_REC_SIZE(obj, rec->hdr.size);
+	if(size > limit - off)
+	{
+		return 0;
+	}
+	/* records that were not synced may be torn */
+	if(seq >= obj->phdr->commit_seq && rec->crc != ring_buff_crc32(rec->seq, (uint8_t*)rec + obj->rec_hdr, rec->hdr.size))
+	{
+		return 0;
+	}
+
+	return size;
+}
+
+static ring_buff_err_t ring_buff_persist_sync(ring_buff_obj_t* obj)
+{
+	uint8_t *commit, *read;
+	uint64_t commit_seq, read_seq;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	/* producers that wait here find their records synced by the one before */
+	ring_buff_mutex_lock(obj->sync_lock);
+	ENTER_RING_BUFF_CONTEXT(obj);
+	commit = obj->commit;
+	commit_seq = obj->commit_seq;
+	read = obj->read;
+	read_seq = obj->read_seq;
+	LEAVE_RING_BUFF_CONTEXT(obj);
+	if(commit_seq == obj->sync_seq && read == obj->sync_read)
+	{
+		goto done;
+	}
+	/* data first, header must not point past the records that are not durable */
+	if(commit_seq != obj->sync_seq)
+	{
+		if(commit >= obj->sync_commit)
+		{
+			err = ring_buff_file_sync(obj->file, obj->sync_commit, commit - obj->sync_commit);
+		}
+		else
+		{
+			err = ring_buff_file_sync(obj->file, obj->sync_commit, obj->buff + obj->size - obj->sync_commit);
+			if(err == RING_BUFF_ERR_OK)
+			{
+				err = ring_buff_file_sync(obj->file, obj->buff, commit - obj->buff);
+			}
+		}
+		if(err != RING_BUFF_ERR_OK)
+		{
+			goto done;
+		}
+	}
+	obj->phdr->read = read - obj->buff;
+	obj->phdr->read_seq = read_seq;
+	obj->phdr->commit_seq = commit_seq;
+	err = ring_buff_file_sync(obj->file, obj->phdr, sizeof(ring_buff_persist_hdr_t));
+	if(err != RING_BUFF_ERR_OK)
+	{
+		goto done;
+	}
+	ENTER_RING_BUFF_CONTEXT(obj);
+	obj->sync_seq = commit_seq;
+	obj->sync_commit = commit;
+	obj->sync_read = read;
+	/* writer may continue over the released space */
+	if(obj->write_waiters)
+	{
+		RING_BUFF_SEM_GIVE(obj, obj->write_sem);
+	}
+	LEAVE_RING_BUFF_CONTEXT(obj);
+
+done:
+	ring_buff_mutex_unlock(obj->sync_lock);
+	return err;
+}
+
+static uint8_t ring_buff_spill_active(ring_buff_obj_t* obj)
+{
+	/* spilled records have to be claimed first, otherwise new records would get ahead of them */
+	if(obj->spilling && obj->spill_count == 0 && obj->spill_pending == 0 && obj->spill_reading == 0 &&
+			(obj->acc_size < obj->wm_low || obj->acc_size == 0))
+	{
+		obj->spilling = 0;
+		obj->spill_write = 0;
+		obj->spill_read = 0;
+		ring_buff_file_truncate(obj->spill, 0);
+	}
+	else if(!obj->spilling && obj->wm_high && obj->acc_size > obj->wm_high)
+	{
+		obj->spilling = 1;
+	}
+
+	return obj->spilling;
+}
+
+static ring_buff_err_t ring_buff_spill_commit(ring_buff_obj_t* obj, ring_buff_rec_hdr_t* hdr)
+{
+	uint32_t size = RING_BUFF_REC_ALIGN + hdr->size;
+	ring_buff_err_t err;
+
+	/* records are appended in the commit order */
+	ring_buff_mutex_lock(obj->spill_lock);
+	err = ring_buff_file_write(obj->spill, obj->spill_write, hdr, size);
+	if(err == RING_BUFF_ERR_OK)
+	{
+		obj->spill_write += size;
+	}
+	ENTER_RING_BUFF_CONTEXT(obj);
+	obj->spill_pending--;
+	if(err == RING_BUFF_ERR_OK)
+	{
+		obj->spill_count++;
+		RING_BUFF_EVENT(obj, RING_BUFF_EVENT_READ);
+	}
+	LEAVE_RING_BUFF_CONTEXT(obj);
+	ring_buff_mutex_unlock(obj->spill_lock);
+	free(hdr);
+	RING_BUFF_SEM_GIVE(obj, obj->read_sem);
+
+	return err;
+}
+
+static ring_buff_err_t ring_buff_spill_claim(ring_buff_obj_t* obj, void** buff, uint32_t* size)
+{
+	ring_buff_rec_hdr_t hdr;
+	ring_buff_rec_hdr_t* rec = NULL;
+	ring_buff_err_t err;
+
+	/* file is not truncated while there are claimed records to read, and the reads are serialized */
+	ring_buff_mutex_lock(obj->spill_lock);
+	err = ring_buff_file_read(obj->spill, obj->spill_read, &hdr, sizeof(hdr));
+	if(err != RING_BUFF_ERR_OK)
+	{
+		goto done;
+	}
+	rec = malloc(RING_BUFF_REC_ALIGN + hdr.size);
+	if(rec == NULL)
+	{
+		err = RING_BUFF_ERR_NO_MEM;
+		goto done;
+	}
+	err = ring_buff_file_read(obj->spill, obj->spill_read + RING_BUFF_REC_ALIGN, (uint8_t*)rec + RING_BUFF_REC_ALIGN, hdr.size);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		free(rec);
+		goto done;
+	}
+	rec->size = hdr.size;
+	rec->flags = RING_BUFF_REC_SPILLED;
+	obj->spill_read += RING_BUFF_REC_ALIGN + hdr.size;
+	*buff = (uint8_t*)rec + RING_BUFF_REC_ALIGN;
+	*size = hdr.size;
+
+done:
+	ring_buff_mutex_unlock(obj->spill_lock);
+	ENTER_RING_BUFF_CONTEXT(obj);
+	obj->spill_reading--;
+	/* record is not read, so it stays in the file for the next claim */
+	if(err != RING_BUFF_ERR_OK)
+	{
+		obj->spill_count++;
+		RING_BUFF_SEM_GIVE(obj, obj->read_sem);
+	}
+	LEAVE_RING_BUFF_CONTEXT(obj);
+
+	return err;
+}
+
+static uint8_t ring_buff_elastic_resize(ring_buff_obj_t* obj, uint32_t size)
+{
+	uint32_t new_size = 0;
+	uint8_t* buff = NULL;
+	uint64_t now = 0;
+
+	/* only one memory can be drained at a time, and the reader must not be behind the wrap around */
+	if(obj->old != NULL || obj->eod != NULL || obj->free_eod != NULL)
+	{
+		return 0;
+	}
+	if(obj->waits && obj->acc_size > obj->wm_high && obj->size < obj->size_max)
+	{
+		new_size = (obj->size > obj->size_max / 2) ? obj->size_max : obj->size * 2;
+		obj->low_since = 0;
+	}
+	else if(obj->shrink_us && obj->size > obj->base_size)
+	{
+		if(obj->acc_size >= obj->wm_low && obj->acc_size != 0)
+		{
+			obj->low_since = 0;
+		}
+		else
+		{
+			now = ring_buff_time_us();
+			if(obj->low_since == 0)
+			{
+				obj->low_since = now;
+			}
+			else if(now - obj->low_since >= obj->shrink_us)
+			{
+				new_size = (obj->size / 2 < obj->base_size) ? obj->base_size : obj->size / 2;
+				/* next step waits for the whole idle time again */
+				obj->low_since = now;
+			}
+		}
+	}
+	obj->waits = 0;
+	if(new_size == 0 || new_size < size)
+	{
+		return 0;
+	}
+	buff = (new_size == obj->base_size) ? obj->base : malloc(new_size);
+	if(buff == NULL)
+	{
+		return 0;
+	}
+	if(obj->read == obj->write)
+	{
+		/* nothing is handed out, current memory can go right away */
+		if(obj->buff != obj->base)
+		{
+			free(obj->buff);
+		}
+		obj->read = buff;
+		obj->acc = buff;
+		obj->commit = buff;
+	}
+	else
+	{
+		/* reader follows the writer to the new memory (same as with the wrap around) */
+		obj->old = obj->buff;
+		obj->old_size = obj->size;
+		obj->eod = obj->write;
+		obj->free_eod = obj->write;
+	}
+	obj->buff = buff;
+	obj->size = new_size;
+	obj->write = buff;
+
+	return 1;
+}
+
+static uint8_t ring_buff_rewind(ring_buff_obj_t* obj)
+{
+	/* persistent read position is in the file, and old memory of the elastic buffer is not drained yet */
+	if(obj->file != NULL || obj->old != NULL)
+	{
+		return 0;
+	}
+	if(obj->read != obj->write || obj->acc != obj->write || obj->acc_size != 0 || obj->freed_count != 0 ||
+			(obj->records && obj->commit != obj->write))
+	{
+		return 0;
+	}
+	/* everything is consumed, paddings are behind the read position as well */
+	obj->read = obj->buff;
+	obj->acc = obj->buff;
+	obj->commit = obj->buff;
+	obj->write = obj->buff;
+	obj->eod = NULL;
+	obj->free_eod = NULL;
+	obj->pad_acc = NULL;
+	obj->pad_free = NULL;
+	obj->pad_tail = NULL;
+
+	return 1;
+}
+
+static void ring_buff_elastic_drained(ring_buff_obj_t* obj)
+{
+	/* read position is at the old end of data, or it already moved to the new memory */
+	if(obj->read == obj->free_eod)
+	{
+		obj->read = obj->buff;
+		obj->free_eod = NULL;
+	}
+	else if(obj->read >= obj->old && obj->read < obj->old + obj->old_size)
+	{
+		return;
+	}
+	if(obj->old != obj->base)
+	{
+		free(obj->old);
+	}
+	obj->old = NULL;
+}
+
+static uint32_t ring_buff_reclaim_idle(ring_buff_obj_t* obj, uint8_t force)
+{
+	uint64_t now = ring_buff_time_us();
+	uint32_t released = 0;
+	uint32_t size = 0;
+
+	/* grown buffer may still have data in the old memory; empty buffer is idle even if wm_low is 0 */
+	if(obj->old != NULL || (!force && obj->acc_size >= obj->wm_low && obj->acc_size != 0))
+	{
+		obj->reclaim_since = 0;
+		return 0;
+	}
+	if(obj->reclaim_since == 0)
+	{
+		obj->reclaim_since = now;
+	}
+	/* rate limited, and only once per burst (nothing new is written to the space given back) */
+	if(!force && (now - obj->reclaim_since < obj->reclaim_us || now - obj->reclaim_time < obj->reclaim_us))
+	{
+		return 0;
+	}
+	if(obj->write == obj->reclaim_write)
+	{
+		return 0;
+	}
+	obj->reclaim_time = now;
+	obj->reclaim_write = obj->write;
+	/* pages have to be dropped with the context acquired, writer must not touch them meanwhile */
+	if(obj->write < obj->read)
+	{
+		if(obj->read - obj->write >= RING_BUFF_RECLAIM_MIN)
+		{
+			ring_buff_mem_release(obj->write, obj->read - obj->write, &released);
+		}
+		return released;
+	}
+	if(obj->buff + obj->size - obj->write >= RING_BUFF_RECLAIM_MIN)
+	{
+		ring_buff_mem_release(obj->write, obj->buff + obj->size - obj->write, &size);
+		released += size;
+	}
+	if(obj->read - obj->buff >= RING_BUFF_RECLAIM_MIN)
+	{
+		ring_buff_mem_release(obj->buff, obj->read - obj->buff, &size);
+		released += size;
+	}
+
+	return released;
+}
+
+static uint32_t ring_buff_crc32(uint32_t crc, const uint8_t* buff, uint32_t size)
+{
+	crc = ~crc;
+	while(size--)
+	{
+		crc = ring_buff_crc_table[(crc ^ *buff++) & 0xff] ^ (crc >> 8);
+	}
+
+	return ~crc;
+}
+
+static ring_buff_err_t ring_buff_handle_wm(ring_buff_obj_t* obj)
+{
+	uint8_t notify = 0;
+
+	ENTER_RING_BUFF_CONTEXT(obj);
+	notify = ring_buff_check_wm(obj);
+	LEAVE_RING_BUFF_CONTEXT(obj);
+	if(notify != 0)
+	{
+		return obj->wm_cb(obj, obj->last_level);
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+static uint8_t ring_buff_check_wm(ring_buff_obj_t* obj)
+{
+	if((obj->acc_size > obj->wm_high) && obj->last_level == ring_buff_wm_low)
+	{
+		obj->last_level = ring_buff_wm_high;
+		return 1;
+	}
+	if((obj->acc_size < obj->wm_low) && obj->last_level == ring_buff_wm_high)
+	{
+		obj->last_level = ring_buff_wm_low;
+		return 1;
+	}
+
+	return 0;
+}
+
+/* ############### Single-threaded hot paths ################ */
+
+static ring_buff_err_t ring_buff_commit_st(ring_buff_obj_t* obj, void* buff, uint32_t size)
+{
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	obj->acc_size += size;
+	/* Sanity check. This may be removed. */
+	if(obj->acc_size > obj->size)
+	{
+		return RING_BUFF_ERR_SIZE;
+	}
+	if(obj->wm_cb != NULL && ring_buff_check_wm(obj))
+	{
+		err = obj->wm_cb(obj, obj->last_level);
+	}
+	if(obj->accumulate && obj->notify_func)
+	{
+		buff = ring_buff_acc_window(obj, buff, size, &size);
+		if(obj->acc_target_us && buff && size)
+		{
+			ring_buff_adapt_acc(obj, size, ring_buff_time_us());
+		}
+		if(buff && size)
+		{
+			err = obj->notify_func(obj, buff, size);
+		}
+	}
+
+	return err;
+}
+
+static ring_buff_err_t ring_buff_free_st(ring_buff_obj_t* obj, void* buff, uint32_t size)
+{
+	if(obj->freed_max)
+	{
+		if(ring_buff_free_tracked(obj, buff, size) != RING_BUFF_ERR_OK)
+		{
+			return RING_BUFF_ERR_OVERRUN;
+		}
+	}
+	else
+	{
+		if(obj->pad_free != NULL)
+		{
+			ring_buff_pass_pads(obj, &(obj->pad_free), obj->read, buff);
+		}
+		if((uint8_t*)buff == obj->buff || (obj->free_eod != NULL && (uint8_t*)buff < obj->read))
+		{
+			obj->free_eod = NULL;
+		}
+		obj->read = (uint8_t*)buff + size;
+	}
+	if(obj->reclaim_us)
+	{
+		ring_buff_reclaim_idle(obj, 0);
+	}
+	if(obj->wm_cb != NULL && ring_buff_check_wm(obj))
 	{
 		return obj->wm_cb(obj, obj->last_level);
 	}
@@ -59,7 +59,9 @@ typedef enum ring_buff_err
 	/** Internal (system) error */
 	RING_BUFF_ERR_INTERNAL,
 	/** Operation not permitted (e.g. reading after cancel is called) */
-	RING_BUFF_ERR_PERM
+	RING_BUFF_ERR_PERM,
+	/** Operation would block (non-blocking call) */
+	RING_BUFF_ERR_WOULD_BLOCK
 } ring_buff_err_t;
 
 /**
@@ -73,6 +75,9 @@ typedef enum ring_buff_wm_level
 	ring_buff_wm_high
 } ring_buff_wm_level_t;
 
+/** Alignment of the storage passed to "ring_buff_init" (cache line). */
+#define RING_BUFF_STORAGE_ALIGN 64
+
 /** Ring buffer handle. */
 typedef void* ring_buff_handle_t;
 /**
@@ -126,6 +131,116 @@ typedef struct ring_buff_attr
 	 * or whenever it gets over wm_high. It is called ONLY during the fullness transition.
 	 */
 	ring_buff_wm_cb_t wm_cb;
+	/**
+	 * Linger time in microseconds. Used only with accumulation/notification mechanism.
+	 * If set, notify function is called also when the oldest data that is not notified is
+	 * older than linger time, even if there is less than "accumulate" bytes available.
+	 * NOTE: Such notification is called from the internal timer thread (shared by all ring buffers).
+	 * Notifications are serialized with an internal lock, which is held during commit and notify callback,
+	 * so notify callback must NOT commit to, or flush the same ring buffer (it would deadlock).
+	 */
+	uint32_t linger_us;
+	/**
+	 * Adaptive accumulation target in microseconds. If set, accumulate size is adjusted at runtime
+	 * (between "acc_min" and "acc_max") so that the window is filled in about this time, measured
+	 * against the observed commit rate. Window also grows when notify callback takes more than half
+	 * of the time between notifications. Used only with accumulation/notification mechanism.
+	 */
+	uint32_t acc_target_us;
+	/** Minimum accumulate size in bytes (adaptive accumulation). */
+	uint32_t acc_min;
+	/** Maximum accumulate size in bytes (adaptive accumulation). It has to be up to half of the buffer size. */
+	uint32_t acc_max;
+	/**
+	 * Maximum number of chunks that can be freed ahead of the read position. If set to 0,
+	 * chunks have to be freed in the order they are read. Otherwise, freed chunks are tracked
+	 * and the read position is advanced only over the contiguous freed prefix, so chunks
+	 * may be processed (and freed) out of order, e.g. on the worker pool.
+	 */
+	uint32_t free_slots;
+	/**
+	 * Record mode. If set, every reserved chunk is a record. Consumers claim records one by one
+	 * ("ring_buff_claim"), process them in place and release them ("ring_buff_release") in any order,
+	 * so several consumers may work on the same buffer. "free_slots" limits the number of claimed
+	 * records that are not reclaimed yet (default is used if it is 0).
+	 * Record mode can NOT be used together with the notify mechanism, "ring_buff_read" or "ring_buff_free".
+	 */
+	uint8_t records;
+	/**
+	 * Persistent mode (record mode only). If set, ring buffer memory is mapped from this file, together with
+	 * a small header that keeps the read position and the durable commit position. If the file already
+	 * exists, records that were not released are recovered (records after the durable position are checked
+	 * against their checksums), and they can be claimed again. "buff" must be NULL in this mode.
+	 */
+	const char* path;
+	/**
+	 * Group commit size (persistent mode). Committed records are synced to the file (from the commit call)
+	 * once there are "sync_batch" records that are not synced. If set to 0, records are synced only
+	 * with "ring_buff_sync".
+	 */
+	uint32_t sync_batch;
+	/**
+	 * Overflow spill file (record mode only, it can NOT be used together with the persistent mode).
+	 * If set, producers are not blocked when consumers fall behind: once committed data gets over wm_high
+	 * (or when there is no room for the record), new records are appended to this file. Records are claimed
+	 * from the memory first and from the file after, in order. Buffer goes back to the memory only once
+	 * the spilled records are claimed and it gets under wm_low. Spilled records are copied
+	 * (they are staged in the heap), and the file is truncated when it is created.
+	 */
+	const char* spill_path;
+	/**
+	 * Elastic mode, maximum buffer size (it can NOT be used together with the notify mechanism or the persistent mode).
+	 * If set, buffer grows (twice the size, up to "size_max") when producers have to wait for the room while
+	 * committed data is over wm_high. Writer moves to the new memory when it wraps around, and the old memory
+	 * is freed once all its data is freed, so nothing is copied and pointers handed out stay valid.
+	 * Memory passed in "buff" is never freed, it is used again when buffer shrinks back to "size".
+	 */
+	uint32_t size_max;
+	/**
+	 * Elastic mode: idle time in microseconds. Grown buffer shrinks (half the size, down to "size") once
+	 * committed data stays under wm_low for this long. If set to 0, buffer does not shrink.
+	 */
+	uint32_t shrink_us;
+	/**
+	 * Idle page reclamation time in microseconds (it can NOT be used together with the persistent mode).
+	 * If set, once committed data stays under wm_low (or buffer stays empty) for this long, free space of the buffer is given back
+	 * to the system (from "ring_buff_free"/"ring_buff_release", at most once per this time), and pages are
+	 * faulted in again on the next burst. Only page aligned ranges of 64 KB at least are given back.
+	 * Ring buffer that is completely idle is reclaimed with "ring_buff_reclaim".
+	 */
+	uint32_t reclaim_us;
+	/**
+	 * Single-threaded buffer. If set, buffer is used from one thread only (e.g. producer that consumes the data
+	 * in the notify function), so reserve/commit/read/free do not lock nor signal anything. Calls that would
+	 * have to wait return RING_BUFF_ERR_WOULD_BLOCK. It can NOT be used together with the record mode,
+	 * persistent mode, spill file, elastic mode, linger time, or ring buffer sets.
+	 * If the library is built with RING_BUFF_SINGLE_THREADED defined, all the buffers are single-threaded.
+	 */
+	uint8_t single_thread;
+	/**
+	 * OSAL backend of the buffer lock and semaphores (see ring_buff_osal.h). It may be one of the
+	 * built-in backends (ring_buff_osal_posix, ring_buff_osal_spin, ring_buff_osal_futex, ring_buff_osal_pi)
+	 * or a custom one, and it must stay valid while the buffer exists. If NULL, default backend is called
+	 * directly (without going through the table). Locks used by optional features are always default ones.
+	 */
+	const struct ring_buff_osal_ops *osal;
+	/**
+	 * Real-time profile. Lock and semaphores use priority inheritance (ring_buff_osal_pi, unless "osal" is set),
+	 * buffer memory and object storage are locked in RAM and prefaulted, and pages are never reclaimed.
+	 * Reserve/commit/read/free that neither wait nor wake up a waiting thread then do not allocate
+	 * nor enter the kernel. Buffer memory is unlocked when the buffer is destroyed, so it should not
+	 * share pages with other locked memory. It can NOT be used together with persistent mode,
+	 * spill file, elastic mode, or linger time.
+	 */
+	uint8_t realtime;
+	/**
+	 * Alignment of reserved chunks (power of two, e.g. 64 for cache line and SIMD loads, or 4096 for O_DIRECT).
+	 * Padding that is put in front of the chunk is skipped by read, notifications and free, so consumer
+	 * sees only the data. Alignment is relative to the address space, so the buffer itself does not have
+	 * to be aligned. If 0, chunks are not aligned (unless "ring_buff_reserve_aligned" is used).
+	 * It can NOT be used together with the record mode, persistent mode, spill file, or elastic mode.
+	 */
+	uint32_t align;
 } ring_buff_attr_t;
 
 /**
@@ -138,6 +253,26 @@ typedef struct ring_buff_attr
  * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
  */
 ring_buff_err_t ring_buff_create(ring_buff_attr_t *attr, ring_buff_handle_t *handle);
+/**
+ * Returns size of the storage needed for the ring buffer object (see "ring_buff_init").
+ * It depends only on "records" and "free_slots" attributes.
+ * @param attr Ring buffer attribute object.
+ * @return Size in bytes (0 if attr is NULL).
+ */
+uint32_t ring_buff_get_storage_size(ring_buff_attr_t *attr);
+/**
+ * Creates ring buffer in the storage provided by the caller, so that nothing is allocated.
+ * Object, its lock, semaphores and completion tracker are placed in one block, that is cleared once.
+ * Features that need more resources ("path", "spill_path", "size_max" and "linger_us") can NOT be used.
+ * Buffer is destroyed with "ring_buff_destroy" (storage is not freed, it may be used again after).
+ * @param attr Ring buffer attribute object.
+ * @param storage Object storage, aligned to RING_BUFF_STORAGE_ALIGN.
+ * @param storage_size Storage size, at least "ring_buff_get_storage_size".
+ * @param handle Pointer to the handle. This argument must not be NULL.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_SIZE if storage is too small,
+ * RING_BUFF_ERR_PERM if attributes need resources that are not in the storage, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_init(ring_buff_attr_t *attr, void *storage, uint32_t storage_size, ring_buff_handle_t *handle);
 /**
  * Ring buffer destructor function. This function must be called, so that all resources
  * allocated on ring buffer construction are freed.
@@ -154,6 +289,16 @@ ring_buff_err_t ring_buff_destroy(ring_buff_handle_t handle);
  * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
  */
 ring_buff_err_t ring_buff_reserve(ring_buff_handle_t handle, void **buff, uint32_t size);
+/**
+ * Reserves chunk of memory that starts at the requested alignment (see "align" ring buffer attribute).
+ * @param handle Ring buffer handle.
+ * @param buff Pointer to the reserved data. This is output value.
+ * @param size Requested buffer size in bytes.
+ * @param align Chunk alignment (power of two), or 0 for the alignment set by the attributes.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_PERM if buffer can not align its chunks,
+ * or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_reserve_aligned(ring_buff_handle_t handle, void **buff, uint32_t size, uint32_t align);
 /**
  * Commits written data. After this function is called, data is available for reading.
  * @param handle Ring buffer handle.
@@ -163,11 +308,13 @@ ring_buff_err_t ring_buff_reserve(ring_buff_handle_t handle, void **buff, uint32
  */
 ring_buff_err_t ring_buff_commit(ring_buff_handle_t handle, void *buff, uint32_t size);
 /**
- * Frees ring buffer chunk, so that it can be used for writing.
+ * Frees ring buffer chunk, so that it can be used for writing. Chunks have to be freed in order,
+ * unless "free_slots" attribute is set.
  * @param handle Ring buffer handle.
  * @param buff Pointer to data that should be freed.
  * @param size Chunk length that should be freed.
- * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem
+ * (RING_BUFF_ERR_OVERRUN if there are too many chunks freed out of order).
  */
 ring_buff_err_t ring_buff_free(ring_buff_handle_t handle, void *buff, uint32_t size);
 /**
@@ -179,9 +326,44 @@ ring_buff_err_t ring_buff_free(ring_buff_handle_t handle, void *buff, uint32_t s
  * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
  */
 ring_buff_err_t ring_buff_read(ring_buff_handle_t handle, void **buff, uint32_t size, uint32_t *read);
+/**
+ * Claims next record (record mode only). Record is owned by the caller until it is released with
+ * "ring_buff_release". Function blocks until record is available.
+ * @param handle Ring buffer handle.
+ * @param buff Output argument that will contain pointer to the record data.
+ * @param size Output argument that will contain record size.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem
+ * (RING_BUFF_ERR_PERM if buffer is stopped and there are no more records).
+ */
+ring_buff_err_t ring_buff_claim(ring_buff_handle_t handle, void **buff, uint32_t *size);
+/**
+ * Same as "ring_buff_claim", but it does not block.
+ * @param handle Ring buffer handle.
+ * @param buff Output argument that will contain pointer to the record data.
+ * @param size Output argument that will contain record size.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_WOULD_BLOCK if there is no record
+ * that can be claimed, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_try_claim(ring_buff_handle_t handle, void **buff, uint32_t *size);
+/**
+ * Releases claimed record. Records may be released in any order, memory is reclaimed
+ * once all the records claimed before are released.
+ * @param handle Ring buffer handle.
+ * @param buff Record data, as returned by "ring_buff_claim".
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_release(ring_buff_handle_t handle, void *buff);
+/**
+ * Makes committed records durable, and saves the read position (persistent mode only).
+ * Calls made at the same time are served with a single sync.
+ * @param handle Ring buffer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_sync(ring_buff_handle_t handle);
 /**
  * This function can be used when the notify mechanism is used. Calling this function will result
- * with forced call to the notify function.
+ * with forced call to the notify function (with all the data that is not notified yet).
+ * NOTE: If linger time is set, it must not be called from the notify function of the same buffer (see "linger_us").
  * @param handle Ring buffer handle.
  * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
  */
@@ -207,6 +389,29 @@ ring_buff_err_t ring_buff_stop(ring_buff_handle_t handle);
  * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
  */
 ring_buff_err_t ring_buff_resume(ring_buff_handle_t handle);
+/**
+ * Returns accumulate size currently in use. It changes over time if adaptive accumulation is used.
+ * @param handle Ring buffer handle.
+ * @param accumulate Output argument that will contain accumulate size in bytes.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_get_accumulate(ring_buff_handle_t handle, uint32_t *accumulate);
+/**
+ * Returns buffer size currently in use. It changes over time if elastic mode is used.
+ * @param handle Ring buffer handle.
+ * @param size Output argument that will contain buffer size in bytes.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_get_size(ring_buff_handle_t handle, uint32_t *size);
+/**
+ * Gives free space of the buffer back to the system right away (idle page reclamation must be set),
+ * regardless of wm_low. It may be called periodically for the buffers that are completely idle.
+ * @param handle Ring buffer handle.
+ * @param released Output argument that will contain number of bytes given back (may be NULL).
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_PERM if "reclaim_us" attribute is not set,
+ * or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_reclaim(ring_buff_handle_t handle, uint32_t *released);
 /**
  * Convenience function that prints out 'human readable' ring buffer error description.
  * @param err Error.
@@ -0,0 +1,492 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring_buff64.h"
+#include "ring_buff_osal.h"
+
+#define GET_RING_BUFF64_OBJ(handle) ((ring_buff64_obj_t*)handle)
+#define ENTER_RING_BUFF64_CONTEXT(handle) (ring_buff_mutex_lock(handle->lock))
+#define LEAVE_RING_BUFF64_CONTEXT(handle) (ring_buff_mutex_unlock(handle->lock))
+/* Buffer memory at the position */
+#define RING_BUFF64_PTR(handle, pos) ((handle)->buff + (size_t)((pos) % (handle)->size))
+
+typedef enum ring_buff64_state
+{
+	RING_BUFF64_STATE_ACTIVE = 1,  /**< Active (normal) state. */
+	RING_BUFF64_STATE_CANCELED = 2,/**< Buffering was canceled. */
+	RING_BUFF64_STATE_STOPPED = 4  /**< Buffer is stopped (e.g. end of stream). */
+} ring_buff64_state_t;
+
+/**
+ * 64-bit ring buffer structure. Positions are never wrapped, memory is at position modulo buffer size.
+ * Chunk that does not fit till the buffer end is placed at the beginning, and the space it skips
+ * (pad) is counted in positions, but not in stream offsets. There is at most one pad between
+ * the read and write position (two pads would be more than a buffer size apart).
+ */
+typedef struct ring_buff64_obj
+{
+	/** Buffer memory */
+	uint8_t* buff;
+	/** Buffer size */
+	uint64_t size;
+	/** Position up to which data is freed */
+	uint64_t read;
+	/** Position up to which data is read */
+	uint64_t acc;
+	/** Position up to which data is committed */
+	uint64_t commit;
+	/** Position up to which space is reserved */
+	uint64_t write;
+	/** The last pad start position */
+	uint64_t pad_start;
+	/** The last pad end position (it is equal to the start if there is no pad) */
+	uint64_t pad_end;
+	/** Size of all the pads so far (including the last one) */
+	uint64_t pad_total;
+	/** Watermarks */
+	uint64_t wm_low;
+	uint64_t wm_high;
+	ring_buff64_wm_cb_t wm_cb;
+	ring_buff_wm_level_t last_level;
+	/** Buffer state */
+	ring_buff64_state_t state;
+	ring_buff_mutex_t lock;
+	ring_buff_binary_sem_t read_sem;
+	ring_buff_binary_sem_t write_sem;
+} ring_buff64_obj_t;
+
+/**
+ * Internal function which converts position to the stream offset.
+ * @param obj Valid ring buffer object.
+ * @param pos Position (it must not be before the read position).
+ * @return Stream offset.
+ */
+static uint64_t ring_buff64_offset(ring_buff64_obj_t* obj, uint64_t pos);
+/**
+ * Internal function which returns size of the data that is committed, but not read.
+ * @param obj Valid ring buffer object.
+ * @return Size in bytes (pad is not counted).
+ */
+static uint64_t ring_buff64_queued(ring_buff64_obj_t* obj);
+/**
+ * Internal function which calls watermark callback, if committed data crossed the watermark.
+ * @param obj Valid ring buffer object.
+ * @return Error returned by the callback, or RING_BUFF_ERR_OK.
+ */
+static ring_buff_err_t ring_buff64_handle_wm(ring_buff64_obj_t* obj);
+
+ring_buff_err_t ring_buff64_create(ring_buff64_attr_t* attr, ring_buff64_handle_t* handle)
+{
+	ring_buff64_obj_t* obj = NULL;
+	ring_buff_err_t err_code = RING_BUFF_ERR_BAD_ARG;
+
+	if(attr == NULL || handle == NULL)
+	{
+		goto done;
+	}
+	if(attr->size == 0 || attr->buff == NULL || (uint64_t)(size_t)attr->size != attr->size)
+	{
+		goto done;
+	}
+	obj = malloc(sizeof(ring_buff64_obj_t));
+	if(obj == NULL)
+	{
+		err_code = RING_BUFF_ERR_NO_MEM;
+		goto done;
+	}
+	memset(obj, 0, sizeof(ring_buff64_obj_t));
+	obj->buff = attr->buff;
+	obj->size = attr->size;
+	obj->state = RING_BUFF64_STATE_ACTIVE;
+	obj->last_level = ring_buff_wm_low;
+	if(attr->wm_cb != NULL)
+	{
+		if(attr->wm_high > attr->size || attr->wm_low > attr->wm_high)
+		{
+			fprintf(stderr, "WARNING (%s): Watermarks set wrong. They will be turned OFF!\n", __func__);
+		}
+		else
+		{
+			obj->wm_low = attr->wm_low;
+			obj->wm_high = attr->wm_high;
+			obj->wm_cb = attr->wm_cb;
+		}
+	}
+	if(ring_buff_mutex_create(&(obj->lock)) != RING_BUFF_ERR_OK ||
+			ring_buff_binary_sem_create(&(obj->read_sem)) != RING_BUFF_ERR_OK ||
+			ring_buff_binary_sem_create(&(obj->write_sem)) != RING_BUFF_ERR_OK)
+	{
+		ring_buff64_destroy(obj);
+		obj = NULL;
+		err_code = RING_BUFF_ERR_INTERNAL;
+		goto done;
+	}
+	err_code = RING_BUFF_ERR_OK;
+
+done:
+	if(handle != NULL)
+	{
+		*handle = obj;
+	}
+	return err_code;
+}
+
+ring_buff_err_t ring_buff64_destroy(ring_buff64_handle_t handle)
+{
+	ring_buff64_obj_t* obj = GET_RING_BUFF64_OBJ(handle);
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	if(obj->lock != NULL)
+	{
+		ring_buff_mutex_destroy(obj->lock);
+	}
+	if(obj->read_sem != NULL)
+	{
+		ring_buff_binary_sem_destroy(obj->read_sem);
+	}
+	if(obj->write_sem != NULL)
+	{
+		ring_buff_binary_sem_destroy(obj->write_sem);
+	}
+	free(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff64_reserve(ring_buff64_handle_t handle, void** buff, uint64_t size, uint64_t* off)
+{
+	ring_buff64_obj_t* obj = GET_RING_BUFF64_OBJ(handle);
+	uint64_t start = 0;
+
+	if(obj == NULL || buff == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	if(size == 0 || size > obj->size)
+	{
+		return RING_BUFF_ERR_SIZE;
+	}
+	ENTER_RING_BUFF64_CONTEXT(obj);
+	for(;;)
+	{
+		if(obj->state != RING_BUFF64_STATE_ACTIVE)
+		{
+			LEAVE_RING_BUFF64_CONTEXT(obj);
+			return RING_BUFF_ERR_PERM;
+		}
+		/* chunk that does not fit till the buffer end starts at the beginning */
+		start = obj->write;
+		if(start % obj->size + size > obj->size)
+		{
+			start += obj->size - start % obj->size;
+		}
+		/* fullness is the position difference, so there is no need to keep the write behind the read */
+		if(start + size - obj->read <= obj->size)
+		{
+			break;
+		}
+		LEAVE_RING_BUFF64_CONTEXT(obj);
+		ring_buff_binary_sem_take(obj->write_sem);
+		ENTER_RING_BUFF64_CONTEXT(obj);
+	}
+	if(start != obj->write)
+	{
+		obj->pad_start = obj->write;
+		obj->pad_end = start;
+		obj->pad_total += start - obj->write;
+	}
+	*buff = RING_BUFF64_PTR(obj, start);
+	if(off != NULL)
+	{
+		*off = start - obj->pad_total;
+	}
+	obj->write = start + size;
+	/* semaphore is binary, pass the wake up to the other producer (there may be more space) */
+	ring_buff_binary_sem_give(obj->write_sem);
+	LEAVE_RING_BUFF64_CONTEXT(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff64_commit(ring_buff64_handle_t handle, void* buff, uint64_t size)
+{
+	ring_buff64_obj_t* obj = GET_RING_BUFF64_OBJ(handle);
+	uint64_t pos = 0;
+
+	if(obj == NULL || buff == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ENTER_RING_BUFF64_CONTEXT(obj);
+	pos = obj->commit;
+	/* chunk may be placed after the pad */
+	if(pos == obj->pad_start && pos != obj->pad_end)
+	{
+		pos = obj->pad_end;
+	}
+	if((uint8_t*)buff != RING_BUFF64_PTR(obj, pos))
+	{
+		LEAVE_RING_BUFF64_CONTEXT(obj);
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	if(pos + size > obj->write)
+	{
+		LEAVE_RING_BUFF64_CONTEXT(obj);
+		return RING_BUFF_ERR_SIZE;
+	}
+	obj->commit = pos + size;
+	ring_buff_binary_sem_give(obj->read_sem);
+	LEAVE_RING_BUFF64_CONTEXT(obj);
+	if(obj->wm_cb != NULL)
+	{
+		return ring_buff64_handle_wm(obj);
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff64_read(ring_buff64_handle_t handle, void** buff, uint64_t size, uint64_t* read, uint64_t* off)
+{
+	ring_buff64_obj_t* obj = GET_RING_BUFF64_OBJ(handle);
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	uint64_t end = 0;
+
+	if(obj == NULL || buff == NULL || size == 0 || size > obj->size || read == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ENTER_RING_BUFF64_CONTEXT(obj);
+	/* make sure that we have enough data available */
+	while(size > ring_buff64_queued(obj) && obj->state == RING_BUFF64_STATE_ACTIVE)
+	{
+		LEAVE_RING_BUFF64_CONTEXT(obj);
+		ring_buff_binary_sem_take(obj->read_sem);
+		ENTER_RING_BUFF64_CONTEXT(obj);
+	}
+	/* We can read, even if buffer has been stopped */
+	if(obj->state == RING_BUFF64_STATE_CANCELED)
+	{
+		LEAVE_RING_BUFF64_CONTEXT(obj);
+		return RING_BUFF_ERR_PERM;
+	}
+	if(size > ring_buff64_queued(obj))
+	{
+		size = ring_buff64_queued(obj);
+		err = RING_BUFF_ERR_PERM;
+	}
+	if(obj->acc == obj->pad_start && obj->pad_start != obj->pad_end)
+	{
+		obj->acc = obj->pad_end;
+	}
+	/* chunk must not wrap around the buffer end (data ends either at the pad or at the buffer end) */
+	end = obj->acc + obj->size - obj->acc % obj->size;
+	if(obj->acc < obj->pad_start && obj->pad_start < end)
+	{
+		end = obj->pad_start;
+	}
+	if(obj->acc + size > end)
+	{
+		size = end - obj->acc;
+	}
+	*buff = RING_BUFF64_PTR(obj, obj->acc);
+	*read = size;
+	if(off != NULL)
+	{
+		*off = ring_buff64_offset(obj, obj->acc);
+	}
+	obj->acc += size;
+	LEAVE_RING_BUFF64_CONTEXT(obj);
+	if(obj->wm_cb != NULL && size != 0)
+	{
+		ring_buff64_handle_wm(obj);
+	}
+
+	return err;
+}
+
+ring_buff_err_t ring_buff64_free(ring_buff64_handle_t handle, void* buff, uint64_t size)
+{
+	ring_buff64_obj_t* obj = GET_RING_BUFF64_OBJ(handle);
+	uint64_t pos = 0;
+
+	if(obj == NULL || buff == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ENTER_RING_BUFF64_CONTEXT(obj);
+	pos = obj->read;
+	if(pos == obj->pad_start && pos != obj->pad_end)
+	{
+		pos = obj->pad_end;
+	}
+	if((uint8_t*)buff != RING_BUFF64_PTR(obj, pos) || pos + size > obj->acc)
+	{
+		LEAVE_RING_BUFF64_CONTEXT(obj);
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	obj->read = pos + size;
+	ring_buff_binary_sem_give(obj->write_sem);
+	LEAVE_RING_BUFF64_CONTEXT(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff64_get_offsets(ring_buff64_handle_t handle, uint64_t* read, uint64_t* commit)
+{
+	ring_buff64_obj_t* obj = GET_RING_BUFF64_OBJ(handle);
+
+	if(obj == NULL || read == NULL || commit == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ENTER_RING_BUFF64_CONTEXT(obj);
+	*read = ring_buff64_offset(obj, obj->read);
+	*commit = ring_buff64_offset(obj, obj->commit);
+	LEAVE_RING_BUFF64_CONTEXT(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff64_cancel(ring_buff64_handle_t handle)
+{
+	ring_buff64_obj_t* obj = GET_RING_BUFF64_OBJ(handle);
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ENTER_RING_BUFF64_CONTEXT(obj);
+	obj->state = RING_BUFF64_STATE_CANCELED;
+	ring_buff_binary_sem_give(obj->read_sem);
+	ring_buff_binary_sem_give(obj->write_sem);
+	LEAVE_RING_BUFF64_CONTEXT(obj);
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff64_stop(ring_buff64_handle_t handle)
+{
+	ring_buff64_obj_t* obj = GET_RING_BUFF64_OBJ(handle);
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ENTER_RING_BUFF64_CONTEXT(obj);
+	obj->state = RING_BUFF64_STATE_STOPPED;
+	ring_buff_binary_sem_give(obj->read_sem);
+	ring_buff_binary_sem_give(obj->write_sem);
+	LEAVE_RING_BUFF64_CONTEXT(obj);
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff64_resume(ring_buff64_handle_t handle)
+{
+	ring_buff64_obj_t* obj = GET_RING_BUFF64_OBJ(handle);
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ENTER_RING_BUFF64_CONTEXT(obj);
+	/* reservations that are not committed are dropped, together with their pad */
+	if(obj->commit <= obj->pad_start)
+	{
+		obj->pad_total -= obj->pad_end - obj->pad_start;
+		obj->pad_end = obj->pad_start;
+	}
+	obj->read = obj->commit;
+	obj->acc = obj->commit;
+	obj->write = obj->commit;
+	obj->last_level = ring_buff_wm_low;
+	obj->state = RING_BUFF64_STATE_ACTIVE;
+	LEAVE_RING_BUFF64_CONTEXT(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+
+static uint64_t ring_buff64_offset(ring_buff64_obj_t* obj, uint64_t pos)
+{
+	/* the last pad is not before the position */
+	if(pos < obj->pad_end)
+	{
+		return pos - obj->pad_total + (obj->pad_end - obj->pad_start);
+	}
+
+	return pos - obj->pad_total;
+}
+
+static uint64_t ring_buff64_queued(ring_buff64_obj_t* obj)
+{
+	uint64_t queued = obj->commit - obj->acc;
+
+	if(obj->acc <= obj->pad_start && obj->pad_end <= obj->commit)
+	{
+		queued -= obj->pad_end - obj->pad_start;
+	}
+
+	return queued;
+}
+
+static ring_buff_err_t ring_buff64_handle_wm(ring_buff64_obj_t* obj)
+{
+	uint8_t notify = 0;
+	uint64_t queued = 0;
+
+	ENTER_RING_BUFF64_CONTEXT(obj);
+	queued = ring_buff64_queued(obj);
+	if((queued > obj->wm_high) && obj->last_level == ring_buff_wm_low)
+	{
+		obj->last_level = ring_buff_wm_high;
+		notify = 1;
+	}
+	else if((queued < obj->wm_low) && obj->last_level == ring_buff_wm_high)
+	{
+		obj->last_level = ring_buff_wm_low;
+		notify = 1;
+	}
+	LEAVE_RING_BUFF64_CONTEXT(obj);
+	if(notify != 0)
+	{
+		return obj->wm_cb(obj, obj->last_level);
+	}
+
+	return RING_BUFF_ERR_OK;
+}
@@ -0,0 +1,164 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+
+#ifndef RING_BUFF64_H_
+#define RING_BUFF64_H_
+
+#include "ring_buff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * 64-bit ring buffer. Sizes are 64-bit, so buffer may be larger than 4 GB. Read and write positions
+ * grow monotonically (they are never wrapped), so buffer fullness is just the difference between them,
+ * and there is no full/empty ambiguity. Every chunk has its absolute stream offset, i.e. the number of
+ * bytes committed before it (space skipped at the buffer end does not count), which may be used for indexing.
+ * It is used the same way as the read mode of the 32-bit ring buffer (reserve/commit, read/free).
+ */
+
+/** 64-bit ring buffer handle. */
+typedef void* ring_buff64_handle_t;
+/**
+ * Watermark callback (see "ring_buff_wm_cb_t").
+ * @param handle Ring buffer handle.
+ * @param level Watermark which is hit.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if ring buffer client detected some problem.
+ */
+typedef ring_buff_err_t (*ring_buff64_wm_cb_t) (ring_buff64_handle_t handle, ring_buff_wm_level_t level);
+
+/**
+ * 64-bit ring buffer attribute structure. It is used when ring buffer is created.
+ */
+typedef struct ring_buff64_attr
+{
+	/** Memory used for ring buffer. */
+	void* buff;
+	/** Buffer size. */
+	uint64_t size;
+	/** Low watermark value in bytes. It has to be between zero and wm_high. */
+	uint64_t wm_low;
+	/** High watermark value in bytes. It has to be less than buffer size. */
+	uint64_t wm_high;
+	/**
+	 * Watermark callback. It is called whenever data that is committed, but not read yet,
+	 * gets under wm_low, or whenever it gets over wm_high (only during the transition).
+	 */
+	ring_buff64_wm_cb_t wm_cb;
+} ring_buff64_attr_t;
+
+/**
+ * Creates 64-bit ring buffer.
+ * @param attr Ring buffer attribute object.
+ * @param handle Pointer to the handle. This argument must not be NULL.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff64_create(ring_buff64_attr_t *attr, ring_buff64_handle_t *handle);
+/**
+ * Ring buffer destructor function.
+ * @param handle Ring buffer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff64_destroy(ring_buff64_handle_t handle);
+/**
+ * Reserves continuous chunk of memory from ring buffer. Function blocks until there is enough free space.
+ * @param handle Ring buffer handle.
+ * @param buff Pointer to the reserved data. This is output value.
+ * @param size Requested buffer size in bytes.
+ * @param off Output argument that will contain stream offset of the chunk (it may be NULL).
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff64_reserve(ring_buff64_handle_t handle, void **buff, uint64_t size, uint64_t *off);
+/**
+ * Commits written data. Chunks have to be committed in the order they are reserved, with the reserved size.
+ * @param handle Ring buffer handle.
+ * @param buff Pointer to data that should be committed. This pointer is retrieved with "ring_buff64_reserve".
+ * @param size Committed data size in bytes.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff64_commit(ring_buff64_handle_t handle, void *buff, uint64_t size);
+/**
+ * Reads out requested size of data. Function blocks until there is enough data. Less data is returned
+ * if the chunk would wrap around the buffer end (the rest is returned with the next read).
+ * Data should be additionally freed with "ring_buff64_free".
+ * @param handle Ring buffer handle.
+ * @param buff Output argument that will contain pointer with read data.
+ * @param size Data size that should be read.
+ * @param read Output argument that will contain read data size.
+ * @param off Output argument that will contain stream offset of the read data (it may be NULL).
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem
+ * (RING_BUFF_ERR_PERM if buffer is stopped, with the rest of the data returned).
+ */
+ring_buff_err_t ring_buff64_read(ring_buff64_handle_t handle, void **buff, uint64_t size, uint64_t *read, uint64_t *off);
+/**
+ * Frees ring buffer chunk, so that it can be used for writing. Chunks have to be freed in the order they are read.
+ * @param handle Ring buffer handle.
+ * @param buff Pointer to data that should be freed.
+ * @param size Chunk length that should be freed.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff64_free(ring_buff64_handle_t handle, void *buff, uint64_t size);
+/**
+ * Returns stream offsets of the buffer ends. Data between them is in the buffer
+ * (it is committed, but not freed yet), so their difference is buffer fullness.
+ * @param handle Ring buffer handle.
+ * @param read Output argument that will contain stream offset of the oldest data that is not freed.
+ * @param commit Output argument that will contain stream offset of the end of committed data.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff64_get_offsets(ring_buff64_handle_t handle, uint64_t *read, uint64_t *commit);
+/**
+ * Stops further operations on ring buffer (see "ring_buff_cancel").
+ * @param handle Ring buffer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff64_cancel(ring_buff64_handle_t handle);
+/**
+ * Stops the buffer, reader can still read rest of the data (see "ring_buff_stop").
+ * @param handle Ring buffer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff64_stop(ring_buff64_handle_t handle);
+/**
+ * Resumes stopped/canceled buffer. Data is dropped, but stream offsets go on from the last commit.
+ * @param handle Ring buffer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff64_resume(ring_buff64_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RING_BUFF64_H_ */
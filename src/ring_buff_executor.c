@@ -0,0 +1,622 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring_buff_executor.h"
+#include "ring_buff_priv.h"
+#include "ring_buff_osal.h"
+
+#define GET_RING_BUFF_EXECUTOR_OBJ(handle) ((ring_buff_executor_obj_t*)handle)
+
+/**
+ * Consumer task states. Task is in at most one worker queue, and it is run by at most one worker.
+ */
+typedef enum ring_buff_task_state
+{
+	RING_BUFF_TASK_IDLE = 0,  /**< Waiting for data. */
+	RING_BUFF_TASK_SCHEDULED, /**< In the worker queue. */
+	RING_BUFF_TASK_RUNNING,   /**< Consumer is running. */
+	RING_BUFF_TASK_NOTIFIED,  /**< Consumer is running, and more data is committed meanwhile. */
+	RING_BUFF_TASK_REMOVED    /**< Task is removed. */
+} ring_buff_task_state_t;
+
+struct ring_buff_executor_obj;
+
+/**
+ * Consumer task.
+ */
+typedef struct ring_buff_task
+{
+	/** Ring buffer (NULL if task slot is free) */
+	ring_buff_handle_t ring;
+	/** Consumer function */
+	ring_buff_consumer_t consumer;
+	/** Consumer function argument */
+	void* arg;
+	/** Task state (ring_buff_task_state_t) */
+	uint32_t state;
+	/** Set when task is being removed */
+	uint8_t removed;
+	/** Set when consumer returned error (it is not scheduled anymore) */
+	uint8_t stopped;
+	/** Signaled when removed task is dropped by the worker (if remover did not drop it) */
+	ring_buff_binary_sem_t done_sem;
+	/** Executor */
+	struct ring_buff_executor_obj *executor;
+} ring_buff_task_t;
+
+/**
+ * Executor worker.
+ */
+typedef struct ring_buff_exec_worker
+{
+	/** Executor */
+	struct ring_buff_executor_obj *executor;
+	/** Worker thread */
+	ring_buff_thread_t thread;
+	/** Queue of ready tasks. Owner works on its tail (LIFO), others steal from its head (FIFO). */
+	ring_buff_task_t **queue;
+	/** Queue head */
+	uint32_t head;
+	/** Number of tasks in the queue */
+	uint32_t count;
+	/** Protects the queue */
+	ring_buff_mutex_t lock;
+	/** Statistics (written only by the worker) */
+	uint64_t runs;
+	uint64_t steals;
+} ring_buff_exec_worker_t;
+
+/**
+ * Executor structure.
+ */
+typedef struct ring_buff_executor_obj
+{
+	/** Workers */
+	ring_buff_exec_worker_t **workers;
+	/** Number of workers */
+	uint32_t count;
+	/** Tasks */
+	ring_buff_task_t *tasks;
+	/** Maximum number of tasks (it is also the worker queue size) */
+	uint32_t max;
+	/** Protects task table */
+	ring_buff_mutex_t lock;
+	/** Idle workers wait on it */
+	ring_buff_binary_sem_t idle_sem;
+	/** Number of idle workers */
+	uint32_t idle;
+	/** Number of tasks in all the queues */
+	uint32_t queued;
+	/** Next queue for tasks scheduled outside of the workers */
+	uint32_t next;
+	/** Worker of the calling thread */
+	ring_buff_tls_t tls;
+	/** Set when workers have to exit */
+	uint8_t exit;
+} ring_buff_executor_obj_t;
+
+/**
+ * Ring buffer event callback. It is called with ring buffer context acquired.
+ * @param arg Task.
+ * @param events Ring buffer events.
+ */
+static void ring_buff_executor_event(void* arg, uint32_t events);
+/**
+ * Internal function which schedules task (if it is not scheduled or running already).
+ * @param task Task.
+ */
+static void ring_buff_executor_notify(ring_buff_task_t* task);
+/**
+ * Internal function which puts task in the worker queue, and wakes up idle worker.
+ * @param obj Valid executor object.
+ * @param task Task.
+ */
+static void ring_buff_executor_push(ring_buff_executor_obj_t* obj, ring_buff_task_t* task);
+/**
+ * Internal function which takes task from own queue, or steals it from the other worker.
+ * @param worker Worker.
+ * @return Task, or NULL if all the queues are empty.
+ */
+static ring_buff_task_t* ring_buff_executor_take(ring_buff_exec_worker_t* worker);
+/**
+ * Internal function which runs the task.
+ * @param worker Worker.
+ * @param task Task.
+ */
+static void ring_buff_executor_run(ring_buff_exec_worker_t* worker, ring_buff_task_t* task);
+/**
+ * Internal function which drops the task that became idle, if it is removed meanwhile
+ * (remover may have seen it running, so it waits for the worker).
+ * @param task Task.
+ */
+static void ring_buff_executor_idle(ring_buff_task_t* task);
+/**
+ * Worker thread.
+ * @param arg Worker.
+ */
+static void ring_buff_executor_worker(void* arg);
+
+ring_buff_err_t ring_buff_executor_create(uint32_t workers, uint32_t max_rings, ring_buff_executor_handle_t *handle)
+{
+	ring_buff_executor_obj_t* obj = NULL;
+	ring_buff_exec_worker_t* worker = NULL;
+	ring_buff_err_t err_code = RING_BUFF_ERR_BAD_ARG;
+	uint32_t i = 0;
+
+	if(workers == 0 || max_rings == 0 || handle == NULL)
+	{
+		goto done;
+	}
+	err_code = RING_BUFF_ERR_NO_MEM;
+	obj = malloc(sizeof(ring_buff_executor_obj_t));
+	if(obj == NULL)
+	{
+		goto done;
+	}
+	memset(obj, 0, sizeof(ring_buff_executor_obj_t));
+	obj->workers = calloc(workers, sizeof(ring_buff_exec_worker_t*));
+	obj->tasks = calloc(max_rings, sizeof(ring_buff_task_t));
+	if(obj->workers == NULL || obj->tasks == NULL)
+	{
+		goto fail;
+	}
+	obj->max = max_rings;
+	if(ring_buff_mutex_create(&(obj->lock)) != RING_BUFF_ERR_OK ||
+			ring_buff_binary_sem_create(&(obj->idle_sem)) != RING_BUFF_ERR_OK ||
+			ring_buff_tls_create(&(obj->tls)) != RING_BUFF_ERR_OK)
+	{
+		goto fail;
+	}
+	/* queues are created up-front, worker may steal as soon as it starts */
+	for(i = 0; i < workers; i++)
+	{
+		worker = malloc(sizeof(ring_buff_exec_worker_t));
+		if(worker == NULL)
+		{
+			goto fail;
+		}
+		memset(worker, 0, sizeof(ring_buff_exec_worker_t));
+		obj->workers[i] = worker;
+		worker->executor = obj;
+		worker->queue = calloc(max_rings, sizeof(ring_buff_task_t*));
+		if(worker->queue == NULL || ring_buff_mutex_create(&(worker->lock)) != RING_BUFF_ERR_OK)
+		{
+			goto fail;
+		}
+	}
+	obj->count = workers;
+	for(i = 0; i < workers; i++)
+	{
+		if(ring_buff_thread_create(&(obj->workers[i]->thread), ring_buff_executor_worker, obj->workers[i]) != RING_BUFF_ERR_OK)
+		{
+			err_code = RING_BUFF_ERR_INTERNAL;
+			goto fail;
+		}
+	}
+	err_code = RING_BUFF_ERR_OK;
+	goto done;
+
+fail:
+	obj->count = workers;
+	ring_buff_executor_destroy(obj);
+	obj = NULL;
+done:
+	if(handle != NULL)
+	{
+		*handle = obj;
+	}
+	return err_code;
+}
+
+ring_buff_err_t ring_buff_executor_destroy(ring_buff_executor_handle_t handle)
+{
+	ring_buff_executor_obj_t* obj = GET_RING_BUFF_EXECUTOR_OBJ(handle);
+	ring_buff_exec_worker_t* worker = NULL;
+	uint32_t i = 0;
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	/* workers have to run while consumers are removed (they drop scheduled tasks) */
+	for(i = 0; obj->tasks != NULL && i < obj->max; i++)
+	{
+		if(obj->tasks[i].ring != NULL)
+		{
+			ring_buff_executor_remove(obj, obj->tasks[i].ring);
+		}
+	}
+	__atomic_store_n(&(obj->exit), 1, __ATOMIC_SEQ_CST);
+	if(obj->idle_sem != NULL)
+	{
+		ring_buff_binary_sem_give(obj->idle_sem);
+	}
+	for(i = 0; obj->workers != NULL && i < obj->count; i++)
+	{
+		worker = obj->workers[i];
+		if(worker == NULL)
+		{
+			continue;
+		}
+		if(worker->thread != NULL)
+		{
+			ring_buff_thread_join(worker->thread);
+		}
+		if(worker->lock != NULL)
+		{
+			ring_buff_mutex_destroy(worker->lock);
+		}
+		free(worker->queue);
+		free(worker);
+	}
+	if(obj->tls != NULL)
+	{
+		ring_buff_tls_destroy(obj->tls);
+	}
+	if(obj->idle_sem != NULL)
+	{
+		ring_buff_binary_sem_destroy(obj->idle_sem);
+	}
+	if(obj->lock != NULL)
+	{
+		ring_buff_mutex_destroy(obj->lock);
+	}
+	free(obj->workers);
+	free(obj->tasks);
+	free(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_executor_add(ring_buff_executor_handle_t handle, ring_buff_handle_t ring,
+		ring_buff_consumer_t consumer, void* arg)
+{
+	ring_buff_executor_obj_t* obj = GET_RING_BUFF_EXECUTOR_OBJ(handle);
+	ring_buff_task_t* task = NULL;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	uint32_t i = 0;
+
+	if(obj == NULL || ring == NULL || consumer == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ring_buff_mutex_lock(obj->lock);
+	for(i = 0; i < obj->max; i++)
+	{
+		if(obj->tasks[i].ring == ring)
+		{
+			ring_buff_mutex_unlock(obj->lock);
+			return RING_BUFF_ERR_PERM;
+		}
+		if(task == NULL && obj->tasks[i].ring == NULL)
+		{
+			task = &(obj->tasks[i]);
+		}
+	}
+	if(task == NULL)
+	{
+		ring_buff_mutex_unlock(obj->lock);
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	memset(task, 0, sizeof(ring_buff_task_t));
+	err = ring_buff_binary_sem_create(&(task->done_sem));
+	if(err != RING_BUFF_ERR_OK)
+	{
+		ring_buff_mutex_unlock(obj->lock);
+		return err;
+	}
+	/* semaphore is created signaled, it is given only when the worker drops the removed task */
+	ring_buff_binary_sem_take(task->done_sem);
+	task->ring = ring;
+	task->consumer = consumer;
+	task->arg = arg;
+	task->executor = obj;
+	task->state = RING_BUFF_TASK_IDLE;
+	ring_buff_mutex_unlock(obj->lock);
+	err = ring_buff_set_event_cb(ring, ring_buff_executor_event, task);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		ring_buff_mutex_lock(obj->lock);
+		ring_buff_binary_sem_destroy(task->done_sem);
+		task->ring = NULL;
+		ring_buff_mutex_unlock(obj->lock);
+		return err;
+	}
+	/* there may be data already */
+	if(ring_buff_get_events(ring) & RING_BUFF_EVENT_READ)
+	{
+		ring_buff_executor_notify(task);
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_executor_remove(ring_buff_executor_handle_t handle, ring_buff_handle_t ring)
+{
+	ring_buff_executor_obj_t* obj = GET_RING_BUFF_EXECUTOR_OBJ(handle);
+	ring_buff_task_t* task = NULL;
+	uint32_t state = RING_BUFF_TASK_IDLE;
+	uint32_t i = 0;
+
+	if(obj == NULL || ring == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ring_buff_mutex_lock(obj->lock);
+	for(i = 0; i < obj->max && task == NULL; i++)
+	{
+		if(obj->tasks[i].ring == ring)
+		{
+			task = &(obj->tasks[i]);
+		}
+	}
+	ring_buff_mutex_unlock(obj->lock);
+	if(task == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	__atomic_store_n(&(task->removed), 1, __ATOMIC_SEQ_CST);
+	/* after this, task is not notified anymore */
+	ring_buff_set_event_cb(ring, NULL, NULL);
+	/* idle task is dropped here, task that is scheduled or running is dropped by the worker */
+	if(!__atomic_compare_exchange_n(&(task->state), &state, RING_BUFF_TASK_REMOVED, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+	{
+		ring_buff_binary_sem_take(task->done_sem);
+	}
+	ring_buff_mutex_lock(obj->lock);
+	ring_buff_binary_sem_destroy(task->done_sem);
+	task->ring = NULL;
+	ring_buff_mutex_unlock(obj->lock);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_executor_get_stats(ring_buff_executor_handle_t handle, ring_buff_executor_stats_t *stats)
+{
+	ring_buff_executor_obj_t* obj = GET_RING_BUFF_EXECUTOR_OBJ(handle);
+	uint32_t i = 0;
+
+	if(obj == NULL || stats == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	memset(stats, 0, sizeof(ring_buff_executor_stats_t));
+	for(i = 0; i < obj->count; i++)
+	{
+		stats->runs += __atomic_load_n(&(obj->workers[i]->runs), __ATOMIC_RELAXED);
+		stats->steals += __atomic_load_n(&(obj->workers[i]->steals), __ATOMIC_RELAXED);
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+
+static void ring_buff_executor_event(void* arg, uint32_t events)
+{
+	if(events & RING_BUFF_EVENT_READ)
+	{
+		ring_buff_executor_notify((ring_buff_task_t*)arg);
+	}
+}
+
+static void ring_buff_executor_notify(ring_buff_task_t* task)
+{
+	uint32_t state = RING_BUFF_TASK_IDLE;
+
+	for(;;)
+	{
+		state = __atomic_load_n(&(task->state), __ATOMIC_SEQ_CST);
+		if(state == RING_BUFF_TASK_IDLE)
+		{
+			if(__atomic_load_n(&(task->stopped), __ATOMIC_RELAXED))
+			{
+				return;
+			}
+			if(__atomic_compare_exchange_n(&(task->state), &state, RING_BUFF_TASK_SCHEDULED, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+			{
+				ring_buff_executor_push(task->executor, task);
+				return;
+			}
+		}
+		/* running consumer is scheduled again when it returns */
+		else if(state == RING_BUFF_TASK_RUNNING)
+		{
+			if(__atomic_compare_exchange_n(&(task->state), &state, RING_BUFF_TASK_NOTIFIED, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+			{
+				return;
+			}
+		}
+		else
+		{
+			return;
+		}
+	}
+}
+
+static void ring_buff_executor_push(ring_buff_executor_obj_t* obj, ring_buff_task_t* task)
+{
+	ring_buff_exec_worker_t* worker = NULL;
+
+	/* worker keeps the tasks it schedules (cache locality), others are spread over the workers */
+	worker = (ring_buff_exec_worker_t*)ring_buff_tls_get(obj->tls);
+	if(worker == NULL)
+	{
+		worker = obj->workers[__atomic_fetch_add(&(obj->next), 1, __ATOMIC_RELAXED) % obj->count];
+	}
+	ring_buff_mutex_lock(worker->lock);
+	worker->queue[(worker->head + worker->count) % obj->max] = task;
+	worker->count++;
+	ring_buff_mutex_unlock(worker->lock);
+	__atomic_add_fetch(&(obj->queued), 1, __ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&(obj->idle), __ATOMIC_SEQ_CST) != 0)
+	{
+		ring_buff_binary_sem_give(obj->idle_sem);
+	}
+}
+
+static ring_buff_task_t* ring_buff_executor_take(ring_buff_exec_worker_t* worker)
+{
+	ring_buff_executor_obj_t* obj = worker->executor;
+	ring_buff_exec_worker_t* victim = NULL;
+	ring_buff_task_t* task = NULL;
+	uint32_t self = 0;
+	uint32_t i = 0;
+
+	/* own queue first, newest task */
+	ring_buff_mutex_lock(worker->lock);
+	if(worker->count != 0)
+	{
+		worker->count--;
+		task = worker->queue[(worker->head + worker->count) % obj->max];
+	}
+	ring_buff_mutex_unlock(worker->lock);
+	if(task != NULL)
+	{
+		__atomic_sub_fetch(&(obj->queued), 1, __ATOMIC_SEQ_CST);
+		return task;
+	}
+	/* steal the oldest task of the other worker, starting from the next one */
+	for(self = 0; obj->workers[self] != worker; self++);
+	for(i = 1; i < obj->count && task == NULL; i++)
+	{
+		victim = obj->workers[(self + i) % obj->count];
+		ring_buff_mutex_lock(victim->lock);
+		if(victim->count != 0)
+		{
+			task = victim->queue[victim->head];
+			victim->head = (victim->head + 1) % obj->max;
+			victim->count--;
+		}
+		ring_buff_mutex_unlock(victim->lock);
+	}
+	if(task != NULL)
+	{
+		__atomic_sub_fetch(&(obj->queued), 1, __ATOMIC_SEQ_CST);
+		__atomic_store_n(&(worker->steals), worker->steals + 1, __ATOMIC_RELAXED);
+	}
+
+	return task;
+}
+
+static void ring_buff_executor_run(ring_buff_exec_worker_t* worker, ring_buff_task_t* task)
+{
+	ring_buff_executor_obj_t* obj = worker->executor;
+	uint32_t state = RING_BUFF_TASK_RUNNING;
+
+	/* more tasks are waiting, pass the wake up to the other idle worker */
+	if(__atomic_load_n(&(obj->queued), __ATOMIC_SEQ_CST) != 0 && __atomic_load_n(&(obj->idle), __ATOMIC_SEQ_CST) != 0)
+	{
+		ring_buff_binary_sem_give(obj->idle_sem);
+	}
+	__atomic_store_n(&(task->state), RING_BUFF_TASK_RUNNING, __ATOMIC_SEQ_CST);
+	if(!__atomic_load_n(&(task->removed), __ATOMIC_SEQ_CST))
+	{
+		if(task->consumer(task->ring, task->arg) != RING_BUFF_ERR_OK)
+		{
+			__atomic_store_n(&(task->stopped), 1, __ATOMIC_RELAXED);
+		}
+		__atomic_store_n(&(worker->runs), worker->runs + 1, __ATOMIC_RELAXED);
+	}
+	if(__atomic_load_n(&(task->removed), __ATOMIC_SEQ_CST))
+	{
+		__atomic_store_n(&(task->state), RING_BUFF_TASK_REMOVED, __ATOMIC_SEQ_CST);
+		/* remover frees the task once it is signaled, so it must be the last access */
+		ring_buff_binary_sem_give(task->done_sem);
+		return;
+	}
+	/* consumer may leave data for later (so that the others get their turn). Task is still owned here,
+	 * once it is idle it may be removed at any time. */
+	if(!__atomic_load_n(&(task->stopped), __ATOMIC_RELAXED) && (ring_buff_get_events(task->ring) & RING_BUFF_EVENT_READ))
+	{
+		__atomic_store_n(&(task->state), RING_BUFF_TASK_SCHEDULED, __ATOMIC_SEQ_CST);
+		ring_buff_executor_push(obj, task);
+		return;
+	}
+	if(!__atomic_compare_exchange_n(&(task->state), &state, RING_BUFF_TASK_IDLE, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+	{
+		/* data committed while consumer was running */
+		if(!__atomic_load_n(&(task->stopped), __ATOMIC_RELAXED))
+		{
+			__atomic_store_n(&(task->state), RING_BUFF_TASK_SCHEDULED, __ATOMIC_SEQ_CST);
+			ring_buff_executor_push(obj, task);
+			return;
+		}
+		__atomic_store_n(&(task->state), RING_BUFF_TASK_IDLE, __ATOMIC_SEQ_CST);
+	}
+	ring_buff_executor_idle(task);
+}
+
+static void ring_buff_executor_idle(ring_buff_task_t* task)
+{
+	uint32_t state = RING_BUFF_TASK_IDLE;
+
+	/* either remover or this worker moves the idle task to removed, and only the worker signals it */
+	if(__atomic_load_n(&(task->removed), __ATOMIC_SEQ_CST) &&
+			__atomic_compare_exchange_n(&(task->state), &state, RING_BUFF_TASK_REMOVED, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+	{
+		ring_buff_binary_sem_give(task->done_sem);
+	}
+}
+
+static void ring_buff_executor_worker(void* arg)
+{
+	ring_buff_exec_worker_t* worker = (ring_buff_exec_worker_t*)arg;
+	ring_buff_executor_obj_t* obj = worker->executor;
+	ring_buff_task_t* task = NULL;
+
+	ring_buff_tls_set(obj->tls, worker);
+	while(!__atomic_load_n(&(obj->exit), __ATOMIC_SEQ_CST))
+	{
+		task = ring_buff_executor_take(worker);
+		if(task == NULL)
+		{
+			/* check the queues once more after becoming idle, task might be pushed without the wake up */
+			__atomic_add_fetch(&(obj->idle), 1, __ATOMIC_SEQ_CST);
+			task = ring_buff_executor_take(worker);
+			if(task == NULL && !__atomic_load_n(&(obj->exit), __ATOMIC_SEQ_CST))
+			{
+				ring_buff_binary_sem_take(obj->idle_sem);
+			}
+			__atomic_sub_fetch(&(obj->idle), 1, __ATOMIC_SEQ_CST);
+		}
+		if(task != NULL)
+		{
+			ring_buff_executor_run(worker, task);
+		}
+	}
+	/* let the other workers know as well */
+	ring_buff_binary_sem_give(obj->idle_sem);
+}
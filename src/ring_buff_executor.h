@@ -0,0 +1,118 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+#ifndef RING_BUFF_EXECUTOR_H_
+#define RING_BUFF_EXECUTOR_H_
+
+#include "ring_buff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Executor handle.
+ */
+typedef void* ring_buff_executor_handle_t;
+
+/**
+ * Consumer function prototype. It is called from one of the executor workers whenever ring buffer
+ * has data. It is never called concurrently for the same ring buffer. It should NOT block
+ * (e.g. it should use "ring_buff_try_claim"), and it should process a bounded amount of data:
+ * if there is more data left, consumer is scheduled again, so that other ring buffers get their turn.
+ * @param ring Ring buffer handle.
+ * @param arg Argument passed when ring buffer is added to the executor.
+ * @return RING_BUFF_ERR_OK to keep consuming, or error to stop scheduling the consumer
+ * (e.g. when ring buffer is stopped and drained). Ring buffer still has to be removed from the executor.
+ */
+typedef ring_buff_err_t (*ring_buff_consumer_t) (ring_buff_handle_t ring, void* arg);
+
+/**
+ * Executor statistics.
+ */
+typedef struct ring_buff_executor_stats
+{
+	/** Consumer calls. */
+	uint64_t runs;
+	/** Consumers taken from the other worker. */
+	uint64_t steals;
+} ring_buff_executor_stats_t;
+
+/**
+ * Creates executor with a fixed pool of worker threads that serve ring buffer consumers.
+ * Each worker keeps its own queue of ready consumers, and takes consumers from the other
+ * workers when its queue is empty, so the load is spread across the workers.
+ * @param workers Number of worker threads.
+ * @param max_rings Maximum number of ring buffers.
+ * @param handle Pointer to the handle. This argument must not be NULL.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_executor_create(uint32_t workers, uint32_t max_rings, ring_buff_executor_handle_t *handle);
+/**
+ * Executor destructor function. Worker threads are stopped, and all ring buffers are removed.
+ * @param handle Executor handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_executor_destroy(ring_buff_executor_handle_t handle);
+/**
+ * Adds ring buffer consumer. Consumer is scheduled whenever data is committed to the ring buffer.
+ * Ring buffer can NOT be added to the executor and to the ring buffer set at the same time.
+ * @param handle Executor handle.
+ * @param ring Ring buffer handle.
+ * @param consumer Consumer function.
+ * @param arg Consumer function argument.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_NO_MEM if there are too many ring buffers,
+ * or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_executor_add(ring_buff_executor_handle_t handle, ring_buff_handle_t ring,
+		ring_buff_consumer_t consumer, void* arg);
+/**
+ * Removes ring buffer consumer. When function returns, consumer is not running, and it will not be called anymore.
+ * It must NOT be called from the consumer function.
+ * @param handle Executor handle.
+ * @param ring Ring buffer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_executor_remove(ring_buff_executor_handle_t handle, ring_buff_handle_t ring);
+/**
+ * Returns executor statistics (summed over all the workers).
+ * @param handle Executor handle.
+ * @param stats Output argument that will contain executor statistics.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_executor_get_stats(ring_buff_executor_handle_t handle, ring_buff_executor_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RING_BUFF_EXECUTOR_H_ */
@@ -58,6 +58,24 @@ ring_buff_err_t ring_buff_mutex_create(ring_buff_mutex_t *handle);
  * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
  */
 ring_buff_err_t ring_buff_mutex_destroy(ring_buff_mutex_t handle);
+/**
+ * Returns size of the memory needed to initialize mutex in place (see "ring_buff_mutex_init").
+ * @return Size in bytes.
+ */
+uint32_t ring_buff_mutex_size(void);
+/**
+ * Initializes mutex in the memory provided by the caller (nothing is allocated).
+ * @param mem Memory of "ring_buff_mutex_size" bytes, aligned to 8 bytes at least.
+ * @param handle Pointer to the handle. This argument must not be NULL.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_mutex_init(void* mem, ring_buff_mutex_t *handle);
+/**
+ * Releases resources of the mutex initialized with "ring_buff_mutex_init" (memory is not freed).
+ * @param handle Mutex handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_mutex_deinit(ring_buff_mutex_t handle);
 /**
  * Locks mutex.
  * @param handle Mutex handle.
@@ -93,12 +111,38 @@ ring_buff_err_t ring_buff_binary_sem_create(ring_buff_binary_sem_t *handle);
  * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
  */
 ring_buff_err_t ring_buff_binary_sem_destroy(ring_buff_binary_sem_t handle);
+/**
+ * Returns size of the memory needed to initialize binary semaphore in place (see "ring_buff_binary_sem_init").
+ * @return Size in bytes.
+ */
+uint32_t ring_buff_binary_sem_size(void);
+/**
+ * Initializes binary semaphore in the memory provided by the caller (nothing is allocated).
+ * @param mem Memory of "ring_buff_binary_sem_size" bytes, aligned to 8 bytes at least.
+ * @param handle Pointer to the handle. This argument must not be NULL.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_binary_sem_init(void* mem, ring_buff_binary_sem_t *handle);
+/**
+ * Releases resources of the binary semaphore initialized with "ring_buff_binary_sem_init" (memory is not freed).
+ * @param handle Binary semaphore handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_binary_sem_deinit(ring_buff_binary_sem_t handle);
 /**
  * Takes binary semaphore.
  * @param handle Binary semaphore handle.
  * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
  */
 ring_buff_err_t ring_buff_binary_sem_take(ring_buff_binary_sem_t handle);
+/**
+ * Takes binary semaphore, waiting for it up to the given time.
+ * @param handle Binary semaphore handle.
+ * @param timeout_us Timeout in microseconds.
+ * @return RING_BUFF_ERR_OK if semaphore is taken, RING_BUFF_ERR_WOULD_BLOCK on timeout,
+ * or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_binary_sem_take_timed(ring_buff_binary_sem_t handle, uint32_t timeout_us);
 /**
  * Gives binary semaphore.
  * @param handle Binary semaphore handle.
@@ -106,6 +150,293 @@ ring_buff_err_t ring_buff_binary_sem_take(ring_buff_binary_sem_t handle);
  */
 ring_buff_err_t ring_buff_binary_sem_give(ring_buff_binary_sem_t handle);
 
+
+/**
+ * OSAL backend of a ring buffer: its lock and semaphores (see "osal" ring buffer attribute).
+ * Functions have the same meaning as the mutex and binary semaphore functions above.
+ * Custom backend may be used as well, binary semaphore has to be created up (given).
+ */
+typedef struct ring_buff_osal_ops
+{
+	uint32_t (*mutex_size)(void);
+	ring_buff_err_t (*mutex_init)(void* mem, ring_buff_mutex_t *handle);
+	ring_buff_err_t (*mutex_deinit)(ring_buff_mutex_t handle);
+	ring_buff_err_t (*mutex_lock)(ring_buff_mutex_t handle);
+	ring_buff_err_t (*mutex_unlock)(ring_buff_mutex_t handle);
+	uint32_t (*binary_sem_size)(void);
+	ring_buff_err_t (*binary_sem_init)(void* mem, ring_buff_binary_sem_t *handle);
+	ring_buff_err_t (*binary_sem_deinit)(ring_buff_binary_sem_t handle);
+	ring_buff_err_t (*binary_sem_take)(ring_buff_binary_sem_t handle);
+	ring_buff_err_t (*binary_sem_give)(ring_buff_binary_sem_t handle);
+} ring_buff_osal_ops_t;
+
+/** Default backend (mutex, and semaphore based on condition variable). It is used if "osal" attribute is not set. */
+extern const ring_buff_osal_ops_t ring_buff_osal_posix;
+/**
+ * Spinning backend. Nothing ever sleeps in the kernel, waiting threads spin on the CPU (yielding it
+ * now and then). It is meant for latency-critical buffers whose threads have CPUs of their own.
+ */
+extern const ring_buff_osal_ops_t ring_buff_osal_spin;
+/**
+ * Futex backend. Lock and give/take that are not contended do not enter the kernel
+ * (default backend is used where futexes are not available).
+ */
+extern const ring_buff_osal_ops_t ring_buff_osal_futex;
+/** Priority inheritance backend. Lock holder inherits the priority of the threads that wait for it. */
+extern const ring_buff_osal_ops_t ring_buff_osal_pi;
+
+/**
+ * Returns monotonic time in microseconds. It should be cheap enough to be called on data path
+ * (e.g. no system call).
+ * @return Current time in microseconds.
+ */
+uint64_t ring_buff_time_us(void);
+
+
+/**
+ * Timer handle.
+ */
+typedef void* ring_buff_timer_t;
+/**
+ * Timer callback. It is called from the timer context (not from the one that armed the timer).
+ * Callbacks of all timers are called from one shared thread, so they should not block for long.
+ * @param arg Argument passed on timer creation.
+ */
+typedef void (*ring_buff_timer_cb_t) (void* arg);
+
+/**
+ * Creates new one-shot timer. Timer is created disarmed.
+ * @param handle Pointer to the handle. This argument must not be NULL. If function returns
+ * without error, this pointer will point to timer handle which is required for other
+ * timer operations.
+ * @param cb Callback which is called when timer expires.
+ * @param arg Callback argument.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_timer_create(ring_buff_timer_t *handle, ring_buff_timer_cb_t cb, void* arg);
+/**
+ * Timer destructor function. When it returns, callback is not executing, and it will not be called anymore.
+ * @param handle Timer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_timer_destroy(ring_buff_timer_t handle);
+/**
+ * Arms the timer. If timer is already armed, expiration time is replaced.
+ * @param handle Timer handle.
+ * @param expires Absolute expiration time in microseconds (see "ring_buff_time_us").
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_timer_arm(ring_buff_timer_t handle, uint64_t expires);
+
+
+/**
+ * Thread local storage key handle.
+ */
+typedef void* ring_buff_tls_t;
+
+/**
+ * Creates new thread local storage key. Value is initially NULL in all threads.
+ * @param handle Pointer to the handle. This argument must not be NULL. If function returns
+ * without error, this pointer will point to key handle which is required for other
+ * thread local storage operations.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_tls_create(ring_buff_tls_t *handle);
+/**
+ * Thread local storage value destructor. Called on thread exit with the non NULL value
+ * of the exiting thread.
+ * @param value Value set by the exiting thread.
+ */
+typedef void (*ring_buff_tls_dtor_t)(void *value);
+/**
+ * Creates new thread local storage key with value destructor. Value is initially NULL in
+ * all threads. Destructor is not called for threads exiting after the key is destroyed.
+ * @param handle Pointer to the handle. This argument must not be NULL. If function returns
+ * without error, this pointer will point to key handle which is required for other
+ * thread local storage operations.
+ * @param dtor Value destructor, or NULL if values are not released on thread exit.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_tls_create_with_dtor(ring_buff_tls_t *handle, ring_buff_tls_dtor_t dtor);
+/**
+ * Thread local storage key destructor function. Values stored are not freed.
+ * @param handle Thread local storage key handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_tls_destroy(ring_buff_tls_t handle);
+/**
+ * Returns value of the calling thread.
+ * @param handle Thread local storage key handle.
+ * @return Value set by the calling thread, or NULL if it is not set.
+ */
+void* ring_buff_tls_get(ring_buff_tls_t handle);
+/**
+ * Sets value of the calling thread.
+ * @param handle Thread local storage key handle.
+ * @param value Value to set.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_tls_set(ring_buff_tls_t handle, void* value);
+
+
+/**
+ * Thread handle.
+ */
+typedef void* ring_buff_thread_t;
+/**
+ * Thread function.
+ * @param arg Argument passed on thread creation.
+ */
+typedef void (*ring_buff_thread_func_t) (void* arg);
+
+/**
+ * Creates and starts new thread.
+ * @param handle Pointer to the handle. This argument must not be NULL. If function returns
+ * without error, this pointer will point to thread handle which is required for joining the thread.
+ * @param func Thread function.
+ * @param arg Thread function argument.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_thread_create(ring_buff_thread_t *handle, ring_buff_thread_func_t func, void* arg);
+/**
+ * Waits for the thread to finish, and frees its resources.
+ * @param handle Thread handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_thread_join(ring_buff_thread_t handle);
+
+/**
+ * File mapping handle.
+ */
+typedef void* ring_buff_file_map_t;
+
+/**
+ * Maps file into memory (shared mapping, so that changes are written to the file).
+ * File is created if it does not exist.
+ * @param handle Pointer to the handle. This argument must not be NULL. If function returns
+ * without error, this pointer will point to file mapping handle which is required for other
+ * file mapping operations.
+ * @param path File path.
+ * @param size Mapping size. Existing file must be of the same size.
+ * @param addr Output argument that will contain mapped memory.
+ * @param created Output argument that is set if file is created (its content is zero).
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_SIZE if existing file size
+ * is not the same, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_file_map(ring_buff_file_map_t *handle, const char* path, uint32_t size, void** addr, uint8_t* created);
+/**
+ * Writes mapped memory range to the file, and waits until it is durable.
+ * @param handle File mapping handle.
+ * @param addr Range start (it does not have to be page aligned).
+ * @param size Range size.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_file_sync(ring_buff_file_map_t handle, void* addr, uint32_t size);
+/**
+ * Unmaps memory, and closes the file. Changes that are not synced are written back eventually.
+ * @param handle File mapping handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_file_unmap(ring_buff_file_map_t handle);
+
+/**
+ * File handle.
+ */
+typedef void* ring_buff_file_t;
+
+/**
+ * Opens file for reading and writing. File is created if it does not exist, and it is truncated if it does.
+ * @param handle Pointer to the handle. This argument must not be NULL. If function returns
+ * without error, this pointer will point to file handle which is required for other file operations.
+ * @param path File path.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_file_open(ring_buff_file_t *handle, const char* path);
+/**
+ * Opens file for direct writing, bypassing the page cache. File is created if it does not exist,
+ * and it is truncated if it does. Buffer address, file offset and size of every write have to be
+ * multiple of the device block size.
+ * @param handle Pointer to the handle. This argument must not be NULL.
+ * @param path File path.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_PERM if direct I/O is not supported
+ * (by the system or the file system), or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_file_open_direct(ring_buff_file_t *handle, const char* path);
+/**
+ * Closes the file.
+ * @param handle File handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_file_close(ring_buff_file_t handle);
+/**
+ * Writes data at the given file offset.
+ * @param handle File handle.
+ * @param off File offset.
+ * @param buff Data.
+ * @param size Data size.
+ * @return RING_BUFF_ERR_OK if all the data is written, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_file_write(ring_buff_file_t handle, uint64_t off, const void* buff, uint32_t size);
+/**
+ * Reads data from the given file offset.
+ * @param handle File handle.
+ * @param off File offset.
+ * @param buff Buffer for the data.
+ * @param size Data size.
+ * @return RING_BUFF_ERR_OK if all the data is read, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_file_read(ring_buff_file_t handle, uint64_t off, void* buff, uint32_t size);
+/**
+ * Changes the file size.
+ * @param handle File handle.
+ * @param size New file size.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_file_truncate(ring_buff_file_t handle, uint64_t size);
+
+/**
+ * Gives memory pages back to the system. Pages that are entirely in the range are dropped
+ * (range is page aligned inwards), and they are faulted in again (zeroed) on the next access.
+ * Memory must not be a file mapping.
+ * @param addr Range start (it does not have to be page aligned).
+ * @param size Range size.
+ * @param released Output argument that will contain number of bytes given back.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_mem_release(void* addr, uint32_t size, uint32_t* released);
+/**
+ * Locks memory in RAM and prefaults it, so that it is never paged out, nor faulted in on the first access.
+ * Locking is not nested (pages that are shared with other locked memory are unlocked together with it).
+ * @param addr Range start (it does not have to be page aligned).
+ * @param size Range size.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_NO_MEM if memory can not be locked (e.g. limit
+ * for locked memory is reached), or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_mem_lock(void* addr, uint32_t size);
+/**
+ * Unlocks memory locked with "ring_buff_mem_lock".
+ * @param addr Range start.
+ * @param size Range size.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_mem_unlock(void* addr, uint32_t size);
+/**
+ * Allocates memory that is locked in RAM and prefaulted. It occupies pages of its own, so it
+ * does not share locking with other memory.
+ * @param size Memory size.
+ * @param addr Output argument that will contain allocated memory.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_NO_MEM if memory can not be
+ * allocated or locked, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_mem_alloc_locked(uint32_t size, void** addr);
+/**
+ * Frees memory allocated with "ring_buff_mem_alloc_locked".
+ * @param addr Memory to be freed.
+ * @param size Memory size.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_mem_free_locked(void* addr, uint32_t size);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
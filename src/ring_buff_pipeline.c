@@ -0,0 +1,472 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring_buff_pipeline.h"
+#include "ring_buff_priv.h"
+#include "ring_buff_osal.h"
+
+#define GET_RING_BUFF_PIPELINE_OBJ(handle) ((ring_buff_pipeline_obj_t*)handle)
+#define GET_RING_BUFF_WORKER(ctx) ((ring_buff_worker_t*)ctx)
+
+/* Maximum number of stages */
+#define RING_BUFF_PIPELINE_STAGES 16
+
+struct ring_buff_pipeline_obj;
+
+/**
+ * Stage worker. Statistics are kept per worker, so that workers don't share counters.
+ */
+typedef struct ring_buff_worker
+{
+	/** Pipeline */
+	struct ring_buff_pipeline_obj *pipeline;
+	/** Stage index */
+	uint32_t stage;
+	/** Worker thread */
+	ring_buff_thread_t thread;
+	/** Statistics (written only by the worker) */
+	uint64_t records;
+	uint64_t bytes;
+	uint64_t errors;
+	uint64_t busy_us;
+	uint64_t idle_us;
+} ring_buff_worker_t;
+
+/**
+ * Pipeline stage.
+ */
+typedef struct ring_buff_stage
+{
+	/** Stage attributes */
+	ring_buff_stage_attr_t attr;
+	/** Stage input */
+	ring_buff_handle_t ring;
+	/** Stage input memory */
+	void* buff;
+	/** Workers */
+	ring_buff_worker_t **workers;
+	/** Number of workers that are still running */
+	uint32_t live;
+} ring_buff_stage_t;
+
+/**
+ * Pipeline structure.
+ */
+typedef struct ring_buff_pipeline_obj
+{
+	/** Stages */
+	ring_buff_stage_t stages[RING_BUFF_PIPELINE_STAGES];
+	/** Number of stages */
+	uint32_t count;
+	/** Default stage input buffer size */
+	uint32_t buff_size;
+	/** Set when pipeline is started */
+	uint8_t started;
+} ring_buff_pipeline_obj_t;
+
+/**
+ * Stage worker thread.
+ * @param arg Stage worker.
+ */
+static void ring_buff_pipeline_worker(void* arg);
+/**
+ * Internal function which stops the stage workers and frees stage resources.
+ * @param stage Stage.
+ */
+static void ring_buff_pipeline_free_stage(ring_buff_stage_t* stage);
+
+ring_buff_err_t ring_buff_pipeline_create(uint32_t buff_size, ring_buff_pipeline_handle_t *handle)
+{
+	ring_buff_pipeline_obj_t* obj = NULL;
+	ring_buff_err_t err_code = RING_BUFF_ERR_BAD_ARG;
+
+	if(buff_size == 0 || handle == NULL)
+	{
+		goto done;
+	}
+	obj = malloc(sizeof(ring_buff_pipeline_obj_t));
+	if(obj == NULL)
+	{
+		err_code = RING_BUFF_ERR_NO_MEM;
+		goto done;
+	}
+	memset(obj, 0, sizeof(ring_buff_pipeline_obj_t));
+	obj->buff_size = buff_size;
+	err_code = RING_BUFF_ERR_OK;
+
+done:
+	if(handle != NULL)
+	{
+		*handle = obj;
+	}
+	return err_code;
+}
+
+ring_buff_err_t ring_buff_pipeline_destroy(ring_buff_pipeline_handle_t handle)
+{
+	ring_buff_pipeline_obj_t* obj = GET_RING_BUFF_PIPELINE_OBJ(handle);
+	uint32_t i = 0;
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	if(obj->started)
+	{
+		ring_buff_pipeline_stop(obj);
+	}
+	for(i = 0; i < obj->count; i++)
+	{
+		ring_buff_pipeline_free_stage(&(obj->stages[i]));
+	}
+	free(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_pipeline_add_stage(ring_buff_pipeline_handle_t handle, ring_buff_stage_attr_t *attr)
+{
+	ring_buff_pipeline_obj_t* obj = GET_RING_BUFF_PIPELINE_OBJ(handle);
+	ring_buff_stage_t* stage = NULL;
+
+	if(obj == NULL || attr == NULL || attr->transform == NULL || attr->workers == 0)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	if(obj->started)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+	if(obj->count == RING_BUFF_PIPELINE_STAGES)
+	{
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	stage = &(obj->stages[obj->count]);
+	memset(stage, 0, sizeof(ring_buff_stage_t));
+	stage->attr = *attr;
+	if(stage->attr.buff_size == 0)
+	{
+		stage->attr.buff_size = obj->buff_size;
+	}
+	obj->count++;
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_pipeline_start(ring_buff_pipeline_handle_t handle)
+{
+	ring_buff_pipeline_obj_t* obj = GET_RING_BUFF_PIPELINE_OBJ(handle);
+	ring_buff_stage_t* stage = NULL;
+	ring_buff_attr_t ring_attr;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	uint32_t i = 0;
+	uint32_t j = 0;
+
+	if(obj == NULL || obj->count == 0)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	/* pipeline can be started only once */
+	if(obj->started || obj->stages[0].ring != NULL)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+	/* all the stage inputs have to exist before any worker starts emitting */
+	for(i = 0; i < obj->count; i++)
+	{
+		stage = &(obj->stages[i]);
+		stage->buff = malloc(stage->attr.buff_size);
+		stage->workers = calloc(stage->attr.workers, sizeof(ring_buff_worker_t*));
+		if(stage->buff == NULL || stage->workers == NULL)
+		{
+			err = RING_BUFF_ERR_NO_MEM;
+			goto fail;
+		}
+		memset(&ring_attr, 0, sizeof(ring_buff_attr_t));
+		ring_attr.buff = stage->buff;
+		ring_attr.size = stage->attr.buff_size;
+		ring_attr.records = 1;
+		err = ring_buff_create(&ring_attr, &(stage->ring));
+		if(err != RING_BUFF_ERR_OK)
+		{
+			goto fail;
+		}
+	}
+	for(i = 0; i < obj->count; i++)
+	{
+		stage = &(obj->stages[i]);
+		for(j = 0; j < stage->attr.workers; j++)
+		{
+			stage->workers[j] = malloc(sizeof(ring_buff_worker_t));
+			if(stage->workers[j] == NULL)
+			{
+				err = RING_BUFF_ERR_NO_MEM;
+				goto fail;
+			}
+			memset(stage->workers[j], 0, sizeof(ring_buff_worker_t));
+			stage->workers[j]->pipeline = obj;
+			stage->workers[j]->stage = i;
+			__atomic_add_fetch(&(stage->live), 1, __ATOMIC_RELAXED);
+			err = ring_buff_thread_create(&(stage->workers[j]->thread), ring_buff_pipeline_worker, stage->workers[j]);
+			if(err != RING_BUFF_ERR_OK)
+			{
+				__atomic_sub_fetch(&(stage->live), 1, __ATOMIC_RELAXED);
+				goto fail;
+			}
+		}
+	}
+	obj->started = 1;
+
+	return RING_BUFF_ERR_OK;
+
+fail:
+	/* workers that are started exit once their input is stopped */
+	for(i = 0; i < obj->count; i++)
+	{
+		if(obj->stages[i].ring != NULL)
+		{
+			ring_buff_cancel(obj->stages[i].ring);
+		}
+	}
+	for(i = 0; i < obj->count; i++)
+	{
+		ring_buff_pipeline_free_stage(&(obj->stages[i]));
+	}
+
+	return err;
+}
+
+ring_buff_err_t ring_buff_pipeline_reserve(ring_buff_pipeline_handle_t handle, void **buff, uint32_t size)
+{
+	ring_buff_pipeline_obj_t* obj = GET_RING_BUFF_PIPELINE_OBJ(handle);
+
+	if(obj == NULL || !obj->started)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+
+	return ring_buff_reserve(obj->stages[0].ring, buff, size);
+}
+
+ring_buff_err_t ring_buff_pipeline_commit(ring_buff_pipeline_handle_t handle, void *buff, uint32_t size)
+{
+	ring_buff_pipeline_obj_t* obj = GET_RING_BUFF_PIPELINE_OBJ(handle);
+
+	if(obj == NULL || !obj->started)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+
+	return ring_buff_commit(obj->stages[0].ring, buff, size);
+}
+
+ring_buff_err_t ring_buff_pipeline_emit_reserve(ring_buff_pipeline_ctx_t ctx, void **buff, uint32_t size)
+{
+	ring_buff_worker_t* worker = GET_RING_BUFF_WORKER(ctx);
+
+	if(worker == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	if(worker->stage + 1 == worker->pipeline->count)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+
+	return ring_buff_reserve(worker->pipeline->stages[worker->stage + 1].ring, buff, size);
+}
+
+ring_buff_err_t ring_buff_pipeline_emit_commit(ring_buff_pipeline_ctx_t ctx, void *buff, uint32_t size)
+{
+	ring_buff_worker_t* worker = GET_RING_BUFF_WORKER(ctx);
+
+	if(worker == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	if(worker->stage + 1 == worker->pipeline->count)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+
+	return ring_buff_commit(worker->pipeline->stages[worker->stage + 1].ring, buff, size);
+}
+
+ring_buff_err_t ring_buff_pipeline_emit(ring_buff_pipeline_ctx_t ctx, const void *buff, uint32_t size)
+{
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	void* out = NULL;
+
+	err = ring_buff_pipeline_emit_reserve(ctx, &out, size);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		return err;
+	}
+	memcpy(out, buff, size);
+
+	return ring_buff_pipeline_emit_commit(ctx, out, size);
+}
+
+ring_buff_err_t ring_buff_pipeline_stop(ring_buff_pipeline_handle_t handle)
+{
+	ring_buff_pipeline_obj_t* obj = GET_RING_BUFF_PIPELINE_OBJ(handle);
+	ring_buff_stage_t* stage = NULL;
+	uint32_t i = 0;
+	uint32_t j = 0;
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	if(!obj->started)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+	/* stop propagates downstream: last worker of the stage stops the next stage input once it drains its own */
+	ring_buff_stop(obj->stages[0].ring);
+	for(i = 0; i < obj->count; i++)
+	{
+		stage = &(obj->stages[i]);
+		for(j = 0; j < stage->attr.workers; j++)
+		{
+			ring_buff_thread_join(stage->workers[j]->thread);
+			stage->workers[j]->thread = NULL;
+		}
+	}
+	obj->started = 0;
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_pipeline_get_stats(ring_buff_pipeline_handle_t handle, uint32_t stage, ring_buff_stage_stats_t *stats)
+{
+	ring_buff_pipeline_obj_t* obj = GET_RING_BUFF_PIPELINE_OBJ(handle);
+	ring_buff_worker_t* worker = NULL;
+	uint32_t i = 0;
+
+	if(obj == NULL || stats == NULL || stage >= obj->count)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	memset(stats, 0, sizeof(ring_buff_stage_stats_t));
+	if(obj->stages[stage].workers == NULL)
+	{
+		return RING_BUFF_ERR_OK;
+	}
+	for(i = 0; i < obj->stages[stage].attr.workers; i++)
+	{
+		worker = obj->stages[stage].workers[i];
+		if(worker == NULL)
+		{
+			continue;
+		}
+		stats->records += __atomic_load_n(&(worker->records), __ATOMIC_RELAXED);
+		stats->bytes += __atomic_load_n(&(worker->bytes), __ATOMIC_RELAXED);
+		stats->errors += __atomic_load_n(&(worker->errors), __ATOMIC_RELAXED);
+		stats->busy_us += __atomic_load_n(&(worker->busy_us), __ATOMIC_RELAXED);
+		stats->idle_us += __atomic_load_n(&(worker->idle_us), __ATOMIC_RELAXED);
+	}
+	stats->queued = ring_buff_get_queued(obj->stages[stage].ring);
+
+	return RING_BUFF_ERR_OK;
+}
+
+
+static void ring_buff_pipeline_worker(void* arg)
+{
+	ring_buff_worker_t* worker = GET_RING_BUFF_WORKER(arg);
+	ring_buff_pipeline_obj_t* obj = worker->pipeline;
+	ring_buff_stage_t* stage = &(obj->stages[worker->stage]);
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	uint64_t start = 0;
+	uint64_t now = 0;
+	uint32_t size = 0;
+	void* buff = NULL;
+
+	start = ring_buff_time_us();
+	while(ring_buff_claim(stage->ring, &buff, &size) == RING_BUFF_ERR_OK)
+	{
+		now = ring_buff_time_us();
+		__atomic_store_n(&(worker->idle_us), worker->idle_us + (now - start), __ATOMIC_RELAXED);
+		start = now;
+		err = stage->attr.transform(worker, buff, size, stage->attr.arg);
+		ring_buff_release(stage->ring, buff);
+		now = ring_buff_time_us();
+		__atomic_store_n(&(worker->busy_us), worker->busy_us + (now - start), __ATOMIC_RELAXED);
+		__atomic_store_n(&(worker->records), worker->records + 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&(worker->bytes), worker->bytes + size, __ATOMIC_RELAXED);
+		if(err != RING_BUFF_ERR_OK)
+		{
+			__atomic_store_n(&(worker->errors), worker->errors + 1, __ATOMIC_RELAXED);
+		}
+		start = now;
+	}
+	/* the last worker out stops the next stage, it will process what is left and stop as well */
+	if(__atomic_sub_fetch(&(stage->live), 1, __ATOMIC_ACQ_REL) == 0 && worker->stage + 1 < obj->count)
+	{
+		ring_buff_stop(obj->stages[worker->stage + 1].ring);
+	}
+}
+
+static void ring_buff_pipeline_free_stage(ring_buff_stage_t* stage)
+{
+	uint32_t i = 0;
+
+	if(stage->workers != NULL)
+	{
+		for(i = 0; i < stage->attr.workers; i++)
+		{
+			if(stage->workers[i] != NULL)
+			{
+				if(stage->workers[i]->thread != NULL)
+				{
+					ring_buff_thread_join(stage->workers[i]->thread);
+				}
+				free(stage->workers[i]);
+			}
+		}
+		free(stage->workers);
+		stage->workers = NULL;
+	}
+	if(stage->ring != NULL)
+	{
+		ring_buff_destroy(stage->ring);
+		stage->ring = NULL;
+	}
+	free(stage->buff);
+	stage->buff = NULL;
+	stage->live = 0;
+}
@@ -0,0 +1,188 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+#ifndef RING_BUFF_PIPELINE_H_
+#define RING_BUFF_PIPELINE_H_
+
+#include "ring_buff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Pipeline handle.
+ */
+typedef void* ring_buff_pipeline_handle_t;
+/**
+ * Stage worker context. It is passed to the transform function, and used to emit data downstream.
+ */
+typedef void* ring_buff_pipeline_ctx_t;
+
+/**
+ * Transform function prototype. It is called for every record in the stage input, from one of
+ * the stage worker threads. Record memory is valid only during the call. Output is passed to the
+ * next stage with "ring_buff_pipeline_emit" (copy), or with "ring_buff_pipeline_emit_reserve" and
+ * "ring_buff_pipeline_emit_commit" (transform writes straight into the next stage input).
+ * @param ctx Stage worker context.
+ * @param buff Record data.
+ * @param size Record size.
+ * @param arg Stage argument.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error (it is counted in the stage statistics).
+ */
+typedef ring_buff_err_t (*ring_buff_transform_t) (ring_buff_pipeline_ctx_t ctx, void* buff, uint32_t size, void* arg);
+
+/**
+ * Stage attribute structure.
+ */
+typedef struct ring_buff_stage_attr
+{
+	/** Transform function. */
+	ring_buff_transform_t transform;
+	/** Transform function argument. */
+	void* arg;
+	/** Number of worker threads (parallelism). Records may be emitted out of order if it is more than 1. */
+	uint32_t workers;
+	/** Stage input buffer size. If set to 0, pipeline default is used. */
+	uint32_t buff_size;
+} ring_buff_stage_attr_t;
+
+/**
+ * Stage statistics.
+ */
+typedef struct ring_buff_stage_stats
+{
+	/** Records processed. */
+	uint64_t records;
+	/** Bytes processed. */
+	uint64_t bytes;
+	/** Transform errors. */
+	uint64_t errors;
+	/** Time spent in the transform function, summed over the workers (microseconds). */
+	uint64_t busy_us;
+	/** Time spent waiting for the input, summed over the workers (microseconds). */
+	uint64_t idle_us;
+	/** Bytes queued in the stage input (committed, but not processed yet). */
+	uint32_t queued;
+} ring_buff_stage_stats_t;
+
+/**
+ * Creates pipeline. Stages are added with "ring_buff_pipeline_add_stage", and pipeline is started
+ * with "ring_buff_pipeline_start". Each stage has its own input ring buffer (in record mode), so stage
+ * may block only on its input (no data) or on the next stage input (backpressure).
+ * @param buff_size Default stage input buffer size.
+ * @param handle Pointer to the handle. This argument must not be NULL.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pipeline_create(uint32_t buff_size, ring_buff_pipeline_handle_t *handle);
+/**
+ * Pipeline destructor function. Pipeline is stopped first, if it is running.
+ * @param handle Pipeline handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pipeline_destroy(ring_buff_pipeline_handle_t handle);
+/**
+ * Adds stage at the end of the pipeline. It can be called only before the pipeline is started.
+ * @param handle Pipeline handle.
+ * @param attr Stage attribute object.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pipeline_add_stage(ring_buff_pipeline_handle_t handle, ring_buff_stage_attr_t *attr);
+/**
+ * Starts the pipeline (stage input buffers and workers are created).
+ * @param handle Pipeline handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pipeline_start(ring_buff_pipeline_handle_t handle);
+/**
+ * Reserves record in the pipeline input (first stage). It may be called from more than one thread.
+ * @param handle Pipeline handle.
+ * @param buff Output argument that will contain pointer to the reserved record.
+ * @param size Record size.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pipeline_reserve(ring_buff_pipeline_handle_t handle, void **buff, uint32_t size);
+/**
+ * Commits record reserved with "ring_buff_pipeline_reserve".
+ * @param handle Pipeline handle.
+ * @param buff Pointer to the reserved record.
+ * @param size Record size.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pipeline_commit(ring_buff_pipeline_handle_t handle, void *buff, uint32_t size);
+/**
+ * Reserves record in the next stage input. It is called from the transform function.
+ * @param ctx Stage worker context.
+ * @param buff Output argument that will contain pointer to the reserved record.
+ * @param size Record size.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_PERM if called from the last stage,
+ * or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pipeline_emit_reserve(ring_buff_pipeline_ctx_t ctx, void **buff, uint32_t size);
+/**
+ * Commits record reserved with "ring_buff_pipeline_emit_reserve".
+ * @param ctx Stage worker context.
+ * @param buff Pointer to the reserved record.
+ * @param size Record size.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pipeline_emit_commit(ring_buff_pipeline_ctx_t ctx, void *buff, uint32_t size);
+/**
+ * Copies record to the next stage input. It is called from the transform function.
+ * @param ctx Stage worker context.
+ * @param buff Record data.
+ * @param size Record size.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_PERM if called from the last stage,
+ * or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pipeline_emit(ring_buff_pipeline_ctx_t ctx, const void *buff, uint32_t size);
+/**
+ * Stops the pipeline. Records that are already in the pipeline are processed by all the stages
+ * before the function returns.
+ * @param handle Pipeline handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pipeline_stop(ring_buff_pipeline_handle_t handle);
+/**
+ * Returns stage statistics. It may be called while pipeline is running.
+ * @param handle Pipeline handle.
+ * @param stage Stage index (in order stages are added, starting from 0).
+ * @param stats Output argument that will contain stage statistics.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pipeline_get_stats(ring_buff_pipeline_handle_t handle, uint32_t stage, ring_buff_stage_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RING_BUFF_PIPELINE_H_ */
@@ -0,0 +1,413 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring_buff_pool.h"
+#include "ring_buff_osal.h"
+
+#define GET_RING_BUFF_POOL_OBJ(handle) ((ring_buff_pool_obj_t*)handle)
+/* Rounds size up to the ring storage alignment */
+#define RING_BUFF_POOL_ROUND(size) (((size) + RING_BUFF_STORAGE_ALIGN - 1) & ~(RING_BUFF_STORAGE_ALIGN - 1))
+
+struct ring_buff_pool_obj;
+struct ring_buff_pool_class_obj;
+
+/**
+ * Pooled ring. It is placed right before the ring storage, and the buffer follows the storage,
+ * so that the whole ring is one allocation:
+ * | alignment | entry | ring storage (aligned) | buffer |
+ */
+typedef struct ring_buff_pool_entry
+{
+	/** Allocated memory */
+	void* mem;
+	/** Next idle ring in the class */
+	struct ring_buff_pool_entry *next;
+	/** Class that ring belongs to */
+	struct ring_buff_pool_class_obj *cls;
+	/** Pool that ring belongs to */
+	struct ring_buff_pool_obj *pool;
+	/** Set while ring is acquired */
+	uint8_t used;
+} ring_buff_pool_entry_t;
+
+/**
+ * Size class.
+ */
+typedef struct ring_buff_pool_class_obj
+{
+	/** Buffer size */
+	uint32_t size;
+	/** Number of rings created together with the pool */
+	uint32_t initial;
+	/** Maximum number of rings (0 means no limit) */
+	uint32_t max;
+	/** Number of rings (idle and acquired) */
+	uint32_t count;
+	/** Number of idle rings */
+	uint32_t idle;
+	/** Idle rings (the most recently released first, its memory is likely still in the cache) */
+	ring_buff_pool_entry_t *free;
+} ring_buff_pool_class_obj_t;
+
+/**
+ * Ring buffer pool structure.
+ */
+typedef struct ring_buff_pool_obj
+{
+	/** Ring attributes */
+	ring_buff_attr_t ring_attr;
+	/** Size classes (ascending sizes) */
+	ring_buff_pool_class_obj_t *classes;
+	/** Number of size classes */
+	uint32_t class_count;
+	/** Ring storage size */
+	uint32_t storage_size;
+	/** Number of acquired rings */
+	uint32_t used;
+	/** Protects the classes */
+	ring_buff_mutex_t lock;
+} ring_buff_pool_obj_t;
+
+/**
+ * Internal function which creates a ring in the class, and adds it to the idle rings.
+ * It expects that pool lock is acquired by the caller (or that pool is not shared yet).
+ * @param obj Valid pool object.
+ * @param cls Size class.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+static ring_buff_err_t ring_buff_pool_add(ring_buff_pool_obj_t* obj, ring_buff_pool_class_obj_t* cls);
+/**
+ * Internal function which destroys idle ring.
+ * @param entry Pooled ring (it is not in the idle list anymore).
+ */
+static void ring_buff_pool_free(ring_buff_pool_entry_t* entry);
+
+ring_buff_err_t ring_buff_pool_create(ring_buff_pool_attr_t *attr, ring_buff_pool_handle_t *handle)
+{
+	ring_buff_pool_obj_t* obj = NULL;
+	ring_buff_pool_class_obj_t cls;
+	ring_buff_err_t err_code = RING_BUFF_ERR_BAD_ARG;
+	uint32_t i = 0, j = 0;
+
+	if(attr == NULL || handle == NULL || attr->classes == NULL || attr->class_count == 0)
+	{
+		goto done;
+	}
+	for(i = 0; i < attr->class_count; i++)
+	{
+		if(attr->classes[i].size == 0 || (attr->classes[i].max && attr->classes[i].count > attr->classes[i].max))
+		{
+			goto done;
+		}
+	}
+	obj = malloc(sizeof(ring_buff_pool_obj_t));
+	if(obj == NULL)
+	{
+		err_code = RING_BUFF_ERR_NO_MEM;
+		goto done;
+	}
+	memset(obj, 0, sizeof(ring_buff_pool_obj_t));
+	obj->classes = calloc(attr->class_count, sizeof(ring_buff_pool_class_obj_t));
+	if(obj->classes == NULL || ring_buff_mutex_create(&(obj->lock)) != RING_BUFF_ERR_OK)
+	{
+		ring_buff_pool_destroy(obj);
+		obj = NULL;
+		err_code = RING_BUFF_ERR_NO_MEM;
+		goto done;
+	}
+	obj->class_count = attr->class_count;
+	obj->ring_attr = attr->ring_attr;
+	obj->ring_attr.buff = NULL;
+	obj->ring_attr.size = 0;
+	obj->storage_size = RING_BUFF_POOL_ROUND(ring_buff_get_storage_size(&(obj->ring_attr)));
+	/* classes are kept sorted, so the first one that fits is the smallest */
+	for(i = 0; i < attr->class_count; i++)
+	{
+		memset(&cls, 0, sizeof(cls));
+		cls.size = attr->classes[i].size;
+		cls.initial = attr->classes[i].count;
+		cls.max = attr->classes[i].max;
+		for(j = i; j > 0 && obj->classes[j - 1].size > cls.size; j--)
+		{
+			obj->classes[j] = obj->classes[j - 1];
+		}
+		obj->classes[j] = cls;
+	}
+	for(i = 0; i < attr->class_count; i++)
+	{
+		for(j = 0; j < obj->classes[i].initial; j++)
+		{
+			err_code = ring_buff_pool_add(obj, &(obj->classes[i]));
+			if(err_code != RING_BUFF_ERR_OK)
+			{
+				ring_buff_pool_destroy(obj);
+				obj = NULL;
+				goto done;
+			}
+		}
+	}
+	err_code = RING_BUFF_ERR_OK;
+
+done:
+	if(handle != NULL)
+	{
+		*handle = obj;
+	}
+	return err_code;
+}
+
+ring_buff_err_t ring_buff_pool_destroy(ring_buff_pool_handle_t handle)
+{
+	ring_buff_pool_obj_t* obj = GET_RING_BUFF_POOL_OBJ(handle);
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	if(obj->used)
+	{
+		return RING_BUFF_ERR_PERM;
+	}
+	/* rings are added only once the lock is created */
+	if(obj->lock != NULL)
+	{
+		ring_buff_pool_trim(obj, 0, NULL);
+	}
+	free(obj->classes);
+	if(obj->lock != NULL)
+	{
+		ring_buff_mutex_destroy(obj->lock);
+	}
+	free(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_pool_acquire(ring_buff_pool_handle_t handle, uint32_t size, ring_buff_handle_t *ring)
+{
+	ring_buff_pool_obj_t* obj = GET_RING_BUFF_POOL_OBJ(handle);
+	ring_buff_pool_class_obj_t* cls = NULL;
+	ring_buff_pool_entry_t* entry = NULL;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	uint32_t i = 0;
+
+	if(obj == NULL || ring == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	*ring = NULL;
+	for(i = 0; i < obj->class_count && cls == NULL; i++)
+	{
+		if(obj->classes[i].size >= size)
+		{
+			cls = &(obj->classes[i]);
+		}
+	}
+	if(cls == NULL)
+	{
+		return RING_BUFF_ERR_SIZE;
+	}
+	ring_buff_mutex_lock(obj->lock);
+	/* slow path, pool grows */
+	if(cls->free == NULL)
+	{
+		if(cls->max && cls->count >= cls->max)
+		{
+			ring_buff_mutex_unlock(obj->lock);
+			return RING_BUFF_ERR_WOULD_BLOCK;
+		}
+		err = ring_buff_pool_add(obj, cls);
+		if(err != RING_BUFF_ERR_OK)
+		{
+			ring_buff_mutex_unlock(obj->lock);
+			return err;
+		}
+	}
+	entry = cls->free;
+	cls->free = entry->next;
+	cls->idle--;
+	entry->next = NULL;
+	entry->used = 1;
+	obj->used++;
+	ring_buff_mutex_unlock(obj->lock);
+	/* ring storage follows the entry */
+	*ring = (uint8_t*)entry + RING_BUFF_POOL_ROUND(sizeof(ring_buff_pool_entry_t));
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_pool_release(ring_buff_pool_handle_t handle, ring_buff_handle_t ring)
+{
+	ring_buff_pool_obj_t* obj = GET_RING_BUFF_POOL_OBJ(handle);
+	ring_buff_pool_entry_t* entry = NULL;
+
+	if(obj == NULL || ring == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	entry = (ring_buff_pool_entry_t*)((uint8_t*)ring - RING_BUFF_POOL_ROUND(sizeof(ring_buff_pool_entry_t)));
+	if(entry->pool != obj || !entry->used)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	/* ring is handed out in the state it has after creation */
+	ring_buff_resume(ring);
+	ring_buff_mutex_lock(obj->lock);
+	entry->used = 0;
+	entry->next = entry->cls->free;
+	entry->cls->free = entry;
+	entry->cls->idle++;
+	obj->used--;
+	ring_buff_mutex_unlock(obj->lock);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_pool_trim(ring_buff_pool_handle_t handle, uint32_t keep, uint64_t *freed)
+{
+	ring_buff_pool_obj_t* obj = GET_RING_BUFF_POOL_OBJ(handle);
+	ring_buff_pool_entry_t* list = NULL;
+	ring_buff_pool_entry_t* entry = NULL;
+	ring_buff_pool_class_obj_t* cls = NULL;
+	uint64_t size = 0;
+	uint32_t i = 0;
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	/* rings are unlinked under the lock, and destroyed after */
+	ring_buff_mutex_lock(obj->lock);
+	for(i = 0; i < obj->class_count; i++)
+	{
+		cls = &(obj->classes[i]);
+		while(cls->idle > keep)
+		{
+			entry = cls->free;
+			cls->free = entry->next;
+			cls->idle--;
+			cls->count--;
+			entry->next = list;
+			list = entry;
+			size += obj->storage_size + cls->size;
+		}
+	}
+	ring_buff_mutex_unlock(obj->lock);
+	while(list != NULL)
+	{
+		entry = list;
+		list = entry->next;
+		ring_buff_pool_free(entry);
+	}
+	if(freed != NULL)
+	{
+		*freed = size;
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_pool_get_count(ring_buff_pool_handle_t handle, uint32_t *idle, uint32_t *used)
+{
+	ring_buff_pool_obj_t* obj = GET_RING_BUFF_POOL_OBJ(handle);
+	uint32_t i = 0;
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	ring_buff_mutex_lock(obj->lock);
+	if(idle != NULL)
+	{
+		*idle = 0;
+		for(i = 0; i < obj->class_count; i++)
+		{
+			*idle += obj->classes[i].idle;
+		}
+	}
+	if(used != NULL)
+	{
+		*used = obj->used;
+	}
+	ring_buff_mutex_unlock(obj->lock);
+
+	return RING_BUFF_ERR_OK;
+}
+
+
+static ring_buff_err_t ring_buff_pool_add(ring_buff_pool_obj_t* obj, ring_buff_pool_class_obj_t* cls)
+{
+	ring_buff_pool_entry_t* entry = NULL;
+	ring_buff_attr_t attr = obj->ring_attr;
+	ring_buff_handle_t ring = NULL;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	uint8_t* mem = NULL;
+	uint8_t* storage = NULL;
+
+	/* malloc alignment is not enough for the ring storage, so memory is aligned here */
+	mem = malloc(RING_BUFF_STORAGE_ALIGN + RING_BUFF_POOL_ROUND(sizeof(ring_buff_pool_entry_t)) + obj->storage_size + cls->size);
+	if(mem == NULL)
+	{
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	storage = (uint8_t*)RING_BUFF_POOL_ROUND((size_t)mem + RING_BUFF_POOL_ROUND(sizeof(ring_buff_pool_entry_t)));
+	attr.buff = storage + obj->storage_size;
+	attr.size = cls->size;
+	err = ring_buff_init(&attr, storage, obj->storage_size, &ring);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		free(mem);
+		return err;
+	}
+	entry = (ring_buff_pool_entry_t*)(storage - RING_BUFF_POOL_ROUND(sizeof(ring_buff_pool_entry_t)));
+	entry->mem = mem;
+	entry->cls = cls;
+	entry->pool = obj;
+	entry->used = 0;
+	entry->next = cls->free;
+	cls->free = entry;
+	cls->idle++;
+	cls->count++;
+
+	return RING_BUFF_ERR_OK;
+}
+
+static void ring_buff_pool_free(ring_buff_pool_entry_t* entry)
+{
+	ring_buff_destroy((uint8_t*)entry + RING_BUFF_POOL_ROUND(sizeof(ring_buff_pool_entry_t)));
+	free(entry->mem);
+}
@@ -0,0 +1,131 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+
+#ifndef RING_BUFF_POOL_H_
+#define RING_BUFF_POOL_H_
+
+#include "ring_buff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Ring buffer pool handle.
+ */
+typedef void* ring_buff_pool_handle_t;
+
+/**
+ * Ring buffer pool size class.
+ */
+typedef struct ring_buff_pool_class
+{
+	/** Buffer size of the rings in the class. */
+	uint32_t size;
+	/** Number of rings created together with the pool. */
+	uint32_t count;
+	/** Maximum number of rings in the class (0 means no limit). Rings over "count" are created on demand. */
+	uint32_t max;
+} ring_buff_pool_class_t;
+
+/**
+ * Ring buffer pool attribute structure. It is used when ring buffer pool is created.
+ */
+typedef struct ring_buff_pool_attr
+{
+	/**
+	 * Attributes of the rings in the pool ("buff" and "size" are ignored). Rings are created in place
+	 * (see "ring_buff_init"), so features that need more resources can NOT be used.
+	 */
+	ring_buff_attr_t ring_attr;
+	/** Size classes. */
+	const ring_buff_pool_class_t *classes;
+	/** Number of size classes. */
+	uint32_t class_count;
+} ring_buff_pool_attr_t;
+
+/**
+ * Creates ring buffer pool. Every ring in the pool (object and buffer) is a single allocation,
+ * so acquiring a pooled ring does not allocate, nor create OSAL objects.
+ * @param attr Ring buffer pool attribute object.
+ * @param handle Pointer to the handle. This argument must not be NULL.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pool_create(ring_buff_pool_attr_t *attr, ring_buff_pool_handle_t *handle);
+/**
+ * Ring buffer pool destructor function. All the rings have to be released before.
+ * @param handle Ring buffer pool handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_PERM if some ring is not released,
+ * or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pool_destroy(ring_buff_pool_handle_t handle);
+/**
+ * Acquires ring from the smallest size class that fits the requested size. If there is no idle ring
+ * in the class, new one is created (unless the class is at its maximum).
+ * @param handle Ring buffer pool handle.
+ * @param size Minimum buffer size.
+ * @param ring Output argument that will contain ring buffer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_SIZE if no class is large enough,
+ * RING_BUFF_ERR_WOULD_BLOCK if the class is at its maximum, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pool_acquire(ring_buff_pool_handle_t handle, uint32_t size, ring_buff_handle_t *ring);
+/**
+ * Releases ring back to the pool. Ring is reset (see "ring_buff_resume"), so its data is dropped.
+ * Ring must not be used (nor be a member of some set) anymore.
+ * @param handle Ring buffer pool handle.
+ * @param ring Ring buffer handle, as returned by "ring_buff_pool_acquire".
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pool_release(ring_buff_pool_handle_t handle, ring_buff_handle_t ring);
+/**
+ * Frees idle rings (e.g. under memory pressure), so that at most "keep" idle rings are left in every class.
+ * @param handle Ring buffer pool handle.
+ * @param keep Number of idle rings to keep per class.
+ * @param freed Output argument that will contain number of bytes freed (may be NULL).
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pool_trim(ring_buff_pool_handle_t handle, uint32_t keep, uint64_t *freed);
+/**
+ * Returns number of rings in the pool.
+ * @param handle Ring buffer pool handle.
+ * @param idle Output argument that will contain number of idle rings (may be NULL).
+ * @param used Output argument that will contain number of acquired rings (may be NULL).
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_pool_get_count(ring_buff_pool_handle_t handle, uint32_t *idle, uint32_t *used);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RING_BUFF_POOL_H_ */
@@ -28,8 +28,28 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  ******************************************************************************/
+/* monotonic clock and condition variable clock selection */
+#define _POSIX_C_SOURCE 200112L
+/* syscall() for futex backend */
+#define _DEFAULT_SOURCE
+/* O_DIRECT for direct file I/O */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <stdlib.h>
+#include <errno.h>
+#include <time.h>
 #include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
 
 #include "ring_buff_osal.h"
 
@@ -45,20 +65,43 @@ ring_buff_err_t ring_buff_mutex_create(ring_buff_mutex_t *handle)
 		*handle = NULL;
 		return RING_BUFF_ERR_NO_MEM;
 	}
-	if(pthread_mutex_init(mtx, NULL))
+	if(ring_buff_mutex_init(mtx, handle) != RING_BUFF_ERR_OK)
 	{
 		free(mtx);
+		*handle = NULL;
 		return RING_BUFF_ERR_GENERAL;
 	}
-	*handle = mtx;
 	return RING_BUFF_ERR_OK;
 }
 
 ring_buff_err_t ring_buff_mutex_destroy(ring_buff_mutex_t handle)
+{
+	ring_buff_mutex_deinit(handle);
+	free(handle);
+	return RING_BUFF_ERR_OK;
+}
+
+uint32_t ring_buff_mutex_size(void)
+{
+	return sizeof(pthread_mutex_t);
+}
+
+ring_buff_err_t ring_buff_mutex_init(void* mem, ring_buff_mutex_t *handle)
+{
+	pthread_mutex_t *mtx = CAST_TO_PTHREAD_MUTEX(mem);
+	if(pthread_mutex_init(mtx, NULL))
+	{
+		*handle = NULL;
+		return RING_BUFF_ERR_GENERAL;
+	}
+	*handle = mtx;
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_mutex_deinit(ring_buff_mutex_t handle)
 {
 	pthread_mutex_t *mtx = CAST_TO_PTHREAD_MUTEX(handle);
 	pthread_mutex_destroy(mtx);
-	free(mtx);
 	return RING_BUFF_ERR_OK;
 }
 
@@ -108,22 +151,70 @@ ring_buff_err_t ring_buff_binary_sem_create(ring_buff_binary_sem_t *handle)
 		*handle = NULL;
 		return RING_BUFF_ERR_NO_MEM;
 	}
+	if(ring_buff_binary_sem_init(s, handle) != RING_BUFF_ERR_OK)
+	{
+		free(s);
+		*handle = NULL;
+		return RING_BUFF_ERR_GENERAL;
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_binary_sem_destroy(ring_buff_binary_sem_t handle)
+{
+	ring_buff_binary_sem_deinit(handle);
+	free(handle);
+
+	return RING_BUFF_ERR_OK;
+}
+
+uint32_t ring_buff_binary_sem_size(void)
+{
+	return sizeof(bin_sema_t);
+}
+
+static ring_buff_err_t ring_buff_bin_sema_setup(bin_sema_t *s, const pthread_mutexattr_t *mattr)
+{
+	pthread_condattr_t attr;
+
 	/* Init mutex */
-	pthread_mutex_init(&(s->mutex), NULL);
-	/* Init cond. variable */
-	pthread_cond_init(&(s->cv), NULL);
+	if(pthread_mutex_init(&(s->mutex), mattr))
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	/* Init cond. variable (monotonic clock is used for timed take) */
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	if(pthread_cond_init(&(s->cv), &attr))
+	{
+		pthread_condattr_destroy(&attr);
+		pthread_mutex_destroy(&(s->mutex));
+		return RING_BUFF_ERR_GENERAL;
+	}
+	pthread_condattr_destroy(&attr);
 	/* Set flag value */
 	s->flag = 1;
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_binary_sem_init(void* mem, ring_buff_binary_sem_t *handle)
+{
+	bin_sema_t *s = CAST_TO_PTHREAD_BIN_SEMA(mem);
+
+	if(ring_buff_bin_sema_setup(s, NULL) != RING_BUFF_ERR_OK)
+	{
+		*handle = NULL;
+		return RING_BUFF_ERR_GENERAL;
+	}
 	*handle = s;
 	return RING_BUFF_ERR_OK;
 }
 
-ring_buff_err_t ring_buff_binary_sem_destroy(ring_buff_binary_sem_t handle)
+ring_buff_err_t ring_buff_binary_sem_deinit(ring_buff_binary_sem_t handle)
 {
 	bin_sema_t *s = CAST_TO_PTHREAD_BIN_SEMA(handle);
 	pthread_mutex_destroy(&(s->mutex));
 	pthread_cond_destroy(&(s->cv));
-	free(s);
 
 	return RING_BUFF_ERR_OK;
 }
@@ -147,6 +238,37 @@ ring_buff_err_t ring_buff_binary_sem_take(ring_buff_binary_sem_t handle)
 	return RING_BUFF_ERR_OK;
 }
 
+ring_buff_err_t ring_buff_binary_sem_take_timed(ring_buff_binary_sem_t handle, uint32_t timeout_us)
+{
+	bin_sema_t *s = CAST_TO_PTHREAD_BIN_SEMA(handle);
+	uint64_t expires = ring_buff_time_us() + timeout_us;
+	struct timespec ts;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	ts.tv_sec = expires / 1000000;
+	ts.tv_nsec = (expires % 1000000) * 1000;
+	/* Try to get exclusive access to s->flag */
+	pthread_mutex_lock(&(s->mutex));
+	/* Examine the flag and wait until flag == 1, or until timeout */
+	while (s->flag == 0)
+	{
+		if(pthread_cond_timedwait(&(s->cv), &(s->mutex), &ts) == ETIMEDOUT && s->flag == 0)
+		{
+			err = RING_BUFF_ERR_WOULD_BLOCK;
+			break;
+		}
+	}
+	/* Semaphore is successfully taken */
+	if(err == RING_BUFF_ERR_OK)
+	{
+		s->flag = 0;
+	}
+	/* Release exclusive access to s->flag */
+	pthread_mutex_unlock(&(s->mutex));
+
+	return err;
+}
+
 ring_buff_err_t ring_buff_binary_sem_give(ring_buff_binary_sem_t handle)
 {
 	bin_sema_t *s = CAST_TO_PTHREAD_BIN_SEMA(handle);
@@ -162,3 +284,995 @@ ring_buff_err_t ring_buff_binary_sem_give(ring_buff_binary_sem_t handle)
 
 	return RING_BUFF_ERR_OK;
 }
+
+/* ############### OSAL backends implementation ################ */
+
+const ring_buff_osal_ops_t ring_buff_osal_posix =
+{
+	ring_buff_mutex_size, ring_buff_mutex_init, ring_buff_mutex_deinit, ring_buff_mutex_lock, ring_buff_mutex_unlock,
+	ring_buff_binary_sem_size, ring_buff_binary_sem_init, ring_buff_binary_sem_deinit,
+	ring_buff_binary_sem_take, ring_buff_binary_sem_give
+};
+
+/* Spinning backend: lock is 0 = free, 1 = taken; semaphore is 0 = down, 1 = up */
+
+#if defined(__i386__) || defined(__x86_64__)
+#define RING_BUFF_CPU_RELAX() __builtin_ia32_pause()
+#else
+#define RING_BUFF_CPU_RELAX() do { } while(0)
+#endif
+/* Spins before the CPU is yielded (the other side may be preempted on the same CPU) */
+#define RING_BUFF_SPIN_MAX 1024
+
+static void ring_buff_spin_relax(uint32_t *spins)
+{
+	if(++(*spins) < RING_BUFF_SPIN_MAX)
+	{
+		RING_BUFF_CPU_RELAX();
+	}
+	else
+	{
+		*spins = 0;
+		sched_yield();
+	}
+}
+
+static uint32_t ring_buff_spin_size(void)
+{
+	return sizeof(int);
+}
+
+static ring_buff_err_t ring_buff_spin_mutex_init(void* mem, ring_buff_mutex_t *handle)
+{
+	__atomic_store_n((int*)mem, 0, __ATOMIC_RELEASE);
+	*handle = mem;
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_spin_sem_init(void* mem, ring_buff_binary_sem_t *handle)
+{
+	__atomic_store_n((int*)mem, 1, __ATOMIC_RELEASE);
+	*handle = mem;
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_spin_deinit(void* handle)
+{
+	(void)handle;
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_spin_lock(ring_buff_mutex_t handle)
+{
+	int *lock = (int*)handle;
+	uint32_t spins = 0;
+
+	while(__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE))
+	{
+		/* wait for the release without writing to the cache line */
+		while(__atomic_load_n(lock, __ATOMIC_RELAXED))
+		{
+			ring_buff_spin_relax(&spins);
+		}
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_spin_unlock(ring_buff_mutex_t handle)
+{
+	__atomic_store_n((int*)handle, 0, __ATOMIC_RELEASE);
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_spin_sem_take(ring_buff_binary_sem_t handle)
+{
+	int *flag = (int*)handle;
+	int up = 1;
+	uint32_t spins = 0;
+
+	while(!__atomic_compare_exchange_n(flag, &up, 0, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+	{
+		while(!__atomic_load_n(flag, __ATOMIC_RELAXED))
+		{
+			ring_buff_spin_relax(&spins);
+		}
+		up = 1;
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_spin_sem_give(ring_buff_binary_sem_t handle)
+{
+	__atomic_store_n((int*)handle, 1, __ATOMIC_RELEASE);
+	return RING_BUFF_ERR_OK;
+}
+
+const ring_buff_osal_ops_t ring_buff_osal_spin =
+{
+	ring_buff_spin_size, ring_buff_spin_mutex_init, ring_buff_spin_deinit, ring_buff_spin_lock, ring_buff_spin_unlock,
+	ring_buff_spin_size, ring_buff_spin_sem_init, ring_buff_spin_deinit, ring_buff_spin_sem_take, ring_buff_spin_sem_give
+};
+
+#if defined(__linux__) && defined(SYS_futex)
+/*
+ * Futex backend. Lock is 0 = free, 1 = taken, 2 = taken and (maybe) contended (as in "Futexes Are Tricky"
+ * by Ulrich Drepper). Semaphore is 1 = up, 0 = down, -1 = down and (maybe) waited for.
+ * Kernel is entered only when the other side has to sleep or has to be woken up.
+ */
+
+static void ring_buff_futex_wait(int *addr, int val)
+{
+	syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static void ring_buff_futex_wake(int *addr)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+static ring_buff_err_t ring_buff_futex_lock(ring_buff_mutex_t handle)
+{
+	int *lock = (int*)handle;
+	int c = 0;
+
+	if(__atomic_compare_exchange_n(lock, &c, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+	{
+		return RING_BUFF_ERR_OK;
+	}
+	if(c != 2)
+	{
+		c = __atomic_exchange_n(lock, 2, __ATOMIC_ACQUIRE);
+	}
+	while(c != 0)
+	{
+		ring_buff_futex_wait(lock, 2);
+		c = __atomic_exchange_n(lock, 2, __ATOMIC_ACQUIRE);
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_futex_unlock(ring_buff_mutex_t handle)
+{
+	int *lock = (int*)handle;
+
+	if(__atomic_fetch_sub(lock, 1, __ATOMIC_RELEASE) != 1)
+	{
+		__atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+		ring_buff_futex_wake(lock);
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_futex_sem_take(ring_buff_binary_sem_t handle)
+{
+	int *flag = (int*)handle;
+	int up = 1;
+
+	if(__atomic_compare_exchange_n(flag, &up, 0, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+	{
+		return RING_BUFF_ERR_OK;
+	}
+	/* taking it while marked as waited for costs one extra wake-up at most */
+	while(__atomic_exchange_n(flag, -1, __ATOMIC_ACQUIRE) != 1)
+	{
+		ring_buff_futex_wait(flag, -1);
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_futex_sem_give(ring_buff_binary_sem_t handle)
+{
+	int *flag = (int*)handle;
+
+	if(__atomic_exchange_n(flag, 1, __ATOMIC_RELEASE) == -1)
+	{
+		ring_buff_futex_wake(flag);
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+const ring_buff_osal_ops_t ring_buff_osal_futex =
+{
+	ring_buff_spin_size, ring_buff_spin_mutex_init, ring_buff_spin_deinit, ring_buff_futex_lock, ring_buff_futex_unlock,
+	ring_buff_spin_size, ring_buff_spin_sem_init, ring_buff_spin_deinit, ring_buff_futex_sem_take, ring_buff_futex_sem_give
+};
+#else
+const ring_buff_osal_ops_t ring_buff_osal_futex =
+{
+	ring_buff_mutex_size, ring_buff_mutex_init, ring_buff_mutex_deinit, ring_buff_mutex_lock, ring_buff_mutex_unlock,
+	ring_buff_binary_sem_size, ring_buff_binary_sem_init, ring_buff_binary_sem_deinit,
+	ring_buff_binary_sem_take, ring_buff_binary_sem_give
+};
+#endif
+
+/* Priority inheritance backend: pthread mutexes with PTHREAD_PRIO_INHERIT protocol */
+
+static ring_buff_err_t ring_buff_pi_mutexattr(pthread_mutexattr_t *attr)
+{
+	if(pthread_mutexattr_init(attr))
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+#if defined(_POSIX_THREAD_PRIO_INHERIT) && _POSIX_THREAD_PRIO_INHERIT > 0
+	if(pthread_mutexattr_setprotocol(attr, PTHREAD_PRIO_INHERIT))
+	{
+		pthread_mutexattr_destroy(attr);
+		return RING_BUFF_ERR_GENERAL;
+	}
+#endif
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_pi_mutex_init(void* mem, ring_buff_mutex_t *handle)
+{
+	pthread_mutexattr_t attr;
+	ring_buff_err_t err = ring_buff_pi_mutexattr(&attr);
+
+	*handle = NULL;
+	if(err != RING_BUFF_ERR_OK)
+	{
+		return err;
+	}
+	if(pthread_mutex_init(CAST_TO_PTHREAD_MUTEX(mem), &attr))
+	{
+		err = RING_BUFF_ERR_GENERAL;
+	}
+	else
+	{
+		*handle = mem;
+	}
+	pthread_mutexattr_destroy(&attr);
+	return err;
+}
+
+static ring_buff_err_t ring_buff_pi_sem_init(void* mem, ring_buff_binary_sem_t *handle)
+{
+	pthread_mutexattr_t attr;
+	ring_buff_err_t err = ring_buff_pi_mutexattr(&attr);
+
+	*handle = NULL;
+	if(err != RING_BUFF_ERR_OK)
+	{
+		return err;
+	}
+	err = ring_buff_bin_sema_setup(CAST_TO_PTHREAD_BIN_SEMA(mem), &attr);
+	if(err == RING_BUFF_ERR_OK)
+	{
+		*handle = mem;
+	}
+	pthread_mutexattr_destroy(&attr);
+	return err;
+}
+
+const ring_buff_osal_ops_t ring_buff_osal_pi =
+{
+	ring_buff_mutex_size, ring_buff_pi_mutex_init, ring_buff_mutex_deinit, ring_buff_mutex_lock, ring_buff_mutex_unlock,
+	ring_buff_binary_sem_size, ring_buff_pi_sem_init, ring_buff_binary_sem_deinit,
+	ring_buff_binary_sem_take, ring_buff_binary_sem_give
+};
+
+/* ############### Time implementation ################ */
+
+uint64_t ring_buff_time_us(void)
+{
+	struct timespec ts;
+
+	/* served from vDSO on Linux, no system call */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* ############### Timer implementation ################ */
+
+/* All timers are served by one shared thread, which runs while there is at least one timer */
+
+/* Heap position of the disarmed timer */
+#define RING_BUFF_TIMER_IDLE     (0xFFFFFFFFu)
+/* Initial armed timers heap size */
+#define RING_BUFF_TIMER_HEAP_MIN (8)
+
+typedef struct _timer
+{
+	/** Expiration time in microseconds */
+	uint64_t expires;
+	ring_buff_timer_cb_t cb;
+	void* arg;
+	/** Position in the armed timers heap (RING_BUFF_TIMER_IDLE if disarmed) */
+	uint32_t pos;
+} osal_timer_t;
+
+typedef struct _timer_service
+{
+	/** Timer thread */
+	pthread_t thread;
+	/** Cond. variable - timer thread waits on it for the first expiration time */
+	pthread_cond_t cv;
+	/** Cond. variable - destroyed timer waits on it for its callback to finish */
+	pthread_cond_t done_cv;
+	/** Mutex variable - protects timers state */
+	pthread_mutex_t mutex;
+	/** Armed timers (min-heap by expiration time), the first one expires first */
+	osal_timer_t **armed;
+	/** Number of armed timers */
+	uint32_t armed_count;
+	/** Armed timers heap size (never less than the number of timers) */
+	uint32_t armed_max;
+	/** Timer whose callback is executing */
+	osal_timer_t *running;
+	/** Number of timers */
+	uint32_t count;
+	/** Set when the last timer is destroyed */
+	int exit;
+	/** Set once cond. variables are initialized */
+	int ready;
+} osal_timer_service_t;
+
+#define CAST_TO_PTHREAD_TIMER(handle) ((osal_timer_t*)handle)
+
+static osal_timer_service_t timer_service;
+/* serializes timer creation and destruction (timer thread is started and stopped there) */
+static pthread_mutex_t timer_service_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void ring_buff_timer_place(osal_timer_t *t, uint32_t pos)
+{
+	timer_service.armed[pos] = t;
+	t->pos = pos;
+}
+
+static void ring_buff_timer_sift_up(osal_timer_t *t)
+{
+	uint32_t pos = t->pos;
+	uint32_t parent;
+
+	while(pos > 0)
+	{
+		parent = (pos - 1) / 2;
+		if(timer_service.armed[parent]->expires <= t->expires)
+		{
+			break;
+		}
+		ring_buff_timer_place(timer_service.armed[parent], pos);
+		pos = parent;
+	}
+	ring_buff_timer_place(t, pos);
+}
+
+static void ring_buff_timer_sift_down(osal_timer_t *t)
+{
+	uint32_t pos = t->pos;
+	uint32_t child;
+
+	for(;;)
+	{
+		child = 2 * pos + 1;
+		if(child >= timer_service.armed_count)
+		{
+			break;
+		}
+		if(child + 1 < timer_service.armed_count &&
+				timer_service.armed[child + 1]->expires < timer_service.armed[child]->expires)
+		{
+			child++;
+		}
+		if(timer_service.armed[child]->expires >= t->expires)
+		{
+			break;
+		}
+		ring_buff_timer_place(timer_service.armed[child], pos);
+		pos = child;
+	}
+	ring_buff_timer_place(t, pos);
+}
+
+static void ring_buff_timer_unlink(osal_timer_t *t)
+{
+	osal_timer_t *last;
+
+	if(t->pos == RING_BUFF_TIMER_IDLE)
+	{
+		return;
+	}
+	/* the last timer takes the free place, and moves to where it belongs */
+	last = timer_service.armed[--timer_service.armed_count];
+	if(last != t)
+	{
+		ring_buff_timer_place(last, t->pos);
+		ring_buff_timer_sift_up(last);
+		ring_buff_timer_sift_down(last);
+	}
+	t->pos = RING_BUFF_TIMER_IDLE;
+}
+
+static void* ring_buff_timer_thread(void* arg)
+{
+	osal_timer_service_t *svc = (osal_timer_service_t*)arg;
+	osal_timer_t *t;
+	struct timespec ts;
+
+	pthread_mutex_lock(&(svc->mutex));
+	while(!svc->exit)
+	{
+		t = svc->armed_count ? svc->armed[0] : NULL;
+		if(t == NULL)
+		{
+			pthread_cond_wait(&(svc->cv), &(svc->mutex));
+		}
+		else if(ring_buff_time_us() >= t->expires)
+		{
+			ring_buff_timer_unlink(t);
+			svc->running = t;
+			/* callback may re-arm the timer */
+			pthread_mutex_unlock(&(svc->mutex));
+			t->cb(t->arg);
+			pthread_mutex_lock(&(svc->mutex));
+			svc->running = NULL;
+			pthread_cond_broadcast(&(svc->done_cv));
+		}
+		else
+		{
+			ts.tv_sec = t->expires / 1000000;
+			ts.tv_nsec = (t->expires % 1000000) * 1000;
+			pthread_cond_timedwait(&(svc->cv), &(svc->mutex), &ts);
+		}
+	}
+	pthread_mutex_unlock(&(svc->mutex));
+
+	return NULL;
+}
+
+static ring_buff_err_t ring_buff_timer_service_start(osal_timer_service_t *svc)
+{
+	pthread_condattr_t attr;
+
+	if(!svc->ready)
+	{
+		if(pthread_mutex_init(&(svc->mutex), NULL))
+		{
+			return RING_BUFF_ERR_GENERAL;
+		}
+		pthread_condattr_init(&attr);
+		pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+		if(pthread_cond_init(&(svc->cv), &attr))
+		{
+			pthread_condattr_destroy(&attr);
+			pthread_mutex_destroy(&(svc->mutex));
+			return RING_BUFF_ERR_GENERAL;
+		}
+		pthread_condattr_destroy(&attr);
+		if(pthread_cond_init(&(svc->done_cv), NULL))
+		{
+			pthread_cond_destroy(&(svc->cv));
+			pthread_mutex_destroy(&(svc->mutex));
+			return RING_BUFF_ERR_GENERAL;
+		}
+		svc->ready = 1;
+	}
+	svc->exit = 0;
+	if(pthread_create(&(svc->thread), NULL, ring_buff_timer_thread, svc))
+	{
+		return RING_BUFF_ERR_INTERNAL;
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+static ring_buff_err_t ring_buff_timer_service_grow(osal_timer_service_t *svc)
+{
+	osal_timer_t **armed;
+	uint32_t max = svc->armed_max ? 2 * svc->armed_max : RING_BUFF_TIMER_HEAP_MIN;
+
+	/* timer thread runs (and looks at the heap) only while there are timers */
+	if(svc->count)
+	{
+		pthread_mutex_lock(&(svc->mutex));
+	}
+	armed = (osal_timer_t **) realloc(svc->armed, max * sizeof(osal_timer_t*));
+	if(armed != NULL)
+	{
+		svc->armed = armed;
+		svc->armed_max = max;
+	}
+	if(svc->count)
+	{
+		pthread_mutex_unlock(&(svc->mutex));
+	}
+
+	return (armed != NULL) ? RING_BUFF_ERR_OK : RING_BUFF_ERR_NO_MEM;
+}
+
+ring_buff_err_t ring_buff_timer_create(ring_buff_timer_t *handle, ring_buff_timer_cb_t cb, void* arg)
+{
+	osal_timer_t *t = (osal_timer_t *) malloc(sizeof(osal_timer_t));
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	if(t == NULL)
+	{
+		*handle = NULL;
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	t->expires = 0;
+	t->cb = cb;
+	t->arg = arg;
+	t->pos = RING_BUFF_TIMER_IDLE;
+	pthread_mutex_lock(&timer_service_lock);
+	/* every timer has its place in the heap, so arming never allocates */
+	if(timer_service.count == timer_service.armed_max)
+	{
+		err = ring_buff_timer_service_grow(&timer_service);
+	}
+	/* the first timer starts the thread */
+	if(err == RING_BUFF_ERR_OK && timer_service.count == 0)
+	{
+		err = ring_buff_timer_service_start(&timer_service);
+	}
+	if(err == RING_BUFF_ERR_OK)
+	{
+		pthread_mutex_lock(&(timer_service.mutex));
+		timer_service.count++;
+		pthread_mutex_unlock(&(timer_service.mutex));
+	}
+	pthread_mutex_unlock(&timer_service_lock);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		free(t);
+		*handle = NULL;
+		return err;
+	}
+	*handle = t;
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_timer_destroy(ring_buff_timer_t handle)
+{
+	osal_timer_t *t = CAST_TO_PTHREAD_TIMER(handle);
+	int last;
+
+	pthread_mutex_lock(&timer_service_lock);
+	pthread_mutex_lock(&(timer_service.mutex));
+	/* callback may re-arm the timer, so it is unlinked once the callback is done */
+	while(timer_service.running == t)
+	{
+		pthread_cond_wait(&(timer_service.done_cv), &(timer_service.mutex));
+	}
+	ring_buff_timer_unlink(t);
+	/* the last timer stops the thread */
+	last = (--timer_service.count == 0);
+	if(last)
+	{
+		timer_service.exit = 1;
+		pthread_cond_signal(&(timer_service.cv));
+	}
+	pthread_mutex_unlock(&(timer_service.mutex));
+	if(last)
+	{
+		pthread_join(timer_service.thread, NULL);
+		free(timer_service.armed);
+		timer_service.armed = NULL;
+		timer_service.armed_max = 0;
+	}
+	pthread_mutex_unlock(&timer_service_lock);
+	free(t);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_timer_arm(ring_buff_timer_t handle, uint64_t expires)
+{
+	osal_timer_t *t = CAST_TO_PTHREAD_TIMER(handle);
+	uint64_t first = 0;
+	uint8_t armed = 0;
+
+	pthread_mutex_lock(&(timer_service.mutex));
+	if(timer_service.armed_count)
+	{
+		armed = 1;
+		first = timer_service.armed[0]->expires;
+	}
+	t->expires = expires;
+	if(t->pos == RING_BUFF_TIMER_IDLE)
+	{
+		ring_buff_timer_place(t, timer_service.armed_count++);
+	}
+	ring_buff_timer_sift_up(t);
+	ring_buff_timer_sift_down(t);
+	/* timer thread has to be woken up only if it would sleep for too long */
+	if(timer_service.armed[0] == t && (!armed || expires < first))
+	{
+		pthread_cond_signal(&(timer_service.cv));
+	}
+	pthread_mutex_unlock(&(timer_service.mutex));
+
+	return RING_BUFF_ERR_OK;
+}
+
+/* ############### Thread local storage implementation ################ */
+
+#define CAST_TO_PTHREAD_KEY(handle) ((pthread_key_t*)handle)
+
+ring_buff_err_t ring_buff_tls_create(ring_buff_tls_t *handle)
+{
+	return ring_buff_tls_create_with_dtor(handle, NULL);
+}
+
+ring_buff_err_t ring_buff_tls_create_with_dtor(ring_buff_tls_t *handle, ring_buff_tls_dtor_t dtor)
+{
+	pthread_key_t *key = (pthread_key_t *)malloc(sizeof (pthread_key_t));
+	if(key == NULL)
+	{
+		*handle = NULL;
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	if(pthread_key_create(key, dtor))
+	{
+		free(key);
+		*handle = NULL;
+		return RING_BUFF_ERR_GENERAL;
+	}
+	*handle = key;
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_tls_destroy(ring_buff_tls_t handle)
+{
+	pthread_key_t *key = CAST_TO_PTHREAD_KEY(handle);
+	pthread_key_delete(*key);
+	free(key);
+	return RING_BUFF_ERR_OK;
+}
+
+void* ring_buff_tls_get(ring_buff_tls_t handle)
+{
+	return pthread_getspecific(*CAST_TO_PTHREAD_KEY(handle));
+}
+
+ring_buff_err_t ring_buff_tls_set(ring_buff_tls_t handle, void* value)
+{
+	if(pthread_setspecific(*CAST_TO_PTHREAD_KEY(handle), value))
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+/* ############### Thread implementation ################ */
+
+typedef struct _thread
+{
+	pthread_t thread;
+	ring_buff_thread_func_t func;
+	void* arg;
+} osal_thread_t;
+
+#define CAST_TO_PTHREAD_THREAD(handle) ((osal_thread_t*)handle)
+
+static void* ring_buff_thread_main(void* arg)
+{
+	osal_thread_t *t = CAST_TO_PTHREAD_THREAD(arg);
+
+	t->func(t->arg);
+	return NULL;
+}
+
+ring_buff_err_t ring_buff_thread_create(ring_buff_thread_t *handle, ring_buff_thread_func_t func, void* arg)
+{
+	osal_thread_t *t = (osal_thread_t *) malloc(sizeof(osal_thread_t));
+
+	if(t == NULL)
+	{
+		*handle = NULL;
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	t->func = func;
+	t->arg = arg;
+	if(pthread_create(&(t->thread), NULL, ring_buff_thread_main, t))
+	{
+		free(t);
+		*handle = NULL;
+		return RING_BUFF_ERR_INTERNAL;
+	}
+	*handle = t;
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_thread_join(ring_buff_thread_t handle)
+{
+	osal_thread_t *t = CAST_TO_PTHREAD_THREAD(handle);
+
+	pthread_join(t->thread, NULL);
+	free(t);
+	return RING_BUFF_ERR_OK;
+}
+
+/* ############### File mapping implementation ################ */
+
+typedef struct _file_map
+{
+	int fd;
+	void* addr;
+	uint32_t size;
+} osal_file_map_t;
+
+#define CAST_TO_FILE_MAP(handle) ((osal_file_map_t*)handle)
+
+ring_buff_err_t ring_buff_file_map(ring_buff_file_map_t *handle, const char* path, uint32_t size, void** addr, uint8_t* created)
+{
+	osal_file_map_t *map = (osal_file_map_t *) malloc(sizeof(osal_file_map_t));
+	ring_buff_err_t err = RING_BUFF_ERR_INTERNAL;
+	struct stat st;
+
+	*handle = NULL;
+	*created = 0;
+	if(map == NULL)
+	{
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	map->size = size;
+	map->fd = open(path, O_RDWR | O_CREAT, 0644);
+	if(map->fd < 0 || fstat(map->fd, &st))
+	{
+		goto fail;
+	}
+	if(st.st_size == 0)
+	{
+		/* new file, make the size durable as well */
+		if(ftruncate(map->fd, size) || fsync(map->fd))
+		{
+			goto fail;
+		}
+		*created = 1;
+	}
+	else if(st.st_size != size)
+	{
+		err = RING_BUFF_ERR_SIZE;
+		goto fail;
+	}
+	map->addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, map->fd, 0);
+	if(map->addr == MAP_FAILED)
+	{
+		goto fail;
+	}
+	*addr = map->addr;
+	*handle = map;
+	return RING_BUFF_ERR_OK;
+
+fail:
+	if(map->fd >= 0)
+	{
+		close(map->fd);
+	}
+	free(map);
+	return err;
+}
+
+ring_buff_err_t ring_buff_file_sync(ring_buff_file_map_t handle, void* addr, uint32_t size)
+{
+	uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uintptr_t start = (uintptr_t)addr & ~(page - 1);
+
+	/* handle is not needed, range is synced by its address */
+	(void)handle;
+	if(size == 0)
+	{
+		return RING_BUFF_ERR_OK;
+	}
+	if(msync((void*)start, (uintptr_t)addr + size - start, MS_SYNC))
+	{
+		return RING_BUFF_ERR_INTERNAL;
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_file_unmap(ring_buff_file_map_t handle)
+{
+	osal_file_map_t *map = CAST_TO_FILE_MAP(handle);
+
+	munmap(map->addr, map->size);
+	close(map->fd);
+	free(map);
+	return RING_BUFF_ERR_OK;
+}
+
+/* ############### File implementation ################ */
+
+typedef struct _file
+{
+	int fd;
+} osal_file_t;
+
+#define CAST_TO_FILE(handle) ((osal_file_t*)handle)
+
+ring_buff_err_t ring_buff_file_open(ring_buff_file_t *handle, const char* path)
+{
+	osal_file_t *file = (osal_file_t *) malloc(sizeof(osal_file_t));
+
+	if(file == NULL)
+	{
+		*handle = NULL;
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	file->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(file->fd < 0)
+	{
+		free(file);
+		*handle = NULL;
+		return RING_BUFF_ERR_INTERNAL;
+	}
+	*handle = file;
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_file_open_direct(ring_buff_file_t *handle, const char* path)
+{
+#ifdef O_DIRECT
+	osal_file_t *file = (osal_file_t *) malloc(sizeof(osal_file_t));
+
+	if(file == NULL)
+	{
+		*handle = NULL;
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	file->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+	if(file->fd < 0)
+	{
+		free(file);
+		*handle = NULL;
+		/* file system does not do direct I/O (e.g. older tmpfs) */
+		return errno == EINVAL ? RING_BUFF_ERR_PERM : RING_BUFF_ERR_INTERNAL;
+	}
+	*handle = file;
+	return RING_BUFF_ERR_OK;
+#else
+	*handle = NULL;
+	return RING_BUFF_ERR_PERM;
+#endif
+}
+
+ring_buff_err_t ring_buff_file_close(ring_buff_file_t handle)
+{
+	osal_file_t *file = CAST_TO_FILE(handle);
+
+	close(file->fd);
+	free(file);
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_file_write(ring_buff_file_t handle, uint64_t off, const void* buff, uint32_t size)
+{
+	osal_file_t *file = CAST_TO_FILE(handle);
+	ssize_t ret;
+
+	while(size)
+	{
+		ret = pwrite(file->fd, buff, size, (off_t)off);
+		if(ret < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(ret <= 0)
+		{
+			return RING_BUFF_ERR_INTERNAL;
+		}
+		buff = (const uint8_t*)buff + ret;
+		off += ret;
+		size -= ret;
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_file_read(ring_buff_file_t handle, uint64_t off, void* buff, uint32_t size)
+{
+	osal_file_t *file = CAST_TO_FILE(handle);
+	ssize_t ret;
+
+	while(size)
+	{
+		ret = pread(file->fd, buff, size, (off_t)off);
+		if(ret < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		/* data must be there */
+		if(ret <= 0)
+		{
+			return RING_BUFF_ERR_INTERNAL;
+		}
+		buff = (uint8_t*)buff + ret;
+		off += ret;
+		size -= ret;
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_file_truncate(ring_buff_file_t handle, uint64_t size)
+{
+	osal_file_t *file = CAST_TO_FILE(handle);
+
+	if(ftruncate(file->fd, (off_t)size))
+	{
+		return RING_BUFF_ERR_INTERNAL;
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+/* ############### Memory implementation ################ */
+
+ring_buff_err_t ring_buff_mem_release(void* addr, uint32_t size, uint32_t* released)
+{
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t start = ((size_t)addr + page - 1) & ~(page - 1);
+	size_t end = ((size_t)addr + size) & ~(page - 1);
+
+	*released = 0;
+	if(end <= start)
+	{
+		return RING_BUFF_ERR_OK;
+	}
+	/* MADV_DONTNEED drops the pages right away (MADV_FREE would keep them counted until there is memory pressure) */
+#ifdef MADV_DONTNEED
+	if(madvise((void*)start, end - start, MADV_DONTNEED))
+#else
+	if(posix_madvise((void*)start, end - start, POSIX_MADV_DONTNEED))
+#endif
+	{
+		return RING_BUFF_ERR_INTERNAL;
+	}
+	*released = (uint32_t)(end - start);
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_mem_lock(void* addr, uint32_t size)
+{
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	volatile uint8_t *p = (volatile uint8_t*)addr;
+	size_t off;
+
+	if(mlock(addr, size))
+	{
+		return (errno == ENOMEM || errno == EPERM || errno == EAGAIN) ? RING_BUFF_ERR_NO_MEM : RING_BUFF_ERR_INTERNAL;
+	}
+	/* write to every page (locking may map in shared zero page, that is copied on the first write) */
+	for(off = 0; off < size; off += page - (((size_t)p + off) & (page - 1)))
+	{
+		p[off] = p[off];
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_mem_unlock(void* addr, uint32_t size)
+{
+	if(munlock(addr, size))
+	{
+		return RING_BUFF_ERR_INTERNAL;
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_mem_alloc_locked(uint32_t size, void** addr)
+{
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t total = (size + page - 1) & ~(page - 1);
+	ring_buff_err_t err;
+
+	*addr = NULL;
+	if(posix_memalign(addr, page, total))
+	{
+		*addr = NULL;
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	err = ring_buff_mem_lock(*addr, total);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		free(*addr);
+		*addr = NULL;
+	}
+	return err;
+}
+
+ring_buff_err_t ring_buff_mem_free_locked(void* addr, uint32_t size)
+{
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+	munlock(addr, (size + page - 1) & ~(page - 1));
+	free(addr);
+	return RING_BUFF_ERR_OK;
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+#ifndef RING_BUFF_PRIV_H_
+#define RING_BUFF_PRIV_H_
+
+#include "ring_buff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Internal ring buffer interface. It is used by the objects built on top of the ring buffer
+ * (e.g. ring buffer set), and it is NOT part of the public API.
+ */
+
+/** Ring buffer has data to read (or it is stopped/canceled). */
+#define RING_BUFF_EVENT_READ  0x1
+/** Ring buffer has free space to write to (or it is stopped/canceled). */
+#define RING_BUFF_EVENT_WRITE 0x2
+
+/**
+ * Event callback function prototype. It is called whenever data is committed (RING_BUFF_EVENT_READ),
+ * chunk is freed (RING_BUFF_EVENT_WRITE), or buffer is stopped/canceled (both).
+ * NOTE: Callback is called with buffer context acquired, so it must NOT call ring buffer functions.
+ * @param arg Argument passed when callback is set.
+ * @param events Events (bitwise or of RING_BUFF_EVENT_xxx).
+ */
+typedef void (*ring_buff_event_cb_t) (void* arg, uint32_t events);
+
+/**
+ * Sets event callback. There can be only one callback per ring buffer. When function returns,
+ * previous callback is not executing, and it will not be called anymore.
+ * @param handle Ring buffer handle.
+ * @param cb Event callback (NULL to remove the callback).
+ * @param arg Callback argument.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem
+ * (RING_BUFF_ERR_PERM if other callback is already set).
+ */
+ring_buff_err_t ring_buff_set_event_cb(ring_buff_handle_t handle, ring_buff_event_cb_t cb, void* arg);
+/**
+ * Returns current ring buffer events (level, not edge).
+ * @param handle Ring buffer handle.
+ * @return Events (bitwise or of RING_BUFF_EVENT_xxx).
+ */
+uint32_t ring_buff_get_events(ring_buff_handle_t handle);
+/**
+ * Returns size of the data that is committed, but not read (claimed) yet.
+ * @param handle Ring buffer handle.
+ * @return Size in bytes (including record headers in record mode).
+ */
+uint32_t ring_buff_get_queued(ring_buff_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RING_BUFF_PRIV_H_ */
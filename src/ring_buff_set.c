@@ -0,0 +1,421 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring_buff_set.h"
+#include "ring_buff_priv.h"
+#include "ring_buff_osal.h"
+
+/* NOTE: RING_BUFF_SET_READ/RING_BUFF_SET_WRITE have the same values as RING_BUFF_EVENT_READ/RING_BUFF_EVENT_WRITE. */
+
+#define GET_RING_BUFF_SET_OBJ(handle) ((ring_buff_set_obj_t*)handle)
+
+struct ring_buff_set_obj;
+
+/**
+ * Ring buffer set member.
+ */
+typedef struct ring_buff_set_member
+{
+	/** Ring buffer (NULL if member slot is free) */
+	ring_buff_handle_t ring;
+	/** Events of interest */
+	uint32_t events;
+	/** Client argument */
+	void* arg;
+	/** Events signaled, but not returned yet */
+	uint32_t pending;
+	/** Set when member is in the ready list */
+	uint8_t queued;
+	/** Next member in the ready list */
+	struct ring_buff_set_member *next;
+	/** Set that member belongs to */
+	struct ring_buff_set_obj *set;
+} ring_buff_set_member_t;
+
+/**
+ * Ring buffer set structure.
+ */
+typedef struct ring_buff_set_obj
+{
+	/** Members */
+	ring_buff_set_member_t *members;
+	/** Maximum number of members */
+	uint32_t max;
+	/** Ready list head */
+	ring_buff_set_member_t *head;
+	/** Ready list tail */
+	ring_buff_set_member_t *tail;
+	/** Members returned by the last wait (they are checked again on the next wait) */
+	ring_buff_set_member_t **reported;
+	/** Number of members returned by the last wait */
+	uint32_t reported_count;
+	/** Protects ready list */
+	ring_buff_mutex_t lock;
+	/** Signaled when ready list becomes non-empty */
+	ring_buff_binary_sem_t ready_sem;
+} ring_buff_set_obj_t;
+
+/**
+ * Ring buffer event callback. It is called with ring buffer context acquired.
+ * @param arg Set member.
+ * @param events Ring buffer events.
+ */
+static void ring_buff_set_event(void* arg, uint32_t events);
+/**
+ * Internal function which adds member to the ready list. It expects that set lock is acquired by the caller.
+ * @param obj Valid set object.
+ * @param member Set member.
+ * @param events Ready events.
+ * @return 1 if ready list was empty, 0 otherwise.
+ */
+static uint8_t ring_buff_set_ready(ring_buff_set_obj_t* obj, ring_buff_set_member_t* member, uint32_t events);
+
+ring_buff_err_t ring_buff_set_create(uint32_t max, ring_buff_set_handle_t *handle)
+{
+	ring_buff_set_obj_t* obj = NULL;
+	ring_buff_err_t err_code = RING_BUFF_ERR_BAD_ARG;
+
+	if(max == 0 || handle == NULL)
+	{
+		goto done;
+	}
+	obj = malloc(sizeof(ring_buff_set_obj_t));
+	if(obj == NULL)
+	{
+		err_code = RING_BUFF_ERR_NO_MEM;
+		goto done;
+	}
+	memset(obj, 0, sizeof(ring_buff_set_obj_t));
+	obj->members = calloc(max, sizeof(ring_buff_set_member_t));
+	obj->reported = calloc(max, sizeof(ring_buff_set_member_t*));
+	if(obj->members == NULL || obj->reported == NULL)
+	{
+		ring_buff_set_destroy(obj);
+		obj = NULL;
+		err_code = RING_BUFF_ERR_NO_MEM;
+		goto done;
+	}
+	obj->max = max;
+	if(ring_buff_mutex_create(&(obj->lock)) != RING_BUFF_ERR_OK ||
+			ring_buff_binary_sem_create(&(obj->ready_sem)) != RING_BUFF_ERR_OK)
+	{
+		ring_buff_set_destroy(obj);
+		obj = NULL;
+		err_code = RING_BUFF_ERR_NO_MEM;
+		goto done;
+	}
+	err_code = RING_BUFF_ERR_OK;
+
+done:
+	if(handle != NULL)
+	{
+		*handle = obj;
+	}
+	return err_code;
+}
+
+ring_buff_err_t ring_buff_set_destroy(ring_buff_set_handle_t handle)
+{
+	ring_buff_set_obj_t* obj = GET_RING_BUFF_SET_OBJ(handle);
+	uint32_t i = 0;
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	/* ring buffers must not call back into the set anymore */
+	for(i = 0; i < obj->max; i++)
+	{
+		if(obj->members[i].ring != NULL)
+		{
+			ring_buff_set_event_cb(obj->members[i].ring, NULL, NULL);
+		}
+	}
+	if(obj->lock != NULL)
+	{
+		ring_buff_mutex_destroy(obj->lock);
+	}
+	if(obj->ready_sem != NULL)
+	{
+		ring_buff_binary_sem_destroy(obj->ready_sem);
+	}
+	free(obj->members);
+	free(obj->reported);
+	free(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_set_add(ring_buff_set_handle_t handle, ring_buff_handle_t ring, uint32_t events, void* arg)
+{
+	ring_buff_set_obj_t* obj = GET_RING_BUFF_SET_OBJ(handle);
+	ring_buff_set_member_t* member = NULL;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	uint8_t wake = 0;
+	uint32_t i = 0;
+
+	if(obj == NULL || ring == NULL || (events & (RING_BUFF_SET_READ | RING_BUFF_SET_WRITE)) == 0)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	for(i = 0; i < obj->max; i++)
+	{
+		if(obj->members[i].ring == ring)
+		{
+			return RING_BUFF_ERR_PERM;
+		}
+		if(member == NULL && obj->members[i].ring == NULL)
+		{
+			member = &(obj->members[i]);
+		}
+	}
+	if(member == NULL)
+	{
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	ring_buff_mutex_lock(obj->lock);
+	member->ring = ring;
+	member->events = events & (RING_BUFF_SET_READ | RING_BUFF_SET_WRITE);
+	member->arg = arg;
+	member->pending = 0;
+	member->queued = 0;
+	member->next = NULL;
+	member->set = obj;
+	ring_buff_mutex_unlock(obj->lock);
+	err = ring_buff_set_event_cb(ring, ring_buff_set_event, member);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		member->ring = NULL;
+		return err;
+	}
+	/* ring buffer may already be ready */
+	events = ring_buff_get_events(ring) & member->events;
+	if(events)
+	{
+		ring_buff_mutex_lock(obj->lock);
+		wake = ring_buff_set_ready(obj, member, events);
+		ring_buff_mutex_unlock(obj->lock);
+		if(wake)
+		{
+			ring_buff_binary_sem_give(obj->ready_sem);
+		}
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_set_remove(ring_buff_set_handle_t handle, ring_buff_handle_t ring)
+{
+	ring_buff_set_obj_t* obj = GET_RING_BUFF_SET_OBJ(handle);
+	ring_buff_set_member_t* member = NULL;
+	ring_buff_set_member_t* prev = NULL;
+	ring_buff_set_member_t* cur = NULL;
+	uint32_t i = 0;
+
+	if(obj == NULL || ring == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	for(i = 0; i < obj->max && member == NULL; i++)
+	{
+		if(obj->members[i].ring == ring)
+		{
+			member = &(obj->members[i]);
+		}
+	}
+	if(member == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	/* after this, event callback is not called anymore */
+	ring_buff_set_event_cb(ring, NULL, NULL);
+	ring_buff_mutex_lock(obj->lock);
+	if(member->queued)
+	{
+		for(cur = obj->head; cur != member; cur = cur->next)
+		{
+			prev = cur;
+		}
+		if(prev != NULL)
+		{
+			prev->next = member->next;
+		}
+		else
+		{
+			obj->head = member->next;
+		}
+		if(obj->tail == member)
+		{
+			obj->tail = prev;
+		}
+	}
+	member->ring = NULL;
+	member->queued = 0;
+	member->pending = 0;
+	ring_buff_mutex_unlock(obj->lock);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_set_wait(ring_buff_set_handle_t handle, ring_buff_set_event_t *events, uint32_t max,
+		uint32_t *count, uint32_t timeout_us)
+{
+	ring_buff_set_obj_t* obj = GET_RING_BUFF_SET_OBJ(handle);
+	ring_buff_set_member_t* member = NULL;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	uint64_t expires = 0;
+	uint64_t now = 0;
+	uint32_t ready = 0;
+	uint32_t i = 0;
+
+	if(obj == NULL || events == NULL || max == 0 || count == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	*count = 0;
+	/* level triggered: members returned last time are still ready if they are not fully served */
+	for(i = 0; i < obj->reported_count; i++)
+	{
+		member = obj->reported[i];
+		if(member->ring == NULL)
+		{
+			continue;
+		}
+		ready = ring_buff_get_events(member->ring) & member->events;
+		if(ready)
+		{
+			ring_buff_mutex_lock(obj->lock);
+			ring_buff_set_ready(obj, member, ready);
+			ring_buff_mutex_unlock(obj->lock);
+		}
+	}
+	obj->reported_count = 0;
+	if(timeout_us != RING_BUFF_SET_FOREVER)
+	{
+		expires = ring_buff_time_us() + timeout_us;
+	}
+	for(;;)
+	{
+		ring_buff_mutex_lock(obj->lock);
+		while(obj->head != NULL && *count < max)
+		{
+			member = obj->head;
+			obj->head = member->next;
+			if(obj->head == NULL)
+			{
+				obj->tail = NULL;
+			}
+			events[*count].ring = member->ring;
+			events[*count].events = member->pending;
+			events[*count].arg = member->arg;
+			member->queued = 0;
+			member->pending = 0;
+			member->next = NULL;
+			obj->reported[obj->reported_count++] = member;
+			(*count)++;
+		}
+		ring_buff_mutex_unlock(obj->lock);
+		if(*count != 0)
+		{
+			break;
+		}
+		if(timeout_us == RING_BUFF_SET_FOREVER)
+		{
+			err = ring_buff_binary_sem_take(obj->ready_sem);
+		}
+		else
+		{
+			now = ring_buff_time_us();
+			if(now >= expires)
+			{
+				return RING_BUFF_ERR_WOULD_BLOCK;
+			}
+			err = ring_buff_binary_sem_take_timed(obj->ready_sem, (uint32_t)(expires - now));
+		}
+		if(err != RING_BUFF_ERR_OK && err != RING_BUFF_ERR_WOULD_BLOCK)
+		{
+			return err;
+		}
+	}
+
+	return RING_BUFF_ERR_OK;
+}
+
+
+static void ring_buff_set_event(void* arg, uint32_t events)
+{
+	ring_buff_set_member_t* member = (ring_buff_set_member_t*)arg;
+	ring_buff_set_obj_t* obj = member->set;
+	uint8_t wake = 0;
+
+	events &= member->events;
+	if(events == 0)
+	{
+		return;
+	}
+	ring_buff_mutex_lock(obj->lock);
+	wake = ring_buff_set_ready(obj, member, events);
+	ring_buff_mutex_unlock(obj->lock);
+	/* waiter has to be woken up only when the first member gets ready */
+	if(wake)
+	{
+		ring_buff_binary_sem_give(obj->ready_sem);
+	}
+}
+
+static uint8_t ring_buff_set_ready(ring_buff_set_obj_t* obj, ring_buff_set_member_t* member, uint32_t events)
+{
+	uint8_t empty = (obj->head == NULL);
+
+	member->pending |= events;
+	if(member->queued)
+	{
+		return 0;
+	}
+	member->queued = 1;
+	member->next = NULL;
+	if(obj->tail != NULL)
+	{
+		obj->tail->next = member;
+	}
+	else
+	{
+		obj->head = member;
+	}
+	obj->tail = member;
+
+	return empty;
+}
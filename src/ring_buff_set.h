@@ -0,0 +1,118 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+#ifndef RING_BUFF_SET_H_
+#define RING_BUFF_SET_H_
+
+#include "ring_buff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Ring buffer has data to read (or it is stopped/canceled). */
+#define RING_BUFF_SET_READ  0x1
+/** Ring buffer has free space to write to (or it is stopped/canceled). */
+#define RING_BUFF_SET_WRITE 0x2
+/** Wait without timeout. */
+#define RING_BUFF_SET_FOREVER 0xFFFFFFFF
+
+/**
+ * Ring buffer set handle.
+ */
+typedef void* ring_buff_set_handle_t;
+
+/**
+ * Ready ring buffer, as returned by "ring_buff_set_wait".
+ */
+typedef struct ring_buff_set_event
+{
+	/** Ring buffer handle. */
+	ring_buff_handle_t ring;
+	/** Ready events (bitwise or of RING_BUFF_SET_READ/RING_BUFF_SET_WRITE). */
+	uint32_t events;
+	/** Argument passed when ring buffer is added to the set. */
+	void* arg;
+} ring_buff_set_event_t;
+
+/**
+ * Creates ring buffer set. Set is used to wait until any of its ring buffers is ready.
+ * Only one thread may wait on the set, and it should be the one that adds/removes ring buffers.
+ * @param max Maximum number of ring buffers in the set.
+ * @param handle Pointer to the handle. This argument must not be NULL.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_set_create(uint32_t max, ring_buff_set_handle_t *handle);
+/**
+ * Ring buffer set destructor function. Ring buffers are removed from the set, but not destroyed.
+ * @param handle Ring buffer set handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_set_destroy(ring_buff_set_handle_t handle);
+/**
+ * Adds ring buffer to the set. Ring buffer can be a member of only one set.
+ * @param handle Ring buffer set handle.
+ * @param ring Ring buffer handle.
+ * @param events Events of interest (bitwise or of RING_BUFF_SET_READ/RING_BUFF_SET_WRITE).
+ * @param arg Argument returned with the ring buffer events.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_NO_MEM if set is full,
+ * RING_BUFF_ERR_PERM if ring buffer is already a member of some set, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_set_add(ring_buff_set_handle_t handle, ring_buff_handle_t ring, uint32_t events, void* arg);
+/**
+ * Removes ring buffer from the set.
+ * @param handle Ring buffer set handle.
+ * @param ring Ring buffer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_set_remove(ring_buff_set_handle_t handle, ring_buff_handle_t ring);
+/**
+ * Waits until at least one ring buffer in the set is ready, and returns ready ones.
+ * Readiness is level triggered: ring buffer that is returned is checked again on the next wait,
+ * and returned again if it is still ready. Cost of the wait depends only on the number of ready
+ * ring buffers, not on the set size.
+ * @param handle Ring buffer set handle.
+ * @param events Output array that will contain ready ring buffers.
+ * @param max Size of the output array.
+ * @param count Output argument that will contain number of ready ring buffers.
+ * @param timeout_us Timeout in microseconds (0 to return right away, RING_BUFF_SET_FOREVER to wait without timeout).
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_WOULD_BLOCK on timeout,
+ * or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_set_wait(ring_buff_set_handle_t handle, ring_buff_set_event_t *events, uint32_t max,
+		uint32_t *count, uint32_t timeout_us);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RING_BUFF_SET_H_ */
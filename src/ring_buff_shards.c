@@ -0,0 +1,444 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring_buff_shards.h"
+#include "ring_buff_osal.h"
+
+#define GET_RING_BUFF_SHARDS_OBJ(handle) ((ring_buff_shards_obj_t*)handle)
+
+/* Record header (commit time stamp), used only for time stamp order */
+#define RING_BUFF_SHARDS_HDR_SIZE sizeof(uint64_t)
+
+/**
+ * Shard record that is claimed by the consumer, but not drained yet.
+ */
+typedef struct ring_buff_shard_head
+{
+	/** Claimed record (NULL if there is none) */
+	uint8_t *rec;
+	/** Record size (including header) */
+	uint32_t size;
+} ring_buff_shard_head_t;
+
+struct ring_buff_shards_obj;
+
+/**
+ * Shard ownership. Producer thread keeps pointer to it in the thread local storage.
+ */
+typedef struct ring_buff_shard_slot
+{
+	/** Sharded ring buffer the shard belongs to */
+	struct ring_buff_shards_obj *obj;
+	/** Shard index */
+	uint32_t idx;
+	/** Set while the shard is assigned to the producer thread */
+	uint8_t owned;
+} ring_buff_shard_slot_t;
+
+/**
+ * Sharded ring buffer structure.
+ */
+typedef struct ring_buff_shards_obj
+{
+	/** Shards (ring buffers in record mode) */
+	ring_buff_handle_t *rings;
+	/** Shard buffers */
+	void **buffs;
+	/** Records claimed by the consumer, one per shard (consumer only) */
+	ring_buff_shard_head_t *heads;
+	/** Shard ownership, one per shard */
+	ring_buff_shard_slot_t *slots;
+	/** Number of shards */
+	uint32_t count;
+	/** Number of shards that were ever assigned to the producers (never more than count) */
+	uint32_t registered;
+	/** Next shard to drain (round robin) */
+	uint32_t next;
+	/** Drain order */
+	ring_buff_shards_order_t order;
+	/** Record header size */
+	uint32_t hdr_size;
+	/** Set when shards are stopped */
+	uint8_t stopped;
+	/** Shard of the calling (producer) thread */
+	ring_buff_tls_t tls;
+} ring_buff_shards_obj_t;
+
+/**
+ * Internal function which returns shard of the calling thread. Free shard is assigned on the first call.
+ * @param obj Valid sharded buffer object.
+ * @param ring Output argument that will contain shard handle.
+ * @return RING_BUFF_ERR_OK, or RING_BUFF_ERR_NO_MEM if all the shards are taken.
+ */
+static ring_buff_err_t ring_buff_shards_get(ring_buff_shards_obj_t* obj, ring_buff_handle_t* ring);
+/**
+ * Internal function which releases the shard, so it can be assigned to another thread.
+ * It is thread local storage destructor, called when the producer thread exits.
+ * @param value Shard slot of the exiting thread.
+ */
+static void ring_buff_shards_put(void* value);
+
+ring_buff_err_t ring_buff_shards_create(ring_buff_shards_attr_t *attr, ring_buff_shards_handle_t *handle)
+{
+	ring_buff_shards_obj_t* obj = NULL;
+	ring_buff_attr_t ring_attr;
+	ring_buff_err_t err_code = RING_BUFF_ERR_BAD_ARG;
+	uint32_t i = 0;
+
+	if(attr == NULL || handle == NULL)
+	{
+		goto done;
+	}
+	if(attr->shards == 0 || attr->shard_size == 0)
+	{
+		goto done;
+	}
+	obj = malloc(sizeof(ring_buff_shards_obj_t));
+	if(obj == NULL)
+	{
+		err_code = RING_BUFF_ERR_NO_MEM;
+		goto done;
+	}
+	memset(obj, 0, sizeof(ring_buff_shards_obj_t));
+	obj->rings = calloc(attr->shards, sizeof(ring_buff_handle_t));
+	obj->buffs = calloc(attr->shards, sizeof(void*));
+	obj->heads = calloc(attr->shards, sizeof(ring_buff_shard_head_t));
+	obj->slots = calloc(attr->shards, sizeof(ring_buff_shard_slot_t));
+	if(obj->rings == NULL || obj->buffs == NULL || obj->heads == NULL || obj->slots == NULL)
+	{
+		ring_buff_shards_destroy(obj);
+		obj = NULL;
+		err_code = RING_BUFF_ERR_NO_MEM;
+		goto done;
+	}
+	obj->count = attr->shards;
+	obj->order = attr->order;
+	obj->hdr_size = (attr->order == RING_BUFF_SHARDS_TIMESTAMP) ? RING_BUFF_SHARDS_HDR_SIZE : 0;
+	/* all the shards are created up-front, so consumer never races with shard creation */
+	memset(&ring_attr, 0, sizeof(ring_buff_attr_t));
+	ring_attr.size = attr->shard_size;
+	ring_attr.records = 1;
+	for(i = 0; i < attr->shards; i++)
+	{
+		obj->buffs[i] = malloc(attr->shard_size);
+		if(obj->buffs[i] == NULL)
+		{
+			ring_buff_shards_destroy(obj);
+			obj = NULL;
+			err_code = RING_BUFF_ERR_NO_MEM;
+			goto done;
+		}
+		obj->slots[i].obj = obj;
+		obj->slots[i].idx = i;
+		ring_attr.buff = obj->buffs[i];
+		err_code = ring_buff_create(&ring_attr, &(obj->rings[i]));
+		if(err_code != RING_BUFF_ERR_OK)
+		{
+			ring_buff_shards_destroy(obj);
+			obj = NULL;
+			goto done;
+		}
+	}
+	err_code = ring_buff_tls_create_with_dtor(&(obj->tls), ring_buff_shards_put);
+	if(err_code != RING_BUFF_ERR_OK)
+	{
+		ring_buff_shards_destroy(obj);
+		obj = NULL;
+		goto done;
+	}
+
+done:
+	if(handle != NULL)
+	{
+		*handle = obj;
+	}
+	return err_code;
+}
+
+ring_buff_err_t ring_buff_shards_destroy(ring_buff_shards_handle_t handle)
+{
+	ring_buff_shards_obj_t* obj = GET_RING_BUFF_SHARDS_OBJ(handle);
+	uint32_t i = 0;
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	if(obj->tls != NULL)
+	{
+		ring_buff_tls_destroy(obj->tls);
+	}
+	/* shards are created in order, so the first missing one ends the list */
+	for(i = 0; i < obj->count && obj->buffs[i] != NULL; i++)
+	{
+		if(obj->rings[i] != NULL)
+		{
+			ring_buff_destroy(obj->rings[i]);
+		}
+		free(obj->buffs[i]);
+	}
+	free(obj->rings);
+	free(obj->buffs);
+	free(obj->heads);
+	free(obj->slots);
+	free(obj);
+
+	return RING_BUFF_ERR_OK;
+}
+
+ring_buff_err_t ring_buff_shards_reserve(ring_buff_shards_handle_t handle, void **buff, uint32_t size)
+{
+	ring_buff_shards_obj_t* obj = GET_RING_BUFF_SHARDS_OBJ(handle);
+	ring_buff_handle_t ring = NULL;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	if(handle == NULL || buff == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	err = ring_buff_shards_get(obj, &ring);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		return err;
+	}
+	err = ring_buff_reserve(ring, buff, size + obj->hdr_size);
+	if(err == RING_BUFF_ERR_OK)
+	{
+		*buff = (uint8_t*)*buff + obj->hdr_size;
+	}
+
+	return err;
+}
+
+ring_buff_err_t ring_buff_shards_commit(ring_buff_shards_handle_t handle, void *buff, uint32_t size)
+{
+	ring_buff_shards_obj_t* obj = GET_RING_BUFF_SHARDS_OBJ(handle);
+	ring_buff_handle_t ring = NULL;
+	uint8_t* rec = NULL;
+	uint64_t now = 0;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	if(handle == NULL || buff == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	err = ring_buff_shards_get(obj, &ring);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		return err;
+	}
+	rec = (uint8_t*)buff - obj->hdr_size;
+	if(obj->hdr_size)
+	{
+		now = ring_buff_time_us();
+		memcpy(rec, &now, sizeof(now));
+	}
+
+	return ring_buff_commit(ring, rec, size + obj->hdr_size);
+}
+
+ring_buff_err_t ring_buff_shards_drain(ring_buff_shards_handle_t handle, ring_buff_shards_drain_t drain_func,
+		void* arg, uint32_t max, uint32_t *drained)
+{
+	ring_buff_shards_obj_t* obj = GET_RING_BUFF_SHARDS_OBJ(handle);
+	ring_buff_shard_head_t* head = NULL;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	uint64_t ts = 0;
+	uint64_t sel_ts = 0;
+	uint32_t count = 0;
+	uint32_t stopped = 0;
+	uint32_t done = 0;
+	uint32_t sel = 0;
+	uint32_t idx = 0;
+	uint32_t i = 0;
+	void* rec = NULL;
+
+	if(handle == NULL || drain_func == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	count = __atomic_load_n(&obj->registered, __ATOMIC_ACQUIRE);
+	if(count > obj->count)
+	{
+		count = obj->count;
+	}
+	while(max == 0 || done < max)
+	{
+		/* pick the shard to drain from: next one that has a record (round robin), or the oldest record */
+		sel = count;
+		stopped = 0;
+		for(i = 0; i < count; i++)
+		{
+			idx = (obj->next + i) % count;
+			head = &(obj->heads[idx]);
+			if(head->rec == NULL)
+			{
+				err = ring_buff_try_claim(obj->rings[idx], &rec, &(head->size));
+				if(err != RING_BUFF_ERR_OK)
+				{
+					if(err == RING_BUFF_ERR_PERM)
+					{
+						stopped++;
+					}
+					continue;
+				}
+				head->rec = rec;
+			}
+			if(obj->order == RING_BUFF_SHARDS_ROUND_ROBIN)
+			{
+				sel = idx;
+				break;
+			}
+			memcpy(&ts, head->rec, sizeof(ts));
+			if(sel == count || ts < sel_ts)
+			{
+				sel = idx;
+				sel_ts = ts;
+			}
+		}
+		if(sel == count)
+		{
+			break;
+		}
+		head = &(obj->heads[sel]);
+		err = drain_func(obj, head->rec + obj->hdr_size, head->size - obj->hdr_size, arg);
+		ring_buff_release(obj->rings[sel], head->rec);
+		head->rec = NULL;
+		obj->next = (sel + 1) % count;
+		done++;
+		if(err != RING_BUFF_ERR_OK)
+		{
+			goto done;
+		}
+	}
+	err = RING_BUFF_ERR_OK;
+	/* everything is drained only if producers are done (stopped) */
+	if(sel == count && stopped == count && __atomic_load_n(&obj->stopped, __ATOMIC_ACQUIRE))
+	{
+		err = RING_BUFF_ERR_PERM;
+	}
+
+done:
+	if(drained != NULL)
+	{
+		*drained = done;
+	}
+	return err;
+}
+
+ring_buff_err_t ring_buff_shards_unregister(ring_buff_shards_handle_t handle)
+{
+	ring_buff_shards_obj_t* obj = GET_RING_BUFF_SHARDS_OBJ(handle);
+	ring_buff_shard_slot_t* slot = NULL;
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	slot = ring_buff_tls_get(obj->tls);
+	if(slot == NULL)
+	{
+		return RING_BUFF_ERR_OK;
+	}
+	ring_buff_shards_put(slot);
+
+	return ring_buff_tls_set(obj->tls, NULL);
+}
+
+ring_buff_err_t ring_buff_shards_stop(ring_buff_shards_handle_t handle)
+{
+	ring_buff_shards_obj_t* obj = GET_RING_BUFF_SHARDS_OBJ(handle);
+	uint32_t i = 0;
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	for(i = 0; i < obj->count; i++)
+	{
+		ring_buff_stop(obj->rings[i]);
+	}
+	__atomic_store_n(&obj->stopped, 1, __ATOMIC_RELEASE);
+
+	return RING_BUFF_ERR_OK;
+}
+
+
+static ring_buff_err_t ring_buff_shards_get(ring_buff_shards_obj_t* obj, ring_buff_handle_t* ring)
+{
+	ring_buff_shard_slot_t* slot = NULL;
+	uint32_t idx = 0;
+	uint32_t i = 0;
+
+	slot = ring_buff_tls_get(obj->tls);
+	if(slot != NULL)
+	{
+		*ring = obj->rings[slot->idx];
+		return RING_BUFF_ERR_OK;
+	}
+	/* the only shared access of the producer, done once per thread: take the first free shard */
+	for(i = 0; slot == NULL && i < obj->count; i++)
+	{
+		uint8_t owned = 0;
+		if(__atomic_compare_exchange_n(&obj->slots[i].owned, &owned, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+		{
+			slot = &(obj->slots[i]);
+		}
+	}
+	if(slot == NULL)
+	{
+		*ring = NULL;
+		fprintf(stderr, "WARNING (%s): No free shard for the producer thread!\n", __func__);
+		return RING_BUFF_ERR_NO_MEM;
+	}
+	/* shards released by exited threads are reused, so registered stops at count */
+	idx = __atomic_load_n(&obj->registered, __ATOMIC_ACQUIRE);
+	while(idx <= slot->idx &&
+			!__atomic_compare_exchange_n(&obj->registered, &idx, slot->idx + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	{
+	}
+	*ring = obj->rings[slot->idx];
+
+	return ring_buff_tls_set(obj->tls, slot);
+}
+
+static void ring_buff_shards_put(void* value)
+{
+	ring_buff_shard_slot_t* slot = (ring_buff_shard_slot_t*)value;
+
+	/* records already committed stay in the shard until they are drained */
+	__atomic_store_n(&slot->owned, 0, __ATOMIC_RELEASE);
+}
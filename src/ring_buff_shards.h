@@ -0,0 +1,148 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+#ifndef RING_BUFF_SHARDS_H_
+#define RING_BUFF_SHARDS_H_
+
+#include "ring_buff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Order in which records from different shards are drained.
+ */
+typedef enum ring_buff_shards_order
+{
+	/** One record from each shard in turn */
+	RING_BUFF_SHARDS_ROUND_ROBIN = 0,
+	/** Records are merged by their commit time stamp */
+	RING_BUFF_SHARDS_TIMESTAMP
+} ring_buff_shards_order_t;
+
+/**
+ * Sharded ring buffer handle.
+ */
+typedef void* ring_buff_shards_handle_t;
+
+/**
+ * Drain callback function prototype. It is called for every record drained, from the
+ * thread that calls "ring_buff_shards_drain". Record memory is valid only during the call.
+ * @param handle Sharded ring buffer handle.
+ * @param buff Record data.
+ * @param size Record size.
+ * @param arg Argument passed to "ring_buff_shards_drain".
+ * @return RING_BUFF_ERR_OK if everything was OK, or error (draining stops in that case).
+ */
+typedef ring_buff_err_t (*ring_buff_shards_drain_t) (ring_buff_shards_handle_t handle, void* buff, uint32_t size, void* arg);
+
+/**
+ * Sharded ring buffer attribute structure. It is used when sharded ring buffer is created.
+ */
+typedef struct ring_buff_shards_attr
+{
+	/** Number of shards (maximum number of concurrent producer threads). */
+	uint32_t shards;
+	/** Buffer size of each shard. Memory is allocated internally. */
+	uint32_t shard_size;
+	/** Drain order. */
+	ring_buff_shards_order_t order;
+} ring_buff_shards_attr_t;
+
+/**
+ * Creates sharded ring buffer. It is a set of ring buffers (shards) in record mode, one per
+ * producer thread, so producers never share the buffer (or lock) with each other. Consumer
+ * drains all the shards as one stream.
+ * @param attr Sharded ring buffer attribute object.
+ * @param handle Pointer to the handle. This argument must not be NULL.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_shards_create(ring_buff_shards_attr_t *attr, ring_buff_shards_handle_t *handle);
+/**
+ * Sharded ring buffer destructor function. All the shards are destroyed.
+ * @param handle Sharded ring buffer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_shards_destroy(ring_buff_shards_handle_t handle);
+/**
+ * Reserves record in the shard of the calling thread. Thread is assigned a free shard on its first reserve,
+ * and it keeps it until it exits or calls "ring_buff_shards_unregister".
+ * @param handle Sharded ring buffer handle.
+ * @param buff Output argument that will contain pointer to the reserved record.
+ * @param size Record size.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_NO_MEM if all the shards are taken,
+ * or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_shards_reserve(ring_buff_shards_handle_t handle, void **buff, uint32_t size);
+/**
+ * Commits record reserved with "ring_buff_shards_reserve". It must be called from the same thread.
+ * @param handle Sharded ring buffer handle.
+ * @param buff Pointer to the reserved record.
+ * @param size Record size.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_shards_commit(ring_buff_shards_handle_t handle, void *buff, uint32_t size);
+/**
+ * Releases the shard of the calling thread, so it can be assigned to another producer thread.
+ * It is done automatically when the thread exits. Records already committed are still drained,
+ * but all the reserved records must be committed before the shard is released.
+ * @param handle Sharded ring buffer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK (or the thread has no shard), or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_shards_unregister(ring_buff_shards_handle_t handle);
+/**
+ * Drains available records from all the shards, in the configured order. It does NOT block.
+ * Only one thread may drain the sharded ring buffer.
+ * NOTE: Time stamp order is kept between the records that are available when they are drained.
+ * @param handle Sharded ring buffer handle.
+ * @param drain_func Function called for every record.
+ * @param arg Argument passed to the drain function.
+ * @param max Maximum number of records to drain (0 means no limit).
+ * @param drained Output argument that will contain number of records drained (may be NULL).
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_PERM if buffer is stopped and all
+ * the records are drained, or error returned by the drain function.
+ */
+ring_buff_err_t ring_buff_shards_drain(ring_buff_shards_handle_t handle, ring_buff_shards_drain_t drain_func,
+		void* arg, uint32_t max, uint32_t *drained);
+/**
+ * Stops all the shards. Consumer can still drain rest of the data.
+ * @param handle Sharded ring buffer handle.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_shards_stop(ring_buff_shards_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RING_BUFF_SHARDS_H_ */
@@ -0,0 +1,557 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring_buff_sink.h"
+#include "ring_buff_osal.h"
+
+#define GET_RING_BUFF_SINK_OBJ(handle) ((ring_buff_sink_obj_t*)handle)
+
+/* Default block size */
+#define RING_BUFF_SINK_BLOCK 4096
+/* Default maximum write size */
+#define RING_BUFF_SINK_CHUNK (1024 * 1024)
+/* Default number of writes in flight */
+#define RING_BUFF_SINK_DEPTH 4
+/* Write from the bounce buffer (it does not hold any ring buffer chunk) */
+#define RING_BUFF_SINK_NO_CHUNK 0xFFFFFFFF
+
+struct ring_buff_sink_obj;
+
+/**
+ * Writer. Each writer has one write in flight, so number of writers is the sink depth.
+ */
+typedef struct ring_buff_sink_writer
+{
+	/** Sink */
+	struct ring_buff_sink_obj *sink;
+	/** Writer thread */
+	ring_buff_thread_t thread;
+	/** Signaled when write is assigned (or writer should exit) */
+	ring_buff_binary_sem_t go_sem;
+	/** Bounce buffer memory */
+	void* mem;
+	/** Bounce buffer (block aligned, chunk size) */
+	uint8_t* bounce;
+	/** Write data */
+	const uint8_t* data;
+	/** Write size */
+	uint32_t size;
+	/** File offset */
+	uint64_t off;
+	/** Ring buffer chunk the data belongs to (RING_BUFF_SINK_NO_CHUNK for the bounce buffer) */
+	uint32_t chunk;
+	/** Set when writer should exit */
+	uint8_t quit;
+} ring_buff_sink_writer_t;
+
+/**
+ * Ring buffer chunk that is read, but not freed yet.
+ */
+typedef struct ring_buff_sink_chunk
+{
+	/** Chunk data */
+	void* buff;
+	/** Chunk size */
+	uint32_t size;
+	/** Writes in flight that point to the chunk */
+	uint32_t writes;
+	/** Set when sink is done with the chunk (it is copied, or its writes are issued) */
+	uint8_t sealed;
+} ring_buff_sink_chunk_t;
+
+/**
+ * Sink structure.
+ */
+typedef struct ring_buff_sink_obj
+{
+	/** Drained ring buffer */
+	ring_buff_handle_t ring;
+	/** Output file */
+	ring_buff_file_t file;
+	/** Block size */
+	uint32_t block;
+	/** Maximum write size */
+	uint32_t chunk;
+	/** Number of writers */
+	uint32_t depth;
+	/** Sink thread */
+	ring_buff_thread_t thread;
+	/** Guards writer and chunk bookkeeping */
+	ring_buff_mutex_t lock;
+	/** Signaled when writer finishes the write */
+	ring_buff_binary_sem_t idle_sem;
+	/** Writers */
+	ring_buff_sink_writer_t* writers;
+	/** Idle writers (stack of indexes) */
+	uint32_t* idle;
+	/** Number of idle writers */
+	uint32_t idle_count;
+	/** Chunks that are not freed, in the read order (circular) */
+	ring_buff_sink_chunk_t* chunks;
+	/** Chunk queue capacity */
+	uint32_t chunks_max;
+	/** Oldest chunk */
+	uint32_t chunks_head;
+	/** Number of chunks */
+	uint32_t chunks_count;
+	/** Writer whose bounce buffer is being filled (NULL if none) */
+	ring_buff_sink_writer_t* cur;
+	/** File offset of the bounce buffer that is being filled (block aligned) */
+	uint64_t cur_off;
+	/** Bytes in the bounce buffer that is being filled */
+	uint32_t cur_len;
+	/** First error (RING_BUFF_ERR_OK if none) */
+	ring_buff_err_t err;
+	/** Statistics (written only by the sink thread) */
+	ring_buff_sink_stats_t stats;
+} ring_buff_sink_obj_t;
+
+/**
+ * Sink thread. It reads the ring buffer until it is stopped, and issues the writes.
+ * @param arg Sink.
+ */
+static void ring_buff_sink_drain(void* arg);
+/**
+ * Writer thread.
+ * @param arg Writer.
+ */
+static void ring_buff_sink_write(void* arg);
+/**
+ * Internal function which issues writes for the chunk that is read from the ring buffer.
+ * @param obj Sink.
+ * @param chunk Chunk index.
+ * @param buff Chunk data.
+ * @param size Chunk size.
+ */
+static void ring_buff_sink_consume(ring_buff_sink_obj_t* obj, uint32_t chunk, uint8_t* buff, uint32_t size);
+/**
+ * Internal function which waits for an idle writer.
+ * @param obj Sink.
+ * @return Idle writer.
+ */
+static ring_buff_sink_writer_t* ring_buff_sink_get_writer(ring_buff_sink_obj_t* obj);
+/**
+ * Internal function which passes write to the writer.
+ * @param obj Sink.
+ * @param writer Writer (taken with "ring_buff_sink_get_writer").
+ * @param chunk Chunk index, or RING_BUFF_SINK_NO_CHUNK if data is in the writer bounce buffer.
+ * @param data Write data.
+ * @param size Write size.
+ * @param off File offset.
+ */
+static void ring_buff_sink_submit(ring_buff_sink_obj_t* obj, ring_buff_sink_writer_t* writer, uint32_t chunk,
+		const uint8_t* data, uint32_t size, uint64_t off);
+/**
+ * Internal function which frees chunks that are done, in the read order. It is called with the lock held.
+ * @param obj Sink.
+ */
+static void ring_buff_sink_retire(ring_buff_sink_obj_t* obj);
+/**
+ * Internal function which stops the threads and frees sink resources.
+ * @param obj Sink.
+ */
+static void ring_buff_sink_free(ring_buff_sink_obj_t* obj);
+
+ring_buff_err_t ring_buff_sink_create(ring_buff_handle_t ring, ring_buff_sink_attr_t *attr, ring_buff_sink_handle_t *handle)
+{
+	ring_buff_sink_obj_t* obj = NULL;
+	ring_buff_sink_writer_t* writer = NULL;
+	ring_buff_err_t err_code = RING_BUFF_ERR_BAD_ARG;
+	uint32_t size = 0;
+	uint32_t i = 0;
+
+	if(ring == NULL || attr == NULL || attr->path == NULL || handle == NULL ||
+			(attr->block & (attr->block - 1)) != 0 || ring_buff_get_size(ring, &size) != RING_BUFF_ERR_OK)
+	{
+		goto done;
+	}
+	obj = malloc(sizeof(ring_buff_sink_obj_t));
+	if(obj == NULL)
+	{
+		err_code = RING_BUFF_ERR_NO_MEM;
+		goto done;
+	}
+	memset(obj, 0, sizeof(ring_buff_sink_obj_t));
+	obj->ring = ring;
+	obj->block = attr->block ? attr->block : RING_BUFF_SINK_BLOCK;
+	obj->chunk = attr->chunk ? attr->chunk : RING_BUFF_SINK_CHUNK;
+	obj->depth = attr->depth ? attr->depth : RING_BUFF_SINK_DEPTH;
+	/* sink must not hold the whole ring buffer while it waits for the next chunk */
+	if(obj->chunk > size / 2)
+	{
+		obj->chunk = size / 2;
+	}
+	obj->chunk &= ~(obj->block - 1);
+	if(obj->chunk == 0)
+	{
+		err_code = RING_BUFF_ERR_SIZE;
+		goto fail;
+	}
+	/* every writer holds at most one chunk, and chunks that are only copied wait behind them */
+	obj->chunks_max = 2 * obj->depth + 1;
+	obj->writers = calloc(obj->depth, sizeof(ring_buff_sink_writer_t));
+	obj->idle = calloc(obj->depth, sizeof(uint32_t));
+	obj->chunks = calloc(obj->chunks_max, sizeof(ring_buff_sink_chunk_t));
+	if(obj->writers == NULL || obj->idle == NULL || obj->chunks == NULL)
+	{
+		err_code = RING_BUFF_ERR_NO_MEM;
+		goto fail;
+	}
+	err_code = ring_buff_file_open_direct(&(obj->file), attr->path);
+	if(err_code != RING_BUFF_ERR_OK)
+	{
+		goto fail;
+	}
+	if((err_code = ring_buff_mutex_create(&(obj->lock))) != RING_BUFF_ERR_OK ||
+			(err_code = ring_buff_binary_sem_create(&(obj->idle_sem))) != RING_BUFF_ERR_OK)
+	{
+		goto fail;
+	}
+	for(i = 0; i < obj->depth; i++)
+	{
+		writer = &(obj->writers[i]);
+		writer->sink = obj;
+		writer->mem = malloc(obj->chunk + obj->block);
+		if(writer->mem == NULL)
+		{
+			err_code = RING_BUFF_ERR_NO_MEM;
+			goto fail;
+		}
+		writer->bounce = (uint8_t*)(((uintptr_t)writer->mem + obj->block - 1) & ~((uintptr_t)obj->block - 1));
+		if((err_code = ring_buff_binary_sem_create(&(writer->go_sem))) != RING_BUFF_ERR_OK)
+		{
+			goto fail;
+		}
+		/* semaphore is created signaled, and writer has nothing to write yet */
+		ring_buff_binary_sem_take(writer->go_sem);
+		if((err_code = ring_buff_thread_create(&(writer->thread), ring_buff_sink_write, writer)) != RING_BUFF_ERR_OK)
+		{
+			goto fail;
+		}
+		obj->idle[obj->idle_count++] = i;
+	}
+	err_code = ring_buff_thread_create(&(obj->thread), ring_buff_sink_drain, obj);
+	if(err_code != RING_BUFF_ERR_OK)
+	{
+		goto fail;
+	}
+
+	goto done;
+
+fail:
+	ring_buff_sink_free(obj);
+	obj = NULL;
+
+done:
+	if(handle != NULL)
+	{
+		*handle = obj;
+	}
+	return err_code;
+}
+
+ring_buff_err_t ring_buff_sink_destroy(ring_buff_sink_handle_t handle)
+{
+	ring_buff_sink_obj_t* obj = GET_RING_BUFF_SINK_OBJ(handle);
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	if(obj == NULL)
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	/* sink thread exits once ring buffer is drained, and everything is on the disk */
+	ring_buff_thread_join(obj->thread);
+	obj->thread = NULL;
+	err = obj->err;
+	ring_buff_sink_free(obj);
+
+	return err;
+}
+
+ring_buff_err_t ring_buff_sink_get_stats(ring_buff_sink_handle_t handle, ring_buff_sink_stats_t *stats)
+{
+	ring_buff_sink_obj_t* obj = GET_RING_BUFF_SINK_OBJ(handle);
+
+	if(obj == NULL || stats == NULL)
+	{
+		return RING_BUFF_ERR_BAD_ARG;
+	}
+	*stats = obj->stats;
+
+	return RING_BUFF_ERR_OK;
+}
+
+static void ring_buff_sink_drain(void* arg)
+{
+	ring_buff_sink_obj_t* obj = GET_RING_BUFF_SINK_OBJ(arg);
+	ring_buff_sink_chunk_t* chunk = NULL;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	void* buff = NULL;
+	uint32_t read = 0;
+	uint32_t index = 0;
+	uint32_t pad = 0;
+
+	do
+	{
+		err = ring_buff_read(obj->ring, &buff, obj->chunk, &read);
+		if(read == 0)
+		{
+			continue;
+		}
+		/* chunks are freed in order, so copied chunks may wait behind the ones that are being written */
+		ring_buff_mutex_lock(obj->lock);
+		while(obj->chunks_count == obj->chunks_max)
+		{
+			ring_buff_mutex_unlock(obj->lock);
+			ring_buff_binary_sem_take(obj->idle_sem);
+			ring_buff_mutex_lock(obj->lock);
+		}
+		index = (obj->chunks_head + obj->chunks_count) % obj->chunks_max;
+		chunk = &(obj->chunks[index]);
+		chunk->buff = buff;
+		chunk->size = read;
+		chunk->writes = 0;
+		chunk->sealed = 0;
+		obj->chunks_count++;
+		ring_buff_mutex_unlock(obj->lock);
+
+		ring_buff_sink_consume(obj, index, buff, read);
+
+		ring_buff_mutex_lock(obj->lock);
+		chunk->sealed = 1;
+		ring_buff_sink_retire(obj);
+		ring_buff_mutex_unlock(obj->lock);
+	} while(err == RING_BUFF_ERR_OK);
+
+	/* last partial block is padded, and file is trimmed once it is written */
+	if(obj->cur != NULL)
+	{
+		pad = (obj->block - obj->cur_len % obj->block) % obj->block;
+		memset(obj->cur->bounce + obj->cur_len, 0, pad);
+		ring_buff_sink_submit(obj, obj->cur, RING_BUFF_SINK_NO_CHUNK, obj->cur->bounce, obj->cur_len + pad, obj->cur_off);
+		obj->cur = NULL;
+	}
+	ring_buff_mutex_lock(obj->lock);
+	while(obj->idle_count < obj->depth)
+	{
+		ring_buff_mutex_unlock(obj->lock);
+		ring_buff_binary_sem_take(obj->idle_sem);
+		ring_buff_mutex_lock(obj->lock);
+	}
+	ring_buff_mutex_unlock(obj->lock);
+	if(pad && ring_buff_file_truncate(obj->file, obj->stats.bytes) != RING_BUFF_ERR_OK && obj->err == RING_BUFF_ERR_OK)
+	{
+		obj->err = RING_BUFF_ERR_INTERNAL;
+	}
+}
+
+static void ring_buff_sink_write(void* arg)
+{
+	ring_buff_sink_writer_t* writer = (ring_buff_sink_writer_t*)arg;
+	ring_buff_sink_obj_t* obj = writer->sink;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+
+	for(;;)
+	{
+		ring_buff_binary_sem_take(writer->go_sem);
+		if(writer->quit)
+		{
+			break;
+		}
+		err = ring_buff_file_write(obj->file, writer->off, writer->data, writer->size);
+
+		ring_buff_mutex_lock(obj->lock);
+		if(err != RING_BUFF_ERR_OK && obj->err == RING_BUFF_ERR_OK)
+		{
+			obj->err = err;
+		}
+		if(writer->chunk != RING_BUFF_SINK_NO_CHUNK)
+		{
+			obj->chunks[writer->chunk].writes--;
+			ring_buff_sink_retire(obj);
+		}
+		obj->idle[obj->idle_count++] = writer - obj->writers;
+		ring_buff_mutex_unlock(obj->lock);
+		ring_buff_binary_sem_give(obj->idle_sem);
+	}
+}
+
+static void ring_buff_sink_consume(ring_buff_sink_obj_t* obj, uint32_t chunk, uint8_t* buff, uint32_t size)
+{
+	uint32_t block = obj->block;
+	uint32_t part = 0;
+
+	while(size)
+	{
+		if(obj->stats.bytes % block == 0 && (uintptr_t)buff % block == 0 && size >= block)
+		{
+			/* whole blocks, aligned both in memory and in the file -> written straight from the ring buffer */
+			if(obj->cur != NULL)
+			{
+				ring_buff_sink_submit(obj, obj->cur, RING_BUFF_SINK_NO_CHUNK, obj->cur->bounce, obj->cur_len, obj->cur_off);
+				obj->cur = NULL;
+			}
+			part = size - size % block;
+			ring_buff_mutex_lock(obj->lock);
+			obj->chunks[chunk].writes++;
+			ring_buff_mutex_unlock(obj->lock);
+			ring_buff_sink_submit(obj, ring_buff_sink_get_writer(obj), chunk, buff, part, obj->stats.bytes);
+			obj->stats.direct += part;
+		}
+		else
+		{
+			if(obj->cur == NULL)
+			{
+				/* bounce buffer always starts at the block boundary */
+				obj->cur = ring_buff_sink_get_writer(obj);
+				obj->cur_off = obj->stats.bytes;
+				obj->cur_len = 0;
+			}
+			part = obj->chunk - obj->cur_len;
+			/* memory has the same block offset as the file -> copy only up to the block boundary */
+			if((uintptr_t)buff % block == obj->stats.bytes % block && part > block - obj->stats.bytes % block)
+			{
+				part = block - obj->stats.bytes % block;
+			}
+			if(part > size)
+			{
+				part = size;
+			}
+			memcpy(obj->cur->bounce + obj->cur_len, buff, part);
+			obj->cur_len += part;
+			obj->stats.copied += part;
+			if(obj->cur_len == obj->chunk)
+			{
+				ring_buff_sink_submit(obj, obj->cur, RING_BUFF_SINK_NO_CHUNK, obj->cur->bounce, obj->cur_len, obj->cur_off);
+				obj->cur = NULL;
+			}
+		}
+		buff += part;
+		size -= part;
+		obj->stats.bytes += part;
+	}
+}
+
+static ring_buff_sink_writer_t* ring_buff_sink_get_writer(ring_buff_sink_obj_t* obj)
+{
+	ring_buff_sink_writer_t* writer = NULL;
+
+	ring_buff_mutex_lock(obj->lock);
+	while(obj->idle_count == 0)
+	{
+		ring_buff_mutex_unlock(obj->lock);
+		ring_buff_binary_sem_take(obj->idle_sem);
+		ring_buff_mutex_lock(obj->lock);
+	}
+	writer = &(obj->writers[obj->idle[--obj->idle_count]]);
+	ring_buff_mutex_unlock(obj->lock);
+
+	return writer;
+}
+
+static void ring_buff_sink_submit(ring_buff_sink_obj_t* obj, ring_buff_sink_writer_t* writer, uint32_t chunk,
+		const uint8_t* data, uint32_t size, uint64_t off)
+{
+	writer->chunk = chunk;
+	writer->data = data;
+	writer->size = size;
+	writer->off = off;
+	obj->stats.writes++;
+	ring_buff_binary_sem_give(writer->go_sem);
+}
+
+static void ring_buff_sink_retire(ring_buff_sink_obj_t* obj)
+{
+	ring_buff_sink_chunk_t* chunk = NULL;
+
+	while(obj->chunks_count)
+	{
+		chunk = &(obj->chunks[obj->chunks_head]);
+		if(!chunk->sealed || chunk->writes)
+		{
+			break;
+		}
+		if(ring_buff_free(obj->ring, chunk->buff, chunk->size) != RING_BUFF_ERR_OK && obj->err == RING_BUFF_ERR_OK)
+		{
+			obj->err = RING_BUFF_ERR_INTERNAL;
+		}
+		obj->chunks_head = (obj->chunks_head + 1) % obj->chunks_max;
+		obj->chunks_count--;
+	}
+}
+
+static void ring_buff_sink_free(ring_buff_sink_obj_t* obj)
+{
+	ring_buff_sink_writer_t* writer = NULL;
+	uint32_t i = 0;
+
+	if(obj == NULL)
+	{
+		return;
+	}
+	for(i = 0; obj->writers != NULL && i < obj->depth; i++)
+	{
+		writer = &(obj->writers[i]);
+		if(writer->thread != NULL)
+		{
+			writer->quit = 1;
+			ring_buff_binary_sem_give(writer->go_sem);
+			ring_buff_thread_join(writer->thread);
+		}
+		if(writer->go_sem != NULL)
+		{
+			ring_buff_binary_sem_destroy(writer->go_sem);
+		}
+		free(writer->mem);
+	}
+	if(obj->idle_sem != NULL)
+	{
+		ring_buff_binary_sem_destroy(obj->idle_sem);
+	}
+	if(obj->lock != NULL)
+	{
+		ring_buff_mutex_destroy(obj->lock);
+	}
+	if(obj->file != NULL)
+	{
+		ring_buff_file_close(obj->file);
+	}
+	free(obj->chunks);
+	free(obj->idle);
+	free(obj->writers);
+	free(obj);
+}
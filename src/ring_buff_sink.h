@@ -0,0 +1,121 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2012 Vladimir Maksovic
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither Vladimir Maksovic nor the names of this software contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL VLADIMIR MAKSOVIC
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+
+
+#ifndef RING_BUFF_SINK_H_
+#define RING_BUFF_SINK_H_
+
+#include "ring_buff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Sink handle.
+ */
+typedef void* ring_buff_sink_handle_t;
+
+/**
+ * Sink attribute structure.
+ */
+typedef struct ring_buff_sink_attr
+{
+	/** Output file path. File is created, or truncated if it exists. */
+	const char* path;
+	/**
+	 * Device block size (power of 2). Address, file offset and size of every write are multiple of it.
+	 * If set to 0, 4096 is used.
+	 */
+	uint32_t block;
+	/**
+	 * Maximum size of one write (it is rounded down to the block size). It is also the size sink reads
+	 * from the ring buffer at once, so it is limited to the half of the ring buffer.
+	 * If set to 0, 1MB is used.
+	 */
+	uint32_t chunk;
+	/** Number of writes in flight. If set to 0, 4 is used. */
+	uint32_t depth;
+} ring_buff_sink_attr_t;
+
+/**
+ * Sink statistics.
+ */
+typedef struct ring_buff_sink_stats
+{
+	/** Bytes drained from the ring buffer (file size, once sink is done). */
+	uint64_t bytes;
+	/** Bytes written straight from the ring buffer memory. */
+	uint64_t direct;
+	/** Bytes that had to be copied to a bounce buffer first. */
+	uint64_t copied;
+	/** Writes issued. */
+	uint64_t writes;
+} ring_buff_sink_stats_t;
+
+/**
+ * Creates sink that drains committed data of the ring buffer to the file opened for direct I/O
+ * (page cache is bypassed). Sink thread reads the ring buffer with "ring_buff_read", so ring buffer
+ * has to be in the stream mode, and nobody else may read it. Every chunk is freed once it is on the disk.
+ * Data is written straight from the ring buffer memory while it lies at the same block offset as in
+ * the file. That is the case when ring buffer memory and size are block aligned, and writers don't
+ * leave the end of the ring buffer unused when they wrap (e.g. record sizes divide the ring buffer
+ * size). Everything else is copied to block aligned bounce buffers.
+ * Sink writes the last partial block, and trims the file to the data size, once ring buffer is
+ * stopped ("ring_buff_stop") and all the data is drained.
+ * @param ring Ring buffer handle.
+ * @param attr Sink attribute object.
+ * @param handle Pointer to the handle. This argument must not be NULL.
+ * @return RING_BUFF_ERR_OK if everything was OK, RING_BUFF_ERR_PERM if file system does not
+ * support direct I/O, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_sink_create(ring_buff_handle_t ring, ring_buff_sink_attr_t *attr, ring_buff_sink_handle_t *handle);
+/**
+ * Sink destructor function. Ring buffer has to be stopped (or canceled) first, since function
+ * waits until sink writes out all the data.
+ * @param handle Sink handle.
+ * @return RING_BUFF_ERR_OK if all the data is written, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_sink_destroy(ring_buff_sink_handle_t handle);
+/**
+ * Returns sink statistics. It may be called while sink is running.
+ * @param handle Sink handle.
+ * @param stats Output argument that will contain sink statistics.
+ * @return RING_BUFF_ERR_OK if everything was OK, or error if there was some problem.
+ */
+ring_buff_err_t ring_buff_sink_get_stats(ring_buff_sink_handle_t handle, ring_buff_sink_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RING_BUFF_SINK_H_ */
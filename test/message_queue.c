@@ -29,10 +29,17 @@
  *
  ******************************************************************************/
 
+/* monotonic clock and condition variable clock selection */
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
 #include <pthread.h>
 
+#include "ring_buff.h"
 #include "message_queue.h"
 
 typedef struct msg_box
@@ -43,61 +50,213 @@ typedef struct msg_box
 	struct msg_box *next;
 } msg_box_t;
 
-typedef struct msg_queue_obj
+/* Each level has to have its bit in the "ready" bitmap */
+#define MSG_QUEUE_MAX_LEVELS 32
+
+typedef struct msg_level
 {
 	msg_box_t* first;
 	msg_box_t* last;
 	unsigned int count;
+} msg_level_t;
+
+/* Hierarchical timer wheel: 4 levels with 64 slots, one millisecond tick (~4.6 hours range) */
+#define MSG_WHEEL_BITS   6
+#define MSG_WHEEL_SLOTS  (1 << MSG_WHEEL_BITS)
+#define MSG_WHEEL_MASK   (MSG_WHEEL_SLOTS - 1)
+#define MSG_WHEEL_LEVELS 4
+#define MSG_WHEEL_RANGE(level) ((uint64_t)1 << (MSG_WHEEL_BITS * (level)))
+
+typedef struct msg_delayed
+{
+	/** Delayed message is delivered as regular one, so box has to be the first member */
+	msg_box_t box;
+	/** Delivery time (milliseconds) */
+	uint64_t expires;
+	unsigned int wheel_level;
+	msg_box_t **slot;
+	msg_queue_timer_t *timer;
+} msg_delayed_t;
+
+typedef struct msg_queue_obj
+{
+	msg_queue_type_t type;
+	/** Priority levels (level 0 has the highest priority) */
+	msg_level_t levels[MSG_QUEUE_MAX_LEVELS];
+	unsigned int level_count;
+	/** Bitmap of non-empty levels */
+	uint32_t ready;
+	/** Anti-starvation quota */
+	unsigned int quota;
+	/** Messages taken from higher levels while lower ones were waiting */
+	unsigned int burst;
+	/** The last level which got a message when the quota was used up (lower levels get it in turns) */
+	unsigned int grant;
+	/** Urgent messages at the front of the highest level, and the last of them (they are kept in FIFO order) */
+	unsigned int urgent;
+	msg_box_t* urgent_last;
+	unsigned int count;
+	/** Timer wheel slots (delayed messages) */
+	msg_box_t* wheel[MSG_WHEEL_LEVELS][MSG_WHEEL_SLOTS];
+	unsigned int wheel_count[MSG_WHEEL_LEVELS];
+	/** Bitmap of non-empty first level slots */
+	uint64_t wheel_busy;
+	/** The last processed wheel tick */
+	uint64_t wheel_now;
+	/** Number of delayed messages */
+	unsigned int timers;
 	pthread_cond_t cv;
 	pthread_mutex_t lock;
 } msg_queue_obj_t;
 
+/* Avoid false sharing between producer and consumer positions */
+#define MSG_QUEUE_CACHE_LINE 64
+
+typedef struct msg_cell
+{
+	/** Cell sequence number. Tells whether cell is free for position, or holds message for it. */
+	size_t seq;
+	void* data;
+	size_t size;
+} msg_cell_t;
+
+/* Bounded MPMC queue (based on Dmitry Vyukov's bounded MPMC queue algorithm) */
+typedef struct msg_bounded_queue_obj
+{
+	msg_queue_type_t type;
+	msg_cell_t* cells;
+	size_t mask;
+	char pad0[MSG_QUEUE_CACHE_LINE];
+	size_t put_pos;
+	char pad1[MSG_QUEUE_CACHE_LINE];
+	size_t get_pos;
+	char pad2[MSG_QUEUE_CACHE_LINE];
+	/** Number of consumers blocked on empty queue */
+	unsigned int get_waiters;
+	/** Number of producers blocked on full queue */
+	unsigned int put_waiters;
+	/** Number of them which wait for room for a batch (a single free cell may not be enough) */
+	unsigned int put_batch_waiters;
+	pthread_cond_t get_cv;
+	pthread_cond_t put_cv;
+	pthread_mutex_t lock;
+} msg_bounded_queue_obj_t;
+
+/* Copy-in queue. Message is stored in the ring buffer as header followed by the data. */
+typedef struct msg_copy_queue_obj
+{
+	msg_queue_type_t type;
+	ring_buff_handle_t ring;
+	/** Ring buffer expects single writer... */
+	pthread_mutex_t put_lock;
+	/** ...and single reader (header and data have to be read together) */
+	pthread_mutex_t get_lock;
+} msg_copy_queue_obj_t;
+
+typedef struct msg_copy_hdr
+{
+	size_t size;
+} msg_copy_hdr_t;
+
+/* Keep headers aligned */
+#define MSG_COPY_ALIGN(size) (((size) + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1))
+
 #define GET_MSG_QUEUE_OBJ(handle) ((msg_queue_obj_t*)handle)
+#define GET_MSG_BOUNDED_QUEUE_OBJ(handle) ((msg_bounded_queue_obj_t*)handle)
+#define GET_MSG_COPY_QUEUE_OBJ(handle) ((msg_copy_queue_obj_t*)handle)
+/* Every queue object starts with its type */
+#define GET_MSG_QUEUE_TYPE(handle) (*(msg_queue_type_t*)handle)
 
 static msg_box_t* msg_box_create(void* msg_data, size_t msg_size);
 static void msg_box_destroy(msg_box_t *box);
 
-msg_queue_err_t msg_queue_create(msg_queue_hndl *handle)
+static msg_queue_err_t msg_list_queue_create(unsigned int levels, unsigned int quota, msg_queue_hndl *handle);
+static void msg_list_queue_append(msg_queue_obj_t *obj, unsigned int level, msg_box_t *first, msg_box_t *last, unsigned int count);
+static unsigned int msg_list_queue_select(msg_queue_obj_t *obj, unsigned int max, unsigned int *run);
+static msg_box_t* msg_list_queue_take(msg_queue_obj_t *obj, unsigned int level, unsigned int count);
+static msg_queue_err_t msg_list_queue_wait(msg_queue_obj_t *obj, uint64_t deadline, int block);
+static msg_queue_err_t msg_list_queue_get(msg_queue_obj_t *obj, void** msg_data, size_t* msg_size, uint64_t deadline, int block);
+
+static uint64_t msg_queue_now(void);
+static void msg_wheel_insert(msg_queue_obj_t *obj, msg_delayed_t *delayed);
+static void msg_wheel_remove(msg_queue_obj_t *obj, msg_delayed_t *delayed);
+static void msg_wheel_deliver(msg_queue_obj_t *obj, msg_delayed_t *delayed);
+static void msg_wheel_advance(msg_queue_obj_t *obj, uint64_t now);
+static uint64_t msg_wheel_next(msg_queue_obj_t *obj);
+
+static msg_queue_err_t msg_bounded_queue_create(unsigned int capacity, msg_queue_hndl *handle);
+static msg_queue_err_t msg_bounded_queue_destroy(msg_bounded_queue_obj_t *obj);
+static int msg_bounded_queue_try_put(msg_bounded_queue_obj_t *obj, void* msg_data, size_t msg_size);
+static int msg_bounded_queue_try_get(msg_bounded_queue_obj_t *obj, void** msg_data, size_t* msg_size);
+static int msg_bounded_queue_try_put_batch(msg_bounded_queue_obj_t *obj, msg_queue_msg_t* msgs, unsigned int count);
+static msg_queue_err_t msg_bounded_queue_put(msg_bounded_queue_obj_t *obj, void* msg_data, size_t msg_size);
+static msg_queue_err_t msg_bounded_queue_get(msg_bounded_queue_obj_t *obj, void** msg_data, size_t* msg_size);
+static msg_queue_err_t msg_bounded_queue_put_batch(msg_bounded_queue_obj_t *obj, msg_queue_msg_t* msgs, unsigned int count);
+static msg_queue_err_t msg_bounded_queue_get_batch(msg_bounded_queue_obj_t *obj, msg_queue_msg_t* msgs, unsigned int max, unsigned int* count);
+
+static msg_queue_err_t msg_copy_queue_create(void* buff, unsigned int buff_size, msg_queue_hndl *handle);
+static msg_queue_err_t msg_copy_queue_destroy(msg_copy_queue_obj_t *obj);
+static msg_queue_err_t msg_copy_queue_put(msg_copy_queue_obj_t *obj, void* msg_data, size_t msg_size);
+static msg_queue_err_t msg_copy_queue_get(msg_copy_queue_obj_t *obj, void** msg_data, size_t* msg_size);
+static msg_queue_err_t msg_copy_queue_put_batch(msg_copy_queue_obj_t *obj, msg_queue_msg_t* msgs, unsigned int count);
+
+msg_queue_err_t msg_queue_create_with_attr(msg_queue_attr_t *attr, msg_queue_hndl *handle)
 {
-	msg_queue_obj_t *head = (msg_queue_obj_t*)malloc(sizeof(msg_queue_obj_t));
-	if(head == NULL)
+	if(attr == NULL)
 	{
-		*handle = NULL;
-		return MSG_QUEUE_ERR_NO_MEM;
+		return msg_queue_create(handle);
 	}
-	head->first = NULL;
-	head->last = NULL;
-	head->count = 0;
-	/* Init mutex */
-	if(pthread_mutex_init(&(head->lock), NULL))
+	if(attr->type == MSG_QUEUE_TYPE_LIST)
 	{
-		free(head);
-		return MSG_QUEUE_ERR_GENERAL;
+		return msg_list_queue_create(attr->levels, attr->quota, handle);
 	}
-	/* Init cond. variable */
-	if(pthread_cond_init(&(head->cv), NULL))
+	if(attr->type == MSG_QUEUE_TYPE_BOUNDED)
 	{
-		pthread_mutex_destroy(&(head->lock));
-		free(head);
-		return MSG_QUEUE_ERR_GENERAL;
+		return msg_bounded_queue_create(attr->capacity, handle);
 	}
+	if(attr->type == MSG_QUEUE_TYPE_COPY)
+	{
+		return msg_copy_queue_create(attr->buff, attr->buff_size, handle);
+	}
+	*handle = NULL;
+	return MSG_QUEUE_ERR_GENERAL;
+}
 
-	*handle = head;
-	return MSG_QUEUE_ERR_OK;
+msg_queue_err_t msg_queue_create(msg_queue_hndl *handle)
+{
+	return msg_list_queue_create(1, 0, handle);
 }
 
 msg_queue_err_t msg_queue_destroy(msg_queue_hndl handle)
 {
 	msg_queue_obj_t *obj = GET_MSG_QUEUE_OBJ(handle);
-	int i;
+	unsigned int level;
 	msg_box_t *box, *next;
 
+	if(GET_MSG_QUEUE_TYPE(handle) == MSG_QUEUE_TYPE_BOUNDED)
+	{
+		return msg_bounded_queue_destroy(GET_MSG_BOUNDED_QUEUE_OBJ(handle));
+	}
+	if(GET_MSG_QUEUE_TYPE(handle) == MSG_QUEUE_TYPE_COPY)
+	{
+		return msg_copy_queue_destroy(GET_MSG_COPY_QUEUE_OBJ(handle));
+	}
 	pthread_mutex_lock(&(obj->lock));
-	for(i=0, box=obj->first; i<obj->count; i++)
+	for(level=0; level<obj->level_count; level++)
 	{
-		next = box->next;
-		msg_box_destroy(box);
-		box = next;
+		for(box=obj->levels[level].first; box != NULL; box = next)
+		{
+			next = box->next;
+			msg_box_destroy(box);
+		}
+	}
+	for(level=0; level<MSG_WHEEL_LEVELS * MSG_WHEEL_SLOTS; level++)
+	{
+		for(box=obj->wheel[level / MSG_WHEEL_SLOTS][level % MSG_WHEEL_SLOTS]; box != NULL; box = next)
+		{
+			next = box->next;
+			msg_box_destroy(box);
+		}
 	}
 	pthread_mutex_unlock(&(obj->lock));
 	pthread_mutex_destroy(&(obj->lock));
@@ -110,25 +269,35 @@ msg_queue_err_t msg_queue_destroy(msg_queue_hndl handle)
 msg_queue_err_t msg_queue_put(msg_queue_hndl handle, void* msg_data, size_t msg_size)
 {
 	msg_queue_obj_t *obj = GET_MSG_QUEUE_OBJ(handle);
-	msg_box_t *box = msg_box_create(msg_data, msg_size);
 
-	if(box == NULL)
+	if(GET_MSG_QUEUE_TYPE(handle) == MSG_QUEUE_TYPE_BOUNDED)
 	{
-		return MSG_QUEUE_ERR_GENERAL;
+		return msg_bounded_queue_put(GET_MSG_BOUNDED_QUEUE_OBJ(handle), msg_data, msg_size);
 	}
-	pthread_mutex_lock(&(obj->lock));
-	box->previous = obj->last;
-	if(obj->last)
+	if(GET_MSG_QUEUE_TYPE(handle) == MSG_QUEUE_TYPE_COPY)
+	{
+		return msg_copy_queue_put(GET_MSG_COPY_QUEUE_OBJ(handle), msg_data, msg_size);
+	}
+
+	return msg_queue_put_prio(handle, msg_data, msg_size, obj->level_count - 1);
+}
+
+msg_queue_err_t msg_queue_put_prio(msg_queue_hndl handle, void* msg_data, size_t msg_size, unsigned int level)
+{
+	msg_queue_obj_t *obj = GET_MSG_QUEUE_OBJ(handle);
+	msg_box_t *box;
+
+	if(GET_MSG_QUEUE_TYPE(handle) != MSG_QUEUE_TYPE_LIST || level >= obj->level_count)
 	{
-		obj->last->next = box;
+		return MSG_QUEUE_ERR_GENERAL;
 	}
-	obj->last = box;
-	if(obj->count == 0)
+	box = msg_box_create(msg_data, msg_size);
+	if(box == NULL)
 	{
-		obj->first = box;
+		return MSG_QUEUE_ERR_GENERAL;
 	}
-
-	obj->count++;
+	pthread_mutex_lock(&(obj->lock));
+	msg_list_queue_append(obj, level, box, box, 1);
 	/* send signal that new message arrived, if someone is waiting for that */
 	pthread_cond_signal(&(obj->cv));
 	pthread_mutex_unlock(&(obj->lock));
@@ -139,15 +308,44 @@ msg_queue_err_t msg_queue_put(msg_queue_hndl handle, void* msg_data, size_t msg_
 msg_queue_err_t msg_queue_put_urgent(msg_queue_hndl handle, void* msg_data, size_t msg_size)
 {
 	msg_queue_obj_t *obj = GET_MSG_QUEUE_OBJ(handle);
-	msg_box_t *box = msg_box_create(msg_data, msg_size);
+	msg_level_t *lvl;
+	msg_box_t *box;
 
+	/* other queue types are strictly FIFO */
+	if(GET_MSG_QUEUE_TYPE(handle) != MSG_QUEUE_TYPE_LIST)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	box = msg_box_create(msg_data, msg_size);
 	if(box == NULL)
 	{
 		return MSG_QUEUE_ERR_GENERAL;
 	}
 	pthread_mutex_lock(&(obj->lock));
-	box->next = obj->first;
-	obj->first = box;
+	/* urgent message goes in front of the highest priority level, behind urgent messages that came before */
+	lvl = &(obj->levels[0]);
+	box->previous = obj->urgent_last;
+	box->next = obj->urgent_last ? obj->urgent_last->next : lvl->first;
+	if(box->next)
+	{
+		box->next->previous = box;
+	}
+	else
+	{
+		lvl->last = box;
+	}
+	if(obj->urgent_last)
+	{
+		obj->urgent_last->next = box;
+	}
+	else
+	{
+		lvl->first = box;
+	}
+	obj->urgent_last = box;
+	obj->urgent++;
+	lvl->count++;
+	obj->ready |= 1u;
 	obj->count++;
 	/* send signal that new message arrived, if someone is waiting for that */
 	pthread_cond_signal(&(obj->cv));
@@ -159,25 +357,621 @@ msg_queue_err_t msg_queue_put_urgent(msg_queue_hndl handle, void* msg_data, size
 msg_queue_err_t msg_queue_get(msg_queue_hndl handle, void** msg_data, size_t* msg_size)
 {
 	msg_queue_obj_t *obj = GET_MSG_QUEUE_OBJ(handle);
+
+	if(GET_MSG_QUEUE_TYPE(handle) == MSG_QUEUE_TYPE_BOUNDED)
+	{
+		return msg_bounded_queue_get(GET_MSG_BOUNDED_QUEUE_OBJ(handle), msg_data, msg_size);
+	}
+	if(GET_MSG_QUEUE_TYPE(handle) == MSG_QUEUE_TYPE_COPY)
+	{
+		return msg_copy_queue_get(GET_MSG_COPY_QUEUE_OBJ(handle), msg_data, msg_size);
+	}
+
+	return msg_list_queue_get(obj, msg_data, msg_size, 0, 1);
+}
+
+msg_queue_err_t msg_queue_get_timed(msg_queue_hndl handle, void** msg_data, size_t* msg_size, unsigned long timeout_us)
+{
+	msg_queue_obj_t *obj = GET_MSG_QUEUE_OBJ(handle);
+
+	if(GET_MSG_QUEUE_TYPE(handle) != MSG_QUEUE_TYPE_LIST)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+
+	return msg_list_queue_get(obj, msg_data, msg_size, msg_queue_now() + (timeout_us + 999) / 1000, 1);
+}
+
+msg_queue_err_t msg_queue_try_get(msg_queue_hndl handle, void** msg_data, size_t* msg_size)
+{
+	msg_queue_obj_t *obj = GET_MSG_QUEUE_OBJ(handle);
+
+	if(GET_MSG_QUEUE_TYPE(handle) != MSG_QUEUE_TYPE_LIST)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+
+	return msg_list_queue_get(obj, msg_data, msg_size, 0, 0);
+}
+
+msg_queue_err_t msg_queue_put_at(msg_queue_hndl handle, void* msg_data, size_t msg_size, const struct timespec *deadline, msg_queue_timer_t *timer)
+{
+	msg_queue_obj_t *obj = GET_MSG_QUEUE_OBJ(handle);
+	msg_delayed_t *delayed;
+
+	if(GET_MSG_QUEUE_TYPE(handle) != MSG_QUEUE_TYPE_LIST || deadline == NULL)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	delayed = (msg_delayed_t*)malloc(sizeof(msg_delayed_t));
+	if(delayed == NULL)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	delayed->box.data = msg_data;
+	delayed->box.size = msg_size;
+	delayed->box.previous = NULL;
+	delayed->box.next = NULL;
+	/* never deliver before the deadline */
+	delayed->expires = (uint64_t)deadline->tv_sec * 1000 + (deadline->tv_nsec + 999999) / 1000000;
+	delayed->timer = timer;
+	if(timer)
+	{
+		timer->pending = delayed;
+	}
+	pthread_mutex_lock(&(obj->lock));
+	msg_wheel_advance(obj, msg_queue_now());
+	msg_wheel_insert(obj, delayed);
+	/* waiting consumers have to reconsider when to wake up */
+	pthread_cond_broadcast(&(obj->cv));
+	pthread_mutex_unlock(&(obj->lock));
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+msg_queue_err_t msg_queue_put_after(msg_queue_hndl handle, void* msg_data, size_t msg_size, unsigned long delay_us, msg_queue_timer_t *timer)
+{
+	struct timespec deadline;
+
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += delay_us / 1000000;
+	deadline.tv_nsec += (delay_us % 1000000) * 1000;
+	if(deadline.tv_nsec >= 1000000000)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	return msg_queue_put_at(handle, msg_data, msg_size, &deadline, timer);
+}
+
+msg_queue_err_t msg_queue_cancel(msg_queue_hndl handle, msg_queue_timer_t *timer, void** msg_data, size_t* msg_size)
+{
+	msg_queue_obj_t *obj = GET_MSG_QUEUE_OBJ(handle);
+	msg_delayed_t *delayed;
+
+	if(GET_MSG_QUEUE_TYPE(handle) != MSG_QUEUE_TYPE_LIST || timer == NULL)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	pthread_mutex_lock(&(obj->lock));
+	delayed = (msg_delayed_t*)timer->pending;
+	if(delayed == NULL)
+	{
+		/* already delivered (or canceled) */
+		pthread_mutex_unlock(&(obj->lock));
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	msg_wheel_remove(obj, delayed);
+	timer->pending = NULL;
+	pthread_mutex_unlock(&(obj->lock));
+	if(msg_data)
+	{
+		*msg_data = delayed->box.data;
+	}
+	if(msg_size)
+	{
+		*msg_size = delayed->box.size;
+	}
+	msg_box_destroy(&(delayed->box));
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+msg_queue_err_t msg_queue_put_batch(msg_queue_hndl handle, msg_queue_msg_t* msgs, unsigned int count)
+{
+	msg_queue_obj_t *obj = GET_MSG_QUEUE_OBJ(handle);
+	msg_box_t *first = NULL, *last = NULL, *box;
+	unsigned int i;
+
+	if(msgs == NULL || count == 0)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	if(GET_MSG_QUEUE_TYPE(handle) == MSG_QUEUE_TYPE_BOUNDED)
+	{
+		return msg_bounded_queue_put_batch(GET_MSG_BOUNDED_QUEUE_OBJ(handle), msgs, count);
+	}
+	if(GET_MSG_QUEUE_TYPE(handle) == MSG_QUEUE_TYPE_COPY)
+	{
+		return msg_copy_queue_put_batch(GET_MSG_COPY_QUEUE_OBJ(handle), msgs, count);
+	}
+	/* build the chain out of the queue lock */
+	for(i=0; i<count; i++)
+	{
+		box = msg_box_create(msgs[i].data, msgs[i].size);
+		if(box == NULL)
+		{
+			while(first != NULL)
+			{
+				box = first->next;
+				msg_box_destroy(first);
+				first = box;
+			}
+			return MSG_QUEUE_ERR_GENERAL;
+		}
+		box->previous = last;
+		if(last)
+		{
+			last->next = box;
+		}
+		else
+		{
+			first = box;
+		}
+		last = box;
+	}
+	pthread_mutex_lock(&(obj->lock));
+	msg_list_queue_append(obj, obj->level_count - 1, first, last, count);
+	/* more than one consumer may be served */
+	if(count > 1)
+	{
+		pthread_cond_broadcast(&(obj->cv));
+	}
+	else
+	{
+		pthread_cond_signal(&(obj->cv));
+	}
+	pthread_mutex_unlock(&(obj->lock));
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+msg_queue_err_t msg_queue_get_batch(msg_queue_hndl handle, msg_queue_msg_t* msgs, unsigned int max, unsigned int* count)
+{
+	msg_queue_obj_t *obj = GET_MSG_QUEUE_OBJ(handle);
+	msg_box_t *first = NULL, *last = NULL, *box, *next;
+	unsigned int i, level, taken = 0, n;
+
+	if(msgs == NULL || max == 0 || count == NULL)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	if(GET_MSG_QUEUE_TYPE(handle) == MSG_QUEUE_TYPE_BOUNDED)
+	{
+		return msg_bounded_queue_get_batch(GET_MSG_BOUNDED_QUEUE_OBJ(handle), msgs, max, count);
+	}
+	if(GET_MSG_QUEUE_TYPE(handle) == MSG_QUEUE_TYPE_COPY)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	pthread_mutex_lock(&(obj->lock));
+	msg_list_queue_wait(obj, 0, 1);
+	/* levels are served as for single messages, just in runs */
+	while(taken < max && obj->ready != 0)
+	{
+		level = msg_list_queue_select(obj, max - taken, &n);
+		box = msg_list_queue_take(obj, level, n);
+		if(last)
+		{
+			last->next = box;
+		}
+		else
+		{
+			first = box;
+		}
+		for(i=0, last=box; i<n-1; i++)
+		{
+			last = last->next;
+		}
+		taken += n;
+	}
+	pthread_mutex_unlock(&(obj->lock));
+	/* boxes are out of the queue, so they can be released without the lock */
+	for(i=0, box=first; i<taken; i++)
+	{
+		next = box->next;
+		msgs[i].data = box->data;
+		msgs[i].size = box->size;
+		msg_box_destroy(box);
+		box = next;
+	}
+	*count = taken;
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+msg_queue_err_t msg_queue_release(msg_queue_hndl handle, void* msg_data, size_t msg_size)
+{
+	msg_copy_queue_obj_t *obj = GET_MSG_COPY_QUEUE_OBJ(handle);
+	msg_copy_hdr_t *hdr = (msg_copy_hdr_t*)msg_data - 1;
+
+	if(GET_MSG_QUEUE_TYPE(handle) != MSG_QUEUE_TYPE_COPY || msg_data == NULL)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	if(ring_buff_free(obj->ring, hdr, sizeof(msg_copy_hdr_t) + MSG_COPY_ALIGN(msg_size)) != RING_BUFF_ERR_OK)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+static msg_queue_err_t msg_list_queue_create(unsigned int levels, unsigned int quota, msg_queue_hndl *handle)
+{
+	msg_queue_obj_t *head;
+	pthread_condattr_t cv_attr;
+
+	if(levels == 0)
+	{
+		levels = 1;
+	}
+	if(levels > MSG_QUEUE_MAX_LEVELS)
+	{
+		*handle = NULL;
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	head = (msg_queue_obj_t*)malloc(sizeof(msg_queue_obj_t));
+	if(head == NULL)
+	{
+		*handle = NULL;
+		return MSG_QUEUE_ERR_NO_MEM;
+	}
+	memset(head, 0, sizeof(msg_queue_obj_t));
+	head->type = MSG_QUEUE_TYPE_LIST;
+	head->level_count = levels;
+	head->quota = quota;
+	/* Init mutex */
+	if(pthread_mutex_init(&(head->lock), NULL))
+	{
+		free(head);
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	/* Init cond. variable (timed waits are done against the monotonic clock) */
+	pthread_condattr_init(&cv_attr);
+	pthread_condattr_setclock(&cv_attr, CLOCK_MONOTONIC);
+	if(pthread_cond_init(&(head->cv), &cv_attr))
+	{
+		pthread_condattr_destroy(&cv_attr);
+		pthread_mutex_destroy(&(head->lock));
+		free(head);
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	pthread_condattr_destroy(&cv_attr);
+	head->wheel_now = msg_queue_now();
+
+	*handle = head;
+	return MSG_QUEUE_ERR_OK;
+}
+
+static void msg_list_queue_append(msg_queue_obj_t *obj, unsigned int level, msg_box_t *first, msg_box_t *last, unsigned int count)
+{
+	msg_level_t *lvl = &(obj->levels[level]);
+
+	first->previous = lvl->last;
+	if(lvl->last)
+	{
+		lvl->last->next = first;
+	}
+	else
+	{
+		lvl->first = first;
+	}
+	lvl->last = last;
+	lvl->count += count;
+	obj->ready |= (1u << level);
+	obj->count += count;
+}
+
+static unsigned int msg_list_queue_select(msg_queue_obj_t *obj, unsigned int max, unsigned int *run)
+{
+	unsigned int level = __builtin_ctz(obj->ready);
+	unsigned int lower, next;
+
+	*run = (obj->levels[level].count < max) ? obj->levels[level].count : max;
+	if(obj->quota == 0)
+	{
+		return level;
+	}
+	/* levels with lower priority which have messages waiting */
+	lower = obj->ready & ~((2u << level) - 1);
+	if(lower == 0)
+	{
+		obj->burst = 0;
+	}
+	else if(obj->burst >= obj->quota)
+	{
+		/* quota used up, one message goes to the waiting level which is next in turn after the last one granted */
+		obj->burst = 0;
+		next = lower & ~((2u << obj->grant) - 1);
+		level = __builtin_ctz(next ? next : lower);
+		obj->grant = level;
+		*run = 1;
+	}
+	else
+	{
+		if(*run > obj->quota - obj->burst)
+		{
+			*run = obj->quota - obj->burst;
+		}
+		obj->burst += *run;
+	}
+
+	return level;
+}
+
+static msg_box_t* msg_list_queue_take(msg_queue_obj_t *obj, unsigned int level, unsigned int count)
+{
+	msg_level_t *lvl = &(obj->levels[level]);
+	msg_box_t *first = lvl->first, *next;
+	unsigned int i;
+
+	if(count == lvl->count)
+	{
+		lvl->first = NULL;
+		lvl->last = NULL;
+		obj->ready &= ~(1u << level);
+	}
+	else
+	{
+		for(i=0, next=first; i<count; i++)
+		{
+			next = next->next;
+		}
+		next->previous = NULL;
+		lvl->first = next;
+	}
+	lvl->count -= count;
+	obj->count -= count;
+	if(level == 0 && obj->urgent)
+	{
+		obj->urgent = (count < obj->urgent) ? obj->urgent - count : 0;
+		if(obj->urgent == 0)
+		{
+			obj->urgent_last = NULL;
+		}
+	}
+
+	return first;
+}
+
+static msg_queue_err_t msg_list_queue_wait(msg_queue_obj_t *obj, uint64_t deadline, int block)
+{
+	uint64_t now, wake;
+	struct timespec ts;
+
+	while(1)
+	{
+		now = msg_queue_now();
+		msg_wheel_advance(obj, now);
+		if(obj->count != 0)
+		{
+			return MSG_QUEUE_ERR_OK;
+		}
+		if(!block)
+		{
+			return MSG_QUEUE_ERR_EMPTY;
+		}
+		if(deadline != 0 && now >= deadline)
+		{
+			return MSG_QUEUE_ERR_TIMEOUT;
+		}
+		/* wake up when the first delayed message is due, or when the caller gives up */
+		wake = (obj->timers != 0) ? msg_wheel_next(obj) : 0;
+		if(deadline != 0 && (wake == 0 || deadline < wake))
+		{
+			wake = deadline;
+		}
+		if(wake == 0)
+		{
+			pthread_cond_wait(&(obj->cv), &(obj->lock));
+		}
+		else
+		{
+			ts.tv_sec = wake / 1000;
+			ts.tv_nsec = (wake % 1000) * 1000000;
+			pthread_cond_timedwait(&(obj->cv), &(obj->lock), &ts);
+		}
+	}
+}
+
+static msg_queue_err_t msg_list_queue_get(msg_queue_obj_t *obj, void** msg_data, size_t* msg_size, uint64_t deadline, int block)
+{
 	msg_box_t *box;
+	msg_queue_err_t err;
+	unsigned int run;
 
 	pthread_mutex_lock(&(obj->lock));
-	if(obj->count == 0)
+	err = msg_list_queue_wait(obj, deadline, block);
+	if(err != MSG_QUEUE_ERR_OK)
 	{
-		pthread_cond_wait(&(obj->cv), &(obj->lock));
+		pthread_mutex_unlock(&(obj->lock));
+		return err;
 	}
-	box = obj->first;
-	obj->first = box->next;
+	box = msg_list_queue_take(obj, msg_list_queue_select(obj, 1, &run), 1);
+	pthread_mutex_unlock(&(obj->lock));
 	*msg_data = box->data;
 	*msg_size = box->size;
 	msg_box_destroy(box);
-	obj->count--;
-	if(obj->count == 0)
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+/* ############### Timer wheel implementation ################ */
+
+static uint64_t msg_queue_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void msg_wheel_insert(msg_queue_obj_t *obj, msg_delayed_t *delayed)
+{
+	uint64_t expires = delayed->expires;
+	unsigned int level;
+
+	if(expires <= obj->wheel_now)
 	{
-		obj->last = NULL;
+		msg_wheel_deliver(obj, delayed);
+		return;
 	}
-	pthread_mutex_unlock(&(obj->lock));
-	return MSG_QUEUE_ERR_OK;
+	/* the level is chosen so that its slot is reached within one wheel rotation */
+	for(level=0; level<MSG_WHEEL_LEVELS-1; level++)
+	{
+		if(expires - obj->wheel_now < MSG_WHEEL_RANGE(level + 1))
+		{
+			break;
+		}
+	}
+	/* beyond the wheel range: park at the furthest slot, it will be cascaded back */
+	if(expires - obj->wheel_now >= MSG_WHEEL_RANGE(MSG_WHEEL_LEVELS))
+	{
+		expires = obj->wheel_now + MSG_WHEEL_RANGE(MSG_WHEEL_LEVELS) - 1;
+	}
+	delayed->wheel_level = level;
+	delayed->slot = &(obj->wheel[level][(expires >> (MSG_WHEEL_BITS * level)) & MSG_WHEEL_MASK]);
+	delayed->box.previous = NULL;
+	delayed->box.next = *(delayed->slot);
+	if(delayed->box.next)
+	{
+		delayed->box.next->previous = &(delayed->box);
+	}
+	*(delayed->slot) = &(delayed->box);
+	if(level == 0)
+	{
+		obj->wheel_busy |= (uint64_t)1 << (delayed->slot - obj->wheel[0]);
+	}
+	obj->wheel_count[level]++;
+	obj->timers++;
+}
+
+static void msg_wheel_remove(msg_queue_obj_t *obj, msg_delayed_t *delayed)
+{
+	if(delayed->box.previous)
+	{
+		delayed->box.previous->next = delayed->box.next;
+	}
+	else
+	{
+		*(delayed->slot) = delayed->box.next;
+	}
+	if(delayed->box.next)
+	{
+		delayed->box.next->previous = delayed->box.previous;
+	}
+	if(delayed->wheel_level == 0 && *(delayed->slot) == NULL)
+	{
+		obj->wheel_busy &= ~((uint64_t)1 << (delayed->slot - obj->wheel[0]));
+	}
+	delayed->box.previous = NULL;
+	delayed->box.next = NULL;
+	obj->wheel_count[delayed->wheel_level]--;
+	obj->timers--;
+}
+
+static void msg_wheel_deliver(msg_queue_obj_t *obj, msg_delayed_t *delayed)
+{
+	if(delayed->timer)
+	{
+		delayed->timer->pending = NULL;
+	}
+	delayed->box.previous = NULL;
+	delayed->box.next = NULL;
+	msg_list_queue_append(obj, obj->level_count - 1, &(delayed->box), &(delayed->box), 1);
+}
+
+static void msg_wheel_advance(msg_queue_obj_t *obj, uint64_t now)
+{
+	msg_box_t *box, *next;
+	unsigned int level;
+	uint64_t tick;
+
+	while(obj->wheel_now < now)
+	{
+		if(obj->timers == 0)
+		{
+			obj->wheel_now = now;
+			break;
+		}
+		/* jump right to the next tick with something to do, idle ticks in between are skipped */
+		tick = msg_wheel_next(obj);
+		if(tick > now)
+		{
+			obj->wheel_now = now;
+			break;
+		}
+		obj->wheel_now = tick;
+		/* move messages from the higher levels whose slot period has just started */
+		for(level=1; level<MSG_WHEEL_LEVELS; level++)
+		{
+			if(obj->wheel_now & (MSG_WHEEL_RANGE(level) - 1))
+			{
+				break;
+			}
+			box = obj->wheel[level][(obj->wheel_now >> (MSG_WHEEL_BITS * level)) & MSG_WHEEL_MASK];
+			while(box != NULL)
+			{
+				next = box->next;
+				msg_wheel_remove(obj, (msg_delayed_t*)box);
+				msg_wheel_insert(obj, (msg_delayed_t*)box);
+				box = next;
+			}
+		}
+		/* deliver messages which are due */
+		box = obj->wheel[0][obj->wheel_now & MSG_WHEEL_MASK];
+		while(box != NULL)
+		{
+			next = box->next;
+			msg_wheel_remove(obj, (msg_delayed_t*)box);
+			msg_wheel_deliver(obj, (msg_delayed_t*)box);
+			box = next;
+		}
+	}
+}
+
+static uint64_t msg_wheel_next(msg_queue_obj_t *obj)
+{
+	uint64_t tick = 0, busy;
+	unsigned int shift, level;
+
+	/* first level slots map to exact ticks, look for the first busy one after the current tick */
+	if(obj->wheel_busy != 0)
+	{
+		shift = (unsigned int)((obj->wheel_now + 1) & MSG_WHEEL_MASK);
+		busy = obj->wheel_busy >> shift;
+		if(shift != 0)
+		{
+			busy |= obj->wheel_busy << (MSG_WHEEL_SLOTS - shift);
+		}
+		tick = obj->wheel_now + 1 + __builtin_ctzll(busy);
+	}
+	/* higher levels may hold earlier messages, they are known only after cascading at the next period */
+	for(level=1; level<MSG_WHEEL_LEVELS; level++)
+	{
+		if(obj->wheel_count[level] != 0)
+		{
+			if(tick == 0 || tick > (obj->wheel_now | MSG_WHEEL_MASK) + 1)
+			{
+				tick = (obj->wheel_now | MSG_WHEEL_MASK) + 1;
+			}
+			break;
+		}
+	}
+
+	return tick;
 }
 
 static msg_box_t* msg_box_create(void* msg_data, size_t msg_size)
@@ -199,3 +993,475 @@ static void msg_box_destroy(msg_box_t *box)
 {
 	free(box);
 }
+
+/* ############### Bounded MPMC queue implementation ################ */
+
+static msg_queue_err_t msg_bounded_queue_create(unsigned int capacity, msg_queue_hndl *handle)
+{
+	msg_bounded_queue_obj_t *obj;
+	size_t size = 2, i;
+
+	*handle = NULL;
+	if(capacity == 0)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	while(size < capacity)
+	{
+		size <<= 1;
+	}
+	obj = (msg_bounded_queue_obj_t*)malloc(sizeof(msg_bounded_queue_obj_t));
+	if(obj == NULL)
+	{
+		return MSG_QUEUE_ERR_NO_MEM;
+	}
+	obj->cells = (msg_cell_t*)malloc(size * sizeof(msg_cell_t));
+	if(obj->cells == NULL)
+	{
+		free(obj);
+		return MSG_QUEUE_ERR_NO_MEM;
+	}
+	/* cell is free for position equal to its sequence number */
+	for(i=0; i<size; i++)
+	{
+		obj->cells[i].seq = i;
+	}
+	obj->type = MSG_QUEUE_TYPE_BOUNDED;
+	obj->mask = size - 1;
+	obj->put_pos = 0;
+	obj->get_pos = 0;
+	obj->get_waiters = 0;
+	obj->put_waiters = 0;
+	obj->put_batch_waiters = 0;
+	if(pthread_mutex_init(&(obj->lock), NULL))
+	{
+		free(obj->cells);
+		free(obj);
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	if(pthread_cond_init(&(obj->get_cv), NULL))
+	{
+		pthread_mutex_destroy(&(obj->lock));
+		free(obj->cells);
+		free(obj);
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	if(pthread_cond_init(&(obj->put_cv), NULL))
+	{
+		pthread_cond_destroy(&(obj->get_cv));
+		pthread_mutex_destroy(&(obj->lock));
+		free(obj->cells);
+		free(obj);
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+
+	*handle = obj;
+	return MSG_QUEUE_ERR_OK;
+}
+
+static msg_queue_err_t msg_bounded_queue_destroy(msg_bounded_queue_obj_t *obj)
+{
+	pthread_mutex_destroy(&(obj->lock));
+	pthread_cond_destroy(&(obj->get_cv));
+	pthread_cond_destroy(&(obj->put_cv));
+	free(obj->cells);
+	free(obj);
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+static int msg_bounded_queue_try_put(msg_bounded_queue_obj_t *obj, void* msg_data, size_t msg_size)
+{
+	msg_cell_t *cell;
+	size_t pos = __atomic_load_n(&(obj->put_pos), __ATOMIC_RELAXED);
+	size_t seq;
+	long dif;
+
+	while(1)
+	{
+		cell = &(obj->cells[pos & obj->mask]);
+		seq = __atomic_load_n(&(cell->seq), __ATOMIC_ACQUIRE);
+		dif = (long)seq - (long)pos;
+		if(dif == 0)
+		{
+			/* cell is free, try to claim position (pos is updated on failure) */
+			if(__atomic_compare_exchange_n(&(obj->put_pos), &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				break;
+			}
+		}
+		else if(dif < 0)
+		{
+			/* cell still holds message from the previous lap - queue is full */
+			return 0;
+		}
+		else
+		{
+			pos = __atomic_load_n(&(obj->put_pos), __ATOMIC_RELAXED);
+		}
+	}
+	cell->data = msg_data;
+	cell->size = msg_size;
+	/* publish message to the consumer of this position */
+	__atomic_store_n(&(cell->seq), pos + 1, __ATOMIC_RELEASE);
+
+	return 1;
+}
+
+static int msg_bounded_queue_try_get(msg_bounded_queue_obj_t *obj, void** msg_data, size_t* msg_size)
+{
+	msg_cell_t *cell;
+	size_t pos = __atomic_load_n(&(obj->get_pos), __ATOMIC_RELAXED);
+	size_t seq;
+	long dif;
+
+	while(1)
+	{
+		cell = &(obj->cells[pos & obj->mask]);
+		seq = __atomic_load_n(&(cell->seq), __ATOMIC_ACQUIRE);
+		dif = (long)seq - (long)(pos + 1);
+		if(dif == 0)
+		{
+			if(__atomic_compare_exchange_n(&(obj->get_pos), &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				break;
+			}
+		}
+		else if(dif < 0)
+		{
+			/* message for this position is not there yet - queue is empty */
+			return 0;
+		}
+		else
+		{
+			pos = __atomic_load_n(&(obj->get_pos), __ATOMIC_RELAXED);
+		}
+	}
+	*msg_data = cell->data;
+	*msg_size = cell->size;
+	/* free the cell for the producer of the next lap */
+	__atomic_store_n(&(cell->seq), pos + obj->mask + 1, __ATOMIC_RELEASE);
+
+	return 1;
+}
+
+static int msg_bounded_queue_try_put_batch(msg_bounded_queue_obj_t *obj, msg_queue_msg_t* msgs, unsigned int count)
+{
+	msg_cell_t *cell;
+	size_t pos = __atomic_load_n(&(obj->put_pos), __ATOMIC_RELAXED);
+	size_t seq;
+	long dif = 0;
+	unsigned int i;
+
+	while(1)
+	{
+		/* all cells have to be free for their positions, before they are claimed at once */
+		for(i=0; i<count; i++)
+		{
+			cell = &(obj->cells[(pos + i) & obj->mask]);
+			seq = __atomic_load_n(&(cell->seq), __ATOMIC_ACQUIRE);
+			dif = (long)seq - (long)(pos + i);
+			if(dif != 0)
+			{
+				break;
+			}
+		}
+		if(i == count)
+		{
+			/* free cells are changed only by their producer, so they stay free (pos is updated on failure) */
+			if(__atomic_compare_exchange_n(&(obj->put_pos), &pos, pos + count, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				break;
+			}
+		}
+		else if(dif < 0)
+		{
+			/* not enough room for the whole batch */
+			return 0;
+		}
+		else
+		{
+			pos = __atomic_load_n(&(obj->put_pos), __ATOMIC_RELAXED);
+		}
+	}
+	for(i=0; i<count; i++)
+	{
+		cell = &(obj->cells[(pos + i) & obj->mask]);
+		cell->data = msgs[i].data;
+		cell->size = msgs[i].size;
+		__atomic_store_n(&(cell->seq), pos + i + 1, __ATOMIC_RELEASE);
+	}
+
+	return 1;
+}
+
+/*
+ * Blocking is layered on top of lock-free operations. Waiter registers itself (under the lock)
+ * before the last try, and the other side looks at the waiter count after its operation is
+ * published. Full barriers on both sides guarantee that at least one of them sees the other,
+ * so the lock and the signal are used only when someone really waits.
+ */
+
+static msg_queue_err_t msg_bounded_queue_put(msg_bounded_queue_obj_t *obj, void* msg_data, size_t msg_size)
+{
+	while(!msg_bounded_queue_try_put(obj, msg_data, msg_size))
+	{
+		pthread_mutex_lock(&(obj->lock));
+		__atomic_add_fetch(&(obj->put_waiters), 1, __ATOMIC_SEQ_CST);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if(msg_bounded_queue_try_put(obj, msg_data, msg_size))
+		{
+			__atomic_sub_fetch(&(obj->put_waiters), 1, __ATOMIC_SEQ_CST);
+			pthread_mutex_unlock(&(obj->lock));
+			break;
+		}
+		pthread_cond_wait(&(obj->put_cv), &(obj->lock));
+		__atomic_sub_fetch(&(obj->put_waiters), 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&(obj->lock));
+	}
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&(obj->get_waiters), __ATOMIC_RELAXED))
+	{
+		pthread_mutex_lock(&(obj->lock));
+		pthread_cond_signal(&(obj->get_cv));
+		pthread_mutex_unlock(&(obj->lock));
+	}
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+static msg_queue_err_t msg_bounded_queue_get(msg_bounded_queue_obj_t *obj, void** msg_data, size_t* msg_size)
+{
+	while(!msg_bounded_queue_try_get(obj, msg_data, msg_size))
+	{
+		pthread_mutex_lock(&(obj->lock));
+		__atomic_add_fetch(&(obj->get_waiters), 1, __ATOMIC_SEQ_CST);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if(msg_bounded_queue_try_get(obj, msg_data, msg_size))
+		{
+			__atomic_sub_fetch(&(obj->get_waiters), 1, __ATOMIC_SEQ_CST);
+			pthread_mutex_unlock(&(obj->lock));
+			break;
+		}
+		pthread_cond_wait(&(obj->get_cv), &(obj->lock));
+		__atomic_sub_fetch(&(obj->get_waiters), 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&(obj->lock));
+	}
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&(obj->put_waiters), __ATOMIC_RELAXED))
+	{
+		pthread_mutex_lock(&(obj->lock));
+		/* batch producer may not fit into the freed cell, so it must not take the only wake up */
+		if(obj->put_batch_waiters)
+		{
+			pthread_cond_broadcast(&(obj->put_cv));
+		}
+		else
+		{
+			pthread_cond_signal(&(obj->put_cv));
+		}
+		pthread_mutex_unlock(&(obj->lock));
+	}
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+static msg_queue_err_t msg_bounded_queue_put_batch(msg_bounded_queue_obj_t *obj, msg_queue_msg_t* msgs, unsigned int count)
+{
+	/* batch would never fit */
+	if(count > obj->mask + 1)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	while(!msg_bounded_queue_try_put_batch(obj, msgs, count))
+	{
+		pthread_mutex_lock(&(obj->lock));
+		__atomic_add_fetch(&(obj->put_waiters), 1, __ATOMIC_SEQ_CST);
+		obj->put_batch_waiters++;
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if(msg_bounded_queue_try_put_batch(obj, msgs, count))
+		{
+			obj->put_batch_waiters--;
+			__atomic_sub_fetch(&(obj->put_waiters), 1, __ATOMIC_SEQ_CST);
+			pthread_mutex_unlock(&(obj->lock));
+			break;
+		}
+		pthread_cond_wait(&(obj->put_cv), &(obj->lock));
+		obj->put_batch_waiters--;
+		__atomic_sub_fetch(&(obj->put_waiters), 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&(obj->lock));
+	}
+	/* consumers are signaled once, and only if they wait */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&(obj->get_waiters), __ATOMIC_RELAXED))
+	{
+		pthread_mutex_lock(&(obj->lock));
+		if(count > 1)
+		{
+			pthread_cond_broadcast(&(obj->get_cv));
+		}
+		else
+		{
+			pthread_cond_signal(&(obj->get_cv));
+		}
+		pthread_mutex_unlock(&(obj->lock));
+	}
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+static msg_queue_err_t msg_bounded_queue_get_batch(msg_bounded_queue_obj_t *obj, msg_queue_msg_t* msgs, unsigned int max, unsigned int* count)
+{
+	unsigned int taken = 1;
+
+	msg_bounded_queue_get(obj, &(msgs[0].data), &(msgs[0].size));
+	while(taken < max && msg_bounded_queue_try_get(obj, &(msgs[taken].data), &(msgs[taken].size)))
+	{
+		taken++;
+	}
+	if(taken > 1)
+	{
+		/* let blocked producers know about the freed cells */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if(__atomic_load_n(&(obj->put_waiters), __ATOMIC_RELAXED))
+		{
+			pthread_mutex_lock(&(obj->lock));
+			pthread_cond_broadcast(&(obj->put_cv));
+			pthread_mutex_unlock(&(obj->lock));
+		}
+	}
+	*count = taken;
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+/* ############### Copy-in queue implementation ################ */
+
+static msg_queue_err_t msg_copy_queue_create(void* buff, unsigned int buff_size, msg_queue_hndl *handle)
+{
+	msg_copy_queue_obj_t *obj;
+	ring_buff_attr_t attr;
+
+	*handle = NULL;
+	if(buff == NULL || buff_size < sizeof(msg_copy_hdr_t))
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	obj = (msg_copy_queue_obj_t*)malloc(sizeof(msg_copy_queue_obj_t));
+	if(obj == NULL)
+	{
+		return MSG_QUEUE_ERR_NO_MEM;
+	}
+	memset(&attr, 0, sizeof(ring_buff_attr_t));
+	attr.buff = buff;
+	attr.size = buff_size;
+	if(ring_buff_create(&attr, &(obj->ring)) != RING_BUFF_ERR_OK)
+	{
+		free(obj);
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	if(pthread_mutex_init(&(obj->put_lock), NULL))
+	{
+		ring_buff_destroy(obj->ring);
+		free(obj);
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	if(pthread_mutex_init(&(obj->get_lock), NULL))
+	{
+		pthread_mutex_destroy(&(obj->put_lock));
+		ring_buff_destroy(obj->ring);
+		free(obj);
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	obj->type = MSG_QUEUE_TYPE_COPY;
+
+	*handle = obj;
+	return MSG_QUEUE_ERR_OK;
+}
+
+static msg_queue_err_t msg_copy_queue_destroy(msg_copy_queue_obj_t *obj)
+{
+	ring_buff_destroy(obj->ring);
+	pthread_mutex_destroy(&(obj->put_lock));
+	pthread_mutex_destroy(&(obj->get_lock));
+	free(obj);
+
+	return MSG_QUEUE_ERR_OK;
+}
+
+static msg_queue_err_t msg_copy_queue_put(msg_copy_queue_obj_t *obj, void* msg_data, size_t msg_size)
+{
+	msg_copy_hdr_t *hdr;
+	size_t size = sizeof(msg_copy_hdr_t) + MSG_COPY_ALIGN(msg_size);
+	ring_buff_err_t err;
+
+	/* reservation size must not be truncated (or wrapped), message would not fit in it */
+	if(size < msg_size || size > UINT32_MAX)
+	{
+		return MSG_QUEUE_ERR_GENERAL;
+	}
+	/* header and data are reserved as one chunk, so they never get split by the wrap */
+	pthread_mutex_lock(&(obj->put_lock));
+	err = ring_buff_reserve(obj->ring, (void**)&hdr, (uint32_t)size);
+	if(err == RING_BUFF_ERR_OK)
+	{
+		hdr->size = msg_size;
+		memcpy(hdr + 1, msg_data, msg_size);
+		err = ring_buff_commit(obj->ring, hdr, (uint32_t)size);
+	}
+	pthread_mutex_unlock(&(obj->put_lock));
+
+	return (err == RING_BUFF_ERR_OK) ? MSG_QUEUE_ERR_OK : MSG_QUEUE_ERR_GENERAL;
+}
+
+static msg_queue_err_t msg_copy_queue_put_batch(msg_copy_queue_obj_t *obj, msg_queue_msg_t* msgs, unsigned int count)
+{
+	msg_copy_hdr_t *hdr;
+	uint8_t *span;
+	size_t size = 0;
+	unsigned int i;
+	ring_buff_err_t err;
+
+	for(i=0; i<count; i++)
+	{
+		size += sizeof(msg_copy_hdr_t) + MSG_COPY_ALIGN(msgs[i].size);
+		if(size > UINT32_MAX)
+		{
+			return MSG_QUEUE_ERR_GENERAL;
+		}
+	}
+	/* all messages are copied into one span, and committed together (or nothing is put if it does not fit) */
+	pthread_mutex_lock(&(obj->put_lock));
+	err = ring_buff_reserve(obj->ring, (void**)&span, (uint32_t)size);
+	if(err == RING_BUFF_ERR_OK)
+	{
+		for(i=0, hdr=(msg_copy_hdr_t*)span; i<count; i++)
+		{
+			hdr->size = msgs[i].size;
+			memcpy(hdr + 1, msgs[i].data, msgs[i].size);
+			hdr = (msg_copy_hdr_t*)((uint8_t*)(hdr + 1) + MSG_COPY_ALIGN(msgs[i].size));
+		}
+		err = ring_buff_commit(obj->ring, span, (uint32_t)size);
+	}
+	pthread_mutex_unlock(&(obj->put_lock));
+
+	return (err == RING_BUFF_ERR_OK) ? MSG_QUEUE_ERR_OK : MSG_QUEUE_ERR_GENERAL;
+}
+
+static msg_queue_err_t msg_copy_queue_get(msg_copy_queue_obj_t *obj, void** msg_data, size_t* msg_size)
+{
+	msg_copy_hdr_t *hdr;
+	uint32_t read;
+	ring_buff_err_t err;
+
+	pthread_mutex_lock(&(obj->get_lock));
+	err = ring_buff_read(obj->ring, (void**)&hdr, sizeof(msg_copy_hdr_t), &read);
+	if(err == RING_BUFF_ERR_OK)
+	{
+		err = ring_buff_read(obj->ring, msg_data, (uint32_t)MSG_COPY_ALIGN(hdr->size), &read);
+		*msg_size = hdr->size;
+	}
+	pthread_mutex_unlock(&(obj->get_lock));
+
+	return (err == RING_BUFF_ERR_OK) ? MSG_QUEUE_ERR_OK : MSG_QUEUE_ERR_GENERAL;
+}
@@ -32,6 +32,8 @@
 #ifndef MESSAGE_QUEUE_H_
 #define MESSAGE_QUEUE_H_
 
+#include <time.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -43,9 +45,75 @@ typedef enum
 {
 	MSG_QUEUE_ERR_OK,     /**< MSG_QUEUE_ERR_OK No error. */
 	MSG_QUEUE_ERR_GENERAL,/**< MSG_QUEUE_ERR_GENERAL General error. */
-	MSG_QUEUE_ERR_NO_MEM  /**< MSG_QUEUE_ERR_NO_MEM Not enough system memory error. */
+	MSG_QUEUE_ERR_NO_MEM, /**< MSG_QUEUE_ERR_NO_MEM Not enough system memory error. */
+	MSG_QUEUE_ERR_TIMEOUT,/**< MSG_QUEUE_ERR_TIMEOUT No message arrived before the timeout. */
+	MSG_QUEUE_ERR_EMPTY   /**< MSG_QUEUE_ERR_EMPTY No message available (non-blocking get). */
 } msg_queue_err_t;
 
+/**
+ * Message queue types.
+ */
+typedef enum
+{
+	MSG_QUEUE_TYPE_LIST,   /**< MSG_QUEUE_TYPE_LIST Unbounded, mutex protected list (default). */
+	MSG_QUEUE_TYPE_BOUNDED,/**< MSG_QUEUE_TYPE_BOUNDED Bounded, lock-free array based MPMC queue. */
+	MSG_QUEUE_TYPE_COPY    /**< MSG_QUEUE_TYPE_COPY Message data is copied into ring buffer storage. */
+} msg_queue_type_t;
+
+/**
+ * Message queue attribute structure. It is used when message queue is created.
+ */
+typedef struct msg_queue_attr
+{
+	/** Queue type. */
+	msg_queue_type_t type;
+	/**
+	 * Maximum number of messages in the queue. Used only by MSG_QUEUE_TYPE_BOUNDED,
+	 * and rounded up to the power of two.
+	 */
+	unsigned int capacity;
+	/**
+	 * Number of priority levels (up to 32). Used only by MSG_QUEUE_TYPE_LIST. Level 0 has
+	 * the highest priority. If set to 0, queue will have one level.
+	 */
+	unsigned int levels;
+	/**
+	 * Anti-starvation quota. After "quota" messages are taken from higher levels while lower
+	 * levels are waiting, one message from a lower non-empty level is taken. Waiting lower levels
+	 * get these turns in rotation, so none of them starves.
+	 * If set to 0, levels are served in strict priority order.
+	 */
+	unsigned int quota;
+	/**
+	 * Memory used for message storage. Used only by MSG_QUEUE_TYPE_COPY. It is
+	 * provided (and freed) by user.
+	 */
+	void* buff;
+	/** Message storage size in bytes. Used only by MSG_QUEUE_TYPE_COPY. */
+	unsigned int buff_size;
+} msg_queue_attr_t;
+
+/**
+ * Message descriptor. Used for batch operations.
+ */
+typedef struct msg_queue_msg
+{
+	/** Message data. */
+	void* data;
+	/** Message data size in bytes. */
+	size_t size;
+} msg_queue_msg_t;
+
+/**
+ * Delayed message timer. It is provided by user, and it can be used to cancel delayed message.
+ * It has to stay valid until the message is delivered or canceled.
+ */
+typedef struct msg_queue_timer
+{
+	/** Internal. Pending delayed message (NULL once the message is delivered or canceled). */
+	void* pending;
+} msg_queue_timer_t;
+
 /**
  * Message queue handle.
  */
@@ -57,6 +125,15 @@ typedef void* msg_queue_hndl;
  * @return error descriptor.
  */
 msg_queue_err_t msg_queue_create(msg_queue_hndl *handle);
+/**
+ * Message queue constructor with attributes.
+ * Bounded queue does not use any lock while there is space (or messages) available. It blocks
+ * producers only when the queue is full, and consumers only when it is empty.
+ * @param attr message queue attributes. If NULL, queue is created as with "msg_queue_create".
+ * @param handle pointer to handle which will be updated if construction was successful (output param)
+ * @return error descriptor.
+ */
+msg_queue_err_t msg_queue_create_with_attr(msg_queue_attr_t *attr, msg_queue_hndl *handle);
 /**
  * Message queue destructor.
  * @param handle handle which will be freed.
@@ -64,7 +141,9 @@ msg_queue_err_t msg_queue_create(msg_queue_hndl *handle);
  */
 msg_queue_err_t msg_queue_destroy(msg_queue_hndl handle);
 /**
- * Put message in the queue.
+ * Put message in the queue. If bounded queue is full, this function will block until
+ * there is space available. MSG_QUEUE_TYPE_COPY queue copies message data into its storage
+ * (blocking if there is not enough space), so user keeps the data ownership.
  * @param handle message queue handle
  * @param msg_data message data. Data is preallocated by user (queue is not doing any data memory management).
  * @param msg_size message data size in bytes.
@@ -72,7 +151,19 @@ msg_queue_err_t msg_queue_destroy(msg_queue_hndl handle);
  */
 msg_queue_err_t msg_queue_put(msg_queue_hndl handle, void* msg_data, size_t msg_size);
 /**
- * Put message as first one in the queue.
+ * Put message at the end of given priority level. Plain "msg_queue_put" uses the lowest priority level.
+ * NOTE: Supported only by the MSG_QUEUE_TYPE_LIST queue (MSG_QUEUE_ERR_GENERAL is returned otherwise).
+ * @param handle message queue handle.
+ * @param msg_data message data. Data is preallocated by user (queue is not doing any data memory management).
+ * @param msg_size message data size in bytes.
+ * @param level priority level (0 is the highest).
+ * @return error descriptor.
+ */
+msg_queue_err_t msg_queue_put_prio(msg_queue_hndl handle, void* msg_data, size_t msg_size, unsigned int level);
+/**
+ * Put message in front of the highest priority level. Urgent messages are kept in the order they are put,
+ * so the message goes behind urgent messages that are already waiting.
+ * NOTE: Supported only by the MSG_QUEUE_TYPE_LIST queue (MSG_QUEUE_ERR_GENERAL is returned otherwise).
  * @param handle message queue handle.
  * @param msg_data message data. Data is preallocated by user (queue is not doing any data memory management).
  * @param msg_size message data size in bytes.
@@ -81,6 +172,8 @@ msg_queue_err_t msg_queue_put(msg_queue_hndl handle, void* msg_data, size_t msg_
 msg_queue_err_t msg_queue_put_urgent(msg_queue_hndl handle, void* msg_data, size_t msg_size);
 /**
  * Get message from queue. Message related memory is freed, but message data needs to be freed by user.
+ * For MSG_QUEUE_TYPE_COPY queue, data points into queue storage and it is valid until it is released
+ * with "msg_queue_release" (messages have to be released in the order they are received).
  * This function will block execution until message is available in the queue.
  * @param handle message queue handle.
  * @param msg_data message data. This is output parameter which will contain data pointer if there were no errors.
@@ -88,6 +181,87 @@ msg_queue_err_t msg_queue_put_urgent(msg_queue_hndl handle, void* msg_data, size
  * @return error descriptor.
  */
 msg_queue_err_t msg_queue_get(msg_queue_hndl handle, void** msg_data, size_t* msg_size);
+/**
+ * Get message from queue, waiting for it at most "timeout_us" microseconds.
+ * @param handle message queue handle.
+ * @param msg_data message data (output param).
+ * @param msg_size message size (output param).
+ * @param timeout_us timeout in microseconds.
+ * @return error descriptor (MSG_QUEUE_ERR_TIMEOUT if no message arrived in time).
+ */
+msg_queue_err_t msg_queue_get_timed(msg_queue_hndl handle, void** msg_data, size_t* msg_size, unsigned long timeout_us);
+/**
+ * Get message from queue if one is available. This function never blocks.
+ * @param handle message queue handle.
+ * @param msg_data message data (output param).
+ * @param msg_size message size (output param).
+ * @return error descriptor (MSG_QUEUE_ERR_EMPTY if there is no message available).
+ */
+msg_queue_err_t msg_queue_try_get(msg_queue_hndl handle, void** msg_data, size_t* msg_size);
+/**
+ * Put message in the queue when deadline is reached. Until then, message is kept in the timer wheel
+ * (insertion and cancellation are O(1)), and it is delivered at the lowest priority level.
+ * Timer resolution is one millisecond.
+ * NOTE: Delayed messages, timed and non-blocking get are supported only by the MSG_QUEUE_TYPE_LIST queue.
+ * @param handle message queue handle.
+ * @param msg_data message data. Data is preallocated by user (queue is not doing any data memory management).
+ * @param msg_size message data size in bytes.
+ * @param deadline absolute delivery time (CLOCK_MONOTONIC).
+ * @param timer optional timer which can be used to cancel the message (may be NULL).
+ * @return error descriptor.
+ */
+msg_queue_err_t msg_queue_put_at(msg_queue_hndl handle, void* msg_data, size_t msg_size, const struct timespec *deadline, msg_queue_timer_t *timer);
+/**
+ * Put message in the queue after "delay_us" microseconds. See "msg_queue_put_at".
+ * @param handle message queue handle.
+ * @param msg_data message data. Data is preallocated by user (queue is not doing any data memory management).
+ * @param msg_size message data size in bytes.
+ * @param delay_us delivery delay in microseconds.
+ * @param timer optional timer which can be used to cancel the message (may be NULL).
+ * @return error descriptor.
+ */
+msg_queue_err_t msg_queue_put_after(msg_queue_hndl handle, void* msg_data, size_t msg_size, unsigned long delay_us, msg_queue_timer_t *timer);
+/**
+ * Cancels delayed message which is not delivered yet.
+ * @param handle message queue handle.
+ * @param timer timer passed when message was put.
+ * @param msg_data canceled message data, so that user can free it (output param, may be NULL).
+ * @param msg_size canceled message size (output param, may be NULL).
+ * @return error descriptor (MSG_QUEUE_ERR_GENERAL if message is already delivered).
+ */
+msg_queue_err_t msg_queue_cancel(msg_queue_hndl handle, msg_queue_timer_t *timer, void** msg_data, size_t* msg_size);
+/**
+ * Put number of messages in the queue at once (at the lowest priority level). Messages are linked to the queue with
+ * single lock acquisition, and waiting consumers are signaled once. MSG_QUEUE_TYPE_BOUNDED queue claims cells
+ * for all messages at once (batch can not be larger than the capacity), and MSG_QUEUE_TYPE_COPY queue copies
+ * all messages into one reserved chunk (batch has to fit in the buffer).
+ * @param handle message queue handle.
+ * @param msgs array of messages. Data is preallocated by user (queue is not doing any data memory management).
+ * @param count number of messages in the array.
+ * @return error descriptor. If error is returned, none of the messages is put in the queue.
+ */
+msg_queue_err_t msg_queue_put_batch(msg_queue_hndl handle, msg_queue_msg_t* msgs, unsigned int count);
+/**
+ * Get up to "max" messages from the queue at once. Messages are detached from the queue under single
+ * lock acquisition (in O(1) if all messages of a level are taken). Levels are served in the same order
+ * as by "msg_queue_get" (anti-starvation quota applies). Message data needs to be freed by user.
+ * This function will block execution until at least one message is available in the queue.
+ * NOTE: Not supported by the MSG_QUEUE_TYPE_COPY queue (MSG_QUEUE_ERR_GENERAL is returned).
+ * @param handle message queue handle.
+ * @param msgs array which will be filled with messages (output param).
+ * @param max array size (maximum number of messages to take).
+ * @param count number of messages taken (output param).
+ * @return error descriptor.
+ */
+msg_queue_err_t msg_queue_get_batch(msg_queue_hndl handle, msg_queue_msg_t* msgs, unsigned int max, unsigned int* count);
+/**
+ * Releases message storage of the MSG_QUEUE_TYPE_COPY queue.
+ * @param handle message queue handle.
+ * @param msg_data message data retrieved with "msg_queue_get".
+ * @param msg_size message size retrieved with "msg_queue_get".
+ * @return error descriptor.
+ */
+msg_queue_err_t msg_queue_release(msg_queue_hndl handle, void* msg_data, size_t msg_size);
 
 #ifdef __cplusplus
 }
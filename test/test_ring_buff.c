@@ -31,13 +31,23 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <pthread.h>
 
 #define __USE_BSD
 #include <unistd.h>
+#include <sys/wait.h>
 
 #include "ring_buff.h"
+#include "ring_buff_osal.h"
+#include "ring_buff_shards.h"
+#include "ring_buff_set.h"
+#include "ring_buff_pipeline.h"
+#include "ring_buff_executor.h"
+#include "ring_buff64.h"
+#include "ring_buff_pool.h"
+#include "ring_buff_sink.h"
 #include "message_queue.h"
 
 #define FIRST_TC_BUFF_SIZE (50*1024)
@@ -421,6 +431,281 @@ ring_buff_err_t second_tc_notify(ring_buff_handle_t handle, void* buff, unsigned
 }
 
 
+#define SECOND_TC_LINGER_RINGS (4)
+#define SECOND_TC_LINGER_SIZE  (4096)
+#define SECOND_TC_LINGER_US    (20000)
+
+typedef struct second_tc_linger_ring
+{
+	ring_buff_handle_t ring_buff;
+	uint8_t mem[SECOND_TC_LINGER_SIZE];
+	/** Notified bytes, and when the last notification arrived (microseconds) */
+	uint32_t notified;
+	uint64_t notify_time;
+} second_tc_linger_ring_t;
+
+static second_tc_linger_ring_t second_tc_linger_rings[SECOND_TC_LINGER_RINGS];
+
+static ring_buff_err_t second_tc_linger_notify(ring_buff_handle_t handle, void* buff, uint32_t size)
+{
+	unsigned int i;
+
+	for(i = 0; i < SECOND_TC_LINGER_RINGS; i++)
+	{
+		if(second_tc_linger_rings[i].ring_buff == handle)
+		{
+			__atomic_store_n(&second_tc_linger_rings[i].notify_time, ring_buff_time_us(), __ATOMIC_RELAXED);
+			__atomic_add_fetch(&second_tc_linger_rings[i].notified, size, __ATOMIC_RELEASE);
+		}
+	}
+	return ring_buff_free(handle, buff, size);
+}
+
+#define SECOND_TC_TIMERS       (32)
+
+static uint64_t second_tc_timer_expires[SECOND_TC_TIMERS];
+static uint64_t second_tc_timer_fired[SECOND_TC_TIMERS];
+static unsigned int second_tc_timer_count;
+
+static void second_tc_timer(void* arg)
+{
+	unsigned int idx = __atomic_fetch_add(&second_tc_timer_count, 1, __ATOMIC_RELAXED);
+
+	second_tc_timer_fired[idx] = second_tc_timer_expires[(uintptr_t)arg];
+}
+
+/* timers armed (and re-armed) in any order fire in the order of expiration */
+static unsigned int second_tc_timers(void)
+{
+	ring_buff_timer_t timers[SECOND_TC_TIMERS];
+	uint64_t start = ring_buff_time_us() + 10000;
+	unsigned int i, created, failed = 0;
+
+	second_tc_timer_count = 0;
+	for(created = 0; created < SECOND_TC_TIMERS; created++)
+	{
+		if(ring_buff_timer_create(&timers[created], second_tc_timer, (void*)(uintptr_t)created) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+			goto done;
+		}
+	}
+	for(i = 0; i < SECOND_TC_TIMERS; i++)
+	{
+		second_tc_timer_expires[i] = start + ((i * 7) % SECOND_TC_TIMERS) * 1000;
+		ring_buff_timer_arm(timers[i], second_tc_timer_expires[i]);
+	}
+	/* earliest timer moves to the end, and the latest one to the front */
+	second_tc_timer_expires[0] = start + SECOND_TC_TIMERS * 1000;
+	ring_buff_timer_arm(timers[0], second_tc_timer_expires[0]);
+	second_tc_timer_expires[9] = start - 5000;
+	ring_buff_timer_arm(timers[9], second_tc_timer_expires[9]);
+	usleep(10000 + SECOND_TC_TIMERS * 1000 + SECOND_TC_LINGER_US);
+	if(__atomic_load_n(&second_tc_timer_count, __ATOMIC_ACQUIRE) != SECOND_TC_TIMERS)
+	{
+		failed++;
+		goto done;
+	}
+	for(i = 1; i < SECOND_TC_TIMERS; i++)
+	{
+		if(second_tc_timer_fired[i] < second_tc_timer_fired[i - 1])
+		{
+			failed++;
+		}
+	}
+
+done:
+	for(i = 0; i < created; i++)
+	{
+		ring_buff_timer_destroy(timers[i]);
+	}
+	return failed;
+}
+
+/* partial windows are notified once they linger long enough, armed timers of all buffers share one thread */
+static unsigned int second_tc_linger(void)
+{
+	ring_buff_attr_t ring_buff_attr;
+	second_tc_linger_ring_t *tc_ring;
+	uint64_t start;
+	unsigned int failed = 0, i;
+	void *buff;
+
+	memset(second_tc_linger_rings, 0, sizeof(second_tc_linger_rings));
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.size = SECOND_TC_LINGER_SIZE;
+	ring_buff_attr.accumulate = 1024;
+	ring_buff_attr.notify_func = second_tc_linger_notify;
+	ring_buff_attr.linger_us = SECOND_TC_LINGER_US;
+	for(i = 0; i < SECOND_TC_LINGER_RINGS; i++)
+	{
+		ring_buff_attr.buff = second_tc_linger_rings[i].mem;
+		if(ring_buff_create(&ring_buff_attr, &second_tc_linger_rings[i].ring_buff) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+			goto done;
+		}
+	}
+	start = ring_buff_time_us();
+	for(i = 0; i < SECOND_TC_LINGER_RINGS; i++)
+	{
+		tc_ring = &second_tc_linger_rings[i];
+		ring_buff_reserve(tc_ring->ring_buff, &buff, 100 * (i + 1));
+		ring_buff_commit(tc_ring->ring_buff, buff, 100 * (i + 1));
+	}
+	for(i = 0; i < SECOND_TC_LINGER_RINGS; i++)
+	{
+		if(__atomic_load_n(&second_tc_linger_rings[i].notified, __ATOMIC_ACQUIRE) != 0)
+		{
+			failed++;
+		}
+	}
+	usleep(SECOND_TC_LINGER_US * 10);
+	for(i = 0; i < SECOND_TC_LINGER_RINGS; i++)
+	{
+		tc_ring = &second_tc_linger_rings[i];
+		if(__atomic_load_n(&tc_ring->notified, __ATOMIC_ACQUIRE) != 100 * (i + 1) ||
+				tc_ring->notify_time < start + SECOND_TC_LINGER_US)
+		{
+			printf(" RING %u: notified %u bytes after %lu us\n", i, tc_ring->notified, (unsigned long)(tc_ring->notify_time - start));
+			failed++;
+		}
+	}
+	/* full window is notified right away */
+	tc_ring = &second_tc_linger_rings[0];
+	ring_buff_reserve(tc_ring->ring_buff, &buff, 1024);
+	ring_buff_commit(tc_ring->ring_buff, buff, 1024);
+	ring_buff_reserve(tc_ring->ring_buff, &buff, 10);
+	ring_buff_commit(tc_ring->ring_buff, buff, 10);
+	if(__atomic_load_n(&tc_ring->notified, __ATOMIC_ACQUIRE) != 100 + 1024)
+	{
+		failed++;
+	}
+	/* armed timers go away with their buffers */
+	for(i = 1; i < SECOND_TC_LINGER_RINGS; i++)
+	{
+		tc_ring = &second_tc_linger_rings[i];
+		ring_buff_reserve(tc_ring->ring_buff, &buff, 10);
+		ring_buff_commit(tc_ring->ring_buff, buff, 10);
+		ring_buff_destroy(tc_ring->ring_buff);
+		tc_ring->ring_buff = NULL;
+	}
+	usleep(SECOND_TC_LINGER_US * 10);
+	if(__atomic_load_n(&second_tc_linger_rings[0].notified, __ATOMIC_ACQUIRE) != 100 + 1024 + 10)
+	{
+		failed++;
+	}
+done:
+	for(i = 0; i < SECOND_TC_LINGER_RINGS; i++)
+	{
+		if(second_tc_linger_rings[i].ring_buff != NULL)
+		{
+			ring_buff_destroy(second_tc_linger_rings[i].ring_buff);
+		}
+	}
+
+	return failed;
+}
+
+#define SECOND_TC_ADAPT_BUFF_SIZE  (128 * 1024)
+#define SECOND_TC_ADAPT_CHUNK      (256)
+#define SECOND_TC_ADAPT_ACC_MIN    (256)
+#define SECOND_TC_ADAPT_ACC_MAX    (32 * 1024)
+
+static struct
+{
+	/** Time spent in the notify callback (microseconds) */
+	volatile unsigned int notify_us;
+	unsigned int notified;
+	unsigned int failed;
+} second_tc_adapt_arg;
+
+static ring_buff_err_t second_tc_adapt_notify(ring_buff_handle_t handle, void* buff, uint32_t size)
+{
+	second_tc_adapt_arg.notified += size;
+	if(second_tc_adapt_arg.notify_us)
+	{
+		usleep(second_tc_adapt_arg.notify_us);
+	}
+	return ring_buff_free(handle, buff, size);
+}
+
+/* commits until the window gets over (grow) or under (shrink) the limit, returns the window reached */
+static uint32_t second_tc_adapt_load(ring_buff_handle_t ring_buff, uint8_t grow, uint32_t limit, unsigned int sleep_us)
+{
+	struct timespec start, now;
+	uint32_t accumulate = 0;
+	void *buff;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do
+	{
+		if(ring_buff_reserve(ring_buff, &buff, SECOND_TC_ADAPT_CHUNK) != RING_BUFF_ERR_OK ||
+				ring_buff_commit(ring_buff, buff, SECOND_TC_ADAPT_CHUNK) != RING_BUFF_ERR_OK ||
+				ring_buff_get_accumulate(ring_buff, &accumulate) != RING_BUFF_ERR_OK)
+		{
+			second_tc_adapt_arg.failed++;
+			break;
+		}
+		if(sleep_us)
+		{
+			usleep(sleep_us);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	}
+	while((grow ? accumulate < limit : accumulate > limit) && now.tv_sec - start.tv_sec < 5);
+
+	return accumulate;
+}
+
+/* window grows for busy consumer, and shrinks again under light load */
+static unsigned int second_tc_adapt(void)
+{
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_handle_t ring_buff = NULL;
+	uint32_t accumulate = 0, grown, shrunk;
+
+	memset(&second_tc_adapt_arg, 0, sizeof(second_tc_adapt_arg));
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.buff = malloc(SECOND_TC_ADAPT_BUFF_SIZE);
+	ring_buff_attr.size = SECOND_TC_ADAPT_BUFF_SIZE;
+	ring_buff_attr.accumulate = 1024;
+	ring_buff_attr.notify_func = second_tc_adapt_notify;
+	ring_buff_attr.acc_target_us = 1000;
+	ring_buff_attr.acc_min = SECOND_TC_ADAPT_ACC_MIN;
+	ring_buff_attr.acc_max = SECOND_TC_ADAPT_ACC_MAX;
+	if(ring_buff_attr.buff == NULL || ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+	{
+		second_tc_adapt_arg.failed++;
+		goto done;
+	}
+	if(ring_buff_get_accumulate(ring_buff, NULL) != RING_BUFF_ERR_BAD_ARG ||
+			ring_buff_get_accumulate(ring_buff, &accumulate) != RING_BUFF_ERR_OK || accumulate != 1024)
+	{
+		second_tc_adapt_arg.failed++;
+	}
+	/* consumer is busy most of the time between notifications, so it gets bigger batches */
+	second_tc_adapt_arg.notify_us = 1000;
+	grown = second_tc_adapt_load(ring_buff, 1, SECOND_TC_ADAPT_ACC_MAX, 0);
+	if(grown != SECOND_TC_ADAPT_ACC_MAX)
+	{
+		second_tc_adapt_arg.failed++;
+	}
+	/* light load with fast consumer, window that is filled in the target time is small */
+	second_tc_adapt_arg.notify_us = 0;
+	shrunk = second_tc_adapt_load(ring_buff, 0, SECOND_TC_ADAPT_ACC_MAX / 8, 100);
+	if(shrunk > SECOND_TC_ADAPT_ACC_MAX / 8 || shrunk < SECOND_TC_ADAPT_ACC_MIN)
+	{
+		second_tc_adapt_arg.failed++;
+	}
+	printf(" WINDOW: %u -> %u -> %u\n", accumulate, grown, shrunk);
+	ring_buff_destroy(ring_buff);
+done:
+	free(ring_buff_attr.buff);
+
+	return second_tc_adapt_arg.failed;
+}
+
 static void execute_second_tc(void)
 {
 	pthread_t provider;
@@ -460,6 +745,9 @@ static void execute_second_tc(void)
 	pthread_join(provider, NULL);
 	ring_buff_destroy(ring_buff);
 	pthread_attr_destroy(&attr);
+	second_tc_failed += second_tc_linger();
+	second_tc_failed += second_tc_timers();
+	second_tc_failed += second_tc_adapt();
 
 done:
 	if(buff != NULL)
@@ -530,6 +818,243 @@ void* fourth_tc_consumer(void* arg)
 	return NULL;
 }
 
+/* elapsed milliseconds since "start" */
+static long fourth_tc_elapsed_ms(struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+static unsigned int fourth_tc_timers(void)
+{
+	static int msgs[4];
+	msg_queue_hndl queue;
+	msg_queue_timer_t timer, far_timer;
+	struct timespec start, deadline;
+	unsigned int failed = 0;
+	void *msg;
+	size_t size;
+
+	if(msg_queue_create(&queue) != MSG_QUEUE_ERR_OK)
+	{
+		return 1;
+	}
+	/* nothing to get */
+	if(msg_queue_try_get(queue, &msg, &size) != MSG_QUEUE_ERR_EMPTY)
+	{
+		failed++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	/* millisecond timer resolution */
+	if(msg_queue_get_timed(queue, &msg, &size, 20000) != MSG_QUEUE_ERR_TIMEOUT || fourth_tc_elapsed_ms(&start) < 19)
+	{
+		failed++;
+	}
+	/* message due later is put while the earlier one still waits in the higher wheel level */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	msg_queue_put_after(queue, &msgs[0], 0, 100000, NULL);
+	usleep(50000);
+	msg_queue_put_after(queue, &msgs[1], 1, 112000 - fourth_tc_elapsed_ms(&start) * 1000, NULL);
+	if(msg_queue_get(queue, &msg, &size) != MSG_QUEUE_ERR_OK || msg != &msgs[0] ||
+			fourth_tc_elapsed_ms(&start) < 100 || fourth_tc_elapsed_ms(&start) >= 112)
+	{
+		printf(" DELAYED ORDER: first message at %ld ms\n", fourth_tc_elapsed_ms(&start));
+		failed++;
+	}
+	if(msg_queue_get(queue, &msg, &size) != MSG_QUEUE_ERR_OK || msg != &msgs[1] || fourth_tc_elapsed_ms(&start) < 112)
+	{
+		failed++;
+	}
+	/* absolute deadline */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	deadline = start;
+	deadline.tv_nsec += 30000000;
+	if(deadline.tv_nsec >= 1000000000)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+	msg_queue_put_at(queue, &msgs[2], 2, &deadline, &timer);
+	if(msg_queue_try_get(queue, &msg, &size) != MSG_QUEUE_ERR_EMPTY)
+	{
+		failed++;
+	}
+	if(msg_queue_get_timed(queue, &msg, &size, 1000000) != MSG_QUEUE_ERR_OK || msg != &msgs[2] || fourth_tc_elapsed_ms(&start) < 30)
+	{
+		failed++;
+	}
+	/* delivered message can not be canceled */
+	if(msg_queue_cancel(queue, &timer, NULL, NULL) != MSG_QUEUE_ERR_GENERAL)
+	{
+		failed++;
+	}
+	/* canceled message is never delivered, the one far away does not hold back the near one */
+	msg_queue_put_after(queue, &msgs[3], 3, 5000000, &far_timer);
+	msg_queue_put_after(queue, &msgs[2], 2, 20000, &timer);
+	msg_queue_put_after(queue, &msgs[1], 1, 10000, NULL);
+	if(msg_queue_cancel(queue, &timer, &msg, &size) != MSG_QUEUE_ERR_OK || msg != &msgs[2] || size != 2)
+	{
+		failed++;
+	}
+	if(msg_queue_get_timed(queue, &msg, &size, 1000000) != MSG_QUEUE_ERR_OK || msg != &msgs[1])
+	{
+		failed++;
+	}
+	if(msg_queue_get_timed(queue, &msg, &size, 40000) != MSG_QUEUE_ERR_TIMEOUT)
+	{
+		failed++;
+	}
+	if(msg_queue_cancel(queue, &far_timer, &msg, NULL) != MSG_QUEUE_ERR_OK || msg != &msgs[3])
+	{
+		failed++;
+	}
+	msg_queue_destroy(queue);
+
+	return failed;
+}
+
+static unsigned int fourth_tc_batch(void)
+{
+	static int data[10];
+	msg_queue_msg_t msgs[16];
+	msg_queue_hndl queue;
+	unsigned int failed = 0, count, i;
+
+	if(msg_queue_create(&queue) != MSG_QUEUE_ERR_OK)
+	{
+		return 1;
+	}
+	if(msg_queue_put_batch(queue, NULL, 1) != MSG_QUEUE_ERR_GENERAL || msg_queue_put_batch(queue, msgs, 0) != MSG_QUEUE_ERR_GENERAL)
+	{
+		failed++;
+	}
+	for(i=0; i<10; i++)
+	{
+		msgs[i].data = &data[i];
+		msgs[i].size = i;
+	}
+	if(msg_queue_put_batch(queue, msgs, 10) != MSG_QUEUE_ERR_OK)
+	{
+		failed++;
+	}
+	memset(msgs, 0, sizeof(msgs));
+	/* batch is split, and the order is kept */
+	if(msg_queue_get_batch(queue, msgs, 4, &count) != MSG_QUEUE_ERR_OK || count != 4 ||
+			msg_queue_get_batch(queue, msgs + 4, 16 - 4, &count) != MSG_QUEUE_ERR_OK || count != 6)
+	{
+		failed++;
+	}
+	for(i=0; i<10; i++)
+	{
+		if(msgs[i].data != &data[i] || msgs[i].size != i)
+		{
+			failed++;
+		}
+	}
+	msg_queue_destroy(queue);
+
+	return failed;
+}
+
+/* message size tells the level, batch and single gets have to see the same order */
+static unsigned int fourth_tc_levels_check(msg_queue_hndl queue, const char *expected, int batch)
+{
+	msg_queue_msg_t msgs[32];
+	unsigned int failed = 0, count = 0, i;
+
+	if(batch)
+	{
+		if(msg_queue_get_batch(queue, msgs, 32, &count) != MSG_QUEUE_ERR_OK)
+		{
+			return 1;
+		}
+	}
+	else
+	{
+		while(msg_queue_try_get(queue, &(msgs[count].data), &(msgs[count].size)) == MSG_QUEUE_ERR_OK)
+		{
+			count++;
+		}
+	}
+	if(count != strlen(expected))
+	{
+		failed++;
+	}
+	for(i=0; i<count && i<strlen(expected); i++)
+	{
+		if(msgs[i].size != (size_t)(expected[i] - '0'))
+		{
+			failed++;
+		}
+	}
+	if(failed)
+	{
+		printf(" LEVELS: unexpected order, expected %s\n", expected);
+	}
+	return failed;
+}
+
+static unsigned int fourth_tc_levels(void)
+{
+	msg_queue_attr_t attr = {MSG_QUEUE_TYPE_LIST, 0, 3, 0, NULL, 0};
+	msg_queue_hndl queue;
+	unsigned int failed = 0, i;
+	int batch;
+	void *msg;
+	size_t size;
+
+	/* strict priority order, urgent messages in front of the highest level in FIFO order */
+	if(msg_queue_create_with_attr(&attr, &queue) != MSG_QUEUE_ERR_OK)
+	{
+		return 1;
+	}
+	if(msg_queue_put_prio(queue, NULL, 0, 3) != MSG_QUEUE_ERR_GENERAL)
+	{
+		failed++;
+	}
+	msg_queue_put(queue, NULL, 2);
+	msg_queue_put_prio(queue, NULL, 1, 1);
+	msg_queue_put_prio(queue, NULL, 3, 0);
+	msg_queue_put_urgent(queue, NULL, 4);
+	msg_queue_put_urgent(queue, NULL, 5);
+	failed += fourth_tc_levels_check(queue, "45312", 0);
+	msg_queue_put_prio(queue, NULL, 3, 0);
+	msg_queue_put_urgent(queue, NULL, 4);
+	msg_queue_put_urgent(queue, NULL, 5);
+	msg_queue_try_get(queue, &msg, &size);
+	msg_queue_put_urgent(queue, NULL, 6);
+	if(size != 4)
+	{
+		failed++;
+	}
+	failed += fourth_tc_levels_check(queue, "563", 1);
+	msg_queue_destroy(queue);
+	/* quota grants go to the waiting lower levels in turns */
+	attr.quota = 2;
+	for(batch=0; batch<2; batch++)
+	{
+		if(msg_queue_create_with_attr(&attr, &queue) != MSG_QUEUE_ERR_OK)
+		{
+			return failed + 1;
+		}
+		for(i=0; i<10; i++)
+		{
+			msg_queue_put_prio(queue, NULL, 0, 0);
+		}
+		for(i=0; i<3; i++)
+		{
+			msg_queue_put_prio(queue, NULL, 1, 1);
+			msg_queue_put_prio(queue, NULL, 2, 2);
+		}
+		failed += fourth_tc_levels_check(queue, "0010020010020021", batch);
+		msg_queue_destroy(queue);
+	}
+
+	return failed;
+}
+
 static void execute_fourth_tc(void)
 {
 	pthread_t provider;
@@ -562,6 +1087,9 @@ static void execute_fourth_tc(void)
 
 	pthread_join(provider, NULL);
 	pthread_join(consumer, NULL);
+	tc_arg.failed += fourth_tc_timers();
+	tc_arg.failed += fourth_tc_batch();
+	tc_arg.failed += fourth_tc_levels();
 done:
 	if(tc_arg.queue)
 	{
@@ -572,34 +1100,3073 @@ done:
 	printf("************************* DONE *************************\n");
 }
 
-static void print_help(void)
+#define FIFTH_TC_THREADS    (8)
+#define FIFTH_TC_LOOPS      (100000)
+#define FIFTH_TC_CAPACITY   (1024)
+#define FIFTH_TC_BATCH      (4)
+
+typedef struct _fifth_tc_arg
 {
-	printf("********** Ring buffer test **************\n");
-	printf("Please provide test case number:\n");
-	printf("1) Regular (blocking) read/write test\n");
-	printf("2) Notify reader on N bytes written test\n");
-	printf("3) Stream from HTTP server with CURL\n");
-	printf("4) Message queue test\n");
-	printf("******************************************\n");
+	msg_queue_hndl queue;
+	unsigned int id;
+	unsigned int loops;
+	unsigned long sum;
+} fifth_tc_arg_t;
+
+void* fifth_tc_provider(void* arg)
+{
+	fifth_tc_arg_t *tc_arg = (fifth_tc_arg_t *) arg;
+	msg_queue_msg_t msgs[FIFTH_TC_BATCH];
+	unsigned int i, j;
+
+	for(i=0; i<FIFTH_TC_LOOPS; i++)
+	{
+		/* every other provider puts batches */
+		if(tc_arg->id % 2)
+		{
+			for(j=0; j<FIFTH_TC_BATCH; j++)
+			{
+				msgs[j].data = tc_arg;
+				msgs[j].size = tc_arg->id * FIFTH_TC_LOOPS + i + j + 1;
+			}
+			if(msg_queue_put_batch(tc_arg->queue, msgs, FIFTH_TC_BATCH) != MSG_QUEUE_ERR_OK)
+			{
+				printf("**************** ERROR sending message *****************\n");
+				return NULL;
+			}
+			tc_arg->loops += FIFTH_TC_BATCH;
+			i += FIFTH_TC_BATCH - 1;
+			continue;
+		}
+		/* message size is used as message value, so no data has to be allocated */
+		if(msg_queue_put(tc_arg->queue, tc_arg, tc_arg->id * FIFTH_TC_LOOPS + i + 1) != MSG_QUEUE_ERR_OK)
+		{
+			printf("**************** ERROR sending message *****************\n");
+			return NULL;
+		}
+		tc_arg->loops++;
+	}
+	return NULL;
 }
 
-int main(int argc, char** argv)
+static void* fifth_tc_batch_provider(void* arg)
 {
-	int tc = 0;
+	msg_queue_msg_t *msgs = (msg_queue_msg_t*)arg;
 
-	if(argc != 2)
+	/* the first descriptor carries the queue */
+	msg_queue_put_batch(msgs[0].data, msgs + 1, 3);
+	return NULL;
+}
+
+/* batch is put as a whole, or it waits until there is room for all of its messages */
+static unsigned int fifth_tc_batch(void)
+{
+	msg_queue_attr_t attr = {MSG_QUEUE_TYPE_BOUNDED, 8, 0, 0, NULL, 0};
+	msg_queue_msg_t msgs[10], late[4];
+	msg_queue_hndl queue;
+	pthread_t provider;
+	unsigned int failed = 0, count, late_count = 0, i;
+
+	if(msg_queue_create_with_attr(&attr, &queue) != MSG_QUEUE_ERR_OK)
 	{
-		print_help();
-		return -1;
+		return 1;
 	}
-	tc = atoi(argv[1]);
-	switch(tc)
+	for(i=0; i<10; i++)
 	{
-	case 1:
-		execute_first_tc();
-		break;
-	case 2:
-		execute_second_tc();
+		msgs[i].data = queue;
+		msgs[i].size = i;
+	}
+	if(msg_queue_put_batch(queue, msgs, 9) != MSG_QUEUE_ERR_GENERAL || msg_queue_put_batch(queue, msgs, 6) != MSG_QUEUE_ERR_OK)
+	{
+		failed++;
+	}
+	/* only two cells are free, so none of the three messages may get in */
+	late[0].data = queue;
+	for(i=1; i<4; i++)
+	{
+		late[i].data = queue;
+		late[i].size = 100 + i;
+	}
+	pthread_create(&provider, NULL, fifth_tc_batch_provider, late);
+	usleep(50000);
+	memset(msgs, 0, sizeof(msgs));
+	/* the first freed cell makes room for the whole batch, so it may be taken here as well (but never a part of it) */
+	if(msg_queue_get_batch(queue, msgs, 10, &count) != MSG_QUEUE_ERR_OK || (count != 6 && count != 9))
+	{
+		failed++;
+	}
+	pthread_join(provider, NULL);
+	if(count < 9 && (msg_queue_get_batch(queue, msgs + count, 10 - count, &late_count) != MSG_QUEUE_ERR_OK || count + late_count != 9))
+	{
+		failed++;
+	}
+	for(i=0; i<9; i++)
+	{
+		if(msgs[i].size != ((i < 6) ? i : 101 + i - 6))
+		{
+			failed++;
+		}
+	}
+	msg_queue_destroy(queue);
+
+	return failed;
+}
+
+void* fifth_tc_consumer(void* arg)
+{
+	fifth_tc_arg_t *tc_arg = (fifth_tc_arg_t *) arg;
+	void *msg;
+	size_t size;
+
+	while(1)
+	{
+		if(msg_queue_get(tc_arg->queue, &msg, &size) != MSG_QUEUE_ERR_OK)
+		{
+			printf("*************** ERROR receiving message ****************\n");
+			return NULL;
+		}
+		/* "End Of Test" message */
+		if(msg == NULL)
+		{
+			break;
+		}
+		tc_arg->sum += size;
+		tc_arg->loops++;
+	}
+	return NULL;
+}
+
+static void execute_fifth_tc(void)
+{
+	pthread_t providers[FIFTH_TC_THREADS];
+	pthread_t consumers[FIFTH_TC_THREADS];
+	fifth_tc_arg_t provider_args[FIFTH_TC_THREADS];
+	fifth_tc_arg_t consumer_args[FIFTH_TC_THREADS];
+	msg_queue_attr_t attr = {MSG_QUEUE_TYPE_BOUNDED, FIFTH_TC_CAPACITY, 0, 0, NULL, 0};
+	msg_queue_hndl queue = NULL;
+	unsigned long sum = 0, expected = 0;
+	unsigned int loops = 0, i;
+	struct timespec start, end;
+
+	printf("********* Executing bounded MPMC message queue test *********\n");
+	if(msg_queue_create_with_attr(&attr, &queue) != MSG_QUEUE_ERR_OK)
+	{
+		printf("************* ERROR creating message queue **************\n");
+		return;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i=0; i<FIFTH_TC_THREADS; i++)
+	{
+		consumer_args[i].queue = queue;
+		consumer_args[i].id = i;
+		consumer_args[i].loops = 0;
+		consumer_args[i].sum = 0;
+		pthread_create(&consumers[i], NULL, fifth_tc_consumer, &consumer_args[i]);
+	}
+	for(i=0; i<FIFTH_TC_THREADS; i++)
+	{
+		provider_args[i] = consumer_args[i];
+		pthread_create(&providers[i], NULL, fifth_tc_provider, &provider_args[i]);
+	}
+	for(i=0; i<FIFTH_TC_THREADS; i++)
+	{
+		pthread_join(providers[i], NULL);
+	}
+	for(i=0; i<FIFTH_TC_THREADS; i++)
+	{
+		msg_queue_put(queue, NULL, 0);
+	}
+	for(i=0; i<FIFTH_TC_THREADS; i++)
+	{
+		pthread_join(consumers[i], NULL);
+		loops += consumer_args[i].loops;
+		sum += consumer_args[i].sum;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	msg_queue_destroy(queue);
+	for(i=0; i<FIFTH_TC_THREADS * FIFTH_TC_LOOPS; i++)
+	{
+		expected += i + 1;
+	}
+	printf(" LOOPS:  %u\n", loops);
+	printf(" FAILED: %u\n", ((sum != expected || loops != FIFTH_TC_THREADS * FIFTH_TC_LOOPS) ? 1 : 0) + fifth_tc_batch());
+	printf(" TIME:   %ld ms\n", (long)((end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000));
+	printf("************************* DONE *************************\n");
+}
+
+#define SIXTH_TC_LOOPS      (100000)
+#define SIXTH_TC_BUFF_SIZE  (16*1024)
+#define SIXTH_TC_BATCH      (4)
+
+void* sixth_tc_provider(void* arg)
+{
+	fourth_tc_arg_t *tc_arg = (fourth_tc_arg_t *) arg;
+	unsigned int msg[SIXTH_TC_BATCH][8];
+	msg_queue_msg_t msgs[SIXTH_TC_BATCH];
+	int i, j;
+
+	for(i=0; i<SIXTH_TC_LOOPS; i += SIXTH_TC_BATCH)
+	{
+		/* message is copied in, so it can live on the stack */
+		for(j=0; j<SIXTH_TC_BATCH; j++)
+		{
+			msg[j][0] = i + j;
+			msgs[j].data = msg[j];
+			msgs[j].size = ((i + j) % 8 + 1) * sizeof(unsigned int);
+		}
+		/* every other group goes in as one batch */
+		if((i / SIXTH_TC_BATCH) % 2)
+		{
+			if(msg_queue_put_batch(tc_arg->queue, msgs, SIXTH_TC_BATCH) != MSG_QUEUE_ERR_OK)
+			{
+				printf("**************** ERROR sending message *****************\n");
+				return NULL;
+			}
+			continue;
+		}
+		for(j=0; j<SIXTH_TC_BATCH; j++)
+		{
+			if(msg_queue_put(tc_arg->queue, msgs[j].data, msgs[j].size) != MSG_QUEUE_ERR_OK)
+			{
+				printf("**************** ERROR sending message *****************\n");
+				return NULL;
+			}
+		}
+	}
+	return NULL;
+}
+
+void* sixth_tc_consumer(void* arg)
+{
+	fourth_tc_arg_t *tc_arg = (fourth_tc_arg_t *) arg;
+	unsigned int *msg;
+	unsigned int i;
+	size_t size;
+
+	for(i=0; i<SIXTH_TC_LOOPS; i++)
+	{
+		if(msg_queue_get(tc_arg->queue, (void*)&msg, &size) != MSG_QUEUE_ERR_OK)
+		{
+			printf("*************** ERROR receiving message ****************\n");
+			return NULL;
+		}
+		if(i != msg[0] || size != (i % 8 + 1) * sizeof(unsigned int))
+		{
+			tc_arg->failed++;
+		}
+		if(msg_queue_release(tc_arg->queue, msg, size) != MSG_QUEUE_ERR_OK)
+		{
+			printf("*************** ERROR releasing message ****************\n");
+			return NULL;
+		}
+		tc_arg->loops++;
+	}
+	return NULL;
+}
+
+/* batch which does not fit is not put at all */
+static unsigned int sixth_tc_batch(msg_queue_hndl queue)
+{
+	static unsigned int big[SIXTH_TC_BUFF_SIZE / 2 / sizeof(unsigned int)];
+	msg_queue_msg_t msgs[3];
+	unsigned int failed = 0, count, *msg;
+	size_t size;
+
+	msgs[0].data = big;
+	msgs[0].size = sizeof(big);
+	msgs[1] = msgs[0];
+	msgs[2] = msgs[0];
+	if(msg_queue_put_batch(queue, msgs, 3) != MSG_QUEUE_ERR_GENERAL)
+	{
+		failed++;
+	}
+	big[0] = 7;
+	msgs[1].size = sizeof(unsigned int);
+	if(msg_queue_put_batch(queue, msgs + 1, 1) != MSG_QUEUE_ERR_OK)
+	{
+		failed++;
+	}
+	if(msg_queue_get(queue, (void**)&msg, &size) != MSG_QUEUE_ERR_OK || size != sizeof(unsigned int) || *msg != 7)
+	{
+		failed++;
+	}
+	else
+	{
+		msg_queue_release(queue, msg, size);
+	}
+	/* messages are released in place, so they can not be taken in batches */
+	if(msg_queue_get_batch(queue, msgs, 3, &count) != MSG_QUEUE_ERR_GENERAL)
+	{
+		failed++;
+	}
+	/* message that is too big for a reservation is rejected, not truncated */
+	if(msg_queue_put(queue, big, (size_t)-1) != MSG_QUEUE_ERR_GENERAL)
+	{
+		failed++;
+	}
+	if(sizeof(size_t) > sizeof(uint32_t) && msg_queue_put(queue, big, (size_t)UINT32_MAX + 1) != MSG_QUEUE_ERR_GENERAL)
+	{
+		failed++;
+	}
+
+	return failed;
+}
+
+static void execute_sixth_tc(void)
+{
+	pthread_t provider;
+	pthread_t consumer;
+	fourth_tc_arg_t tc_arg = {NULL, 0, 0};
+	msg_queue_attr_t attr = {MSG_QUEUE_TYPE_COPY, 0, 0, 0, NULL, SIXTH_TC_BUFF_SIZE};
+
+	printf("************ Executing copy-in message queue test ************\n");
+	if((attr.buff = malloc(SIXTH_TC_BUFF_SIZE)) == NULL)
+	{
+		printf("****************** ERROR no memory *****************\n");
+		return;
+	}
+	if(msg_queue_create_with_attr(&attr, &tc_arg.queue) != MSG_QUEUE_ERR_OK)
+	{
+		printf("************* ERROR creating message queue **************\n");
+		goto done;
+	}
+	pthread_create(&provider, NULL, sixth_tc_provider, &tc_arg);
+	pthread_create(&consumer, NULL, sixth_tc_consumer, &tc_arg);
+	pthread_join(provider, NULL);
+	pthread_join(consumer, NULL);
+	tc_arg.failed += sixth_tc_batch(tc_arg.queue);
+	msg_queue_destroy(tc_arg.queue);
+done:
+	free(attr.buff);
+	printf(" LOOPS:  %u\n", tc_arg.loops);
+	printf(" FAILED: %u\n", tc_arg.failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define SEVENTH_TC_LOOPS     (100000)
+#define SEVENTH_TC_WORKERS   (4)
+#define SEVENTH_TC_REC_SIZE  (64)
+#define SEVENTH_TC_RECORDS   (100)
+#define SEVENTH_TC_BUFF_SIZE (SEVENTH_TC_RECORDS * SEVENTH_TC_REC_SIZE + SEVENTH_TC_REC_SIZE / 2)
+
+typedef struct seventh_tc_arg
+{
+	ring_buff_handle_t ring_buff;
+	pthread_mutex_t lock;
+	unsigned int next;
+	unsigned int loops;
+	unsigned int failed;
+} seventh_tc_arg_t;
+
+void* seventh_tc_provider(void* arg)
+{
+	seventh_tc_arg_t *tc_arg = (seventh_tc_arg_t *) arg;
+	unsigned int *rec;
+	unsigned int i;
+
+	for(i=0; i<SEVENTH_TC_LOOPS; i++)
+	{
+		if(ring_buff_reserve(tc_arg->ring_buff, (void**)&rec, SEVENTH_TC_REC_SIZE) != RING_BUFF_ERR_OK)
+		{
+			printf("*************** ERROR reserving buffer *****************\n");
+			return NULL;
+		}
+		rec[0] = i;
+		rec[1] = ~i;
+		ring_buff_commit(tc_arg->ring_buff, rec, SEVENTH_TC_REC_SIZE);
+	}
+	return NULL;
+}
+
+void* seventh_tc_worker(void* arg)
+{
+	seventh_tc_arg_t *tc_arg = (seventh_tc_arg_t *) arg;
+	unsigned int *rec;
+	uint32_t read;
+	volatile int i;
+	int spin;
+
+	for(;;)
+	{
+		/* records are taken in order, but processed and freed in parallel */
+		pthread_mutex_lock(&tc_arg->lock);
+		if(tc_arg->loops == SEVENTH_TC_LOOPS)
+		{
+			pthread_mutex_unlock(&tc_arg->lock);
+			break;
+		}
+		ring_buff_read(tc_arg->ring_buff, (void**)&rec, SEVENTH_TC_REC_SIZE, &read);
+		if(read != SEVENTH_TC_REC_SIZE || rec[0] != tc_arg->next)
+		{
+			__atomic_add_fetch(&tc_arg->failed, 1, __ATOMIC_RELAXED);
+		}
+		tc_arg->next++;
+		tc_arg->loops++;
+		spin = rand() % 1000;
+		pthread_mutex_unlock(&tc_arg->lock);
+		for(i=0; i<spin; i++);
+		/* record must stay intact until it is freed, regardless of the other workers (checked out of the lock) */
+		if(rec[1] != ~rec[0])
+		{
+			__atomic_add_fetch(&tc_arg->failed, 1, __ATOMIC_RELAXED);
+		}
+		if(ring_buff_free(tc_arg->ring_buff, rec, SEVENTH_TC_REC_SIZE) != RING_BUFF_ERR_OK)
+		{
+			printf("**************** ERROR freeing buffer ******************\n");
+			return NULL;
+		}
+	}
+	return NULL;
+}
+
+#define SEVENTH_TC_ROUNDS (20)
+#define SEVENTH_TC_BATCH  (SEVENTH_TC_RECORDS / 2)
+
+/* batches are freed in scrambled order, and read position must get over all of them (across the wraps) */
+static unsigned int seventh_tc_scrambled(void *buff)
+{
+	ring_buff_handle_t ring_buff = NULL;
+	ring_buff_attr_t ring_buff_attr;
+	unsigned int *recs[SEVENTH_TC_BATCH];
+	unsigned int *rec;
+	unsigned int round, i, failed = 0;
+	uint32_t read;
+
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = SEVENTH_TC_BUFF_SIZE;
+	ring_buff_attr.free_slots = SEVENTH_TC_BATCH;
+	/* reserve does not wait, so the space that is not given back fails the test */
+	ring_buff_attr.single_thread = 1;
+	if(ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+	{
+		return 1;
+	}
+	for(round=0; round<SEVENTH_TC_ROUNDS && failed == 0; round++)
+	{
+		for(i=0; i<SEVENTH_TC_BATCH; i++)
+		{
+			if(ring_buff_reserve(ring_buff, (void**)&rec, SEVENTH_TC_REC_SIZE) != RING_BUFF_ERR_OK)
+			{
+				failed++;
+				break;
+			}
+			rec[0] = round * SEVENTH_TC_BATCH + i;
+			ring_buff_commit(ring_buff, rec, SEVENTH_TC_REC_SIZE);
+		}
+		for(i=0; i<SEVENTH_TC_BATCH && failed == 0; i++)
+		{
+			ring_buff_read(ring_buff, (void**)&recs[i], SEVENTH_TC_REC_SIZE, &read);
+			if(read != SEVENTH_TC_REC_SIZE || recs[i][0] != round * SEVENTH_TC_BATCH + i)
+			{
+				failed++;
+			}
+		}
+		for(i=0; i<SEVENTH_TC_BATCH && failed == 0; i++)
+		{
+			if(ring_buff_free(ring_buff, recs[(i * 7 + round) % SEVENTH_TC_BATCH], SEVENTH_TC_REC_SIZE) != RING_BUFF_ERR_OK)
+			{
+				failed++;
+			}
+		}
+	}
+	ring_buff_destroy(ring_buff);
+
+	return failed;
+}
+
+static void execute_seventh_tc(void)
+{
+	pthread_t provider;
+	pthread_t workers[SEVENTH_TC_WORKERS];
+	ring_buff_handle_t ring_buff = NULL;
+	ring_buff_attr_t ring_buff_attr;
+	seventh_tc_arg_t tc_arg;
+	ring_buff_err_t err;
+	void *buff;
+	int i;
+
+	printf("************ Executing out-of-order free test ************\n");
+	memset(&tc_arg, 0, sizeof(tc_arg));
+	pthread_mutex_init(&tc_arg.lock, NULL);
+	if((buff = malloc(SEVENTH_TC_BUFF_SIZE)) == NULL)
+	{
+		printf("****************** ERROR no memory *****************\n");
+		goto done;
+	}
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = SEVENTH_TC_BUFF_SIZE;
+	/* every record in the buffer may be freed ahead of the read position */
+	ring_buff_attr.free_slots = SEVENTH_TC_RECORDS;
+	err = ring_buff_create(&ring_buff_attr, &ring_buff);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		printf("************** ERROR creating ring buffer **************\n");
+		ring_buff_print_err(err);
+		goto done;
+	}
+	tc_arg.ring_buff = ring_buff;
+	pthread_create(&provider, NULL, seventh_tc_provider, &tc_arg);
+	for(i=0; i<SEVENTH_TC_WORKERS; i++)
+	{
+		pthread_create(&workers[i], NULL, seventh_tc_worker, &tc_arg);
+	}
+	pthread_join(provider, NULL);
+	for(i=0; i<SEVENTH_TC_WORKERS; i++)
+	{
+		pthread_join(workers[i], NULL);
+	}
+	ring_buff_destroy(ring_buff);
+	tc_arg.failed += seventh_tc_scrambled(buff);
+
+done:
+	if(buff != NULL)
+	{
+		free(buff);
+	}
+	pthread_mutex_destroy(&tc_arg.lock);
+	printf(" LOOPS:  %u\n", tc_arg.loops);
+	printf(" FAILED: %u\n", tc_arg.failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define EIGHTH_TC_LOOPS     (200000)
+#define EIGHTH_TC_WORKERS   (4)
+#define EIGHTH_TC_BUFF_SIZE (16*1024)
+
+typedef struct eighth_tc_arg
+{
+	ring_buff_handle_t ring_buff;
+	unsigned int loops;
+	unsigned int failed;
+	unsigned long sum;
+} eighth_tc_arg_t;
+
+void* eighth_tc_provider(void* arg)
+{
+	eighth_tc_arg_t *tc_arg = (eighth_tc_arg_t *) arg;
+	unsigned int *rec;
+	unsigned int size;
+	unsigned int i;
+
+	for(i=0; i<EIGHTH_TC_LOOPS; i++)
+	{
+		size = (i % 16 + 1) * sizeof(unsigned int);
+		if(ring_buff_reserve(tc_arg->ring_buff, (void**)&rec, size) != RING_BUFF_ERR_OK)
+		{
+			printf("*************** ERROR reserving buffer *****************\n");
+			break;
+		}
+		rec[0] = i;
+		rec[size / sizeof(unsigned int) - 1] = i;
+		ring_buff_commit(tc_arg->ring_buff, rec, size);
+	}
+	ring_buff_stop(tc_arg->ring_buff);
+	return NULL;
+}
+
+void* eighth_tc_worker(void* arg)
+{
+	eighth_tc_arg_t *tc_arg = (eighth_tc_arg_t *) arg;
+	unsigned int *rec;
+	uint32_t size;
+
+	/* each worker gets distinct records, until the buffer is stopped and drained */
+	while(ring_buff_claim(tc_arg->ring_buff, (void**)&rec, &size) == RING_BUFF_ERR_OK)
+	{
+		if(size != (rec[0] % 16 + 1) * sizeof(unsigned int) || rec[size / sizeof(unsigned int) - 1] != rec[0])
+		{
+			tc_arg->failed++;
+		}
+		tc_arg->sum += rec[0] + 1;
+		tc_arg->loops++;
+		if(ring_buff_release(tc_arg->ring_buff, rec) != RING_BUFF_ERR_OK)
+		{
+			printf("*************** ERROR releasing record *****************\n");
+			break;
+		}
+	}
+	return NULL;
+}
+
+static void execute_eighth_tc(void)
+{
+	pthread_t provider;
+	pthread_t workers[EIGHTH_TC_WORKERS];
+	eighth_tc_arg_t worker_args[EIGHTH_TC_WORKERS];
+	eighth_tc_arg_t tc_arg;
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_err_t err;
+	unsigned long expected = 0;
+	unsigned long sum = 0;
+	unsigned int loops = 0;
+	unsigned int failed = 0;
+	void *buff;
+	int i;
+
+	printf("************ Executing competing consumers test ************\n");
+	memset(&tc_arg, 0, sizeof(tc_arg));
+	if((buff = malloc(EIGHTH_TC_BUFF_SIZE)) == NULL)
+	{
+		printf("****************** ERROR no memory *****************\n");
+		goto done;
+	}
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = EIGHTH_TC_BUFF_SIZE;
+	ring_buff_attr.records = 1;
+	err = ring_buff_create(&ring_buff_attr, &tc_arg.ring_buff);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		printf("************** ERROR creating ring buffer **************\n");
+		ring_buff_print_err(err);
+		goto done;
+	}
+	pthread_create(&provider, NULL, eighth_tc_provider, &tc_arg);
+	for(i=0; i<EIGHTH_TC_WORKERS; i++)
+	{
+		worker_args[i] = tc_arg;
+		pthread_create(&workers[i], NULL, eighth_tc_worker, &worker_args[i]);
+	}
+	pthread_join(provider, NULL);
+	for(i=0; i<EIGHTH_TC_WORKERS; i++)
+	{
+		pthread_join(workers[i], NULL);
+		loops += worker_args[i].loops;
+		failed += worker_args[i].failed;
+		sum += worker_args[i].sum;
+	}
+	ring_buff_destroy(tc_arg.ring_buff);
+	for(i=0; i<EIGHTH_TC_LOOPS; i++)
+	{
+		expected += i + 1;
+	}
+	if(sum != expected || loops != EIGHTH_TC_LOOPS)
+	{
+		failed++;
+	}
+
+done:
+	if(buff != NULL)
+	{
+		free(buff);
+	}
+	printf(" LOOPS:  %u\n", loops);
+	printf(" FAILED: %u\n", failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define NINTH_TC_LOOPS      (200000)
+#define NINTH_TC_PRODUCERS  (4)
+#define NINTH_TC_SHARD_SIZE (16*1024)
+
+typedef struct ninth_tc_arg
+{
+	ring_buff_shards_handle_t shards;
+	unsigned int id;
+	unsigned int next[NINTH_TC_PRODUCERS];
+	unsigned int loops;
+	unsigned int failed;
+} ninth_tc_arg_t;
+
+void* ninth_tc_provider(void* arg)
+{
+	ninth_tc_arg_t *tc_arg = (ninth_tc_arg_t *) arg;
+	unsigned int *rec;
+	unsigned int i;
+
+	for(i=0; i<NINTH_TC_LOOPS; i++)
+	{
+		if(ring_buff_shards_reserve(tc_arg->shards, (void**)&rec, 2 * sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			printf("*************** ERROR reserving buffer *****************\n");
+			break;
+		}
+		rec[0] = tc_arg->id;
+		rec[1] = i;
+		ring_buff_shards_commit(tc_arg->shards, rec, 2 * sizeof(unsigned int));
+	}
+	return NULL;
+}
+
+static ring_buff_err_t ninth_tc_drain(ring_buff_shards_handle_t handle, void* buff, uint32_t size, void* arg)
+{
+	ninth_tc_arg_t *tc_arg = (ninth_tc_arg_t *) arg;
+	unsigned int *rec = (unsigned int *) buff;
+
+	(void)handle;
+	/* records of one producer must come in order */
+	if(size != 2 * sizeof(unsigned int) || rec[0] >= NINTH_TC_PRODUCERS || tc_arg->next[rec[0]] != rec[1])
+	{
+		tc_arg->failed++;
+	}
+	else
+	{
+		tc_arg->next[rec[0]]++;
+	}
+	tc_arg->loops++;
+	return RING_BUFF_ERR_OK;
+}
+
+#define NINTH_TC_REUSE_SHARDS  (2)
+#define NINTH_TC_REUSE_THREADS (3 * NINTH_TC_REUSE_SHARDS)
+
+void* ninth_tc_reuse_provider(void* arg)
+{
+	ninth_tc_arg_t *tc_arg = (ninth_tc_arg_t *) arg;
+	unsigned int *rec;
+
+	/* thread commits one record and exits, so its shard is released */
+	if(ring_buff_shards_reserve(tc_arg->shards, (void**)&rec, 2 * sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+	{
+		printf("*************** ERROR reserving buffer *****************\n");
+		tc_arg->failed++;
+		return NULL;
+	}
+	rec[0] = 0;
+	rec[1] = tc_arg->id;
+	ring_buff_shards_commit(tc_arg->shards, rec, 2 * sizeof(unsigned int));
+	return NULL;
+}
+
+static unsigned int ninth_tc_reuse(void)
+{
+	pthread_t provider;
+	ninth_tc_arg_t tc_arg;
+	ring_buff_shards_attr_t attr = {NINTH_TC_REUSE_SHARDS, 1024, RING_BUFF_SHARDS_ROUND_ROBIN};
+	unsigned int *rec;
+	int i;
+
+	memset(&tc_arg, 0, sizeof(tc_arg));
+	if(ring_buff_shards_create(&attr, &tc_arg.shards) != RING_BUFF_ERR_OK)
+	{
+		return 1;
+	}
+	/* more threads than shards, one after another */
+	for(i=0; i<NINTH_TC_REUSE_THREADS; i++)
+	{
+		tc_arg.id = i;
+		pthread_create(&provider, NULL, ninth_tc_reuse_provider, &tc_arg);
+		pthread_join(provider, NULL);
+	}
+	/* thread that is done with the shard releases it explicitly */
+	for(i=0; i<NINTH_TC_REUSE_THREADS; i++)
+	{
+		if(ring_buff_shards_reserve(tc_arg.shards, (void**)&rec, 2 * sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			tc_arg.failed++;
+			break;
+		}
+		rec[0] = 1;
+		rec[1] = i;
+		ring_buff_shards_commit(tc_arg.shards, rec, 2 * sizeof(unsigned int));
+		ring_buff_shards_unregister(tc_arg.shards);
+		tc_arg.id = NINTH_TC_REUSE_THREADS + i;
+		pthread_create(&provider, NULL, ninth_tc_reuse_provider, &tc_arg);
+		pthread_join(provider, NULL);
+	}
+	ring_buff_shards_stop(tc_arg.shards);
+	if(ring_buff_shards_drain(tc_arg.shards, ninth_tc_drain, &tc_arg, 0, NULL) != RING_BUFF_ERR_PERM ||
+			tc_arg.loops != 3 * NINTH_TC_REUSE_THREADS)
+	{
+		tc_arg.failed++;
+	}
+	ring_buff_shards_destroy(tc_arg.shards);
+
+	return tc_arg.failed;
+}
+
+static void execute_ninth_tc(void)
+{
+	pthread_t providers[NINTH_TC_PRODUCERS];
+	ninth_tc_arg_t provider_args[NINTH_TC_PRODUCERS];
+	ninth_tc_arg_t tc_arg;
+	ring_buff_shards_attr_t attr = {NINTH_TC_PRODUCERS, NINTH_TC_SHARD_SIZE, RING_BUFF_SHARDS_TIMESTAMP};
+	ring_buff_err_t err;
+	struct timespec start, end;
+	int i;
+
+	printf("************ Executing sharded ring buffer test ************\n");
+	memset(&tc_arg, 0, sizeof(tc_arg));
+	err = ring_buff_shards_create(&attr, &tc_arg.shards);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		printf("********** ERROR creating sharded ring buffer **********\n");
+		ring_buff_print_err(err);
+		goto done;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i=0; i<NINTH_TC_PRODUCERS; i++)
+	{
+		provider_args[i] = tc_arg;
+		provider_args[i].id = i;
+		pthread_create(&providers[i], NULL, ninth_tc_provider, &provider_args[i]);
+	}
+	/* drain (without blocking) until all the records are in */
+	for(;;)
+	{
+		err = ring_buff_shards_drain(tc_arg.shards, ninth_tc_drain, &tc_arg, 0, NULL);
+		if(err != RING_BUFF_ERR_OK || tc_arg.loops == NINTH_TC_PRODUCERS * NINTH_TC_LOOPS)
+		{
+			break;
+		}
+		usleep(100);
+	}
+	for(i=0; i<NINTH_TC_PRODUCERS; i++)
+	{
+		pthread_join(providers[i], NULL);
+	}
+	ring_buff_shards_stop(tc_arg.shards);
+	if(ring_buff_shards_drain(tc_arg.shards, ninth_tc_drain, &tc_arg, 0, NULL) != RING_BUFF_ERR_PERM)
+	{
+		tc_arg.failed++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	ring_buff_shards_destroy(tc_arg.shards);
+	printf(" TIME:   %ld ms\n", (long)((end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000));
+	/* shards of exited (or unregistered) threads are assigned to the new ones */
+	tc_arg.failed += ninth_tc_reuse();
+
+done:
+	printf(" LOOPS:  %u\n", tc_arg.loops);
+	printf(" FAILED: %u\n", tc_arg.failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define TENTH_TC_LOOPS     (100000)
+#define TENTH_TC_RINGS     (8)
+#define TENTH_TC_BUFF_SIZE (4*1024)
+
+typedef struct tenth_tc_arg
+{
+	ring_buff_handle_t ring_buff;
+	unsigned int id;
+} tenth_tc_arg_t;
+
+void* tenth_tc_provider(void* arg)
+{
+	tenth_tc_arg_t *tc_arg = (tenth_tc_arg_t *) arg;
+	unsigned int *rec;
+	unsigned int i;
+
+	for(i=0; i<TENTH_TC_LOOPS; i++)
+	{
+		if(ring_buff_reserve(tc_arg->ring_buff, (void**)&rec, 2 * sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			printf("*************** ERROR reserving buffer *****************\n");
+			break;
+		}
+		rec[0] = tc_arg->id;
+		rec[1] = i;
+		ring_buff_commit(tc_arg->ring_buff, rec, 2 * sizeof(unsigned int));
+	}
+	ring_buff_stop(tc_arg->ring_buff);
+	return NULL;
+}
+
+static void execute_tenth_tc(void)
+{
+	pthread_t providers[TENTH_TC_RINGS];
+	tenth_tc_arg_t provider_args[TENTH_TC_RINGS];
+	void *buffs[TENTH_TC_RINGS];
+	unsigned int next[TENTH_TC_RINGS];
+	ring_buff_set_event_t events[TENTH_TC_RINGS];
+	ring_buff_set_handle_t set = NULL;
+	ring_buff_attr_t ring_buff_attr;
+	unsigned int loops = 0;
+	unsigned int failed = 0;
+	unsigned int waits = 0;
+	unsigned int active = 0;
+	unsigned int *rec;
+	uint32_t count, size, i;
+	tenth_tc_arg_t *tc_arg;
+	ring_buff_err_t err;
+
+	printf("************ Executing ring buffer set test ************\n");
+	memset(provider_args, 0, sizeof(provider_args));
+	memset(buffs, 0, sizeof(buffs));
+	memset(next, 0, sizeof(next));
+	if(ring_buff_set_create(TENTH_TC_RINGS, &set) != RING_BUFF_ERR_OK)
+	{
+		printf("************ ERROR creating ring buffer set ************\n");
+		failed++;
+		goto done;
+	}
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.size = TENTH_TC_BUFF_SIZE;
+	ring_buff_attr.records = 1;
+	for(i=0; i<TENTH_TC_RINGS; i++)
+	{
+		if((buffs[i] = malloc(TENTH_TC_BUFF_SIZE)) == NULL)
+		{
+			printf("****************** ERROR no memory *****************\n");
+			failed++;
+			goto done;
+		}
+		ring_buff_attr.buff = buffs[i];
+		if(ring_buff_create(&ring_buff_attr, &provider_args[i].ring_buff) != RING_BUFF_ERR_OK ||
+				ring_buff_set_add(set, provider_args[i].ring_buff, RING_BUFF_SET_READ, &provider_args[i]) != RING_BUFF_ERR_OK)
+		{
+			printf("************** ERROR creating ring buffer **************\n");
+			failed++;
+			goto done;
+		}
+		provider_args[i].id = i;
+	}
+	for(i=0; i<TENTH_TC_RINGS; i++)
+	{
+		pthread_create(&providers[i], NULL, tenth_tc_provider, &provider_args[i]);
+	}
+	/* one thread serves all the ring buffers, without polling */
+	active = TENTH_TC_RINGS;
+	while(active != 0)
+	{
+		if(ring_buff_set_wait(set, events, TENTH_TC_RINGS, &count, RING_BUFF_SET_FOREVER) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+			break;
+		}
+		waits++;
+		for(i=0; i<count; i++)
+		{
+			tc_arg = (tenth_tc_arg_t *) events[i].arg;
+			while((err = ring_buff_try_claim(events[i].ring, (void**)&rec, &size)) == RING_BUFF_ERR_OK)
+			{
+				if(rec[0] != tc_arg->id || rec[1] != next[tc_arg->id])
+				{
+					failed++;
+				}
+				next[tc_arg->id]++;
+				loops++;
+				ring_buff_release(events[i].ring, rec);
+			}
+			/* provider is done, and everything is read */
+			if(err == RING_BUFF_ERR_PERM)
+			{
+				ring_buff_set_remove(set, events[i].ring);
+				active--;
+			}
+		}
+	}
+	for(i=0; i<TENTH_TC_RINGS; i++)
+	{
+		pthread_join(providers[i], NULL);
+	}
+
+done:
+	if(set != NULL)
+	{
+		ring_buff_set_destroy(set);
+	}
+	for(i=0; i<TENTH_TC_RINGS; i++)
+	{
+		if(provider_args[i].ring_buff != NULL)
+		{
+			ring_buff_destroy(provider_args[i].ring_buff);
+		}
+		free(buffs[i]);
+	}
+	if(loops != TENTH_TC_RINGS * TENTH_TC_LOOPS)
+	{
+		failed++;
+	}
+	printf(" LOOPS:  %u\n", loops);
+	printf(" WAITS:  %u\n", waits);
+	printf(" FAILED: %u\n", failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define ELEVENTH_TC_LOOPS     (200000)
+#define ELEVENTH_TC_BUFF_SIZE (16*1024)
+
+typedef struct eleventh_tc_arg
+{
+	unsigned long sum;
+	unsigned int loops;
+} eleventh_tc_arg_t;
+
+static ring_buff_err_t eleventh_tc_decode(ring_buff_pipeline_ctx_t ctx, void* buff, uint32_t size, void* arg)
+{
+	unsigned int *out;
+	ring_buff_err_t err;
+
+	(void)arg;
+	if(size != sizeof(unsigned int))
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	/* output is written straight into the next stage input */
+	err = ring_buff_pipeline_emit_reserve(ctx, (void**)&out, 2 * sizeof(unsigned int));
+	if(err != RING_BUFF_ERR_OK)
+	{
+		return err;
+	}
+	out[0] = *(unsigned int *)buff;
+	out[1] = out[0] * 2;
+	return ring_buff_pipeline_emit_commit(ctx, out, 2 * sizeof(unsigned int));
+}
+
+static ring_buff_err_t eleventh_tc_enrich(ring_buff_pipeline_ctx_t ctx, void* buff, uint32_t size, void* arg)
+{
+	unsigned int *in = (unsigned int *)buff;
+	unsigned int out;
+
+	(void)arg;
+	if(size != 2 * sizeof(unsigned int) || in[1] != in[0] * 2)
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	out = in[0] + 1;
+	return ring_buff_pipeline_emit(ctx, &out, sizeof(out));
+}
+
+static ring_buff_err_t eleventh_tc_sink(ring_buff_pipeline_ctx_t ctx, void* buff, uint32_t size, void* arg)
+{
+	eleventh_tc_arg_t *tc_arg = (eleventh_tc_arg_t *) arg;
+
+	(void)ctx;
+	if(size != sizeof(unsigned int))
+	{
+		return RING_BUFF_ERR_GENERAL;
+	}
+	/* single worker, no locking needed */
+	tc_arg->sum += *(unsigned int *)buff;
+	tc_arg->loops++;
+	return RING_BUFF_ERR_OK;
+}
+
+static void execute_eleventh_tc(void)
+{
+	ring_buff_pipeline_handle_t pipeline = NULL;
+	eleventh_tc_arg_t tc_arg = {0, 0};
+	ring_buff_stage_attr_t stages[3] = {
+			{eleventh_tc_decode, NULL, 2, 0},
+			{eleventh_tc_enrich, NULL, 2, 0},
+			{eleventh_tc_sink, NULL, 1, 0}};
+	ring_buff_stage_stats_t stats;
+	unsigned long expected = 0;
+	unsigned int failed = 0;
+	unsigned int *rec;
+	unsigned int i;
+
+	printf("************ Executing pipeline test ************\n");
+	stages[2].arg = &tc_arg;
+	if(ring_buff_pipeline_create(ELEVENTH_TC_BUFF_SIZE, &pipeline) != RING_BUFF_ERR_OK)
+	{
+		printf("*************** ERROR creating pipeline ****************\n");
+		failed++;
+		goto done;
+	}
+	for(i=0; i<3; i++)
+	{
+		ring_buff_pipeline_add_stage(pipeline, &stages[i]);
+	}
+	if(ring_buff_pipeline_start(pipeline) != RING_BUFF_ERR_OK)
+	{
+		printf("*************** ERROR starting pipeline ****************\n");
+		failed++;
+		goto done;
+	}
+	for(i=0; i<ELEVENTH_TC_LOOPS; i++)
+	{
+		if(ring_buff_pipeline_reserve(pipeline, (void**)&rec, sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			printf("*************** ERROR reserving buffer *****************\n");
+			failed++;
+			break;
+		}
+		*rec = i;
+		ring_buff_pipeline_commit(pipeline, rec, sizeof(unsigned int));
+		expected += i + 1;
+	}
+	ring_buff_pipeline_stop(pipeline);
+	for(i=0; i<3; i++)
+	{
+		ring_buff_pipeline_get_stats(pipeline, i, &stats);
+		printf(" STAGE %u: records %lu, errors %lu, busy %lu us, idle %lu us\n", i,
+				(unsigned long)stats.records, (unsigned long)stats.errors,
+				(unsigned long)stats.busy_us, (unsigned long)stats.idle_us);
+		if(stats.records != ELEVENTH_TC_LOOPS || stats.errors != 0)
+		{
+			failed++;
+		}
+	}
+	if(tc_arg.sum != expected)
+	{
+		failed++;
+	}
+
+done:
+	if(pipeline != NULL)
+	{
+		ring_buff_pipeline_destroy(pipeline);
+	}
+	printf(" LOOPS:  %u\n", tc_arg.loops);
+	printf(" FAILED: %u\n", failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define TWELFTH_TC_LOOPS     (20000)
+#define TWELFTH_TC_RINGS     (32)
+#define TWELFTH_TC_HOT       (4)
+#define TWELFTH_TC_WORKERS   (4)
+#define TWELFTH_TC_BATCH     (64)
+#define TWELFTH_TC_BUFF_SIZE (4*1024)
+
+typedef struct twelfth_tc_arg
+{
+	ring_buff_handle_t ring_buff;
+	unsigned int loops;
+	unsigned int next;
+	unsigned int failed;
+	unsigned int *done;
+} twelfth_tc_arg_t;
+
+void* twelfth_tc_provider(void* arg)
+{
+	twelfth_tc_arg_t *tc_arg = (twelfth_tc_arg_t *) arg;
+	unsigned int *rec;
+	unsigned int i;
+
+	for(i=0; i<tc_arg->loops; i++)
+	{
+		if(ring_buff_reserve(tc_arg->ring_buff, (void**)&rec, sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			printf("*************** ERROR reserving buffer *****************\n");
+			break;
+		}
+		*rec = i;
+		ring_buff_commit(tc_arg->ring_buff, rec, sizeof(unsigned int));
+	}
+	ring_buff_stop(tc_arg->ring_buff);
+	return NULL;
+}
+
+static ring_buff_err_t twelfth_tc_consumer(ring_buff_handle_t ring, void* arg)
+{
+	twelfth_tc_arg_t *tc_arg = (twelfth_tc_arg_t *) arg;
+	unsigned int *rec;
+	ring_buff_err_t err = RING_BUFF_ERR_OK;
+	uint32_t size;
+	unsigned int i;
+
+	/* bounded batch, the rest is consumed when scheduled again */
+	for(i=0; i<TWELFTH_TC_BATCH; i++)
+	{
+		err = ring_buff_try_claim(ring, (void**)&rec, &size);
+		if(err != RING_BUFF_ERR_OK)
+		{
+			break;
+		}
+		if(*rec != tc_arg->next)
+		{
+			tc_arg->failed++;
+		}
+		tc_arg->next++;
+		ring_buff_release(ring, rec);
+	}
+	/* provider is done, and everything is consumed */
+	if(err == RING_BUFF_ERR_PERM)
+	{
+		__sync_fetch_and_add(tc_arg->done, 1);
+		return err;
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+#define TWELFTH_TC_CHURN     (2000)
+
+typedef struct twelfth_tc_churn_arg
+{
+	ring_buff_handle_t ring_buff;
+	unsigned int stop;
+	unsigned int consumed;
+} twelfth_tc_churn_arg_t;
+
+void* twelfth_tc_churn_provider(void* arg)
+{
+	twelfth_tc_churn_arg_t *tc_arg = (twelfth_tc_churn_arg_t *) arg;
+	unsigned int *rec;
+
+	while(!__atomic_load_n(&tc_arg->stop, __ATOMIC_RELAXED))
+	{
+		if(ring_buff_reserve(tc_arg->ring_buff, (void**)&rec, sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			break;
+		}
+		ring_buff_commit(tc_arg->ring_buff, rec, sizeof(unsigned int));
+	}
+	return NULL;
+}
+
+static ring_buff_err_t twelfth_tc_churn_consumer(ring_buff_handle_t ring, void* arg)
+{
+	twelfth_tc_churn_arg_t *tc_arg = (twelfth_tc_churn_arg_t *) arg;
+	unsigned int *rec;
+	uint32_t size;
+	unsigned int i;
+
+	/* slow consumer, so that it is often running when it is removed */
+	usleep(50);
+	for(i=0; i<TWELFTH_TC_BATCH && ring_buff_try_claim(ring, (void**)&rec, &size) == RING_BUFF_ERR_OK; i++)
+	{
+		ring_buff_release(ring, rec);
+		__atomic_add_fetch(&tc_arg->consumed, 1, __ATOMIC_RELAXED);
+	}
+	return RING_BUFF_ERR_OK;
+}
+
+/* ring buffer is removed and added again, while producer keeps notifying it */
+static unsigned int twelfth_tc_churn(void)
+{
+	twelfth_tc_churn_arg_t tc_arg;
+	ring_buff_executor_handle_t executor = NULL;
+	ring_buff_attr_t ring_buff_attr;
+	pthread_t provider;
+	void *buff = NULL;
+	unsigned int failed = 0;
+	unsigned int i;
+
+	memset(&tc_arg, 0, sizeof(tc_arg));
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.size = TWELFTH_TC_BUFF_SIZE;
+	ring_buff_attr.records = 1;
+	if((buff = malloc(TWELFTH_TC_BUFF_SIZE)) == NULL ||
+			ring_buff_executor_create(TWELFTH_TC_WORKERS, 1, &executor) != RING_BUFF_ERR_OK)
+	{
+		free(buff);
+		return 1;
+	}
+	ring_buff_attr.buff = buff;
+	if(ring_buff_create(&ring_buff_attr, &tc_arg.ring_buff) != RING_BUFF_ERR_OK ||
+			ring_buff_executor_add(executor, tc_arg.ring_buff, twelfth_tc_churn_consumer, &tc_arg) != RING_BUFF_ERR_OK)
+	{
+		failed++;
+		goto done;
+	}
+	pthread_create(&provider, NULL, twelfth_tc_churn_provider, &tc_arg);
+	for(i=0; i<1000 && __atomic_load_n(&tc_arg.consumed, __ATOMIC_RELAXED) == 0; i++)
+	{
+		usleep(1000);
+	}
+	for(i=0; i<TWELFTH_TC_CHURN; i++)
+	{
+		/* let the provider and the workers run in between */
+		usleep(20);
+		if(ring_buff_executor_remove(executor, tc_arg.ring_buff) != RING_BUFF_ERR_OK ||
+				ring_buff_executor_add(executor, tc_arg.ring_buff, twelfth_tc_churn_consumer, &tc_arg) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+			break;
+		}
+	}
+	__atomic_store_n(&tc_arg.stop, 1, __ATOMIC_RELAXED);
+	ring_buff_cancel(tc_arg.ring_buff);
+	pthread_join(provider, NULL);
+	ring_buff_executor_remove(executor, tc_arg.ring_buff);
+	if(tc_arg.consumed == 0)
+	{
+		failed++;
+	}
+
+done:
+	ring_buff_executor_destroy(executor);
+	if(tc_arg.ring_buff != NULL)
+	{
+		ring_buff_destroy(tc_arg.ring_buff);
+	}
+	free(buff);
+	return failed;
+}
+
+static void execute_twelfth_tc(void)
+{
+	pthread_t providers[TWELFTH_TC_RINGS];
+	twelfth_tc_arg_t tc_args[TWELFTH_TC_RINGS];
+	void *buffs[TWELFTH_TC_RINGS];
+	ring_buff_executor_handle_t executor = NULL;
+	ring_buff_executor_stats_t stats;
+	ring_buff_attr_t ring_buff_attr;
+	unsigned int loops = 0;
+	unsigned int failed = 0;
+	unsigned int done = 0;
+	unsigned int started = 0;
+	unsigned int i;
+
+	printf("************ Executing work-stealing executor test ************\n");
+	memset(tc_args, 0, sizeof(tc_args));
+	memset(buffs, 0, sizeof(buffs));
+	if(ring_buff_executor_create(TWELFTH_TC_WORKERS, TWELFTH_TC_RINGS, &executor) != RING_BUFF_ERR_OK)
+	{
+		printf("*************** ERROR creating executor ****************\n");
+		failed++;
+		goto done;
+	}
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.size = TWELFTH_TC_BUFF_SIZE;
+	ring_buff_attr.records = 1;
+	for(i=0; i<TWELFTH_TC_RINGS; i++)
+	{
+		if((buffs[i] = malloc(TWELFTH_TC_BUFF_SIZE)) == NULL)
+		{
+			printf("****************** ERROR no memory *****************\n");
+			failed++;
+			goto done;
+		}
+		ring_buff_attr.buff = buffs[i];
+		/* few hot ring buffers, and many cold ones */
+		tc_args[i].loops = (i < TWELFTH_TC_HOT) ? TWELFTH_TC_LOOPS * 10 : TWELFTH_TC_LOOPS;
+		tc_args[i].done = &done;
+		if(ring_buff_create(&ring_buff_attr, &tc_args[i].ring_buff) != RING_BUFF_ERR_OK ||
+				ring_buff_executor_add(executor, tc_args[i].ring_buff, twelfth_tc_consumer, &tc_args[i]) != RING_BUFF_ERR_OK)
+		{
+			printf("************** ERROR creating ring buffer **************\n");
+			failed++;
+			goto done;
+		}
+	}
+	for(started=0; started<TWELFTH_TC_RINGS; started++)
+	{
+		pthread_create(&providers[started], NULL, twelfth_tc_provider, &tc_args[started]);
+	}
+	/* consumers report when their ring buffers are stopped and drained */
+	while(__sync_fetch_and_add(&done, 0) != TWELFTH_TC_RINGS)
+	{
+		usleep(1000);
+	}
+	ring_buff_executor_get_stats(executor, &stats);
+	printf(" RUNS:   %lu\n", (unsigned long)stats.runs);
+	printf(" STEALS: %lu\n", (unsigned long)stats.steals);
+	failed += twelfth_tc_churn();
+
+done:
+	for(i=0; i<started; i++)
+	{
+		pthread_join(providers[i], NULL);
+	}
+	if(executor != NULL)
+	{
+		ring_buff_executor_destroy(executor);
+	}
+	for(i=0; i<TWELFTH_TC_RINGS; i++)
+	{
+		if(tc_args[i].ring_buff != NULL)
+		{
+			ring_buff_destroy(tc_args[i].ring_buff);
+		}
+		free(buffs[i]);
+		if(tc_args[i].next != tc_args[i].loops)
+		{
+			failed++;
+		}
+		failed += tc_args[i].failed;
+		loops += tc_args[i].next;
+	}
+	printf(" LOOPS:  %u\n", loops);
+	printf(" FAILED: %u\n", failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define THIRTEENTH_TC_LOOPS     (100000)
+#define THIRTEENTH_TC_KEEP      (100)
+#define THIRTEENTH_TC_BUFF_SIZE (16*1024)
+#define THIRTEENTH_TC_PATH      "/tmp/ring_buff_test.dat"
+
+static void thirteenth_tc_writer(void)
+{
+	ring_buff_handle_t ring_buff = NULL;
+	ring_buff_attr_t ring_buff_attr;
+	unsigned int *rec;
+	uint32_t size;
+	unsigned int i;
+
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.size = THIRTEENTH_TC_BUFF_SIZE;
+	ring_buff_attr.records = 1;
+	ring_buff_attr.path = THIRTEENTH_TC_PATH;
+	ring_buff_attr.sync_batch = 16;
+	if(ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+	{
+		_exit(1);
+	}
+	/* the last KEEP records are not consumed */
+	for(i=0; i<THIRTEENTH_TC_LOOPS; i++)
+	{
+		if(ring_buff_reserve(ring_buff, (void**)&rec, sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			_exit(1);
+		}
+		*rec = i;
+		ring_buff_commit(ring_buff, rec, sizeof(unsigned int));
+		if(i >= THIRTEENTH_TC_KEEP)
+		{
+			if(ring_buff_claim(ring_buff, (void**)&rec, &size) != RING_BUFF_ERR_OK || *rec != i - THIRTEENTH_TC_KEEP)
+			{
+				_exit(1);
+			}
+			ring_buff_release(ring_buff, rec);
+		}
+	}
+	ring_buff_sync(ring_buff);
+	/* record that is not synced, and it is torn by the crash */
+	ring_buff_reserve(ring_buff, (void**)&rec, sizeof(unsigned int));
+	*rec = i;
+	ring_buff_commit(ring_buff, rec, sizeof(unsigned int));
+	*rec = 0;
+	/* crash (buffer is not destroyed) */
+	_exit(0);
+}
+
+static void execute_thirteenth_tc(void)
+{
+	ring_buff_handle_t ring_buff = NULL;
+	ring_buff_attr_t ring_buff_attr;
+	unsigned int failed = 0;
+	unsigned int loops = 0;
+	unsigned int *rec;
+	uint32_t size;
+	int status = 0;
+	pid_t pid;
+
+	printf("************ Executing persistent ring buffer test ************\n");
+	unlink(THIRTEENTH_TC_PATH);
+	pid = fork();
+	if(pid == 0)
+	{
+		thirteenth_tc_writer();
+	}
+	if(pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	{
+		printf("**************** ERROR in writer process ***************\n");
+		failed++;
+		goto done;
+	}
+	/* reopen, and get the records that were not released */
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.size = THIRTEENTH_TC_BUFF_SIZE;
+	ring_buff_attr.records = 1;
+	ring_buff_attr.path = THIRTEENTH_TC_PATH;
+	if(ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+	{
+		printf("************** ERROR creating ring buffer **************\n");
+		failed++;
+		goto done;
+	}
+	while(ring_buff_try_claim(ring_buff, (void**)&rec, &size) == RING_BUFF_ERR_OK)
+	{
+		if(size != sizeof(unsigned int) || *rec != THIRTEENTH_TC_LOOPS - THIRTEENTH_TC_KEEP + loops)
+		{
+			failed++;
+		}
+		loops++;
+		ring_buff_release(ring_buff, rec);
+	}
+	if(loops != THIRTEENTH_TC_KEEP)
+	{
+		failed++;
+	}
+	ring_buff_destroy(ring_buff);
+
+done:
+	unlink(THIRTEENTH_TC_PATH);
+	printf(" LOOPS:  %u\n", loops);
+	printf(" FAILED: %u\n", failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define FOURTEENTH_TC_LOOPS     (200000)
+#define FOURTEENTH_TC_BUFF_SIZE (16*1024)
+#define FOURTEENTH_TC_PATH      "/tmp/ring_buff_spill.dat"
+
+typedef struct fourteenth_tc_arg
+{
+	ring_buff_handle_t ring_buff;
+	unsigned int loops;
+	unsigned int failed;
+} fourteenth_tc_arg_t;
+
+void* fourteenth_tc_consumer(void* arg)
+{
+	fourteenth_tc_arg_t *tc_arg = (fourteenth_tc_arg_t *) arg;
+	unsigned int *rec;
+	uint32_t size;
+
+	while(ring_buff_claim(tc_arg->ring_buff, (void**)&rec, &size) == RING_BUFF_ERR_OK)
+	{
+		if(size != sizeof(unsigned int) || *rec != tc_arg->loops)
+		{
+			tc_arg->failed++;
+		}
+		tc_arg->loops++;
+		ring_buff_release(tc_arg->ring_buff, rec);
+		/* consumer is slow at times, so that producer gets over the high watermark */
+		if(tc_arg->loops % 20000 == 0)
+		{
+			usleep(20000);
+		}
+	}
+	return NULL;
+}
+
+#define FOURTEENTH_TC_ORDER_SIZE  (1024)
+#define FOURTEENTH_TC_ORDER_LOOPS (200)
+
+/* record reserved in the buffer before the spilling starts is claimed before the spilled ones, even if it is committed late */
+static unsigned int fourteenth_tc_order(void *buff)
+{
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_handle_t ring_buff = NULL;
+	unsigned int *first, *rec;
+	unsigned int i, failed = 0;
+	uint32_t size;
+
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = FOURTEENTH_TC_ORDER_SIZE;
+	ring_buff_attr.records = 1;
+	ring_buff_attr.spill_path = FOURTEENTH_TC_PATH;
+	if(ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+	{
+		return 1;
+	}
+	if(ring_buff_reserve(ring_buff, (void**)&first, sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+	{
+		failed++;
+		goto done;
+	}
+	*first = 0;
+	/* buffer gets full, so the rest of the records are spilled */
+	for(i=1; i<FOURTEENTH_TC_ORDER_LOOPS; i++)
+	{
+		if(ring_buff_reserve(ring_buff, (void**)&rec, sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+			goto done;
+		}
+		*rec = i;
+		ring_buff_commit(ring_buff, rec, sizeof(unsigned int));
+	}
+	if(ring_buff_try_claim(ring_buff, (void**)&rec, &size) != RING_BUFF_ERR_WOULD_BLOCK)
+	{
+		failed++;
+		goto done;
+	}
+	ring_buff_commit(ring_buff, first, sizeof(unsigned int));
+	for(i=0; i<FOURTEENTH_TC_ORDER_LOOPS; i++)
+	{
+		if(ring_buff_try_claim(ring_buff, (void**)&rec, &size) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+			break;
+		}
+		if(*rec != i)
+		{
+			failed++;
+		}
+		ring_buff_release(ring_buff, rec);
+	}
+
+done:
+	ring_buff_destroy(ring_buff);
+	return failed;
+}
+
+static void execute_fourteenth_tc(void)
+{
+	fourteenth_tc_arg_t tc_arg;
+	ring_buff_attr_t ring_buff_attr;
+	pthread_t consumer;
+	struct timespec start, end;
+	unsigned int *rec;
+	unsigned int i;
+	void *buff = NULL;
+	long max_us = 0, us;
+
+	printf("************ Executing spill to disk test ************\n");
+	memset(&tc_arg, 0, sizeof(tc_arg));
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	if((buff = malloc(FOURTEENTH_TC_BUFF_SIZE)) == NULL)
+	{
+		printf("****************** ERROR no memory *****************\n");
+		tc_arg.failed++;
+		goto done;
+	}
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = FOURTEENTH_TC_BUFF_SIZE;
+	ring_buff_attr.records = 1;
+	ring_buff_attr.wm_high = FOURTEENTH_TC_BUFF_SIZE / 2;
+	ring_buff_attr.wm_low = FOURTEENTH_TC_BUFF_SIZE / 8;
+	ring_buff_attr.spill_path = FOURTEENTH_TC_PATH;
+	if(ring_buff_create(&ring_buff_attr, &tc_arg.ring_buff) != RING_BUFF_ERR_OK)
+	{
+		printf("************** ERROR creating ring buffer **************\n");
+		tc_arg.failed++;
+		goto done;
+	}
+	pthread_create(&consumer, NULL, fourteenth_tc_consumer, &tc_arg);
+	for(i=0; i<FOURTEENTH_TC_LOOPS; i++)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if(ring_buff_reserve(tc_arg.ring_buff, (void**)&rec, sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			printf("*************** ERROR reserving buffer *****************\n");
+			tc_arg.failed++;
+			break;
+		}
+		*rec = i;
+		ring_buff_commit(tc_arg.ring_buff, rec, sizeof(unsigned int));
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+		if(us > max_us)
+		{
+			max_us = us;
+		}
+	}
+	ring_buff_stop(tc_arg.ring_buff);
+	pthread_join(consumer, NULL);
+	ring_buff_destroy(tc_arg.ring_buff);
+	/* producer is never blocked by the slow consumer */
+	printf(" MAX PRODUCER LATENCY: %ld us\n", max_us);
+	if(tc_arg.loops != FOURTEENTH_TC_LOOPS)
+	{
+		tc_arg.failed++;
+	}
+	tc_arg.failed += fourteenth_tc_order(buff);
+
+done:
+	free(buff);
+	unlink(FOURTEENTH_TC_PATH);
+	printf(" LOOPS:  %u\n", tc_arg.loops);
+	printf(" FAILED: %u\n", tc_arg.failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define FIFTEENTH_TC_LOOPS     (100000)
+#define FIFTEENTH_TC_BUFF_SIZE (4*1024)
+#define FIFTEENTH_TC_SIZE_MAX  (64*1024)
+
+typedef struct fifteenth_tc_arg
+{
+	ring_buff_handle_t ring_buff;
+	unsigned int loops;
+	unsigned int failed;
+} fifteenth_tc_arg_t;
+
+void* fifteenth_tc_consumer(void* arg)
+{
+	fifteenth_tc_arg_t *tc_arg = (fifteenth_tc_arg_t *) arg;
+	unsigned int *rec;
+	uint32_t size;
+
+	while(ring_buff_claim(tc_arg->ring_buff, (void**)&rec, &size) == RING_BUFF_ERR_OK)
+	{
+		if(*rec != tc_arg->loops)
+		{
+			tc_arg->failed++;
+		}
+		tc_arg->loops++;
+		ring_buff_release(tc_arg->ring_buff, rec);
+		/* consumer is slow in the first half, so that buffer has to grow */
+		if(tc_arg->loops < FIFTEENTH_TC_LOOPS / 2 && tc_arg->loops % 100 == 0)
+		{
+			usleep(1000);
+		}
+	}
+	return NULL;
+}
+
+static void execute_fifteenth_tc(void)
+{
+	fifteenth_tc_arg_t tc_arg;
+	ring_buff_attr_t ring_buff_attr;
+	pthread_t consumer;
+	unsigned int *rec;
+	unsigned int i;
+	uint32_t size = 0, max_size = 0;
+	void *buff = NULL;
+
+	printf("************ Executing elastic ring buffer test ************\n");
+	memset(&tc_arg, 0, sizeof(tc_arg));
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	if((buff = malloc(FIFTEENTH_TC_BUFF_SIZE)) == NULL)
+	{
+		printf("****************** ERROR no memory *****************\n");
+		tc_arg.failed++;
+		goto done;
+	}
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = FIFTEENTH_TC_BUFF_SIZE;
+	ring_buff_attr.records = 1;
+	ring_buff_attr.wm_high = FIFTEENTH_TC_BUFF_SIZE / 2;
+	ring_buff_attr.wm_low = FIFTEENTH_TC_BUFF_SIZE / 8;
+	ring_buff_attr.size_max = FIFTEENTH_TC_SIZE_MAX;
+	ring_buff_attr.shrink_us = 20000;
+	if(ring_buff_create(&ring_buff_attr, &tc_arg.ring_buff) != RING_BUFF_ERR_OK)
+	{
+		printf("************** ERROR creating ring buffer **************\n");
+		tc_arg.failed++;
+		goto done;
+	}
+	pthread_create(&consumer, NULL, fifteenth_tc_consumer, &tc_arg);
+	for(i=0; i<FIFTEENTH_TC_LOOPS; i++)
+	{
+		if(ring_buff_reserve(tc_arg.ring_buff, (void**)&rec, 4 * sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			printf("*************** ERROR reserving buffer *****************\n");
+			tc_arg.failed++;
+			break;
+		}
+		*rec = i;
+		ring_buff_commit(tc_arg.ring_buff, rec, 4 * sizeof(unsigned int));
+		ring_buff_get_size(tc_arg.ring_buff, &size);
+		if(size > max_size)
+		{
+			max_size = size;
+		}
+	}
+	/* producer is idle now (it writes now and then), so buffer shrinks back step by step */
+	while(size != FIFTEENTH_TC_BUFF_SIZE && i < FIFTEENTH_TC_LOOPS + 100)
+	{
+		usleep(25000);
+		if(ring_buff_reserve(tc_arg.ring_buff, (void**)&rec, sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			tc_arg.failed++;
+			break;
+		}
+		*rec = i++;
+		ring_buff_commit(tc_arg.ring_buff, rec, sizeof(unsigned int));
+		ring_buff_get_size(tc_arg.ring_buff, &size);
+	}
+	ring_buff_stop(tc_arg.ring_buff);
+	pthread_join(consumer, NULL);
+	ring_buff_destroy(tc_arg.ring_buff);
+	printf(" MAX SIZE:   %u\n", max_size);
+	printf(" FINAL SIZE: %u\n", size);
+	if(tc_arg.loops != i || max_size <= FIFTEENTH_TC_BUFF_SIZE || size != FIFTEENTH_TC_BUFF_SIZE)
+	{
+		tc_arg.failed++;
+	}
+
+done:
+	free(buff);
+	printf(" LOOPS:  %u\n", tc_arg.loops);
+	printf(" FAILED: %u\n", tc_arg.failed);
+	printf("************************* DONE *************************\n");
+}
+
+/* stream goes over 4 GB, so that offsets do not fit into 32 bits */
+#define SIXTEENTH_TC_STREAM    ((uint64_t)9 << 29)
+#define SIXTEENTH_TC_BUFF_SIZE (1024*1024)
+#define SIXTEENTH_TC_CHUNK     (64*1024)
+
+typedef struct sixteenth_tc_arg
+{
+	ring_buff64_handle_t ring_buff;
+	uint64_t read;
+	unsigned int failed;
+} sixteenth_tc_arg_t;
+
+void* sixteenth_tc_consumer(void* arg)
+{
+	sixteenth_tc_arg_t *tc_arg = (sixteenth_tc_arg_t *) arg;
+	uint64_t *data;
+	uint64_t size, read, off;
+	unsigned int seed = 1;
+
+	for(;;)
+	{
+		size = 8 * (1 + rand_r(&seed) % (SIXTEENTH_TC_CHUNK / 8));
+		if(ring_buff64_read(tc_arg->ring_buff, (void**)&data, size, &read, &off) != RING_BUFF_ERR_OK && read == 0)
+		{
+			break;
+		}
+		/* every word contains its own stream offset */
+		if(off != tc_arg->read || data[0] != off || data[read / 8 - 1] != off + read - 8)
+		{
+			tc_arg->failed++;
+		}
+		tc_arg->read += read;
+		ring_buff64_free(tc_arg->ring_buff, data, read);
+	}
+	return NULL;
+}
+
+static void execute_sixteenth_tc(void)
+{
+	sixteenth_tc_arg_t tc_arg;
+	ring_buff64_attr_t ring_buff_attr;
+	pthread_t consumer;
+	uint64_t *data;
+	uint64_t size, off, i, read, commit, written = 0;
+	unsigned int seed = 2;
+	struct timespec start, end;
+	void *buff = NULL;
+
+	printf("************ Executing 64-bit ring buffer test *************\n");
+	memset(&tc_arg, 0, sizeof(tc_arg));
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	if((buff = malloc(SIXTEENTH_TC_BUFF_SIZE)) == NULL)
+	{
+		printf("****************** ERROR no memory *****************\n");
+		tc_arg.failed++;
+		goto done;
+	}
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = SIXTEENTH_TC_BUFF_SIZE;
+	if(ring_buff64_create(&ring_buff_attr, &tc_arg.ring_buff) != RING_BUFF_ERR_OK)
+	{
+		printf("************** ERROR creating ring buffer **************\n");
+		tc_arg.failed++;
+		goto done;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_create(&consumer, NULL, sixteenth_tc_consumer, &tc_arg);
+	while(written < SIXTEENTH_TC_STREAM)
+	{
+		size = 8 * (1 + rand_r(&seed) % (SIXTEENTH_TC_CHUNK / 8));
+		if(ring_buff64_reserve(tc_arg.ring_buff, (void**)&data, size, &off) != RING_BUFF_ERR_OK || off != written)
+		{
+			printf("*************** ERROR reserving buffer *****************\n");
+			tc_arg.failed++;
+			break;
+		}
+		for(i = 0; i < size / 8; i++)
+		{
+			data[i] = off + 8 * i;
+		}
+		ring_buff64_commit(tc_arg.ring_buff, data, size);
+		written += size;
+	}
+	ring_buff64_stop(tc_arg.ring_buff);
+	pthread_join(consumer, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	ring_buff64_get_offsets(tc_arg.ring_buff, &read, &commit);
+	ring_buff64_destroy(tc_arg.ring_buff);
+	if(tc_arg.read != written || read != written || commit != written)
+	{
+		tc_arg.failed++;
+	}
+	printf(" STREAM: %lu MB\n", (unsigned long)(written >> 20));
+	printf(" TIME:   %ld ms\n", (long)((end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000));
+
+done:
+	free(buff);
+	printf(" FAILED: %u\n", tc_arg.failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define SEVENTEENTH_TC_LOOPS     (100000)
+#define SEVENTEENTH_TC_BUFF_SIZE (4*1024)
+
+static void execute_seventeenth_tc(void)
+{
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_handle_t ring_buff;
+	struct timespec start, end;
+	long create_us = 0, init_us = 0;
+	uint32_t storage_size = 0, read = 0;
+	unsigned int i, failed = 0;
+	void *storage = NULL;
+	void *buff = NULL;
+	char *data;
+
+	printf("************ Executing in-place ring buffer test ***********\n");
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.size = SEVENTEENTH_TC_BUFF_SIZE;
+	ring_buff_attr.free_slots = 8;
+	storage_size = ring_buff_get_storage_size(&ring_buff_attr);
+	if((buff = malloc(SEVENTEENTH_TC_BUFF_SIZE)) == NULL ||
+			posix_memalign(&storage, RING_BUFF_STORAGE_ALIGN, storage_size) != 0)
+	{
+		printf("****************** ERROR no memory *****************\n");
+		failed++;
+		goto done;
+	}
+	ring_buff_attr.buff = buff;
+	/* storage has to be large enough, and it can not hold resources of e.g. linger timer */
+	if(ring_buff_init(&ring_buff_attr, storage, storage_size - 1, &ring_buff) != RING_BUFF_ERR_SIZE)
+	{
+		failed++;
+	}
+	ring_buff_attr.linger_us = 1000;
+	if(ring_buff_init(&ring_buff_attr, storage, storage_size, &ring_buff) != RING_BUFF_ERR_PERM)
+	{
+		failed++;
+	}
+	ring_buff_attr.linger_us = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < SEVENTEENTH_TC_LOOPS && failed == 0; i++)
+	{
+		if(ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+			break;
+		}
+		ring_buff_destroy(ring_buff);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	create_us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < SEVENTEENTH_TC_LOOPS && failed == 0; i++)
+	{
+		if(ring_buff_init(&ring_buff_attr, storage, storage_size, &ring_buff) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+			break;
+		}
+		ring_buff_destroy(ring_buff);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	init_us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+	/* buffer in the storage works as the allocated one */
+	if(failed == 0 && ring_buff_init(&ring_buff_attr, storage, storage_size, &ring_buff) == RING_BUFF_ERR_OK)
+	{
+		for(i = 0; i < 1000; i++)
+		{
+			ring_buff_reserve(ring_buff, (void**)&data, 100);
+			sprintf(data, "%u", i);
+			ring_buff_commit(ring_buff, data, 100);
+			ring_buff_read(ring_buff, (void**)&data, 100, &read);
+			if(read != 100 || (unsigned int)atoi(data) != i)
+			{
+				failed++;
+			}
+			ring_buff_free(ring_buff, data, read);
+		}
+		ring_buff_destroy(ring_buff);
+	}
+	printf(" STORAGE: %u bytes\n", storage_size);
+	printf(" CREATE:  %ld us\n", create_us);
+	printf(" INIT:    %ld us\n", init_us);
+
+done:
+	free(storage);
+	free(buff);
+	printf(" FAILED: %u\n", failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define EIGHTEENTH_TC_LOOPS (100000)
+
+static void execute_eighteenth_tc(void)
+{
+	ring_buff_pool_class_t classes[2];
+	ring_buff_pool_attr_t pool_attr;
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_pool_handle_t pool = NULL;
+	ring_buff_handle_t ring_buff, rings[8];
+	struct timespec start, end;
+	long alloc_us = 0, pool_us = 0;
+	uint32_t idle = 0, used = 0, read = 0;
+	uint64_t freed = 0;
+	unsigned int i, failed = 0;
+	void *buff = NULL;
+	char *data;
+
+	printf("************** Executing ring buffer pool test *************\n");
+	memset(&pool_attr, 0, sizeof(pool_attr));
+	memset(classes, 0, sizeof(classes));
+	/* classes do not have to be sorted */
+	classes[0].size = 64*1024;
+	classes[0].count = 2;
+	classes[0].max = 8;
+	classes[1].size = 4*1024;
+	classes[1].count = 16;
+	pool_attr.classes = classes;
+	pool_attr.class_count = 2;
+	if(ring_buff_pool_create(&pool_attr, &pool) != RING_BUFF_ERR_OK)
+	{
+		printf("*************** ERROR creating ring pool ***************\n");
+		failed++;
+		goto done;
+	}
+	/* connection setup and teardown with the pool */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < EIGHTEENTH_TC_LOOPS; i++)
+	{
+		if(ring_buff_pool_acquire(pool, 4000, &ring_buff) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+			break;
+		}
+		/* data left in the ring is dropped on release */
+		ring_buff_reserve(ring_buff, (void**)&data, 1000);
+		sprintf(data, "%u", i);
+		ring_buff_commit(ring_buff, data, 1000);
+		ring_buff_read(ring_buff, (void**)&data, 1000, &read);
+		if(read != 1000 || (unsigned int)atoi(data) != i)
+		{
+			failed++;
+		}
+		ring_buff_pool_release(pool, ring_buff);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	pool_us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+	/* the same with the allocated buffer */
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < EIGHTEENTH_TC_LOOPS; i++)
+	{
+		buff = malloc(4*1024);
+		ring_buff_attr.buff = buff;
+		ring_buff_attr.size = 4*1024;
+		if(buff == NULL || ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+			free(buff);
+			break;
+		}
+		ring_buff_reserve(ring_buff, (void**)&data, 1000);
+		ring_buff_commit(ring_buff, data, 1000);
+		ring_buff_read(ring_buff, (void**)&data, 1000, &read);
+		ring_buff_destroy(ring_buff);
+		free(buff);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	alloc_us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+	/* large class grows on demand up to its maximum */
+	for(i = 0; i < 8; i++)
+	{
+		if(ring_buff_pool_acquire(pool, 8000, &rings[i]) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+		}
+	}
+	if(ring_buff_pool_acquire(pool, 8000, &ring_buff) != RING_BUFF_ERR_WOULD_BLOCK ||
+			ring_buff_pool_acquire(pool, 1024*1024, &ring_buff) != RING_BUFF_ERR_SIZE ||
+			ring_buff_pool_destroy(pool) != RING_BUFF_ERR_PERM)
+	{
+		failed++;
+	}
+	for(i = 0; i < 8; i++)
+	{
+		ring_buff_pool_release(pool, rings[i]);
+	}
+	ring_buff_pool_get_count(pool, &idle, &used);
+	if(idle != 24 || used != 0)
+	{
+		failed++;
+	}
+	/* memory pressure */
+	ring_buff_pool_trim(pool, 1, &freed);
+	ring_buff_pool_get_count(pool, &idle, &used);
+	if(idle != 2 || freed < 7*64*1024 + 15*4*1024)
+	{
+		failed++;
+	}
+	printf(" POOL:   %ld us\n", pool_us);
+	printf(" ALLOC:  %ld us\n", alloc_us);
+	printf(" FREED:  %lu bytes\n", (unsigned long)freed);
+
+done:
+	if(pool != NULL)
+	{
+		ring_buff_pool_destroy(pool);
+	}
+	printf(" FAILED: %u\n", failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define NINETEENTH_TC_BUFF_SIZE (16*1024*1024)
+#define NINETEENTH_TC_CHUNK     (60000)
+
+/* resident memory in KB */
+static unsigned long nineteenth_tc_rss(void)
+{
+	unsigned long size = 0, resident = 0;
+	FILE *f = fopen("/proc/self/statm", "r");
+
+	if(f != NULL)
+	{
+		if(fscanf(f, "%lu %lu", &size, &resident) != 2)
+		{
+			resident = 0;
+		}
+		fclose(f);
+	}
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* with the default (zero) watermark, buffer is idle when it is empty */
+static unsigned int nineteenth_tc_default_wm(void *buff)
+{
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_handle_t ring_buff = NULL;
+	uint32_t read = 0, released = 0;
+	unsigned int i, failed = 0;
+	char *data;
+
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = NINETEENTH_TC_BUFF_SIZE;
+	ring_buff_attr.reclaim_us = 20000;
+	if(ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+	{
+		return 1;
+	}
+	for(i = 0; i < NINETEENTH_TC_BUFF_SIZE / NINETEENTH_TC_CHUNK + 1; i++)
+	{
+		ring_buff_reserve(ring_buff, (void**)&data, NINETEENTH_TC_CHUNK);
+		memset(data, i, NINETEENTH_TC_CHUNK);
+		ring_buff_commit(ring_buff, data, NINETEENTH_TC_CHUNK);
+		ring_buff_read(ring_buff, (void**)&data, NINETEENTH_TC_CHUNK, &read);
+		ring_buff_free(ring_buff, data, read);
+	}
+	if(ring_buff_reclaim(ring_buff, &released) != RING_BUFF_ERR_OK || released == 0)
+	{
+		failed++;
+	}
+	printf(" RECLAIMED (wm_low 0): %u bytes\n", released);
+	ring_buff_destroy(ring_buff);
+
+	return failed;
+}
+
+static void execute_nineteenth_tc(void)
+{
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_handle_t ring_buff = NULL;
+	unsigned long rss_burst = 0, rss_idle = 0;
+	uint32_t read = 0, released = 0;
+	unsigned int i, failed = 0;
+	void *buff = NULL;
+	char *data;
+
+	printf("********** Executing idle page reclamation test ************\n");
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	if((buff = malloc(NINETEENTH_TC_BUFF_SIZE)) == NULL)
+	{
+		printf("****************** ERROR no memory *****************\n");
+		failed++;
+		goto done;
+	}
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = NINETEENTH_TC_BUFF_SIZE;
+	ring_buff_attr.wm_low = 1024*1024;
+	ring_buff_attr.wm_high = 2*1024*1024;
+	ring_buff_attr.reclaim_us = 20000;
+	if(ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+	{
+		printf("************** ERROR creating ring buffer **************\n");
+		failed++;
+		goto done;
+	}
+	/* burst goes through the whole buffer, so all of its pages are resident */
+	for(i = 0; i < 2 * NINETEENTH_TC_BUFF_SIZE / NINETEENTH_TC_CHUNK; i++)
+	{
+		ring_buff_reserve(ring_buff, (void**)&data, NINETEENTH_TC_CHUNK);
+		memset(data, i, NINETEENTH_TC_CHUNK);
+		ring_buff_commit(ring_buff, data, NINETEENTH_TC_CHUNK);
+		ring_buff_read(ring_buff, (void**)&data, NINETEENTH_TC_CHUNK, &read);
+		ring_buff_free(ring_buff, data, read);
+	}
+	rss_burst = nineteenth_tc_rss();
+	/* low traffic after the burst, buffer is idle long enough */
+	usleep(50000);
+	for(i = 0; i < 10; i++)
+	{
+		ring_buff_reserve(ring_buff, (void**)&data, 100);
+		sprintf(data, "%u", i);
+		ring_buff_commit(ring_buff, data, 100);
+		ring_buff_read(ring_buff, (void**)&data, 100, &read);
+		if((unsigned int)atoi(data) != i)
+		{
+			failed++;
+		}
+		ring_buff_free(ring_buff, data, read);
+	}
+	rss_idle = nineteenth_tc_rss();
+	if(rss_burst < rss_idle + NINETEENTH_TC_BUFF_SIZE / 2 / 1024)
+	{
+		failed++;
+	}
+	/* pages are faulted in on the next burst */
+	for(i = 0; i < NINETEENTH_TC_BUFF_SIZE / NINETEENTH_TC_CHUNK; i++)
+	{
+		ring_buff_reserve(ring_buff, (void**)&data, NINETEENTH_TC_CHUNK);
+		memset(data, i, NINETEENTH_TC_CHUNK);
+		ring_buff_commit(ring_buff, data, NINETEENTH_TC_CHUNK);
+		ring_buff_read(ring_buff, (void**)&data, NINETEENTH_TC_CHUNK, &read);
+		if(read != NINETEENTH_TC_CHUNK || data[0] != (char)i || data[read - 1] != (char)i)
+		{
+			failed++;
+		}
+		ring_buff_free(ring_buff, data, read);
+	}
+	/* buffer that is idle right after the burst is reclaimed on request */
+	if(ring_buff_reclaim(ring_buff, &released) != RING_BUFF_ERR_OK || released == 0)
+	{
+		failed++;
+	}
+	printf(" RSS BURST: %lu KB\n", rss_burst);
+	printf(" RSS IDLE:  %lu KB\n", rss_idle);
+	printf(" RECLAIMED: %u bytes\n", released);
+	ring_buff_destroy(ring_buff);
+	ring_buff = NULL;
+	failed += nineteenth_tc_default_wm(buff);
+
+done:
+	if(ring_buff != NULL)
+	{
+		ring_buff_destroy(ring_buff);
+	}
+	free(buff);
+	printf(" FAILED: %u\n", failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define TWENTIETH_TC_LOOPS     (2000000)
+#define TWENTIETH_TC_BUFF_SIZE (64*1024)
+
+typedef struct twentieth_tc_arg
+{
+	unsigned int next;
+	unsigned int failed;
+} twentieth_tc_arg_t;
+
+static twentieth_tc_arg_t twentieth_tc_arg;
+
+static ring_buff_err_t twentieth_tc_notify(ring_buff_handle_t handle, void* buff, uint32_t size)
+{
+	unsigned int *data = buff;
+	uint32_t i;
+
+	/* producer consumes its own data, on the same thread */
+	for(i = 0; i < size / sizeof(unsigned int); i += 4)
+	{
+		if(data[i] != twentieth_tc_arg.next++)
+		{
+			twentieth_tc_arg.failed++;
+		}
+	}
+	return ring_buff_free(handle, buff, size);
+}
+
+static long twentieth_tc_run(uint8_t single_thread)
+{
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_handle_t ring_buff = NULL;
+	struct timespec start, end;
+	unsigned int *data;
+	unsigned int i;
+	void *buff = NULL;
+
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	if((buff = malloc(TWENTIETH_TC_BUFF_SIZE)) == NULL)
+	{
+		twentieth_tc_arg.failed++;
+		return 0;
+	}
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = TWENTIETH_TC_BUFF_SIZE;
+	ring_buff_attr.accumulate = 4096;
+	ring_buff_attr.notify_func = twentieth_tc_notify;
+	ring_buff_attr.single_thread = single_thread;
+	if(ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+	{
+		twentieth_tc_arg.failed++;
+		free(buff);
+		return 0;
+	}
+	twentieth_tc_arg.next = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < TWENTIETH_TC_LOOPS; i++)
+	{
+		if(ring_buff_reserve(ring_buff, (void**)&data, 4 * sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			twentieth_tc_arg.failed++;
+			break;
+		}
+		data[0] = i;
+		ring_buff_commit(ring_buff, data, 4 * sizeof(unsigned int));
+	}
+	ring_buff_flush(ring_buff);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if(twentieth_tc_arg.next != TWENTIETH_TC_LOOPS)
+	{
+		twentieth_tc_arg.failed++;
+	}
+	ring_buff_destroy(ring_buff);
+	free(buff);
+	return (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+}
+
+static void execute_twentieth_tc(void)
+{
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_handle_t ring_buff = NULL;
+	long locked_us, st_us;
+	uint32_t read = 0;
+	char buff[256];
+	void *data;
+
+	printf("********** Executing single-threaded ring buffer test **********\n");
+	memset(&twentieth_tc_arg, 0, sizeof(twentieth_tc_arg));
+	locked_us = twentieth_tc_run(0);
+	st_us = twentieth_tc_run(1);
+	/* there is nobody to wait for */
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = sizeof(buff);
+	ring_buff_attr.single_thread = 1;
+	if(ring_buff_create(&ring_buff_attr, &ring_buff) == RING_BUFF_ERR_OK)
+	{
+		if(ring_buff_read(ring_buff, &data, 16, &read) != RING_BUFF_ERR_WOULD_BLOCK ||
+				ring_buff_reserve(ring_buff, &data, 200) != RING_BUFF_ERR_OK ||
+				ring_buff_commit(ring_buff, data, 200) != RING_BUFF_ERR_OK ||
+				ring_buff_reserve(ring_buff, &data, 100) != RING_BUFF_ERR_WOULD_BLOCK ||
+				ring_buff_read(ring_buff, &data, 200, &read) != RING_BUFF_ERR_OK || read != 200 ||
+				ring_buff_free(ring_buff, data, read) != RING_BUFF_ERR_OK ||
+				ring_buff_reserve(ring_buff, &data, 100) != RING_BUFF_ERR_OK)
+		{
+			twentieth_tc_arg.failed++;
+		}
+		ring_buff_destroy(ring_buff);
+	}
+	else
+	{
+		twentieth_tc_arg.failed++;
+	}
+	printf(" LOCKED: %ld us\n", locked_us);
+	printf(" SINGLE: %ld us\n", st_us);
+	printf(" FAILED: %u\n", twentieth_tc_arg.failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define TWENTY_FIRST_TC_LOOPS     (200000)
+#define TWENTY_FIRST_TC_BUFF_SIZE (4*1024)
+
+typedef struct twenty_first_tc_arg
+{
+	ring_buff_handle_t ring_buff;
+	unsigned int failed;
+} twenty_first_tc_arg_t;
+
+/* custom backend: default one that counts lock calls */
+static unsigned long twenty_first_tc_locks;
+
+static ring_buff_err_t twenty_first_tc_lock(ring_buff_mutex_t handle)
+{
+	__atomic_add_fetch(&twenty_first_tc_locks, 1, __ATOMIC_RELAXED);
+	return ring_buff_mutex_lock(handle);
+}
+
+static const ring_buff_osal_ops_t twenty_first_tc_osal =
+{
+	ring_buff_mutex_size, ring_buff_mutex_init, ring_buff_mutex_deinit, twenty_first_tc_lock, ring_buff_mutex_unlock,
+	ring_buff_binary_sem_size, ring_buff_binary_sem_init, ring_buff_binary_sem_deinit,
+	ring_buff_binary_sem_take, ring_buff_binary_sem_give
+};
+
+void* twenty_first_tc_consumer(void* arg)
+{
+	twenty_first_tc_arg_t *tc_arg = (twenty_first_tc_arg_t *) arg;
+	unsigned int *data;
+	uint32_t read;
+	unsigned int i;
+
+	for(i = 0; i < TWENTY_FIRST_TC_LOOPS; i++)
+	{
+		if(ring_buff_read(tc_arg->ring_buff, (void**)&data, 4 * sizeof(unsigned int), &read) != RING_BUFF_ERR_OK)
+		{
+			tc_arg->failed++;
+			break;
+		}
+		if(read != 4 * sizeof(unsigned int) || data[0] != i)
+		{
+			tc_arg->failed++;
+		}
+		ring_buff_free(tc_arg->ring_buff, data, read);
+	}
+	return NULL;
+}
+
+static long twenty_first_tc_run(const ring_buff_osal_ops_t *osal, twenty_first_tc_arg_t *tc_arg)
+{
+	ring_buff_attr_t ring_buff_attr;
+	struct timespec start, end;
+	pthread_t consumer;
+	unsigned int *data;
+	void *buff = NULL;
+	int i;
+
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	if((buff = malloc(TWENTY_FIRST_TC_BUFF_SIZE)) == NULL)
+	{
+		tc_arg->failed++;
+		return 0;
+	}
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = TWENTY_FIRST_TC_BUFF_SIZE;
+	ring_buff_attr.osal = osal;
+	if(ring_buff_create(&ring_buff_attr, &tc_arg->ring_buff) != RING_BUFF_ERR_OK)
+	{
+		tc_arg->failed++;
+		free(buff);
+		return 0;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_create(&consumer, NULL, twenty_first_tc_consumer, tc_arg);
+	for(i = 0; i < TWENTY_FIRST_TC_LOOPS; i++)
+	{
+		if(ring_buff_reserve(tc_arg->ring_buff, (void**)&data, 4 * sizeof(unsigned int)) != RING_BUFF_ERR_OK)
+		{
+			tc_arg->failed++;
+			break;
+		}
+		data[0] = i;
+		ring_buff_commit(tc_arg->ring_buff, data, 4 * sizeof(unsigned int));
+	}
+	pthread_join(consumer, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	ring_buff_destroy(tc_arg->ring_buff);
+	free(buff);
+	return (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+}
+
+static void execute_twenty_first_tc(void)
+{
+	twenty_first_tc_arg_t tc_arg;
+	const ring_buff_osal_ops_t *backends[] = {NULL, &ring_buff_osal_posix, &ring_buff_osal_spin,
+			&ring_buff_osal_futex, &ring_buff_osal_pi, &twenty_first_tc_osal};
+	const char *names[] = {"DEFAULT", "POSIX", "SPIN", "FUTEX", "PI", "CUSTOM"};
+	ring_buff_attr_t ring_buff_attr, default_attr;
+	long us;
+	unsigned int i;
+
+	printf("************** Executing OSAL backends test **************\n");
+	memset(&tc_arg, 0, sizeof(tc_arg));
+	for(i = 0; i < sizeof(backends) / sizeof(backends[0]); i++)
+	{
+		us = twenty_first_tc_run(backends[i], &tc_arg);
+		printf(" %-7s %ld us\n", names[i], us);
+	}
+	/* custom backend is used for the buffer lock, lock and semaphores storage is sized by the backend */
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	memset(&default_attr, 0, sizeof(default_attr));
+	ring_buff_attr.osal = &ring_buff_osal_spin;
+	if(twenty_first_tc_locks < TWENTY_FIRST_TC_LOOPS ||
+			ring_buff_get_storage_size(&ring_buff_attr) >= ring_buff_get_storage_size(&default_attr))
+	{
+		tc_arg.failed++;
+	}
+	printf(" FAILED: %u\n", tc_arg.failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define TWENTY_SECOND_TC_LOOPS     (200000)
+#define TWENTY_SECOND_TC_BUFF_SIZE (256*1024)
+/* round trips over 10 us allowed in the real-time run (0.1 %) */
+#define TWENTY_SECOND_TC_SLOW_MAX  (TWENTY_SECOND_TC_LOOPS / 1000)
+
+/* locked memory in KB */
+static unsigned long twenty_second_tc_locked(void)
+{
+	unsigned long locked = 0;
+	char line[128];
+	FILE *f = fopen("/proc/self/status", "r");
+
+	if(f != NULL)
+	{
+		while(fgets(line, sizeof(line), f) != NULL)
+		{
+			if(sscanf(line, "VmLck: %lu", &locked) == 1)
+			{
+				break;
+			}
+		}
+		fclose(f);
+	}
+	return locked;
+}
+
+/* worst-case reserve/commit/read/free round trip in nanoseconds (and the number of round trips over 10 us) */
+static long twenty_second_tc_run(uint8_t realtime, long *avg, unsigned int *slow, unsigned int *failed)
+{
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_handle_t ring_buff = NULL;
+	struct timespec start, end;
+	unsigned long locked = twenty_second_tc_locked();
+	long ns, max = 0, total = 0;
+	uint32_t read;
+	void *buff, *data;
+	int i;
+
+	if((buff = malloc(TWENTY_SECOND_TC_BUFF_SIZE)) == NULL)
+	{
+		(*failed)++;
+		return 0;
+	}
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = TWENTY_SECOND_TC_BUFF_SIZE;
+	ring_buff_attr.realtime = realtime;
+	if(ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+	{
+		printf("********** ERROR creating ring buffer (memory locking not permitted?) **********\n");
+		(*failed)++;
+		free(buff);
+		return 0;
+	}
+	/* whole buffer has to be locked right away */
+	if(realtime && twenty_second_tc_locked() < locked + TWENTY_SECOND_TC_BUFF_SIZE / 1024)
+	{
+		(*failed)++;
+	}
+	for(i = 0; i < TWENTY_SECOND_TC_LOOPS; i++)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if(ring_buff_reserve(ring_buff, &data, 200) != RING_BUFF_ERR_OK ||
+				ring_buff_commit(ring_buff, data, 200) != RING_BUFF_ERR_OK ||
+				ring_buff_read(ring_buff, &data, 200, &read) != RING_BUFF_ERR_OK ||
+				ring_buff_free(ring_buff, data, read) != RING_BUFF_ERR_OK)
+		{
+			(*failed)++;
+			break;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		ns = (end.tv_sec - start.tv_sec) * 1000000000L + (end.tv_nsec - start.tv_nsec);
+		total += ns;
+		if(ns > 10000)
+		{
+			(*slow)++;
+		}
+		if(ns > max)
+		{
+			max = ns;
+		}
+	}
+	ring_buff_destroy(ring_buff);
+	if(twenty_second_tc_locked() != locked)
+	{
+		(*failed)++;
+	}
+	free(buff);
+	*avg = total / TWENTY_SECOND_TC_LOOPS;
+	return max;
+}
+
+static void execute_twenty_second_tc(void)
+{
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_handle_t ring_buff = NULL;
+	struct sched_param param, old_param;
+	long max, avg = 0, rt_max, rt_avg = 0;
+	unsigned int failed = 0, slow = 0, rt_slow = 0;
+	int policy;
+	char buff[256];
+
+	printf("************ Executing real-time profile test ************\n");
+	/* measure on a real-time thread if permitted */
+	pthread_getschedparam(pthread_self(), &policy, &old_param);
+	param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+	if(pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+	{
+		printf(" SCHED_FIFO not permitted, measuring on a normal thread\n");
+	}
+	max = twenty_second_tc_run(0, &avg, &slow, &failed);
+	rt_max = twenty_second_tc_run(1, &rt_avg, &rt_slow, &failed);
+	pthread_setschedparam(pthread_self(), policy, &old_param);
+	/* linger timer has to be woken up from the data path */
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.buff = buff;
+	ring_buff_attr.size = sizeof(buff);
+	ring_buff_attr.realtime = 1;
+	ring_buff_attr.linger_us = 1000;
+	if(ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_BAD_ARG)
+	{
+		failed++;
+	}
+	/* worst case is up to the scheduler (it is only reported), but the real-time data path must be fast
+	 * almost always, and not slower than the default one (with the margin for the noise) */
+	if(rt_slow > TWENTY_SECOND_TC_SLOW_MAX || rt_avg > 2 * avg + 1000)
+	{
+		failed++;
+	}
+	printf(" DEFAULT:  max %ld ns, avg %ld ns, over 10 us %u\n", max, avg, slow);
+	printf(" REALTIME: max %ld ns, avg %ld ns, over 10 us %u\n", rt_max, rt_avg, rt_slow);
+	printf(" FAILED: %u\n", failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define TWENTY_THIRD_TC_BYTES     (4*1024*1024)
+#define TWENTY_THIRD_TC_BUFF_SIZE (64*1024 + 24)
+
+typedef struct twenty_third_tc_arg
+{
+	ring_buff_handle_t ring_buff;
+	uint32_t align;
+	uint32_t produced;
+	uint32_t consumed;
+	uint8_t out_of_order;
+	unsigned int failed;
+} twenty_third_tc_arg_t;
+
+static twenty_third_tc_arg_t twenty_third_tc_arg;
+
+/* data is a byte stream, padding must not show up in it */
+static void twenty_third_tc_check(uint8_t* data, uint32_t size)
+{
+	uint32_t i;
+
+	for(i = 0; i < size; i++)
+	{
+		if(data[i] != (uint8_t)(twenty_third_tc_arg.consumed++ % 251))
+		{
+			twenty_third_tc_arg.failed++;
+			return;
+		}
+	}
+}
+
+static uint32_t twenty_third_tc_produce(void)
+{
+	/* 0 = alignment of the buffer */
+	static const uint32_t aligns[] = {0, 64, 4096, 16};
+	uint32_t size, align, i;
+	uint8_t *data;
+
+	size = twenty_third_tc_arg.produced % 300 + 1;
+	if(size > TWENTY_THIRD_TC_BYTES - twenty_third_tc_arg.produced)
+	{
+		size = TWENTY_THIRD_TC_BYTES - twenty_third_tc_arg.produced;
+	}
+	align = aligns[twenty_third_tc_arg.produced % 4];
+	if(ring_buff_reserve_aligned(twenty_third_tc_arg.ring_buff, (void**)&data, size, align) != RING_BUFF_ERR_OK)
+	{
+		twenty_third_tc_arg.failed++;
+		return 0;
+	}
+	align = align ? align : twenty_third_tc_arg.align;
+	if(align && ((size_t)data & (align - 1)) != 0)
+	{
+		twenty_third_tc_arg.failed++;
+	}
+	for(i = 0; i < size; i++)
+	{
+		data[i] = (uint8_t)(twenty_third_tc_arg.produced++ % 251);
+	}
+	ring_buff_commit(twenty_third_tc_arg.ring_buff, data, size);
+	return size;
+}
+
+void* twenty_third_tc_consumer(void* arg)
+{
+	uint32_t size, read, held_size = 0;
+	void *data, *held = NULL;
+
+	(void)arg;
+	while(twenty_third_tc_arg.consumed < TWENTY_THIRD_TC_BYTES)
+	{
+		size = rand() % 500 + 1;
+		if(size > TWENTY_THIRD_TC_BYTES - twenty_third_tc_arg.consumed)
+		{
+			size = TWENTY_THIRD_TC_BYTES - twenty_third_tc_arg.consumed;
+		}
+		if(ring_buff_read(twenty_third_tc_arg.ring_buff, &data, size, &read) != RING_BUFF_ERR_OK || read == 0)
+		{
+			twenty_third_tc_arg.failed++;
+			break;
+		}
+		twenty_third_tc_check(data, read);
+		/* newer piece is freed first, completion tracker has to step over the padding */
+		if(twenty_third_tc_arg.out_of_order && held == NULL)
+		{
+			held = data;
+			held_size = read;
+			continue;
+		}
+		if(ring_buff_free(twenty_third_tc_arg.ring_buff, data, read) != RING_BUFF_ERR_OK ||
+				(held != NULL && ring_buff_free(twenty_third_tc_arg.ring_buff, held, held_size) != RING_BUFF_ERR_OK))
+		{
+			twenty_third_tc_arg.failed++;
+			break;
+		}
+		held = NULL;
+	}
+	if(held != NULL)
+	{
+		ring_buff_free(twenty_third_tc_arg.ring_buff, held, held_size);
+	}
+	return NULL;
+}
+
+ring_buff_err_t twenty_third_tc_notify(ring_buff_handle_t handle, void* buff, uint32_t size)
+{
+	twenty_third_tc_check(buff, size);
+	return ring_buff_free(handle, buff, size);
+}
+
+static void twenty_third_tc_run(uint32_t align, uint32_t free_slots, uint32_t accumulate, uint8_t single_thread)
+{
+	ring_buff_attr_t ring_buff_attr;
+	pthread_t consumer;
+	void *buff, *data;
+	uint32_t size, read;
+
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	if((buff = malloc(TWENTY_THIRD_TC_BUFF_SIZE + 8)) == NULL)
+	{
+		twenty_third_tc_arg.failed++;
+		return;
+	}
+	/* buffer itself is not aligned */
+	ring_buff_attr.buff = (uint8_t*)buff + 8;
+	ring_buff_attr.size = TWENTY_THIRD_TC_BUFF_SIZE;
+	ring_buff_attr.align = align;
+	ring_buff_attr.free_slots = free_slots;
+	ring_buff_attr.accumulate = accumulate;
+	ring_buff_attr.notify_func = accumulate ? twenty_third_tc_notify : NULL;
+	ring_buff_attr.single_thread = single_thread;
+	twenty_third_tc_arg.align = align;
+	twenty_third_tc_arg.produced = 0;
+	twenty_third_tc_arg.consumed = 0;
+	twenty_third_tc_arg.out_of_order = free_slots != 0;
+	if(ring_buff_create(&ring_buff_attr, &twenty_third_tc_arg.ring_buff) != RING_BUFF_ERR_OK)
+	{
+		twenty_third_tc_arg.failed++;
+		free(buff);
+		return;
+	}
+	if(!accumulate && !single_thread)
+	{
+		pthread_create(&consumer, NULL, twenty_third_tc_consumer, NULL);
+	}
+	while(twenty_third_tc_arg.produced < TWENTY_THIRD_TC_BYTES)
+	{
+		if((size = twenty_third_tc_produce()) == 0)
+		{
+			break;
+		}
+		/* single-threaded buffer is drained right away */
+		if(single_thread && (ring_buff_read(twenty_third_tc_arg.ring_buff, &data, size, &read) != RING_BUFF_ERR_OK ||
+				read != size))
+		{
+			twenty_third_tc_arg.failed++;
+			break;
+		}
+		if(single_thread)
+		{
+			twenty_third_tc_check(data, read);
+			ring_buff_free(twenty_third_tc_arg.ring_buff, data, read);
+		}
+	}
+	if(accumulate)
+	{
+		ring_buff_flush(twenty_third_tc_arg.ring_buff);
+	}
+	else if(!single_thread)
+	{
+		pthread_join(consumer, NULL);
+	}
+	if(twenty_third_tc_arg.consumed != TWENTY_THIRD_TC_BYTES)
+	{
+		twenty_third_tc_arg.failed++;
+	}
+	ring_buff_destroy(twenty_third_tc_arg.ring_buff);
+	free(buff);
+}
+
+static void execute_twenty_third_tc(void)
+{
+	printf("************ Executing aligned reservations test ************\n");
+	memset(&twenty_third_tc_arg, 0, sizeof(twenty_third_tc_arg));
+	/* read, read with out of order free, notifications, single-threaded buffer */
+	twenty_third_tc_run(64, 0, 0, 0);
+	twenty_third_tc_run(64, 4, 0, 0);
+	twenty_third_tc_run(0, 0, 1024, 0);
+	twenty_third_tc_run(64, 0, 0, 1);
+	printf(" FAILED: %u\n", twenty_third_tc_arg.failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define TWENTY_FOURTH_TC_BYTES     (32*1024*1024 + 1234)
+#define TWENTY_FOURTH_TC_BUFF_SIZE (256*1024)
+#define TWENTY_FOURTH_TC_BLOCK     4096
+#define TWENTY_FOURTH_TC_PATH      "/tmp/ring_buff_sink.dat"
+
+static uint32_t twenty_fourth_tc_check(void)
+{
+	FILE* file = NULL;
+	uint8_t* buff = NULL;
+	uint32_t failed = 0;
+	uint32_t read = 0;
+	uint32_t off = 0;
+	uint32_t i = 0;
+
+	if((file = fopen(TWENTY_FOURTH_TC_PATH, "rb")) == NULL || (buff = malloc(TWENTY_FOURTH_TC_BUFF_SIZE)) == NULL)
+	{
+		failed++;
+		goto done;
+	}
+	while((read = fread(buff, 1, TWENTY_FOURTH_TC_BUFF_SIZE, file)) > 0)
+	{
+		for(i = 0; i < read; i++)
+		{
+			if(buff[i] != (uint8_t)((off + i) % 251))
+			{
+				failed++;
+				goto done;
+			}
+		}
+		off += read;
+	}
+	/* padding of the last block is trimmed */
+	if(off != TWENTY_FOURTH_TC_BYTES)
+	{
+		failed++;
+	}
+
+done:
+	if(file != NULL)
+	{
+		fclose(file);
+	}
+	free(buff);
+	return failed;
+}
+
+static uint32_t twenty_fourth_tc_run(uint32_t offset, uint32_t record)
+{
+	ring_buff_attr_t ring_buff_attr;
+	ring_buff_handle_t ring_buff;
+	ring_buff_sink_attr_t sink_attr;
+	ring_buff_sink_handle_t sink;
+	ring_buff_sink_stats_t stats;
+	ring_buff_err_t err;
+	struct timespec start, end;
+	uint8_t *mem, *buff;
+	uint32_t failed = 0;
+	uint32_t produced = 0;
+	uint32_t size, i;
+	uint64_t us;
+
+	if((mem = malloc(TWENTY_FOURTH_TC_BUFF_SIZE + 2 * TWENTY_FOURTH_TC_BLOCK)) == NULL)
+	{
+		return 1;
+	}
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	ring_buff_attr.buff = (uint8_t*)(((uintptr_t)mem + TWENTY_FOURTH_TC_BLOCK - 1) & ~(uintptr_t)(TWENTY_FOURTH_TC_BLOCK - 1)) + offset;
+	ring_buff_attr.size = TWENTY_FOURTH_TC_BUFF_SIZE;
+	if(ring_buff_create(&ring_buff_attr, &ring_buff) != RING_BUFF_ERR_OK)
+	{
+		free(mem);
+		return 1;
+	}
+	memset(&sink_attr, 0, sizeof(sink_attr));
+	sink_attr.path = TWENTY_FOURTH_TC_PATH;
+	sink_attr.block = TWENTY_FOURTH_TC_BLOCK;
+	sink_attr.chunk = 64*1024;
+	err = ring_buff_sink_create(ring_buff, &sink_attr, &sink);
+	if(err != RING_BUFF_ERR_OK)
+	{
+		if(err == RING_BUFF_ERR_PERM)
+		{
+			printf(" O_DIRECT is not supported by the file system, skipped\n");
+		}
+		ring_buff_destroy(ring_buff);
+		free(mem);
+		return err == RING_BUFF_ERR_PERM ? 0 : 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while(produced < TWENTY_FOURTH_TC_BYTES)
+	{
+		size = record < TWENTY_FOURTH_TC_BYTES - produced ? record : TWENTY_FOURTH_TC_BYTES - produced;
+		if(ring_buff_reserve(ring_buff, (void**)&buff, size) != RING_BUFF_ERR_OK)
+		{
+			failed++;
+			break;
+		}
+		for(i = 0; i < size; i++)
+		{
+			buff[i] = (uint8_t)((produced + i) % 251);
+		}
+		ring_buff_commit(ring_buff, buff, size);
+		produced += size;
+	}
+	/* sink writes the last partial block once buffer is stopped */
+	ring_buff_stop(ring_buff);
+	do
+	{
+		usleep(1000);
+		ring_buff_sink_get_stats(sink, &stats);
+	} while(stats.bytes < produced);
+	if(ring_buff_sink_destroy(sink) != RING_BUFF_ERR_OK)
+	{
+		failed++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+	printf(" RECORD %u, OFFSET %u: %lu MB/s, direct %lu, copied %lu, writes %lu\n", record, offset,
+			(unsigned long)(us ? (uint64_t)TWENTY_FOURTH_TC_BYTES / us : 0),
+			(unsigned long)stats.direct, (unsigned long)stats.copied, (unsigned long)stats.writes);
+	/* aligned buffer with records that divide its size -> only the last partial record is copied */
+	if(offset == 0 && TWENTY_FOURTH_TC_BUFF_SIZE % record == 0 && stats.copied >= TWENTY_FOURTH_TC_BLOCK)
+	{
+		failed++;
+	}
+	failed += twenty_fourth_tc_check();
+	ring_buff_destroy(ring_buff);
+	free(mem);
+	unlink(TWENTY_FOURTH_TC_PATH);
+	return failed;
+}
+
+static void execute_twenty_fourth_tc(void)
+{
+	uint32_t failed = 0;
+
+	printf("************ Executing direct I/O sink test ************\n");
+	/* straight from the ring, gaps at the ring end, unaligned ring memory */
+	failed += twenty_fourth_tc_run(0, 4096);
+	failed += twenty_fourth_tc_run(0, 1000);
+	failed += twenty_fourth_tc_run(8, 4096);
+	printf(" FAILED: %u\n", failed);
+	printf("************************* DONE *************************\n");
+}
+
+#define TWENTY_FIFTH_TC_BUFF_SIZE 100
+
+typedef struct twenty_fifth_tc_arg
+{
+	ring_buff_handle_t ring_buff;
+	void* buff;
+	ring_buff_err_t err;
+	uint32_t done;
+} twenty_fifth_tc_arg_t;
+
+static void* twenty_fifth_tc_writer(void* arg)
+{
+	twenty_fifth_tc_arg_t* tc_arg = (twenty_fifth_tc_arg_t*)arg;
+
+	tc_arg->err = ring_buff_reserve(tc_arg->ring_buff, &tc_arg->buff, 20);
+	__atomic_store_n(&tc_arg->done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static uint32_t twenty_fifth_tc_run(uint8_t single_thread)
+{
+	uint8_t mem[TWENTY_FIFTH_TC_BUFF_SIZE];
+	ring_buff_attr_t ring_buff_attr;
+	twenty_fifth_tc_arg_t tc_arg;
+	pthread_t writer;
+	void *buff, *first;
+	uint32_t failed = 0;
+	uint32_t read;
+
+	memset(&ring_buff_attr, 0, sizeof(ring_buff_attr));
+	memset(&tc_arg, 0, sizeof(tc_arg));
+	ring_buff_attr.buff = mem;
+	ring_buff_attr.size = TWENTY_FIFTH_TC_BUFF_SIZE;
+	ring_buff_attr.single_thread = single_thread;
+	if(ring_buff_create(&ring_buff_attr, &tc_arg.ring_buff) != RING_BUFF_ERR_OK)
+	{
+		return 1;
+	}
+	/* everything is consumed, so the next chunk that does not fit starts over */
+	ring_buff_reserve(tc_arg.ring_buff, &buff, 60);
+	ring_buff_commit(tc_arg.ring_buff, buff, 60);
+	ring_buff_read(tc_arg.ring_buff, &buff, 60, &read);
+	ring_buff_free(tc_arg.ring_buff, buff, 60);
+	if(ring_buff_reserve(tc_arg.ring_buff, &first, 70) != RING_BUFF_ERR_OK || first != mem)
+	{
+		failed++;
+	}
+	ring_buff_commit(tc_arg.ring_buff, first, 70);
+	if(ring_buff_reserve(tc_arg.ring_buff, &buff, 20) != RING_BUFF_ERR_OK || buff != mem + 70)
+	{
+		failed++;
+	}
+	ring_buff_commit(tc_arg.ring_buff, buff, 20);
+	/* next one must not land on the first chunk, that is not read yet */
+	if(single_thread)
+	{
+		if(ring_buff_reserve(tc_arg.ring_buff, &buff, 20) != RING_BUFF_ERR_WOULD_BLOCK)
+		{
+			failed++;
+		}
+	}
+	else
+	{
+		pthread_create(&writer, NULL, twenty_fifth_tc_writer, &tc_arg);
+		usleep(100000);
+		if(__atomic_load_n(&tc_arg.done, __ATOMIC_ACQUIRE))
+		{
+			failed++;
+		}
+		ring_buff_read(tc_arg.ring_buff, &buff, 70, &read);
+		ring_buff_free(tc_arg.ring_buff, buff, read);
+		pthread_join(writer, NULL);
+		if(tc_arg.err != RING_BUFF_ERR_OK || tc_arg.buff != mem)
+		{
+			failed++;
+		}
+	}
+	ring_buff_destroy(tc_arg.ring_buff);
+	return failed;
+}
+
+static void execute_twenty_fifth_tc(void)
+{
+	uint32_t failed = 0;
+
+	printf("************ Executing empty buffer wrap around test ************\n");
+	failed += twenty_fifth_tc_run(0);
+	failed += twenty_fifth_tc_run(1);
+	printf(" FAILED: %u\n", failed);
+	printf("************************* DONE *************************\n");
+}
+
+static void print_help(void)
+{
+	printf("********** Ring buffer test **************\n");
+	printf("Please provide test case number:\n");
+	printf("1) Regular (blocking) read/write test\n");
+	printf("2) Notify reader on N bytes written test\n");
+	printf("3) Stream from HTTP server with CURL\n");
+	printf("4) Message queue test\n");
+	printf("5) Bounded MPMC message queue test\n");
+	printf("6) Copy-in message queue test\n");
+	printf("7) Out-of-order free test\n");
+	printf("8) Competing consumers test\n");
+	printf("9) Sharded ring buffer test\n");
+	printf("10) Ring buffer set (wait any) test\n");
+	printf("11) Pipeline test\n");
+	printf("12) Work-stealing executor test\n");
+	printf("13) Persistent ring buffer test\n");
+	printf("14) Spill to disk test\n");
+	printf("15) Elastic ring buffer test\n");
+	printf("16) 64-bit ring buffer test\n");
+	printf("17) In-place ring buffer test\n");
+	printf("18) Ring buffer pool test\n");
+	printf("19) Idle page reclamation test\n");
+	printf("20) Single-threaded ring buffer test\n");
+	printf("21) OSAL backends test\n");
+	printf("22) Real-time profile test\n");
+	printf("23) Aligned reservations test\n");
+	printf("24) Direct I/O sink test\n");
+	printf("25) Empty buffer wrap around test\n");
+	printf("******************************************\n");
+}
+
+int main(int argc, char** argv)
+{
+	int tc = 0;
+
+	if(argc != 2)
+	{
+		print_help();
+		return -1;
+	}
+	tc = atoi(argv[1]);
+	switch(tc)
+	{
+	case 1:
+		execute_first_tc();
+		break;
+	case 2:
+		execute_second_tc();
 		break;
 	case 3:
 		printf("To be done...\n");
@@ -607,6 +4174,69 @@ int main(int argc, char** argv)
 	case 4:
 		execute_fourth_tc();
 		break;
+	case 5:
+		execute_fifth_tc();
+		break;
+	case 6:
+		execute_sixth_tc();
+		break;
+	case 7:
+		execute_seventh_tc();
+		break;
+	case 8:
+		execute_eighth_tc();
+		break;
+	case 9:
+		execute_ninth_tc();
+		break;
+	case 10:
+		execute_tenth_tc();
+		break;
+	case 11:
+		execute_eleventh_tc();
+		break;
+	case 12:
+		execute_twelfth_tc();
+		break;
+	case 13:
+		execute_thirteenth_tc();
+		break;
+	case 14:
+		execute_fourteenth_tc();
+		break;
+	case 15:
+		execute_fifteenth_tc();
+		break;
+	case 16:
+		execute_sixteenth_tc();
+		break;
+	case 17:
+		execute_seventeenth_tc();
+		break;
+	case 18:
+		execute_eighteenth_tc();
+		break;
+	case 19:
+		execute_nineteenth_tc();
+		break;
+	case 20:
+		execute_twentieth_tc();
+		break;
+	case 21:
+		execute_twenty_first_tc();
+		break;
+	case 22:
+		execute_twenty_second_tc();
+		break;
+	case 23:
+		execute_twenty_third_tc();
+		break;
+	case 24:
+		execute_twenty_fourth_tc();
+		break;
+	case 25:
+		execute_twenty_fifth_tc();
+		break;
 	default:
 		print_help();
 		return -1;